@@ -19,6 +19,7 @@
 #include "mercury_thread_pool.h"
 #endif
 #include "mercury_thread_mutex.h"
+#include "mercury_thread.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -32,6 +33,7 @@
 /* Local Variables */
 /*******************/
 static na_class_t *hg_test_na_class_g = NULL;
+static na_class_t *hg_test_na_rail_class_g = NULL;
 static hg_bool_t hg_test_is_client_g = HG_FALSE;
 static hg_addr_t hg_test_addr_g = HG_ADDR_NULL;
 static int hg_test_rank_g = 0;
@@ -40,11 +42,18 @@ static hg_request_class_t *hg_test_request_class_g = NULL;
 hg_bulk_t hg_test_local_bulk_handle_g = HG_BULK_NULL;
 hg_thread_mutex_t hg_test_local_bulk_handle_mutex_g;
 
+/* Server running within the client process (inproc) */
+static na_class_t *hg_test_inproc_na_class_g = NULL;
+static hg_class_t *hg_test_inproc_class_g = NULL;
+static hg_context_t *hg_test_inproc_context_g = NULL;
+static hg_thread_t hg_test_inproc_thread_g;
+
 static char **hg_test_addr_name_table_g = NULL;
 static hg_addr_t *hg_test_addr_table_g = NULL;
 static unsigned int hg_test_addr_table_size_g = 0;
 
 extern na_bool_t na_test_use_self_g;
+extern na_bool_t na_test_use_rails_g;
 
 #ifdef MERCURY_TESTING_HAS_THREAD_POOL
 hg_thread_pool_t *hg_test_thread_pool_g = NULL;
@@ -302,6 +311,167 @@ hg_test_register(hg_class_t *hg_class)
             void, void, hg_test_finalize2_cb);
 }
 
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+hg_test_inproc_progress(void *arg)
+{
+    hg_context_t *context = (hg_context_t *) arg;
+    hg_thread_ret_t tret = (hg_thread_ret_t) 0;
+    hg_return_t ret;
+
+    /* Same loop as test server, until the client sends the finalize RPC */
+    do {
+        unsigned int actual_count = 0;
+
+        do {
+            ret = HG_Trigger(context, 0, 1, &actual_count);
+        } while ((ret == HG_SUCCESS) && actual_count);
+
+        if (hg_atomic_cas32(&hg_test_finalizing_count_g, 1, 1))
+            break;
+
+        ret = HG_Progress(context, 100);
+    } while (ret == HG_SUCCESS || ret == HG_TIMEOUT);
+
+    hg_thread_exit(tret);
+    return tret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_inproc_server_init(char *addr_name, na_size_t addr_name_len)
+{
+    size_t bulk_size = 1024 * 1024 * MERCURY_TESTING_BUFFER_SIZE;
+    na_addr_t self_addr = NA_ADDR_NULL;
+    char *buf_ptr;
+    size_t i;
+    hg_return_t ret = HG_SUCCESS;
+
+    hg_test_inproc_na_class_g = NA_Initialize("inproc", NA_TRUE);
+    if (!hg_test_inproc_na_class_g) {
+        fprintf(stderr, "Could not initialize inproc NA class\n");
+        ret = HG_NA_ERROR;
+        goto done;
+    }
+    if (NA_Addr_self(hg_test_inproc_na_class_g, &self_addr) != NA_SUCCESS
+        || NA_Addr_to_string(hg_test_inproc_na_class_g, addr_name,
+            &addr_name_len, self_addr) != NA_SUCCESS) {
+        fprintf(stderr, "Could not get inproc server addr\n");
+        ret = HG_NA_ERROR;
+        goto done;
+    }
+
+    hg_test_inproc_class_g = HG_Init_na(hg_test_inproc_na_class_g);
+    if (!hg_test_inproc_class_g) {
+        fprintf(stderr, "Could not initialize inproc server\n");
+        ret = HG_PROTOCOL_ERROR;
+        goto done;
+    }
+    hg_test_inproc_context_g = HG_Context_create(hg_test_inproc_class_g);
+    if (!hg_test_inproc_context_g) {
+        fprintf(stderr, "Could not create inproc server context\n");
+        ret = HG_PROTOCOL_ERROR;
+        goto done;
+    }
+    hg_atomic_set32(&hg_test_finalizing_count_g, 0);
+
+#ifdef MERCURY_TESTING_HAS_THREAD_POOL
+    hg_thread_mutex_init(&hg_test_local_bulk_handle_mutex_g);
+    hg_thread_pool_init(MERCURY_TESTING_NUM_THREADS, &hg_test_thread_pool_g);
+    printf("# Starting server with %d threads...\n",
+        MERCURY_TESTING_NUM_THREADS);
+#endif
+
+    /* Register test routines */
+    hg_test_register(hg_test_inproc_class_g);
+
+    /* Create bulk buffer that can be used for receiving data */
+    HG_Bulk_create(hg_test_inproc_class_g, 1, NULL, (hg_size_t *) &bulk_size,
+        HG_BULK_READWRITE, &hg_test_local_bulk_handle_g);
+    HG_Bulk_access(hg_test_local_bulk_handle_g, 0, bulk_size,
+        HG_BULK_READWRITE, 1, (void **) &buf_ptr, NULL, NULL);
+    for (i = 0; i < bulk_size; i++) {
+        buf_ptr[i] = (char) i;
+    }
+
+    hg_thread_create(&hg_test_inproc_thread_g, hg_test_inproc_progress,
+        hg_test_inproc_context_g);
+
+done:
+    if (self_addr != NA_ADDR_NULL)
+        NA_Addr_free(hg_test_inproc_na_class_g, self_addr);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_inproc_server_finalize(void)
+{
+    hg_return_t ret;
+
+    /* Finalize RPC has been answered, stop progressing */
+    hg_thread_join(hg_test_inproc_thread_g);
+
+    HG_Bulk_free(hg_test_local_bulk_handle_g);
+    hg_test_local_bulk_handle_g = HG_BULK_NULL;
+
+    ret = HG_Context_destroy(hg_test_inproc_context_g);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Could not destroy inproc server context\n");
+        goto done;
+    }
+    hg_test_inproc_context_g = NULL;
+
+    ret = HG_Finalize(hg_test_inproc_class_g);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Could not finalize inproc server\n");
+        goto done;
+    }
+    hg_test_inproc_class_g = NULL;
+
+    if (NA_Finalize(hg_test_inproc_na_class_g) != NA_SUCCESS) {
+        fprintf(stderr, "Could not finalize inproc NA class\n");
+        ret = HG_NA_ERROR;
+        goto done;
+    }
+    hg_test_inproc_na_class_g = NULL;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_init_rails(void)
+{
+    char info_string[NA_TEST_MAX_ADDR_NAME];
+    na_class_t *na_classes[2];
+    hg_return_t ret = HG_SUCCESS;
+
+    /* Second rail uses the same plugin as the test class */
+    sprintf(info_string, "%s+%s", NA_Get_class_name(hg_test_na_class_g),
+        NA_Get_class_protocol(hg_test_na_class_g));
+    hg_test_na_rail_class_g = NA_Initialize(info_string, NA_TRUE);
+    if (!hg_test_na_rail_class_g) {
+        fprintf(stderr, "Could not initialize rail NA class\n");
+        ret = HG_NA_ERROR;
+        goto done;
+    }
+
+    /* HG_Hl_init_na() keeps the default class if already set */
+    na_classes[0] = hg_test_na_class_g;
+    na_classes[1] = hg_test_na_rail_class_g;
+    HG_CLASS_DEFAULT = HG_Init_na_rails(na_classes, NULL, 2);
+    if (!HG_CLASS_DEFAULT) {
+        fprintf(stderr, "Could not initialize Mercury rails\n");
+        ret = HG_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 hg_class_t *
 HG_Test_client_init(int argc, char *argv[], hg_addr_t *addr, int *rank,
@@ -313,6 +483,12 @@ HG_Test_client_init(int argc, char *argv[], hg_addr_t *addr, int *rank,
     hg_test_na_class_g = NA_Test_client_init(argc, argv, test_addr_name,
             NA_TEST_MAX_ADDR_NAME, &hg_test_rank_g);
 
+    if (na_test_use_rails_g) {
+        ret = hg_test_init_rails();
+        if (ret != HG_SUCCESS)
+            goto done;
+    }
+
     ret = HG_Hl_init_na(hg_test_na_class_g);
     if (ret != HG_SUCCESS) {
         fprintf(stderr, "Could not initialize Mercury\n");
@@ -345,6 +521,15 @@ HG_Test_client_init(int argc, char *argv[], hg_addr_t *addr, int *rank,
         HG_Bulk_create(HG_CLASS_DEFAULT, 1, NULL, (hg_size_t *) &bulk_size,
             HG_BULK_READWRITE, &hg_test_local_bulk_handle_g);
     } else {
+        /* Inproc addrs cannot cross processes, serve requests from a second
+         * class within this process */
+        if (strcmp(NA_Get_class_name(hg_test_na_class_g), "inproc") == 0) {
+            ret = hg_test_inproc_server_init(test_addr_name,
+                NA_TEST_MAX_ADDR_NAME);
+            if (ret != HG_SUCCESS)
+                goto done;
+        }
+
         /* Look up addr using port name info */
         ret = HG_Hl_addr_lookup_wait(HG_CONTEXT_DEFAULT, hg_test_request_class_g,
                 test_addr_name, &hg_test_addr_g, HG_MAX_IDLE_TIME);
@@ -395,6 +580,12 @@ HG_Test_server_init(int argc, char *argv[], hg_addr_t **addr_table,
     printf("# Starting server with %d threads...\n", MERCURY_TESTING_NUM_THREADS);
 #endif
 
+    if (na_test_use_rails_g) {
+        ret = hg_test_init_rails();
+        if (ret != HG_SUCCESS)
+            goto done;
+    }
+
     ret = HG_Hl_init_na(hg_test_na_class_g);
     if (ret != HG_SUCCESS) {
         fprintf(stderr, "Could not initialize Mercury\n");
@@ -467,6 +658,12 @@ HG_Test_finalize(hg_class_t *hg_class)
             goto done;
         }
         hg_test_addr_g = HG_ADDR_NULL;
+
+        if (hg_test_inproc_class_g) {
+            ret = hg_test_inproc_server_finalize();
+            if (ret != HG_SUCCESS)
+                goto done;
+        }
     } else if (hg_test_addr_table_g) {
         unsigned int i;
 
@@ -496,6 +693,15 @@ HG_Test_finalize(hg_class_t *hg_class)
         goto done;
     }
 
+    if (hg_test_na_rail_class_g) {
+        na_ret = NA_Finalize(hg_test_na_rail_class_g);
+        if (na_ret != NA_SUCCESS) {
+            fprintf(stderr, "Could not finalize rail NA interface\n");
+            goto done;
+        }
+        hg_test_na_rail_class_g = NULL;
+    }
+
     na_ret = NA_Test_finalize(hg_test_na_class_g);
     if (na_ret != NA_SUCCESS) {
         fprintf(stderr, "Could not finalize NA interface\n");
@@ -0,0 +1,1097 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include "mercury_thread.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_condition.h"
+#include "mercury_time.h"
+#include "mercury_atomic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Commands sent in the first word of unexpected messages */
+#define NA_BENCH_CMD_PING   1   /* Reply with message of same size */
+#define NA_BENCH_CMD_HANDLE 2   /* Reply with serialized memory handle */
+#define NA_BENCH_CMD_DONE   3   /* Reply and stop server */
+
+#define NA_BENCH_WINDOW     16          /* Default operations in flight */
+#define NA_BENCH_LOOP       1000        /* Default iterations measured */
+#define NA_BENCH_MAX_SIZE   (1 << 20)   /* Default largest RMA size */
+#define NA_BENCH_MIN_SIZE   8           /* Smallest message size */
+#define NA_BENCH_LARGE_SIZE 65536       /* Sizes above use fewer iterations */
+#define NA_BENCH_SKIP       10          /* Warm-up iterations not measured */
+#define NA_BENCH_POST_COUNT 64          /* Unexpected receives per context */
+#define NA_BENCH_TIMEOUT    1000        /* Progress timeout (ms) */
+#define NA_BENCH_MAX_WAIT   30          /* Wait for completion (s) */
+
+#define NA_BENCH_MB (1024 * 1024)
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Measured operations */
+typedef enum {
+    NA_BENCH_MSG_LAT,   /* Ping-pong latency (us) */
+    NA_BENCH_MSG_RATE,  /* Message rate (msg/s) */
+    NA_BENCH_PUT_BW,    /* Put bandwidth (MB/s) */
+    NA_BENCH_GET_BW     /* Get bandwidth (MB/s) */
+} na_bench_type_t;
+
+/* Shared by all threads */
+struct na_bench_info {
+    na_class_t *na_class;
+    char target_name[NA_TEST_MAX_ADDR_NAME];
+    unsigned int thread_count;
+    unsigned int window;
+    unsigned int loop;
+    na_size_t msg_size_max;             /* Largest message payload */
+    na_size_t rma_size_max;             /* Largest RMA transfer */
+    na_size_t unexpected_header_size;
+    na_size_t expected_header_size;
+    struct na_bench_thread *threads;
+    double *samples;                    /* Samples of all threads */
+    unsigned int result_count;          /* Number of results printed */
+    hg_atomic_int32_t error;            /* One of the threads failed */
+    hg_thread_mutex_t barrier_mutex;
+    hg_thread_cond_t barrier_cond;
+    unsigned int barrier_count;
+    unsigned int barrier_gen;
+
+    /* Server only */
+    char *rma_buf;
+    na_mem_handle_t rma_handle;
+    hg_atomic_int32_t done_count;       /* Clients that are done */
+    unsigned int peer_count;            /* Clients expected */
+};
+
+/* Server unexpected receive slot */
+struct na_bench_slot {
+    struct na_bench_thread *thread;
+    char *buf;
+    void *plugin_data;
+    na_op_id_t op_id;                   /* Receive op ID, used to cancel */
+    na_bool_t own_op_id;                /* Created with NA_Op_create */
+    na_bool_t posted;                   /* Receive not completed yet */
+};
+
+/* Per thread, each thread has its own context */
+struct na_bench_thread {
+    struct na_bench_info *info;
+    unsigned int id;
+    hg_thread_t thread;
+    na_context_t *context;
+    na_addr_t target_addr;
+    char **send_bufs;
+    char **recv_bufs;
+    void **send_plugin_data;
+    void **recv_plugin_data;
+    na_size_t recv_buf_size;
+    char *rma_buf;
+    na_mem_handle_t local_handle;
+    na_mem_handle_t remote_handle;
+    struct na_bench_slot *slots;        /* Server only */
+    unsigned int busy_count;            /* Server slots in use */
+    unsigned int completed;             /* Operations completed */
+    na_return_t ret;                    /* Error of completed operations */
+    double *samples;
+    unsigned int sample_count;
+    double units;                       /* Messages or MB measured */
+    double elapsed;                     /* Time measured (s) */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+static void
+na_bench_usage(const char *execname);
+
+static int
+na_bench_parse_args(int argc, char *argv[], struct na_bench_info *info,
+    na_bool_t *listen, char *na_argv[]);
+
+static void
+na_bench_barrier(struct na_bench_info *info);
+
+static int
+na_bench_cmp(const void *a, const void *b);
+
+static double
+na_bench_percentile(const double *samples, unsigned int count, double p);
+
+static void
+na_bench_report(struct na_bench_info *info, na_bench_type_t type,
+    na_size_t size);
+
+static unsigned int
+na_bench_timeout(struct na_bench_thread *thread);
+
+static na_return_t
+na_bench_wait(struct na_bench_thread *thread, unsigned int count);
+
+static int
+na_bench_cb(const struct na_cb_info *callback_info);
+
+static int
+na_bench_lookup_cb(const struct na_cb_info *callback_info);
+
+static na_return_t
+na_bench_send(struct na_bench_thread *thread, unsigned int slot,
+    na_uint32_t cmd, na_size_t size);
+
+static na_return_t
+na_bench_client_setup(struct na_bench_thread *thread);
+
+static na_return_t
+na_bench_msg(struct na_bench_thread *thread, na_size_t size,
+    unsigned int window);
+
+static na_return_t
+na_bench_rma(struct na_bench_thread *thread, na_bench_type_t type,
+    na_size_t size);
+
+static void
+na_bench_run(struct na_bench_thread *thread, na_bench_type_t type,
+    na_size_t size);
+
+static HG_THREAD_RETURN_TYPE
+na_bench_client_thread(void *arg);
+
+static na_return_t
+na_bench_post(struct na_bench_slot *slot);
+
+static int
+na_bench_server_send_cb(const struct na_cb_info *callback_info);
+
+static int
+na_bench_server_recv_cb(const struct na_cb_info *callback_info);
+
+static HG_THREAD_RETURN_TYPE
+na_bench_server_thread(void *arg);
+
+static na_return_t
+na_bench_thread_init(struct na_bench_info *info,
+    struct na_bench_thread *thread, unsigned int id);
+
+static void
+na_bench_thread_finalize(struct na_bench_thread *thread);
+
+/*---------------------------------------------------------------------------*/
+static void
+na_bench_usage(const char *execname)
+{
+    printf("usage: %s [BENCHMARK OPTIONS] [OPTIONS]\n", execname);
+    printf("  BENCHMARK OPTIONS\n");
+    printf("     -L,   --listen       Run benchmark as server\n");
+    printf("     -t,   --threads      Number of threads (and contexts)\n");
+    printf("     -w,   --window       Number of operations in flight\n");
+    printf("     -l,   --loop         Number of iterations measured\n");
+    printf("     -z,   --max-size     Largest size used for RMA (bytes)\n");
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bench_parse_args(int argc, char *argv[], struct na_bench_info *info,
+    na_bool_t *listen, char *na_argv[])
+{
+    int na_argc = 0;
+    int i;
+
+    /* Benchmark options are removed, remaining args are parsed by na_test */
+    na_argv[na_argc++] = argv[0];
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        unsigned long value;
+
+        if (!strcmp(arg, "-L") || !strcmp(arg, "--listen")) {
+            *listen = NA_TRUE;
+            continue;
+        }
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+            /* Common options are printed by na_test */
+            na_bench_usage(argv[0]);
+            na_argv[na_argc++] = argv[i];
+            continue;
+        }
+        if (strcmp(arg, "-t") && strcmp(arg, "--threads")
+            && strcmp(arg, "-w") && strcmp(arg, "--window")
+            && strcmp(arg, "-l") && strcmp(arg, "--loop")
+            && strcmp(arg, "-z") && strcmp(arg, "--max-size")) {
+            na_argv[na_argc++] = argv[i];
+            continue;
+        }
+        if (i + 1 >= argc) {
+            na_bench_usage(argv[0]);
+            exit(1);
+        }
+        value = strtoul(argv[++i], NULL, 10);
+        if (!value)
+            continue;
+        if (arg[1] == 't' || !strcmp(arg, "--threads"))
+            info->thread_count = (unsigned int) value;
+        else if (arg[1] == 'w' || !strcmp(arg, "--window"))
+            info->window = (unsigned int) value;
+        else if (arg[1] == 'l' || !strcmp(arg, "--loop"))
+            info->loop = (unsigned int) value;
+        else
+            info->rma_size_max = (na_size_t) value;
+    }
+    na_argv[na_argc] = NULL;
+
+    return na_argc;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_bench_barrier(struct na_bench_info *info)
+{
+    unsigned int gen;
+
+    hg_thread_mutex_lock(&info->barrier_mutex);
+    gen = info->barrier_gen;
+    if (++info->barrier_count == info->thread_count) {
+        info->barrier_count = 0;
+        info->barrier_gen++;
+        hg_thread_cond_broadcast(&info->barrier_cond);
+    } else {
+        while (gen == info->barrier_gen)
+            hg_thread_cond_wait(&info->barrier_cond, &info->barrier_mutex);
+    }
+    hg_thread_mutex_unlock(&info->barrier_mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bench_cmp(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+/*---------------------------------------------------------------------------*/
+static double
+na_bench_percentile(const double *samples, unsigned int count, double p)
+{
+    /* Nearest rank, samples must be sorted */
+    unsigned int rank = (unsigned int) (p * count / 100.0 + 0.5);
+
+    if (rank < 1)
+        rank = 1;
+    if (rank > count)
+        rank = count;
+
+    return samples[rank - 1];
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_bench_report(struct na_bench_info *info, na_bench_type_t type,
+    na_size_t size)
+{
+    const char *name = NULL, *unit = NULL;
+    double units = 0, elapsed = 0, sum = 0;
+    unsigned int count = 0, i, j;
+
+    switch (type) {
+        case NA_BENCH_MSG_LAT:
+            name = "msg_latency";
+            unit = "us";
+            break;
+        case NA_BENCH_MSG_RATE:
+            name = "msg_rate";
+            unit = "msg/s";
+            break;
+        case NA_BENCH_PUT_BW:
+            name = "put_bandwidth";
+            unit = "MB/s";
+            break;
+        case NA_BENCH_GET_BW:
+            name = "get_bandwidth";
+            unit = "MB/s";
+            break;
+    }
+
+    /* Merge samples of all threads, aggregate over slowest thread */
+    for (i = 0; i < info->thread_count; i++) {
+        struct na_bench_thread *thread = &info->threads[i];
+
+        for (j = 0; j < thread->sample_count; j++) {
+            info->samples[count++] = thread->samples[j];
+            sum += thread->samples[j];
+        }
+        units += thread->units;
+        if (thread->elapsed > elapsed)
+            elapsed = thread->elapsed;
+    }
+    if (!count)
+        return;
+    qsort(info->samples, count, sizeof(double), na_bench_cmp);
+
+    printf("%s    {\"test\": \"%s\", \"size\": %lu, \"unit\": \"%s\", "
+        "\"samples\": %u,\n", (info->result_count++) ? ",\n" : "", name,
+        (unsigned long) size, unit, count);
+    printf("     \"min\": %.3f, \"avg\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+        "\"p99\": %.3f, \"p99.9\": %.3f, \"max\": %.3f",
+        info->samples[0], sum / count,
+        na_bench_percentile(info->samples, count, 50),
+        na_bench_percentile(info->samples, count, 90),
+        na_bench_percentile(info->samples, count, 99),
+        na_bench_percentile(info->samples, count, 99.9),
+        info->samples[count - 1]);
+    if (type != NA_BENCH_MSG_LAT && elapsed > 0)
+        printf(",\n     \"aggregate\": %.3f", units / elapsed);
+    printf("}");
+    fflush(stdout);
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+na_bench_timeout(struct na_bench_thread *thread)
+{
+    struct na_bench_info *info = thread->info;
+
+    /* Contexts share the plugin's progress, operations of one context may
+     * complete while another thread progresses, without waking a thread
+     * blocked on its own context, therefore only block with one thread */
+    return (info->thread_count == 1
+        && NA_Poll_try_wait(info->na_class, thread->context)) ?
+        NA_BENCH_TIMEOUT : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_wait(struct na_bench_thread *thread, unsigned int count)
+{
+    hg_time_t t1, t2;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_time_get_current(&t1);
+    while (thread->completed < count) {
+        unsigned int actual_count = 0;
+        na_return_t trigger_ret;
+
+        do {
+            trigger_ret = NA_Trigger(thread->context, 0, 1, NULL,
+                &actual_count);
+            if (actual_count)
+                hg_time_get_current(&t1);
+        } while ((trigger_ret == NA_SUCCESS) && actual_count);
+        if (thread->completed >= count)
+            break;
+
+        ret = NA_Progress(thread->info->na_class, thread->context,
+            na_bench_timeout(thread));
+        if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+            NA_LOG_ERROR("Could not make progress");
+            goto done;
+        }
+
+        /* Give up if nothing completes */
+        hg_time_get_current(&t2);
+        if (hg_time_to_double(hg_time_subtract(t2, t1)) > NA_BENCH_MAX_WAIT) {
+            NA_LOG_ERROR("Timed out waiting for completion");
+            ret = NA_TIMEOUT;
+            goto done;
+        }
+    }
+    thread->completed = 0;
+    ret = thread->ret;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bench_cb(const struct na_cb_info *callback_info)
+{
+    struct na_bench_thread *thread =
+        (struct na_bench_thread *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS)
+        thread->ret = callback_info->ret;
+    thread->completed++;
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bench_lookup_cb(const struct na_cb_info *callback_info)
+{
+    struct na_bench_thread *thread =
+        (struct na_bench_thread *) callback_info->arg;
+
+    if (callback_info->ret == NA_SUCCESS)
+        thread->target_addr = callback_info->info.lookup.addr;
+
+    return na_bench_cb(callback_info);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_send(struct na_bench_thread *thread, unsigned int slot,
+    na_uint32_t cmd, na_size_t size)
+{
+    struct na_bench_info *info = thread->info;
+    na_tag_t tag = (na_tag_t) (thread->id * info->window + slot + 1);
+    char *send_buf = thread->send_bufs[slot];
+    na_return_t ret;
+
+    /* Reply is matched on tag, which is unique to each thread and slot */
+    ret = NA_Msg_recv_expected(info->na_class, thread->context, na_bench_cb,
+        thread, thread->recv_bufs[slot], thread->recv_buf_size,
+        thread->recv_plugin_data[slot], thread->target_addr, tag,
+        NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not post recv of expected message");
+        goto done;
+    }
+
+    memcpy(send_buf + info->unexpected_header_size, &cmd, sizeof(cmd));
+    ret = NA_Msg_send_unexpected(info->na_class, thread->context, na_bench_cb,
+        thread, send_buf, info->unexpected_header_size + size,
+        thread->send_plugin_data[slot], thread->target_addr, tag,
+        NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start send of unexpected message");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_client_setup(struct na_bench_thread *thread)
+{
+    struct na_bench_info *info = thread->info;
+    na_return_t ret;
+
+    /* Each thread looks up target on its own context */
+    ret = NA_Addr_lookup(info->na_class, thread->context, na_bench_lookup_cb,
+        thread, info->target_name, NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start lookup of addr %s", info->target_name);
+        goto done;
+    }
+    ret = na_bench_wait(thread, 1);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not lookup addr %s", info->target_name);
+        goto done;
+    }
+
+    /* Get handle to target RMA buffer */
+    ret = na_bench_send(thread, 0, NA_BENCH_CMD_HANDLE, sizeof(na_uint32_t));
+    if (ret != NA_SUCCESS)
+        goto done;
+    ret = na_bench_wait(thread, 2);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not get memory handle");
+        goto done;
+    }
+    ret = NA_Mem_handle_deserialize(info->na_class, &thread->remote_handle,
+        thread->recv_bufs[0] + info->expected_header_size,
+        thread->recv_buf_size - info->expected_header_size);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not deserialize memory handle");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_msg(struct na_bench_thread *thread, na_size_t size,
+    unsigned int window)
+{
+    unsigned int loop = thread->info->loop, i, j;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_BENCH_SKIP + loop; i++) {
+        hg_time_t t1, t2;
+        double td;
+
+        hg_time_get_current(&t1);
+        for (j = 0; j < window; j++) {
+            ret = na_bench_send(thread, j, NA_BENCH_CMD_PING, size);
+            if (ret != NA_SUCCESS)
+                goto done;
+        }
+        ret = na_bench_wait(thread, 2 * window);
+        if (ret != NA_SUCCESS)
+            goto done;
+        hg_time_get_current(&t2);
+        if (i < NA_BENCH_SKIP)
+            continue;
+
+        /* Latency is half of the round-trip time */
+        td = hg_time_to_double(hg_time_subtract(t2, t1));
+        thread->samples[thread->sample_count++] = (window == 1) ?
+            td * 1e6 / 2 : window / td;
+        thread->units += window;
+        thread->elapsed += td;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_rma(struct na_bench_thread *thread, na_bench_type_t type,
+    na_size_t size)
+{
+    struct na_bench_info *info = thread->info;
+    unsigned int loop = (size > NA_BENCH_LARGE_SIZE) ?
+        (info->loop + 9) / 10 : info->loop;
+    unsigned int skip = (size > NA_BENCH_LARGE_SIZE) ? 1 : NA_BENCH_SKIP;
+    unsigned int i, j;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < skip + loop; i++) {
+        hg_time_t t1, t2;
+        double td, mb;
+
+        hg_time_get_current(&t1);
+        for (j = 0; j < info->window; j++) {
+            if (type == NA_BENCH_PUT_BW)
+                ret = NA_Put(info->na_class, thread->context, na_bench_cb,
+                    thread, thread->local_handle, 0, thread->remote_handle, 0,
+                    size, thread->target_addr, NA_OP_ID_IGNORE);
+            else
+                ret = NA_Get(info->na_class, thread->context, na_bench_cb,
+                    thread, thread->local_handle, 0, thread->remote_handle, 0,
+                    size, thread->target_addr, NA_OP_ID_IGNORE);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not start RMA operation");
+                goto done;
+            }
+        }
+        ret = na_bench_wait(thread, info->window);
+        if (ret != NA_SUCCESS)
+            goto done;
+        hg_time_get_current(&t2);
+        if (i < skip)
+            continue;
+
+        td = hg_time_to_double(hg_time_subtract(t2, t1));
+        mb = (double) size * info->window / NA_BENCH_MB;
+        thread->samples[thread->sample_count++] = mb / td;
+        thread->units += mb;
+        thread->elapsed += td;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_bench_run(struct na_bench_thread *thread, na_bench_type_t type,
+    na_size_t size)
+{
+    struct na_bench_info *info = thread->info;
+    na_return_t ret = NA_SUCCESS;
+
+    /* All threads measure the same operation at the same time */
+    na_bench_barrier(info);
+    if (!hg_atomic_get32(&info->error)) {
+        thread->sample_count = 0;
+        thread->units = 0;
+        thread->elapsed = 0;
+        switch (type) {
+            case NA_BENCH_MSG_LAT:
+                ret = na_bench_msg(thread, size, 1);
+                break;
+            case NA_BENCH_MSG_RATE:
+                ret = na_bench_msg(thread, size, info->window);
+                break;
+            case NA_BENCH_PUT_BW:
+            case NA_BENCH_GET_BW:
+                ret = na_bench_rma(thread, type, size);
+                break;
+        }
+        if (ret != NA_SUCCESS)
+            hg_atomic_set32(&info->error, 1);
+    }
+    na_bench_barrier(info);
+    if (thread->id == 0 && !hg_atomic_get32(&info->error))
+        na_bench_report(info, type, size);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+na_bench_client_thread(void *arg)
+{
+    struct na_bench_thread *thread = (struct na_bench_thread *) arg;
+    struct na_bench_info *info = thread->info;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    na_size_t size;
+
+    if (na_bench_client_setup(thread) != NA_SUCCESS)
+        hg_atomic_set32(&info->error, 1);
+
+    for (size = NA_BENCH_MIN_SIZE; size <= info->msg_size_max; size *= 2)
+        na_bench_run(thread, NA_BENCH_MSG_LAT, size);
+    na_bench_run(thread, NA_BENCH_MSG_RATE, NA_BENCH_MIN_SIZE);
+    for (size = 1; size <= info->rma_size_max; size *= 2)
+        na_bench_run(thread, NA_BENCH_PUT_BW, size);
+    for (size = 1; size <= info->rma_size_max; size *= 2)
+        na_bench_run(thread, NA_BENCH_GET_BW, size);
+
+    /* Tell server to stop once all threads are done, from a thread that
+     * progressed the connection, as exiting may cancel its pending I/O */
+    na_bench_barrier(info);
+    if (thread->id == 0 && (thread->target_addr == NA_ADDR_NULL
+        || na_bench_send(thread, 0, NA_BENCH_CMD_DONE, sizeof(na_uint32_t))
+        != NA_SUCCESS || na_bench_wait(thread, 2) != NA_SUCCESS)) {
+        NA_LOG_ERROR("Could not stop server");
+        hg_atomic_set32(&info->error, 1);
+    }
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_post(struct na_bench_slot *slot)
+{
+    struct na_bench_thread *thread = slot->thread;
+    struct na_bench_info *info = thread->info;
+    na_return_t ret;
+
+    /* Plugin creates a new op ID if it does not support NA_Op_create */
+    if (!slot->own_op_id)
+        slot->op_id = NA_OP_ID_NULL;
+
+    ret = NA_Msg_recv_unexpected(info->na_class, thread->context,
+        na_bench_server_recv_cb, slot, slot->buf,
+        NA_Msg_get_max_unexpected_size(info->na_class), slot->plugin_data, 0,
+        &slot->op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not post recv of unexpected message");
+        goto done;
+    }
+    slot->posted = NA_TRUE;
+    thread->busy_count++;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bench_server_send_cb(const struct na_cb_info *callback_info)
+{
+    struct na_bench_slot *slot = (struct na_bench_slot *) callback_info->arg;
+    struct na_bench_info *info = slot->thread->info;
+
+    slot->thread->busy_count--;
+    if ((unsigned int) hg_atomic_get32(&info->done_count) < info->peer_count)
+        na_bench_post(slot);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bench_server_recv_cb(const struct na_cb_info *callback_info)
+{
+    struct na_bench_slot *slot = (struct na_bench_slot *) callback_info->arg;
+    struct na_bench_thread *thread = slot->thread;
+    struct na_bench_info *info = thread->info;
+    const struct na_cb_info_recv_unexpected *recv_info =
+        &callback_info->info.recv_unexpected;
+    char *payload = slot->buf + info->expected_header_size;
+    na_size_t size = sizeof(na_uint32_t);
+    na_uint32_t cmd;
+    na_return_t ret = NA_SUCCESS;
+
+    slot->posted = NA_FALSE;
+    if (callback_info->ret != NA_SUCCESS) {
+        /* Canceled when server stops */
+        thread->busy_count--;
+        goto done;
+    }
+
+    memcpy(&cmd, slot->buf + info->unexpected_header_size, sizeof(cmd));
+    switch (cmd) {
+        case NA_BENCH_CMD_PING:
+            size = recv_info->actual_buf_size - info->unexpected_header_size;
+            break;
+        case NA_BENCH_CMD_HANDLE:
+            ret = NA_Mem_handle_serialize(info->na_class, payload,
+                NA_Msg_get_max_expected_size(info->na_class)
+                - info->expected_header_size, info->rma_handle);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not serialize memory handle");
+                goto done;
+            }
+            size = NA_Mem_handle_get_serialize_size(info->na_class,
+                info->rma_handle);
+            break;
+        case NA_BENCH_CMD_DONE:
+            hg_atomic_incr32(&info->done_count);
+            break;
+        default:
+            NA_LOG_ERROR("Unknown command %u", cmd);
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+    }
+
+    /* Reply from the same buffer, payload content does not matter */
+    NA_Msg_init_expected(info->na_class, slot->buf,
+        NA_Msg_get_max_expected_size(info->na_class));
+    ret = NA_Msg_send_expected(info->na_class, thread->context,
+        na_bench_server_send_cb, slot, slot->buf,
+        info->expected_header_size + size, slot->plugin_data,
+        recv_info->source, recv_info->tag, NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start send of expected message");
+        goto done;
+    }
+
+done:
+    if (callback_info->ret == NA_SUCCESS) {
+        NA_Addr_free(info->na_class, recv_info->source);
+        if (ret != NA_SUCCESS) {
+            thread->busy_count--;
+            hg_atomic_set32(&info->error, 1);
+        }
+    }
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+na_bench_server_thread(void *arg)
+{
+    struct na_bench_thread *thread = (struct na_bench_thread *) arg;
+    struct na_bench_info *info = thread->info;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    na_bool_t canceled = NA_FALSE;
+    unsigned int i;
+
+    for (i = 0; i < NA_BENCH_POST_COUNT; i++) {
+        if (na_bench_post(&thread->slots[i]) != NA_SUCCESS) {
+            hg_atomic_set32(&info->error, 1);
+            break;
+        }
+    }
+
+    /* Serve until all clients are done, then cancel remaining receives */
+    while (thread->busy_count) {
+        unsigned int actual_count = 0;
+        na_return_t trigger_ret;
+
+        if (!canceled && (hg_atomic_get32(&info->error)
+            || (unsigned int) hg_atomic_get32(&info->done_count)
+            >= info->peer_count)) {
+            for (i = 0; i < NA_BENCH_POST_COUNT; i++)
+                if (thread->slots[i].posted)
+                    NA_Cancel(info->na_class, thread->context,
+                        thread->slots[i].op_id);
+            canceled = NA_TRUE;
+        }
+
+        do {
+            trigger_ret = NA_Trigger(thread->context, 0, 1, NULL,
+                &actual_count);
+        } while ((trigger_ret == NA_SUCCESS) && actual_count);
+
+        NA_Progress(info->na_class, thread->context,
+            (canceled) ? 0 : na_bench_timeout(thread));
+    }
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bench_thread_init(struct na_bench_info *info,
+    struct na_bench_thread *thread, unsigned int id)
+{
+    na_class_t *na_class = info->na_class;
+    unsigned int sample_max = NA_BENCH_SKIP + info->loop, i;
+    na_return_t ret = NA_SUCCESS;
+
+    memset(thread, 0, sizeof(struct na_bench_thread));
+    thread->info = info;
+    thread->id = id;
+    thread->context = NA_Context_create(na_class);
+    if (!thread->context) {
+        NA_LOG_ERROR("Could not create context");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+
+    if (NA_Is_listening(na_class)) {
+        /* Server posts unexpected receives and replies from same buffer */
+        thread->slots = (struct na_bench_slot *) calloc(NA_BENCH_POST_COUNT,
+            sizeof(struct na_bench_slot));
+        if (!thread->slots) {
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        for (i = 0; i < NA_BENCH_POST_COUNT; i++) {
+            struct na_bench_slot *slot = &thread->slots[i];
+
+            slot->thread = thread;
+            slot->buf = (char *) NA_Msg_buf_alloc(na_class,
+                NA_Msg_get_max_unexpected_size(na_class), &slot->plugin_data);
+            if (!slot->buf) {
+                ret = NA_NOMEM_ERROR;
+                goto done;
+            }
+            slot->op_id = NA_Op_create(na_class);
+            slot->own_op_id = (slot->op_id != NA_OP_ID_NULL);
+        }
+        goto done;
+    }
+
+    thread->send_bufs = (char **) calloc(info->window, sizeof(char *));
+    thread->recv_bufs = (char **) calloc(info->window, sizeof(char *));
+    thread->send_plugin_data = (void **) calloc(info->window, sizeof(void *));
+    thread->recv_plugin_data = (void **) calloc(info->window, sizeof(void *));
+    thread->samples = (double *) malloc(sample_max * sizeof(double));
+    thread->rma_buf = (char *) malloc(info->rma_size_max);
+    if (!thread->send_bufs || !thread->recv_bufs || !thread->send_plugin_data
+        || !thread->recv_plugin_data || !thread->samples || !thread->rma_buf) {
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(thread->rma_buf, 0, info->rma_size_max);
+
+    thread->recv_buf_size = NA_Msg_get_max_expected_size(na_class);
+    for (i = 0; i < info->window; i++) {
+        thread->send_bufs[i] = (char *) NA_Msg_buf_alloc(na_class,
+            NA_Msg_get_max_unexpected_size(na_class),
+            &thread->send_plugin_data[i]);
+        thread->recv_bufs[i] = (char *) NA_Msg_buf_alloc(na_class,
+            thread->recv_buf_size, &thread->recv_plugin_data[i]);
+        if (!thread->send_bufs[i] || !thread->recv_bufs[i]) {
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        NA_Msg_init_unexpected(na_class, thread->send_bufs[i],
+            NA_Msg_get_max_unexpected_size(na_class));
+    }
+
+    ret = NA_Mem_handle_create(na_class, thread->rma_buf, info->rma_size_max,
+        NA_MEM_READWRITE, &thread->local_handle);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not create NA memory handle");
+        goto done;
+    }
+    ret = NA_Mem_register(na_class, thread->local_handle);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not register NA memory handle");
+        goto done;
+    }
+
+done:
+    if (ret == NA_NOMEM_ERROR)
+        NA_LOG_ERROR("Could not allocate thread resources");
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_bench_thread_finalize(struct na_bench_thread *thread)
+{
+    na_class_t *na_class = thread->info->na_class;
+    unsigned int i;
+
+    if (thread->slots) {
+        for (i = 0; i < NA_BENCH_POST_COUNT; i++) {
+            if (thread->slots[i].own_op_id)
+                NA_Op_destroy(na_class, thread->slots[i].op_id);
+            if (thread->slots[i].buf)
+                NA_Msg_buf_free(na_class, thread->slots[i].buf,
+                    thread->slots[i].plugin_data);
+        }
+        free(thread->slots);
+    }
+    if (thread->remote_handle != NA_MEM_HANDLE_NULL)
+        NA_Mem_handle_free(na_class, thread->remote_handle);
+    if (thread->local_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(na_class, thread->local_handle);
+        NA_Mem_handle_free(na_class, thread->local_handle);
+    }
+    for (i = 0; i < thread->info->window; i++) {
+        if (thread->send_bufs && thread->send_bufs[i])
+            NA_Msg_buf_free(na_class, thread->send_bufs[i],
+                thread->send_plugin_data[i]);
+        if (thread->recv_bufs && thread->recv_bufs[i])
+            NA_Msg_buf_free(na_class, thread->recv_bufs[i],
+                thread->recv_plugin_data[i]);
+    }
+    free(thread->send_bufs);
+    free(thread->recv_bufs);
+    free(thread->send_plugin_data);
+    free(thread->recv_plugin_data);
+    free(thread->samples);
+    free(thread->rma_buf);
+    if (thread->target_addr != NA_ADDR_NULL)
+        NA_Addr_free(na_class, thread->target_addr);
+    if (thread->context)
+        NA_Context_destroy(na_class, thread->context);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+    struct na_bench_info info;
+    na_bool_t listen = NA_FALSE;
+    char **na_argv = NULL;
+    int na_argc;
+    unsigned int i;
+    int ret = EXIT_SUCCESS;
+
+    memset(&info, 0, sizeof(struct na_bench_info));
+    hg_atomic_init32(&info.error, 0);
+    hg_atomic_init32(&info.done_count, 0);
+    hg_thread_mutex_init(&info.barrier_mutex);
+    hg_thread_cond_init(&info.barrier_cond);
+
+    info.thread_count = 1;
+    info.window = NA_BENCH_WINDOW;
+    info.loop = NA_BENCH_LOOP;
+    info.rma_size_max = NA_BENCH_MAX_SIZE;
+
+    /* Role must be known before initializing NA */
+    na_argv = (char **) malloc((size_t) (argc + 1) * sizeof(char *));
+    if (!na_argv) {
+        NA_LOG_ERROR("Could not allocate args");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+    na_argc = na_bench_parse_args(argc, argv, &info, &listen, na_argv);
+
+    if (listen)
+        info.na_class = NA_Test_server_init(na_argc, na_argv, NA_TRUE, NULL,
+            NULL, &info.peer_count);
+    else
+        info.na_class = NA_Test_client_init(na_argc, na_argv,
+            info.target_name, NA_TEST_MAX_ADDR_NAME, NULL);
+    if (!info.na_class) {
+        NA_LOG_ERROR("Could not initialize NA");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    info.unexpected_header_size =
+        NA_Msg_get_unexpected_header_size(info.na_class);
+    info.expected_header_size = NA_Msg_get_expected_header_size(info.na_class);
+    info.msg_size_max = NA_Msg_get_max_unexpected_size(info.na_class)
+        - info.unexpected_header_size;
+    if (NA_Msg_get_max_expected_size(info.na_class)
+        - info.expected_header_size < info.msg_size_max)
+        info.msg_size_max = NA_Msg_get_max_expected_size(info.na_class)
+            - info.expected_header_size;
+    if (info.thread_count * info.window >= NA_Msg_get_max_tag(info.na_class)) {
+        NA_LOG_ERROR("Threads times window exceeds max tag");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    info.threads = (struct na_bench_thread *) calloc(info.thread_count,
+        sizeof(struct na_bench_thread));
+    info.samples = (double *) malloc(info.thread_count
+        * (NA_BENCH_SKIP + info.loop) * sizeof(double));
+    if (!info.threads || !info.samples) {
+        NA_LOG_ERROR("Could not allocate threads");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    if (listen) {
+        /* Clients put to and get from the same buffer */
+        info.rma_buf = (char *) calloc(1, info.rma_size_max);
+        if (!info.rma_buf) {
+            NA_LOG_ERROR("Could not allocate RMA buffer");
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+        if (NA_Mem_handle_create(info.na_class, info.rma_buf,
+            info.rma_size_max, NA_MEM_READWRITE, &info.rma_handle)
+            != NA_SUCCESS
+            || NA_Mem_register(info.na_class, info.rma_handle)
+            != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not register RMA buffer");
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < info.thread_count; i++) {
+        if (na_bench_thread_init(&info, &info.threads[i], i) != NA_SUCCESS) {
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    if (!listen) {
+        printf("{\"na_class\": \"%s\", \"threads\": %u, \"window\": %u, "
+            "\"loop\": %u,\n  \"results\": [\n",
+            NA_Get_class_name(info.na_class), info.thread_count, info.window,
+            info.loop);
+        fflush(stdout);
+    }
+
+    for (i = 0; i < info.thread_count; i++)
+        hg_thread_create(&info.threads[i].thread, (listen) ?
+            na_bench_server_thread : na_bench_client_thread, &info.threads[i]);
+    for (i = 0; i < info.thread_count; i++)
+        hg_thread_join(info.threads[i].thread);
+
+    if (!listen)
+        printf("\n  ]\n}\n");
+    if (hg_atomic_get32(&info.error))
+        ret = EXIT_FAILURE;
+
+done:
+    if (info.threads) {
+        for (i = 0; i < info.thread_count; i++)
+            if (info.threads[i].info)
+                na_bench_thread_finalize(&info.threads[i]);
+        free(info.threads);
+    }
+    if (info.rma_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(info.na_class, info.rma_handle);
+        NA_Mem_handle_free(info.na_class, info.rma_handle);
+    }
+    free(info.rma_buf);
+    free(info.samples);
+    if (info.na_class)
+        NA_Test_finalize(info.na_class);
+    hg_thread_cond_destroy(&info.barrier_cond);
+    hg_thread_mutex_destroy(&info.barrier_mutex);
+    free(na_argv);
+
+    return ret;
+}
@@ -11,6 +11,9 @@
 #include "na_test.h"
 #include "na_test_getopt.h"
 
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+
 #ifdef NA_HAS_MPI
 #include "na_mpi.h"
 #endif
@@ -56,7 +59,12 @@ static int mpi_internally_initialized = NA_FALSE;
 static char **na_addr_table = NULL;
 static unsigned int na_addr_table_size = 0;
 
-static const char *na_test_short_opt_g = "hc:p:H:sSVE";
+/* Addr of server initialized within this process, inproc addrs cannot be
+ * passed through the config file */
+static char na_test_server_addr_name_g[NA_TEST_MAX_ADDR_NAME];
+static hg_atomic_int32_t na_test_server_ready_g;
+
+static const char *na_test_short_opt_g = "hc:p:H:sSVER";
 static const struct na_test_opt na_test_opt_g[] = {
     { "help", no_arg, 'h'},
     { "comm", require_arg, 'c' },
@@ -68,6 +76,7 @@ static const struct na_test_opt na_test_opt_g[] = {
     { "self", no_arg, 'S' },
     { "variable", no_arg, 'V' },
     { "extra", no_arg, 'E' },
+    { "rails", no_arg, 'R' },
     { NULL, 0, '\0' } /* Must add this at the end */
 };
 
@@ -75,6 +84,7 @@ static na_bool_t na_test_use_static_mpi_g = NA_FALSE;
 na_bool_t na_test_use_self_g = NA_FALSE;
 na_bool_t na_test_use_variable_g = NA_FALSE;
 na_bool_t na_test_use_extra_g = NA_FALSE;
+na_bool_t na_test_use_rails_g = NA_FALSE;
 
 /********************/
 /* Local Prototypes */
@@ -112,6 +122,8 @@ na_test_usage(const char *execname)
            "                          Available protocols: tcp, ib, etc\n");
     printf("     -H,   --host         Select hostname / IP address to use\n"
            "                          Default: localhost\n");
+    printf("     -R,   --rails        Use a second NA class as extra rail\n"
+           "                          for bulk transfers (same plugin)\n");
 }
 
 /*---------------------------------------------------------------------------*/
@@ -191,6 +203,7 @@ na_test_gen_config(int argc, char *argv[], int listen)
 {
     char *na_class_name = NULL;
     char *na_protocol_name = NULL;
+    const char *protocol;
     char *na_hostname = NULL;
     static char info_string[NA_TEST_MAX_ADDR_NAME];
     unsigned int na_port = 22222;
@@ -202,6 +215,8 @@ na_test_gen_config(int argc, char *argv[], int listen)
         exit(1);
     }
 
+    /* Client and server may parse the same args within one process */
+    na_test_opt_ind_g = 1;
     while ((opt = na_test_getopt(argc, argv, na_test_short_opt_g,
             na_test_opt_g)) != EOF) {
         switch (opt) {
@@ -234,6 +249,9 @@ na_test_gen_config(int argc, char *argv[], int listen)
             case 'E':
                 na_test_use_extra_g = NA_TRUE;
                 break;
+            case 'R':
+                na_test_use_rails_g = NA_TRUE;
+                break;
             default:
                 break;
         }
@@ -255,7 +273,11 @@ na_test_gen_config(int argc, char *argv[], int listen)
 
     info_string_ptr += sprintf(info_string_ptr, "%s", na_protocol_name);
 
-    if (strcmp("sm", na_protocol_name) == 0) {
+    /* Protocol of wrapped class (e.g., emu+na+sm) */
+    protocol = strchr(na_protocol_name, '+');
+    protocol = (protocol) ? protocol + 1 : na_protocol_name;
+
+    if (strcmp("sm", protocol) == 0) {
 #if defined(PR_SET_PTRACER) && defined(PR_SET_PTRACER_ANY)
         FILE *scope_config;
         int yama_val = '0';
@@ -278,10 +300,10 @@ na_test_gen_config(int argc, char *argv[], int listen)
             /* special-case SM (pid:id) */
             sprintf(info_string_ptr, "://%d/0", (int) getpid());
         }
-    } else if ((strcmp("tcp", na_protocol_name) == 0)
-        || (strcmp("verbs", na_protocol_name) == 0)
-        || (strcmp("psm2", na_protocol_name) == 0)
-        || (strcmp("sockets", na_protocol_name) == 0)) {
+    } else if ((strcmp("tcp", protocol) == 0)
+        || (strcmp("verbs", protocol) == 0)
+        || (strcmp("psm2", protocol) == 0)
+        || (strcmp("sockets", protocol) == 0)) {
         if (listen) {
             const char *hostname = na_hostname ? na_hostname : "localhost";
             na_port += (unsigned int) na_test_comm_rank_g;
@@ -290,11 +312,13 @@ na_test_gen_config(int argc, char *argv[], int listen)
             const char *hostname = na_hostname ? na_hostname : "localhost";
             sprintf(info_string_ptr, "://%s", hostname);
         }
-    } else if (strcmp("static", na_protocol_name) == 0) {
+    } else if (strcmp("static", protocol) == 0) {
         /* Nothing */
-    } else if (strcmp("dynamic", na_protocol_name) == 0) {
+    } else if (strcmp("dynamic", protocol) == 0) {
         /* Nothing */
-    } else if (strcmp("gni", na_protocol_name) == 0) {
+    } else if (strcmp("inproc", protocol) == 0) {
+        /* Nothing, endpoint names are generated within the process */
+    } else if (strcmp("gni", protocol) == 0) {
         const char *hostname = na_hostname ? na_hostname : "localhost";
         na_port += (unsigned int) na_test_comm_rank_g;
         sprintf(info_string_ptr, "://%s:%d", hostname, na_port);
@@ -422,7 +446,15 @@ NA_Test_client_init(int argc, char *argv[], char *addr_name,
     if (!na_test_use_self_g) {
         char test_addr_name[NA_TEST_MAX_ADDR_NAME];
 
-        na_test_get_config(test_addr_name, NA_TEST_MAX_ADDR_NAME);
+        /* Inproc server can only run within this process, leave addr name
+         * empty if it has not been initialized yet */
+        if (strcmp(NA_Get_class_name(na_class), "inproc") == 0) {
+            if (hg_atomic_get32(&na_test_server_ready_g))
+                strcpy(test_addr_name, na_test_server_addr_name_g);
+            else
+                test_addr_name[0] = '\0';
+        } else
+            na_test_get_config(test_addr_name, NA_TEST_MAX_ADDR_NAME);
 
         strncpy(addr_name, test_addr_name,
                 (max_addr_name < NA_TEST_MAX_ADDR_NAME) ?
@@ -475,6 +507,10 @@ NA_Test_server_init(int argc, char *argv[], na_bool_t print_ready,
 
     na_test_set_config(addr_string);
 
+    /* Make addr available to clients within this process */
+    strcpy(na_test_server_addr_name_g, addr_string);
+    hg_atomic_set32(&na_test_server_ready_g, 1);
+
     /* As many entries in addr table as number of server ranks */
     if (addr_table_size) *addr_table_size = na_addr_table_size;
 
@@ -526,6 +562,14 @@ done:
      return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+void
+NA_Test_server_wait(void)
+{
+    while (!hg_atomic_get32(&na_test_server_ready_g))
+        hg_thread_yield();
+}
+
 /*---------------------------------------------------------------------------*/
 void
 NA_Test_barrier(void)
@@ -42,6 +42,13 @@ NA_Test_server_init(int argc, char *argv[], na_bool_t print_ready,
 na_return_t
 NA_Test_finalize(na_class_t *na_class);
 
+/**
+ * Wait until a server initialized by another thread of this process is ready
+ * (client and server running in the same process, e.g., inproc)
+ */
+void
+NA_Test_server_wait(void);
+
 /**
  * Call MPI_Barrier if available
  */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include "mercury_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Inproc addrs cannot be reached from another process, client and server
+ * tests are therefore linked together with their main() renamed and the
+ * server runs in a separate thread */
+int
+na_test_server_main(int argc, char *argv[]);
+
+int
+na_test_client_main(int argc, char *argv[]);
+
+/* Server thread args */
+struct na_test_inproc_args {
+    int argc;
+    char **argv;
+    int ret;
+};
+
+static HG_THREAD_RETURN_TYPE
+na_test_inproc_server(void *arg)
+{
+    struct na_test_inproc_args *args = (struct na_test_inproc_args *) arg;
+    hg_thread_ret_t tret = (hg_thread_ret_t) 0;
+
+    args->ret = na_test_server_main(args->argc, args->argv);
+
+    hg_thread_exit(tret);
+    return tret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct na_test_inproc_args server_args;
+    hg_thread_t server_thread;
+    int ret;
+
+    server_args.argc = argc;
+    server_args.argv = argv;
+    server_args.ret = EXIT_FAILURE;
+    if (hg_thread_create(&server_thread, na_test_inproc_server, &server_args)
+        != HG_UTIL_SUCCESS) {
+        fprintf(stderr, "Could not create server thread\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Client must not parse args before server is done with them */
+    NA_Test_server_wait();
+
+    ret = na_test_client_main(argc, argv);
+    hg_thread_join(server_thread);
+    if (server_args.ret != EXIT_SUCCESS)
+        ret = EXIT_FAILURE;
+
+    return ret;
+}
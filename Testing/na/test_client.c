@@ -34,6 +34,7 @@ struct na_test_params {
     void *send_buf_plugin_data;
     void *recv_buf_plugin_data;
     unsigned int *bulk_buf;
+    void *bulk_buf_plugin_data;
     na_size_t send_buf_len;
     na_size_t recv_buf_len;
     na_size_t bulk_size;
@@ -275,8 +276,8 @@ main(int argc, char *argv[])
 
     /* Prepare bulk_buf */
     params.bulk_size = NA_TEST_BULK_SIZE;
-    params.bulk_buf = (unsigned int *) malloc(
-        params.bulk_size * sizeof(unsigned int));
+    params.bulk_buf = (unsigned int *) NA_Mem_alloc(params.na_class,
+        params.bulk_size * sizeof(unsigned int), &params.bulk_buf_plugin_data);
     for (i = 0; i < params.bulk_size; i++) {
         params.bulk_buf[i] = i;
     }
@@ -324,7 +325,7 @@ main(int argc, char *argv[])
 
     NA_Msg_buf_free(params.na_class, params.recv_buf, params.recv_buf_plugin_data);
     NA_Msg_buf_free(params.na_class, params.send_buf, params.send_buf_plugin_data);
-    free(params.bulk_buf);
+    NA_Mem_free(params.na_class, params.bulk_buf, params.bulk_buf_plugin_data);
 
     NA_Context_destroy(params.na_class, params.context);
 
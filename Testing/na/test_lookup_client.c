@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* More cycles than connection slots of a NA SM listener (1024) */
+#define NA_TEST_LOOKUP_COUNT 1100
+#define NA_TEST_LOOKUP_TAG 110
+#define NA_TEST_LOOKUP_DONE_TAG 111
+
+/* Test parameters */
+struct na_test_params {
+    na_class_t *na_class;
+    na_context_t *context;
+    na_addr_t server_addr;
+    char *send_buf;
+    char *recv_buf;
+    void *send_buf_plugin_data;
+    void *recv_buf_plugin_data;
+    na_size_t send_buf_len;
+    na_size_t recv_buf_len;
+    unsigned int completed;
+    na_return_t ret;
+};
+
+/* NA test routines */
+static na_return_t test_wait(struct na_test_params *params,
+    unsigned int count);
+static na_return_t test_lookup_cycle(struct na_test_params *params,
+    const char *server_name, na_tag_t tag);
+
+/* NA test user-defined callbacks */
+static int
+lookup_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_params *params = (struct na_test_params *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS)
+        params->ret = callback_info->ret;
+    else
+        params->server_addr = callback_info->info.lookup.addr;
+    params->completed++;
+
+    return NA_SUCCESS;
+}
+
+static int
+msg_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_params *params = (struct na_test_params *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS)
+        params->ret = callback_info->ret;
+    params->completed++;
+
+    return NA_SUCCESS;
+}
+
+/* NA test routines */
+static na_return_t
+test_wait(struct na_test_params *params, unsigned int count)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    while (params->completed < count) {
+        na_return_t trigger_ret;
+        unsigned int actual_count = 0;
+        unsigned int timeout = 0;
+
+        do {
+            trigger_ret = NA_Trigger(params->context, 0, 1, NULL,
+                &actual_count);
+        } while ((trigger_ret == NA_SUCCESS) && actual_count);
+
+        if (params->completed >= count)
+            break;
+
+        if (NA_Poll_try_wait(params->na_class, params->context))
+            timeout = NA_MAX_IDLE_TIME;
+        ret = NA_Progress(params->na_class, params->context, timeout);
+        if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+            NA_LOG_ERROR("Could not make progress");
+            goto done;
+        }
+        ret = NA_SUCCESS;
+    }
+
+done:
+    return ret;
+}
+
+static na_return_t
+test_lookup_cycle(struct na_test_params *params, const char *server_name,
+    na_tag_t tag)
+{
+    na_return_t ret;
+
+    /* Look up target, this reserves a new connection each time */
+    params->completed = 0;
+    params->server_addr = NA_ADDR_NULL;
+    ret = NA_Addr_lookup(params->na_class, params->context, lookup_cb, params,
+        server_name, NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start lookup of addr %s", server_name);
+        goto done;
+    }
+    ret = test_wait(params, 1);
+    if (ret != NA_SUCCESS)
+        goto done;
+    if (params->ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not lookup addr %s", server_name);
+        ret = params->ret;
+        goto done;
+    }
+
+    /* Round trip so that server has accepted the connection */
+    ret = NA_Msg_recv_expected(params->na_class, params->context, msg_cb,
+        params, params->recv_buf, params->recv_buf_len,
+        params->recv_buf_plugin_data, params->server_addr, tag,
+        NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not prepost recv of expected message");
+        goto done;
+    }
+    ret = NA_Msg_send_unexpected(params->na_class, params->context, msg_cb,
+        params, params->send_buf, params->send_buf_len,
+        params->send_buf_plugin_data, params->server_addr, tag,
+        NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start send of unexpected message");
+        goto done;
+    }
+    ret = test_wait(params, 3);
+    if (ret != NA_SUCCESS)
+        goto done;
+    if (params->ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Message exchange failed");
+        ret = params->ret;
+        goto done;
+    }
+
+    /* Free addr, this must give the connection back to the server */
+    ret = NA_Addr_free(params->na_class, params->server_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not free addr");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char server_name[NA_TEST_MAX_ADDR_NAME];
+    struct na_test_params params;
+    unsigned int i;
+    int ret = EXIT_SUCCESS;
+
+    /* Initialize the interface */
+    params.na_class = NA_Test_client_init(argc, argv, server_name,
+        NA_TEST_MAX_ADDR_NAME, NULL);
+
+    params.context = NA_Context_create(params.na_class);
+    params.ret = NA_SUCCESS;
+
+    /* Allocate send and recv bufs */
+    params.send_buf_len = NA_Msg_get_max_unexpected_size(params.na_class);
+    params.recv_buf_len = params.send_buf_len;
+    params.send_buf = (char *) NA_Msg_buf_alloc(params.na_class,
+        params.send_buf_len, &params.send_buf_plugin_data);
+    params.recv_buf = (char *) NA_Msg_buf_alloc(params.na_class,
+        params.recv_buf_len, &params.recv_buf_plugin_data);
+    NA_Msg_init_unexpected(params.na_class, params.send_buf,
+        params.send_buf_len);
+    sprintf(params.send_buf +
+        NA_Msg_get_unexpected_header_size(params.na_class), "Hello Server!");
+
+    for (i = 0; i < NA_TEST_LOOKUP_COUNT; i++) {
+        na_tag_t tag = (i == NA_TEST_LOOKUP_COUNT - 1) ?
+            NA_TEST_LOOKUP_DONE_TAG : NA_TEST_LOOKUP_TAG;
+
+        if (test_lookup_cycle(&params, server_name, tag) != NA_SUCCESS) {
+            fprintf(stderr, "Lookup cycle %u failed\n", i);
+            ret = EXIT_FAILURE;
+            break;
+        }
+    }
+    if (ret == EXIT_SUCCESS)
+        printf("Completed %u lookup cycles\n", i);
+
+    printf("Finalizing...\n");
+
+    NA_Msg_buf_free(params.na_class, params.recv_buf,
+        params.recv_buf_plugin_data);
+    NA_Msg_buf_free(params.na_class, params.send_buf,
+        params.send_buf_plugin_data);
+
+    NA_Context_destroy(params.na_class, params.context);
+
+    NA_Test_finalize(params.na_class);
+
+    return ret;
+}
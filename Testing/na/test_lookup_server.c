@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NA_TEST_LOOKUP_DONE_TAG 111
+
+/* Test parameters */
+struct na_test_params {
+    na_class_t *na_class;
+    na_context_t *context;
+    na_addr_t source_addr;
+    na_tag_t source_tag;
+    char *send_buf;
+    char *recv_buf;
+    void *send_buf_plugin_data;
+    void *recv_buf_plugin_data;
+    na_size_t send_buf_len;
+    na_size_t recv_buf_len;
+    unsigned int completed;
+    na_return_t ret;
+};
+
+/* NA test routines */
+static na_return_t test_wait(struct na_test_params *params,
+    unsigned int count);
+static na_return_t test_respond(struct na_test_params *params);
+
+/* NA test user-defined callbacks */
+static int
+msg_unexpected_recv_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_params *params = (struct na_test_params *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS)
+        params->ret = callback_info->ret;
+    else {
+        params->source_addr = callback_info->info.recv_unexpected.source;
+        params->source_tag = callback_info->info.recv_unexpected.tag;
+    }
+    params->completed++;
+
+    return NA_SUCCESS;
+}
+
+static int
+msg_expected_send_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_params *params = (struct na_test_params *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS)
+        params->ret = callback_info->ret;
+    params->completed++;
+
+    return NA_SUCCESS;
+}
+
+/* NA test routines */
+static na_return_t
+test_wait(struct na_test_params *params, unsigned int count)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    while (params->completed < count) {
+        na_return_t trigger_ret;
+        unsigned int actual_count = 0;
+        unsigned int timeout = 0;
+
+        do {
+            trigger_ret = NA_Trigger(params->context, 0, 1, NULL,
+                &actual_count);
+        } while ((trigger_ret == NA_SUCCESS) && actual_count);
+
+        if (params->completed >= count)
+            break;
+
+        if (NA_Poll_try_wait(params->na_class, params->context))
+            timeout = NA_MAX_IDLE_TIME;
+        ret = NA_Progress(params->na_class, params->context, timeout);
+        if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+            NA_LOG_ERROR("Could not make progress");
+            goto done;
+        }
+        ret = NA_SUCCESS;
+    }
+
+done:
+    return ret;
+}
+
+static na_return_t
+test_respond(struct na_test_params *params)
+{
+    na_return_t ret;
+
+    params->completed = 0;
+    params->source_addr = NA_ADDR_NULL;
+    ret = NA_Msg_recv_unexpected(params->na_class, params->context,
+        msg_unexpected_recv_cb, params, params->recv_buf, params->recv_buf_len,
+        params->recv_buf_plugin_data, 0, NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not post recv of unexpected message");
+        goto done;
+    }
+    ret = test_wait(params, 1);
+    if (ret != NA_SUCCESS)
+        goto done;
+    if (params->ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not recv unexpected message");
+        ret = params->ret;
+        goto done;
+    }
+
+    ret = NA_Msg_send_expected(params->na_class, params->context,
+        msg_expected_send_cb, params, params->send_buf, params->send_buf_len,
+        params->send_buf_plugin_data, params->source_addr, params->source_tag,
+        NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start send of expected message");
+        goto done;
+    }
+    ret = test_wait(params, 2);
+    if (ret != NA_SUCCESS)
+        goto done;
+    if (params->ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not send expected message");
+        ret = params->ret;
+        goto done;
+    }
+
+    ret = NA_Addr_free(params->na_class, params->source_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not free addr");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct na_test_params params;
+    unsigned int count = 0;
+    int ret = EXIT_SUCCESS;
+
+    /* Initialize the interface */
+    params.na_class = NA_Test_server_init(argc, argv, NA_TRUE, NULL, NULL,
+        NULL);
+
+    params.context = NA_Context_create(params.na_class);
+    params.ret = NA_SUCCESS;
+
+    /* Allocate send/recv bufs */
+    params.send_buf_len = NA_Msg_get_max_unexpected_size(params.na_class);
+    params.recv_buf_len = params.send_buf_len;
+    params.send_buf = (char *) NA_Msg_buf_alloc(params.na_class,
+        params.send_buf_len, &params.send_buf_plugin_data);
+    params.recv_buf = (char *) NA_Msg_buf_alloc(params.na_class,
+        params.recv_buf_len, &params.recv_buf_plugin_data);
+    sprintf(params.send_buf, "Hello Client!");
+
+    /* Answer each lookup cycle of the client until it is done */
+    do {
+        if (test_respond(&params) != NA_SUCCESS) {
+            fprintf(stderr, "Could not answer cycle %u\n", count);
+            ret = EXIT_FAILURE;
+            break;
+        }
+        count++;
+    } while (params.source_tag != NA_TEST_LOOKUP_DONE_TAG);
+    if (ret == EXIT_SUCCESS)
+        printf("Answered %u lookup cycles\n", count);
+
+    printf("Finalizing...\n");
+
+    NA_Msg_buf_free(params.na_class, params.recv_buf,
+        params.recv_buf_plugin_data);
+    NA_Msg_buf_free(params.na_class, params.send_buf,
+        params.send_buf_plugin_data);
+
+    NA_Context_destroy(params.na_class, params.context);
+
+    if (NA_Test_finalize(params.na_class) != NA_SUCCESS)
+        ret = EXIT_FAILURE;
+
+    return ret;
+}
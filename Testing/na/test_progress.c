@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na.h"
+#include "na_error.h"
+
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+#include "mercury_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NA_TEST_PROGRESS_MSG_COUNT 20000
+#define NA_TEST_PROGRESS_THREAD_COUNT 8
+#define NA_TEST_PROGRESS_MSG_SIZE 64
+#define NA_TEST_PROGRESS_MAX_TIME 60.0 /* Give up after 60s */
+
+/* Test parameters */
+struct na_test_params {
+    na_class_t *na_class;
+    na_context_t *context;
+    na_addr_t self_addr;
+    char *send_buf;
+    char *recv_buf;
+    void *send_buf_plugin_data;
+    void *recv_buf_plugin_data;
+    na_size_t recv_buf_len;
+    hg_atomic_int32_t recv_count;
+    hg_atomic_int32_t send_count;
+    hg_atomic_int32_t error_count;
+    hg_atomic_int32_t done;
+};
+
+/* NA test routines */
+static na_return_t test_post(struct na_test_params *params);
+static HG_THREAD_RETURN_TYPE test_progress_thread(void *arg);
+
+/* NA test user-defined callbacks */
+static int
+msg_unexpected_recv_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_params *params = (struct na_test_params *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS) {
+        hg_atomic_incr32(&params->error_count);
+        hg_atomic_set32(&params->done, 1);
+        goto done;
+    }
+    NA_Addr_free(params->na_class, callback_info->info.recv_unexpected.source);
+
+    /* Post the next exchange from within the callback, this may run on any
+     * of the progress threads */
+    if (hg_atomic_incr32(&params->recv_count) < NA_TEST_PROGRESS_MSG_COUNT) {
+        if (test_post(params) != NA_SUCCESS) {
+            hg_atomic_incr32(&params->error_count);
+            hg_atomic_set32(&params->done, 1);
+        }
+    } else
+        hg_atomic_set32(&params->done, 1);
+
+done:
+    return NA_SUCCESS;
+}
+
+static int
+msg_unexpected_send_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_params *params = (struct na_test_params *) callback_info->arg;
+
+    if (callback_info->ret != NA_SUCCESS)
+        hg_atomic_incr32(&params->error_count);
+    hg_atomic_incr32(&params->send_count);
+
+    return NA_SUCCESS;
+}
+
+/* NA test routines */
+static na_return_t
+test_post(struct na_test_params *params)
+{
+    na_return_t ret;
+
+    ret = NA_Msg_recv_unexpected(params->na_class, params->context,
+        msg_unexpected_recv_cb, params, params->recv_buf, params->recv_buf_len,
+        params->recv_buf_plugin_data, 0, NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not post recv of unexpected message");
+        goto done;
+    }
+
+    ret = NA_Msg_send_unexpected(params->na_class, params->context,
+        msg_unexpected_send_cb, params, params->send_buf,
+        NA_TEST_PROGRESS_MSG_SIZE, params->send_buf_plugin_data,
+        params->self_addr, 0, NA_OP_ID_IGNORE);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not start send of unexpected message");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+static HG_THREAD_RETURN_TYPE
+test_progress_thread(void *arg)
+{
+    struct na_test_params *params = (struct na_test_params *) arg;
+    hg_thread_ret_t tret = (hg_thread_ret_t) 0;
+    hg_time_t t1, t2;
+
+    hg_time_get_current(&t1);
+    while (!hg_atomic_get32(&params->done)) {
+        unsigned int actual_count = 0;
+        na_return_t ret;
+
+        /* All threads progress and trigger the same context concurrently */
+        ret = NA_Progress(params->na_class, params->context, 100);
+        if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+            NA_LOG_ERROR("Could not make progress");
+            hg_atomic_incr32(&params->error_count);
+            break;
+        }
+        NA_Trigger(params->context, 0, 16, NULL, &actual_count);
+
+        hg_time_get_current(&t2);
+        if (hg_time_to_double(hg_time_subtract(t2, t1))
+            > NA_TEST_PROGRESS_MAX_TIME) {
+            NA_LOG_ERROR("Timed out after %d messages",
+                hg_atomic_get32(&params->recv_count));
+            hg_atomic_incr32(&params->error_count);
+            break;
+        }
+    }
+    hg_atomic_set32(&params->done, 1);
+
+    hg_thread_exit(tret);
+    return tret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *info_string = (argc > 1) ? argv[1] : "inproc";
+    hg_thread_t threads[NA_TEST_PROGRESS_THREAD_COUNT];
+    struct na_test_params params;
+    hg_time_t t1, t2;
+    unsigned int i;
+    int ret = EXIT_SUCCESS;
+
+    params.na_class = NA_Initialize(info_string, NA_TRUE);
+    if (!params.na_class) {
+        fprintf(stderr, "Could not initialize %s\n", info_string);
+        return EXIT_FAILURE;
+    }
+    params.context = NA_Context_create(params.na_class);
+    NA_Addr_self(params.na_class, &params.self_addr);
+    hg_atomic_set32(&params.recv_count, 0);
+    hg_atomic_set32(&params.send_count, 0);
+    hg_atomic_set32(&params.error_count, 0);
+    hg_atomic_set32(&params.done, 0);
+
+    /* Allocate send/recv bufs */
+    params.recv_buf_len = NA_Msg_get_max_unexpected_size(params.na_class);
+    params.send_buf = (char *) NA_Msg_buf_alloc(params.na_class,
+        params.recv_buf_len, &params.send_buf_plugin_data);
+    params.recv_buf = (char *) NA_Msg_buf_alloc(params.na_class,
+        params.recv_buf_len, &params.recv_buf_plugin_data);
+    NA_Msg_init_unexpected(params.na_class, params.send_buf,
+        params.recv_buf_len);
+
+    hg_time_get_current(&t1);
+    if (test_post(&params) != NA_SUCCESS) {
+        ret = EXIT_FAILURE;
+        goto cleanup;
+    }
+    for (i = 0; i < NA_TEST_PROGRESS_THREAD_COUNT; i++)
+        hg_thread_create(&threads[i], test_progress_thread, &params);
+    for (i = 0; i < NA_TEST_PROGRESS_THREAD_COUNT; i++)
+        hg_thread_join(threads[i]);
+    hg_time_get_current(&t2);
+
+    if (hg_atomic_get32(&params.error_count)
+        || hg_atomic_get32(&params.recv_count) != NA_TEST_PROGRESS_MSG_COUNT) {
+        fprintf(stderr, "Received %d (sent %d) of %d messages with %d "
+            "errors\n", hg_atomic_get32(&params.recv_count),
+            hg_atomic_get32(&params.send_count), NA_TEST_PROGRESS_MSG_COUNT,
+            hg_atomic_get32(&params.error_count));
+        ret = EXIT_FAILURE;
+    } else
+        printf("Exchanged %d messages with %d threads in %.3f s\n",
+            NA_TEST_PROGRESS_MSG_COUNT, NA_TEST_PROGRESS_THREAD_COUNT,
+            hg_time_to_double(hg_time_subtract(t2, t1)));
+
+cleanup:
+    /* Drain remaining send completions */
+    for (i = 0; i < 1000 && hg_atomic_get32(&params.send_count)
+        < hg_atomic_get32(&params.recv_count); i++) {
+        unsigned int actual_count = 0;
+
+        NA_Progress(params.na_class, params.context, 10);
+        NA_Trigger(params.context, 0, 16, NULL, &actual_count);
+    }
+
+    NA_Msg_buf_free(params.na_class, params.recv_buf,
+        params.recv_buf_plugin_data);
+    NA_Msg_buf_free(params.na_class, params.send_buf,
+        params.send_buf_plugin_data);
+    NA_Addr_free(params.na_class, params.self_addr);
+    NA_Context_destroy(params.na_class, params.context);
+    NA_Finalize(params.na_class);
+
+    return ret;
+}
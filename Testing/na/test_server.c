@@ -61,7 +61,11 @@ msg_unexpected_recv_cb(const struct na_cb_info *callback_info)
     params->source_addr = callback_info->info.recv_unexpected.source;
     recv_tag = callback_info->info.recv_unexpected.tag;
 
-    params->ret = test_msg_respond(params, recv_tag + 1);
+    /* Prepost recv of memory handle before responding, the client sends it
+     * as soon as it receives the response */
+    params->ret = test_bulk(params);
+    if (params->ret == EXIT_SUCCESS)
+        params->ret = test_msg_respond(params, recv_tag + 1);
 
     return ret;
 }
@@ -79,7 +83,6 @@ msg_expected_send_cb(const struct na_cb_info *callback_info)
     printf("Sent msg (%s)\n", params->send_buf);
 
     test_msg_done_g = 1;
-    params->ret = test_bulk(params);
 
     return ret;
 }
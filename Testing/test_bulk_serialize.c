@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury.h"
+#include "mercury_bulk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HG_TEST_BULK_SEGMENT_COUNT 2
+#define HG_TEST_BULK_SEGMENT_SIZE 4096
+
+/* Permission flags must not carry anything else for single rail handles */
+#define HG_TEST_BULK_FLAGS_MASK 0x03
+
+/* Check serialized handle against the single rail encoding:
+ * flags, total size, segment count, segments, NA handle count, NA handles
+ * (each prefixed by its size), eager mode */
+static int
+hg_test_bulk_check_single_rail(const char *buf, hg_size_t buf_size,
+    void **buf_ptrs, const hg_size_t *buf_sizes, hg_uint32_t count)
+{
+    const char *buf_ptr = buf;
+    hg_uint8_t flags;
+    hg_size_t total_size;
+    hg_uint32_t segment_count, handle_count, i;
+    hg_bool_t eager_mode;
+
+#define HG_TEST_BULK_DECODE(dest) do {                                  \
+    if ((hg_size_t) (buf_ptr - buf) + sizeof(dest) > buf_size) {        \
+        fprintf(stderr, "Serialized handle too short\n");               \
+        return -1;                                                      \
+    }                                                                   \
+    memcpy(&(dest), buf_ptr, sizeof(dest));                             \
+    buf_ptr += sizeof(dest);                                            \
+} while (0)
+
+    HG_TEST_BULK_DECODE(flags);
+    if (flags != HG_BULK_READWRITE) {
+        fprintf(stderr, "Unexpected permission flags 0x%x\n", flags);
+        return -1;
+    }
+    HG_TEST_BULK_DECODE(total_size);
+    if (total_size != count * HG_TEST_BULK_SEGMENT_SIZE) {
+        fprintf(stderr, "Unexpected total size %zu\n", (size_t) total_size);
+        return -1;
+    }
+    HG_TEST_BULK_DECODE(segment_count);
+    if (segment_count != count) {
+        fprintf(stderr, "Unexpected segment count %u\n", segment_count);
+        return -1;
+    }
+    for (i = 0; i < segment_count; i++) {
+        hg_ptr_t address;
+        hg_size_t size;
+
+        HG_TEST_BULK_DECODE(address);
+        HG_TEST_BULK_DECODE(size);
+        if (address != (hg_ptr_t) buf_ptrs[i] || size != buf_sizes[i]) {
+            fprintf(stderr, "Unexpected segment %u\n", i);
+            return -1;
+        }
+    }
+    HG_TEST_BULK_DECODE(handle_count);
+    for (i = 0; i < handle_count; i++) {
+        na_size_t serialize_size;
+
+        HG_TEST_BULK_DECODE(serialize_size);
+        if ((hg_size_t) (buf_ptr - buf) + serialize_size > buf_size) {
+            fprintf(stderr, "Serialized handle too short\n");
+            return -1;
+        }
+        buf_ptr += serialize_size;
+    }
+    HG_TEST_BULK_DECODE(eager_mode);
+    if (eager_mode) {
+        fprintf(stderr, "Unexpected eager mode\n");
+        return -1;
+    }
+
+#undef HG_TEST_BULK_DECODE
+
+    /* Nothing must follow */
+    if ((hg_size_t) (buf_ptr - buf) != buf_size) {
+        fprintf(stderr, "%zu bytes left after single rail encoding\n",
+            (size_t) (buf_size - (hg_size_t) (buf_ptr - buf)));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Serialize handle created on hg_class and deserialize it on each class */
+static int
+hg_test_bulk_serialize(hg_class_t *hg_class, hg_class_t **hg_classes,
+    unsigned int class_count, hg_bool_t single_rail)
+{
+    void *buf_ptrs[HG_TEST_BULK_SEGMENT_COUNT];
+    hg_size_t buf_sizes[HG_TEST_BULK_SEGMENT_COUNT];
+    hg_bulk_t bulk_handle = HG_BULK_NULL;
+    char *buf = NULL;
+    hg_size_t buf_size;
+    unsigned int i;
+    int ret = -1;
+
+    for (i = 0; i < HG_TEST_BULK_SEGMENT_COUNT; i++) {
+        buf_ptrs[i] = calloc(1, HG_TEST_BULK_SEGMENT_SIZE);
+        buf_sizes[i] = HG_TEST_BULK_SEGMENT_SIZE;
+    }
+
+    if (HG_Bulk_create(hg_class, HG_TEST_BULK_SEGMENT_COUNT, buf_ptrs,
+        buf_sizes, HG_BULK_READWRITE, &bulk_handle) != HG_SUCCESS) {
+        fprintf(stderr, "Could not create bulk handle\n");
+        goto done;
+    }
+
+    buf_size = HG_Bulk_get_serialize_size(bulk_handle, HG_FALSE);
+    buf = (char *) malloc(buf_size);
+    if (HG_Bulk_serialize(buf, buf_size, HG_FALSE, bulk_handle)
+        != HG_SUCCESS) {
+        fprintf(stderr, "Could not serialize bulk handle\n");
+        goto done;
+    }
+
+    if (single_rail) {
+        if (hg_test_bulk_check_single_rail(buf, buf_size, buf_ptrs,
+            buf_sizes, HG_TEST_BULK_SEGMENT_COUNT) != 0)
+            goto done;
+    } else if (!(((hg_uint8_t) buf[0]) & ~HG_TEST_BULK_FLAGS_MASK)) {
+        fprintf(stderr, "Rail data not flagged in multi-rail handle\n");
+        goto done;
+    }
+
+    /* Either encoding must be readable by single and multi-rail classes */
+    for (i = 0; i < class_count; i++) {
+        hg_bulk_t deserialized_handle = HG_BULK_NULL;
+        hg_return_t hg_ret;
+
+        if (HG_Bulk_deserialize(hg_classes[i], &deserialized_handle, buf,
+            buf_size) != HG_SUCCESS) {
+            fprintf(stderr, "Could not deserialize bulk handle\n");
+            goto done;
+        }
+        hg_ret = (HG_Bulk_get_size(deserialized_handle)
+            == HG_Bulk_get_size(bulk_handle)
+            && HG_Bulk_get_segment_count(deserialized_handle)
+            == HG_TEST_BULK_SEGMENT_COUNT) ? HG_SUCCESS : HG_PROTOCOL_ERROR;
+        HG_Bulk_free(deserialized_handle);
+        if (hg_ret != HG_SUCCESS) {
+            fprintf(stderr, "Deserialized bulk handle does not match\n");
+            goto done;
+        }
+    }
+
+    ret = 0;
+
+done:
+    if (bulk_handle != HG_BULK_NULL)
+        HG_Bulk_free(bulk_handle);
+    free(buf);
+    for (i = 0; i < HG_TEST_BULK_SEGMENT_COUNT; i++)
+        free(buf_ptrs[i]);
+    return ret;
+}
+
+/******************************************************************************/
+int
+main(int argc, char *argv[])
+{
+    const char *info_string = (argc > 1) ? argv[1] : "na+sm";
+    na_class_t *na_classes[2] = {NULL, NULL};
+    hg_class_t *hg_classes[2] = {NULL, NULL};
+    int ret = EXIT_FAILURE;
+
+    /* Single rail class */
+    hg_classes[0] = HG_Init(info_string, HG_FALSE);
+    if (!hg_classes[0]) {
+        fprintf(stderr, "Could not initialize %s\n", info_string);
+        goto done;
+    }
+
+    /* Two rail class using the same plugin */
+    na_classes[0] = NA_Initialize(info_string, NA_FALSE);
+    na_classes[1] = NA_Initialize(info_string, NA_FALSE);
+    if (!na_classes[0] || !na_classes[1]) {
+        fprintf(stderr, "Could not initialize %s rails\n", info_string);
+        goto done;
+    }
+    hg_classes[1] = HG_Init_na_rails(na_classes, NULL, 2);
+    if (!hg_classes[1]) {
+        fprintf(stderr, "Could not initialize rails\n");
+        goto done;
+    }
+
+    if (hg_test_bulk_serialize(hg_classes[0], hg_classes, 2, HG_TRUE) != 0) {
+        fprintf(stderr, "Single rail serialization failed\n");
+        goto done;
+    }
+    printf("Single rail handle uses single rail encoding\n");
+
+    if (hg_test_bulk_serialize(hg_classes[1], hg_classes, 2, HG_FALSE) != 0) {
+        fprintf(stderr, "Multi-rail serialization failed\n");
+        goto done;
+    }
+    printf("Multi-rail handle is flagged and readable by both classes\n");
+
+    ret = EXIT_SUCCESS;
+
+done:
+    if (hg_classes[1])
+        HG_Finalize(hg_classes[1]);
+    if (na_classes[1])
+        NA_Finalize(na_classes[1]);
+    if (na_classes[0])
+        NA_Finalize(na_classes[0]);
+    if (hg_classes[0])
+        HG_Finalize(hg_classes[0]);
+    return ret;
+}
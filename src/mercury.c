@@ -731,6 +731,26 @@ done:
     return hg_class;
 }
 
+/*---------------------------------------------------------------------------*/
+hg_class_t *
+HG_Init_na_rails(na_class_t **na_classes, const hg_uint32_t *weights,
+    hg_uint32_t count)
+{
+    hg_class_t *hg_class = NULL;
+
+    hg_class = HG_Core_init_na_rails(na_classes, weights, count);
+    if (!hg_class) {
+        HG_LOG_ERROR("Could not create HG class");
+        goto done;
+    }
+
+    /* Set private data allocation on HG handle create */
+    hg_core_set_handle_create_callback(hg_class, hg_private_data_alloc);
+
+done:
+    return hg_class;
+}
+
 /*---------------------------------------------------------------------------*/
 hg_return_t
 HG_Finalize(hg_class_t *hg_class)
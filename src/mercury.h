@@ -79,6 +79,26 @@ HG_Init_na(
         na_class_t *na_class
         );
 
+/**
+ * Initialize the Mercury layer from several existing NA classes (rails).
+ * RPCs go through the first class, bulk transfers are striped across all
+ * of them in proportion to their weights.
+ * Must be finalized with HG_Finalize().
+ *
+ * \param na_classes [IN]       array of pointers to NA classes
+ * \param weights [IN]          array of relative rail weights (NULL for
+ *                              equal weights)
+ * \param count [IN]            number of NA classes
+ *
+ * \return Pointer to HG class or NULL in case of failure
+ */
+HG_EXPORT hg_class_t *
+HG_Init_na_rails(
+        na_class_t **na_classes,
+        const hg_uint32_t *weights,
+        hg_uint32_t count
+        );
+
 /**
  * Finalize the Mercury layer.
  *
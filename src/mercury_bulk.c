@@ -26,6 +26,16 @@
 #define HG_BULK_MIN(a, b) \
     (a < b) ? a : b
 
+/* Transfers smaller than this are not striped across rails */
+#define HG_BULK_RAIL_MIN_SIZE   (64 * 1024)
+
+/* Stripe boundaries are aligned to that size */
+#define HG_BULK_RAIL_ALIGN      4096
+
+/* Set in serialized permission flags when rail data follows the NA memory
+ * handles, single rail handles keep the previous encoding */
+#define HG_BULK_SERIALIZE_RAILS 0x80
+
 /* Remove warnings when plugin does not use callback arguments */
 #if defined(__cplusplus)
     #define HG_BULK_UNUSED
@@ -39,6 +49,38 @@
 /* Local Type and Struct Definition */
 /************************************/
 
+/* Wrapper on top of NA layer */
+typedef na_return_t (*na_bulk_op_t)(
+        na_class_t      *na_class,
+        na_context_t    *context,
+        na_cb_t          callback,
+        void            *arg,
+        na_mem_handle_t  local_mem_handle,
+        na_ptr_t         local_address,
+        na_offset_t      local_offset,
+        na_mem_handle_t  remote_mem_handle,
+        na_ptr_t         remote_address,
+        na_offset_t      remote_offset,
+        na_size_t        data_size,
+        na_addr_t        remote_addr,
+        na_op_id_t      *op_id
+        );
+
+/* Part of a bulk transfer issued on one NA rail */
+struct hg_bulk_stripe {
+    struct hg_bulk_op_id *hg_bulk_op_id;  /* Parent op ID */
+    unsigned int rail;                    /* Rail index */
+    na_addr_t na_addr;                    /* Origin addr on that rail */
+    hg_size_t offset;                     /* Offset from transfer start */
+    hg_size_t size;                       /* Size of stripe */
+    hg_uint32_t origin_segment_index;     /* Origin start segment */
+    hg_size_t origin_segment_offset;      /* Origin start segment offset */
+    hg_uint32_t local_segment_index;      /* Local start segment */
+    hg_size_t local_segment_offset;       /* Local start segment offset */
+    unsigned int op_index;                /* First NA operation ID */
+    unsigned int op_count;                /* Number of NA operations */
+};
+
 /* HG Bulk op id */
 struct hg_bulk_op_id {
     struct hg_class *hg_class;            /* HG class */
@@ -54,6 +96,13 @@ struct hg_bulk_op_id {
     struct hg_bulk *hg_bulk_local;        /* Local handle */
     na_op_id_t *na_op_ids ;               /* NA operations IDs */
     hg_bool_t is_self;                    /* Is self operation */
+    hg_return_t ret;                      /* Return code */
+    na_bulk_op_t na_bulk_op;              /* NA operation (stripes) */
+    na_addr_t na_origin_addr;             /* Origin addr (stripes) */
+    hg_bool_t scatter_gather;             /* Scatter/gather (stripes) */
+    struct hg_bulk_stripe *stripes;       /* Stripes across NA rails */
+    unsigned int stripe_count;            /* Number of stripes */
+    hg_atomic_int32_t lookup_count;       /* Pending rail addr lookups */
     struct hg_completion_entry hg_completion_entry; /* Entry in completion queue */
 };
 
@@ -63,22 +112,11 @@ struct hg_bulk_segment {
     hg_size_t size;   /* size of the segment in bytes */
 };
 
-/* Wrapper on top of NA layer */
-typedef na_return_t (*na_bulk_op_t)(
-        na_class_t      *na_class,
-        na_context_t    *context,
-        na_cb_t          callback,
-        void            *arg,
-        na_mem_handle_t  local_mem_handle,
-        na_ptr_t         local_address,
-        na_offset_t      local_offset,
-        na_mem_handle_t  remote_mem_handle,
-        na_ptr_t         remote_address,
-        na_offset_t      remote_offset,
-        na_size_t        data_size,
-        na_addr_t        remote_addr,
-        na_op_id_t      *op_id
-        );
+/* NA memory handles of an additional NA rail */
+struct hg_bulk_rail {
+    na_mem_handle_t *na_mem_handles;     /* Array of NA memory handles */
+    char *addr_string;                   /* Origin addr on rail (remote) */
+};
 
 /* Note to self, get_serialize_size may be updated accordingly */
 struct hg_bulk {
@@ -92,6 +130,8 @@ struct hg_bulk {
     hg_bool_t segment_alloc;             /* Allocated memory to mirror data */
     hg_uint8_t flags;                    /* Permission flags */
     hg_bool_t eager_mode;                /* Eager transfer */
+    struct hg_bulk_rail *rails;          /* Handles of rails 1..n */
+    hg_uint32_t rail_count;              /* Number of additional rails */
     hg_atomic_int32_t ref_count;         /* Reference count */
 };
 
@@ -107,6 +147,146 @@ hg_core_get_na_context(
         struct hg_context *context
         );
 
+/**
+ * Get number of NA rails.
+ */
+extern unsigned int
+hg_core_get_rail_count(
+        struct hg_class *hg_class
+        );
+
+/**
+ * Get NA class, weight and self addr string of rail.
+ */
+extern na_class_t *
+hg_core_get_rail(
+        struct hg_class *hg_class,
+        unsigned int rail,
+        hg_uint32_t *weight,
+        const char **self_string
+        );
+
+/**
+ * Get NA context of rail.
+ */
+extern na_context_t *
+hg_core_get_rail_na_context(
+        struct hg_context *context,
+        unsigned int rail
+        );
+
+/**
+ * Find previously looked up addr of rail.
+ */
+extern na_addr_t
+hg_core_rail_addr_find(
+        struct hg_class *hg_class,
+        unsigned int rail,
+        const char *name
+        );
+
+/**
+ * Cache addr of rail.
+ */
+extern na_addr_t
+hg_core_rail_addr_insert(
+        struct hg_class *hg_class,
+        unsigned int rail,
+        const char *name,
+        na_addr_t na_addr
+        );
+
+/**
+ * Get NA memory handles of rail.
+ */
+static HG_INLINE na_mem_handle_t *
+hg_bulk_get_rail_handles(
+        struct hg_bulk *hg_bulk,
+        unsigned int rail
+        );
+
+/**
+ * Whether all rails can register scattered segments with one handle.
+ */
+static hg_bool_t
+hg_bulk_rails_use_segments(
+        struct hg_class *hg_class
+        );
+
+/**
+ * Create and register NA memory handles.
+ */
+static hg_return_t
+hg_bulk_register(
+        struct hg_bulk *hg_bulk,
+        na_class_t *na_class,
+        hg_bool_t use_register_segment,
+        na_mem_handle_t *na_mem_handles
+        );
+
+/**
+ * Unpublish, deregister and free NA memory handles.
+ */
+static void
+hg_bulk_deregister(
+        struct hg_bulk *hg_bulk,
+        na_class_t *na_class,
+        na_mem_handle_t *na_mem_handles
+        );
+
+/**
+ * Publish NA memory handles.
+ */
+static hg_return_t
+hg_bulk_publish(
+        struct hg_bulk *hg_bulk,
+        na_class_t *na_class,
+        na_mem_handle_t *na_mem_handles
+        );
+
+/**
+ * Get serialize size of NA memory handles.
+ */
+static hg_size_t
+hg_bulk_get_handles_serialize_size(
+        struct hg_bulk *hg_bulk,
+        na_class_t *na_class,
+        na_mem_handle_t *na_mem_handles
+        );
+
+/**
+ * Serialize NA memory handles.
+ */
+static hg_return_t
+hg_bulk_serialize_handles(
+        char **buf_ptr,
+        ssize_t *buf_size_left,
+        struct hg_bulk *hg_bulk,
+        na_class_t *na_class,
+        na_mem_handle_t *na_mem_handles
+        );
+
+/**
+ * Deserialize NA memory handles, skip them if na_mem_handles is NULL.
+ */
+static hg_return_t
+hg_bulk_deserialize_handles(
+        const char **buf_ptr,
+        ssize_t *buf_size_left,
+        struct hg_bulk *hg_bulk,
+        na_class_t *na_class,
+        na_mem_handle_t *na_mem_handles
+        );
+
+/**
+ * Get addr string sent with rail handles.
+ */
+static const char *
+hg_bulk_get_rail_addr_string(
+        struct hg_bulk *hg_bulk,
+        unsigned int rail
+        );
+
 /**
  * Create handle.
  */
@@ -168,19 +348,103 @@ hg_bulk_transfer_cb(
 static hg_return_t
 hg_bulk_transfer_pieces(
         na_bulk_op_t na_bulk_op,
+        na_class_t *na_class,
+        na_context_t *na_context,
         na_addr_t origin_addr,
         struct hg_bulk *hg_bulk_origin,
+        na_mem_handle_t *origin_mem_handles,
         hg_size_t origin_segment_start_index,
         hg_size_t origin_segment_start_offset,
         struct hg_bulk *hg_bulk_local,
+        na_mem_handle_t *local_mem_handles,
         hg_size_t local_segment_start_index,
         hg_size_t local_segment_start_offset,
         hg_size_t size,
         hg_bool_t scatter_gather,
         struct hg_bulk_op_id *hg_bulk_op_id,
+        na_op_id_t *na_op_ids,
         unsigned int *na_op_count
         );
 
+/**
+ * Create op ID.
+ */
+static struct hg_bulk_op_id *
+hg_bulk_op_id_create(
+        hg_context_t *context,
+        hg_cb_t callback,
+        void *arg,
+        hg_bulk_op_t op,
+        struct hg_bulk *hg_bulk_origin,
+        struct hg_bulk *hg_bulk_local,
+        hg_bool_t is_self
+        );
+
+/**
+ * Split transfer into weighted stripes, one per usable rail.
+ */
+static unsigned int
+hg_bulk_get_stripes(
+        struct hg_class *hg_class,
+        struct hg_bulk *hg_bulk_origin,
+        struct hg_bulk *hg_bulk_local,
+        hg_size_t size,
+        struct hg_bulk_stripe *stripes
+        );
+
+/**
+ * Transfer data striped across NA rails.
+ */
+static hg_return_t
+hg_bulk_transfer_rails(
+        hg_context_t *context,
+        hg_cb_t callback,
+        void *arg,
+        hg_bulk_op_t op,
+        na_bulk_op_t na_bulk_op,
+        na_addr_t na_origin_addr,
+        struct hg_bulk *hg_bulk_origin,
+        hg_size_t origin_offset,
+        struct hg_bulk *hg_bulk_local,
+        hg_size_t local_offset,
+        struct hg_bulk_stripe *stripes,
+        unsigned int stripe_count,
+        hg_op_id_t *op_id
+        );
+
+/**
+ * Rail addr lookup callback.
+ */
+static int
+hg_bulk_rail_lookup_cb(
+        const struct na_cb_info *callback_info
+        );
+
+/**
+ * Issue NA operations of all stripes once rail addrs are resolved.
+ */
+static void
+hg_bulk_transfer_stripes(
+        struct hg_bulk_op_id *hg_bulk_op_id
+        );
+
+/**
+ * Account for NA operations that will not be issued.
+ */
+static void
+hg_bulk_transfer_skip(
+        struct hg_bulk_op_id *hg_bulk_op_id,
+        unsigned int count
+        );
+
+/**
+ * Cancel NA operations of all stripes.
+ */
+static hg_return_t
+hg_bulk_cancel_stripes(
+        struct hg_bulk_op_id *hg_bulk_op_id
+        );
+
 /**
  * Transfer data.
  */
@@ -353,10 +617,9 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
 {
     struct hg_bulk *hg_bulk = NULL;
     hg_return_t ret = HG_SUCCESS;
-    na_return_t na_ret;
     na_class_t *na_class = HG_Core_class_get_na(hg_class);
     hg_bool_t use_register_segment = (hg_bool_t)
-        (na_class->mem_handle_create_segments && count > 1);
+        (hg_bulk_rails_use_segments(hg_class) && count > 1);
     unsigned int i;
 
     hg_bulk = (struct hg_bulk *) malloc(sizeof(struct hg_bulk));
@@ -375,6 +638,8 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
     hg_bulk->segment_alloc = (!buf_ptrs);
     hg_bulk->flags = flags;
     hg_bulk->eager_mode = HG_FALSE;
+    hg_bulk->rails = NULL;
+    hg_bulk->rail_count = 0;
     hg_atomic_set32(&hg_bulk->ref_count, 1);
 
     /* Allocate segments */
@@ -420,6 +685,137 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
 
 
     /* Create and register NA memory handles */
+    ret = hg_bulk_register(hg_bulk, na_class, use_register_segment,
+        hg_bulk->na_mem_handles);
+    if (ret != HG_SUCCESS)
+        goto done;
+
+    /* Memory must also be registered with every additional rail */
+    if (hg_core_get_rail_count(hg_class) > 1) {
+        hg_bulk->rail_count = hg_core_get_rail_count(hg_class) - 1;
+        hg_bulk->rails = (struct hg_bulk_rail *) malloc(
+            hg_bulk->rail_count * sizeof(struct hg_bulk_rail));
+        if (!hg_bulk->rails) {
+            HG_LOG_ERROR("Could not allocate rail array");
+            hg_bulk->rail_count = 0;
+            ret = HG_NOMEM_ERROR;
+            goto done;
+        }
+        memset(hg_bulk->rails, 0,
+            hg_bulk->rail_count * sizeof(struct hg_bulk_rail));
+
+        for (i = 0; i < hg_bulk->rail_count; i++) {
+            struct hg_bulk_rail *hg_bulk_rail = &hg_bulk->rails[i];
+            unsigned int j;
+
+            hg_bulk_rail->na_mem_handles = (na_mem_handle_t *) malloc(
+                hg_bulk->na_mem_handle_count * sizeof(na_mem_handle_t));
+            if (!hg_bulk_rail->na_mem_handles) {
+                HG_LOG_ERROR("Could not allocate mem handle array");
+                ret = HG_NOMEM_ERROR;
+                goto done;
+            }
+            for (j = 0; j < hg_bulk->na_mem_handle_count; j++)
+                hg_bulk_rail->na_mem_handles[j] = NA_MEM_HANDLE_NULL;
+
+            ret = hg_bulk_register(hg_bulk,
+                hg_core_get_rail(hg_class, i + 1, NULL, NULL),
+                use_register_segment, hg_bulk_rail->na_mem_handles);
+            if (ret != HG_SUCCESS)
+                goto done;
+        }
+    }
+
+    *hg_bulk_ptr = hg_bulk;
+
+done:
+    if (ret != HG_SUCCESS) {
+        hg_bulk_free(hg_bulk);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_bulk_free(struct hg_bulk *hg_bulk)
+{
+    hg_return_t ret = HG_SUCCESS;
+    unsigned int i;
+
+    if (!hg_bulk) goto done;
+
+    if (hg_atomic_decr32(&hg_bulk->ref_count)) {
+        /* Cannot free yet */
+        goto done;
+    }
+
+    /* Unregister/free NA memory handles of additional rails */
+    for (i = 0; i < hg_bulk->rail_count; i++) {
+        if (hg_bulk->rails[i].na_mem_handles) {
+            hg_bulk_deregister(hg_bulk,
+                hg_core_get_rail(hg_bulk->hg_class, i + 1, NULL, NULL),
+                hg_bulk->rails[i].na_mem_handles);
+            free(hg_bulk->rails[i].na_mem_handles);
+        }
+        free(hg_bulk->rails[i].addr_string);
+    }
+    free(hg_bulk->rails);
+
+    if (hg_bulk->na_mem_handles) {
+        /* Unregister/free NA memory handles */
+        hg_bulk_deregister(hg_bulk, HG_Core_class_get_na(hg_bulk->hg_class),
+            hg_bulk->na_mem_handles);
+        free(hg_bulk->na_mem_handles);
+    }
+    hg_bulk->segment_published = HG_FALSE;
+
+    /* Free segments */
+    if (hg_bulk->segment_alloc) {
+        for (i = 0; i < hg_bulk->segment_count; i++) {
+            free((void *) hg_bulk->segments[i].address);
+        }
+    }
+    free(hg_bulk->segments);
+    free(hg_bulk);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_INLINE na_mem_handle_t *
+hg_bulk_get_rail_handles(struct hg_bulk *hg_bulk, unsigned int rail)
+{
+    if (!rail)
+        return hg_bulk->na_mem_handles;
+
+    return (rail <= hg_bulk->rail_count) ?
+        hg_bulk->rails[rail - 1].na_mem_handles : NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_bool_t
+hg_bulk_rails_use_segments(struct hg_class *hg_class)
+{
+    unsigned int i;
+
+    for (i = 0; i < hg_core_get_rail_count(hg_class); i++)
+        if (!hg_core_get_rail(hg_class, i, NULL, NULL)
+            ->mem_handle_create_segments)
+            return HG_FALSE;
+
+    return HG_TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_bulk_register(struct hg_bulk *hg_bulk, na_class_t *na_class,
+    hg_bool_t use_register_segment, na_mem_handle_t *na_mem_handles)
+{
+    hg_return_t ret = HG_SUCCESS;
+    na_return_t na_ret;
+    unsigned int i;
+
     for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
         /* na_mem_handle_count always <= segment_count */
         if (!hg_bulk->segments[i].address)
@@ -430,7 +826,7 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
                 (struct na_segment *) hg_bulk->segments;
             na_size_t na_segment_count = (na_size_t) hg_bulk->segment_count;
             na_ret = NA_Mem_handle_create_segments(na_class, na_segments,
-                na_segment_count, flags, &hg_bulk->na_mem_handles[i]);
+                na_segment_count, hg_bulk->flags, &na_mem_handles[i]);
             if (na_ret != NA_SUCCESS) {
                 HG_LOG_ERROR("NA_Mem_handle_create_segments failed");
                 ret = HG_NA_ERROR;
@@ -439,7 +835,8 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
         } else {
             na_ret = NA_Mem_handle_create(na_class,
                 (void *) hg_bulk->segments[i].address,
-                hg_bulk->segments[i].size, flags, &hg_bulk->na_mem_handles[i]);
+                hg_bulk->segments[i].size, hg_bulk->flags,
+                &na_mem_handles[i]);
             if (na_ret != NA_SUCCESS) {
                 HG_LOG_ERROR("NA_Mem_handle_create failed");
                 ret = HG_NA_ERROR;
@@ -447,7 +844,7 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
             }
         }
         /* Register segment */
-        na_ret = NA_Mem_register(na_class, hg_bulk->na_mem_handles[i]);
+        na_ret = NA_Mem_register(na_class, na_mem_handles[i]);
         if (na_ret != NA_SUCCESS) {
             HG_LOG_ERROR("NA_Mem_register failed");
             ret = HG_NA_ERROR;
@@ -455,82 +852,196 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
         }
     }
 
-    *hg_bulk_ptr = hg_bulk;
-
 done:
-    if (ret != HG_SUCCESS) {
-        hg_bulk_free(hg_bulk);
-    }
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+hg_bulk_deregister(struct hg_bulk *hg_bulk, na_class_t *na_class,
+    na_mem_handle_t *na_mem_handles)
+{
+    unsigned int i;
+
+    if (hg_bulk->segment_published) {
+        for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
+            na_return_t na_ret;
+
+            if (!na_mem_handles[i])
+                continue;
+
+            na_ret = NA_Mem_unpublish(na_class, na_mem_handles[i]);
+            if (na_ret != NA_SUCCESS) {
+                HG_LOG_ERROR("NA_Mem_unpublish failed");
+            }
+        }
+    }
+
+    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
+        na_return_t na_ret;
+
+        if (!na_mem_handles[i])
+            continue;
+
+        na_ret = NA_Mem_deregister(na_class, na_mem_handles[i]);
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_ERROR("NA_Mem_deregister failed");
+        }
+
+        na_ret = NA_Mem_handle_free(na_class, na_mem_handles[i]);
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_ERROR("NA_Mem_handle_free failed");
+        }
+        na_mem_handles[i] = NA_MEM_HANDLE_NULL;
+    }
+}
+
 /*---------------------------------------------------------------------------*/
 static hg_return_t
-hg_bulk_free(struct hg_bulk *hg_bulk)
+hg_bulk_publish(struct hg_bulk *hg_bulk, na_class_t *na_class,
+    na_mem_handle_t *na_mem_handles)
 {
     hg_return_t ret = HG_SUCCESS;
     unsigned int i;
 
-    if (!hg_bulk) goto done;
+    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
+        na_return_t na_ret;
 
-    if (hg_atomic_decr32(&hg_bulk->ref_count)) {
-        /* Cannot free yet */
-        goto done;
+        if (!na_mem_handles[i])
+            continue;
+
+        na_ret = NA_Mem_publish(na_class, na_mem_handles[i]);
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_ERROR("NA_Mem_publish failed");
+            ret = HG_NA_ERROR;
+            goto done;
+        }
     }
 
-    if (hg_bulk->na_mem_handles) {
-        na_class_t *na_class = HG_Core_class_get_na(hg_bulk->hg_class);
+done:
+    return ret;
+}
 
-        /* Unregister/free NA memory handles */
-        if (hg_bulk->segment_published) {
-            for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
-                na_return_t na_ret;
+/*---------------------------------------------------------------------------*/
+static hg_size_t
+hg_bulk_get_handles_serialize_size(struct hg_bulk *hg_bulk,
+    na_class_t *na_class, na_mem_handle_t *na_mem_handles)
+{
+    hg_size_t ret = 0;
+    unsigned int i;
 
-                if (!hg_bulk->na_mem_handles[i])
-                    continue;
+    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
+        na_size_t serialize_size = 0;
 
-                na_ret = NA_Mem_unpublish(na_class, hg_bulk->na_mem_handles[i]);
-                if (na_ret != NA_SUCCESS) {
-                    HG_LOG_ERROR("NA_Mem_unpublish failed");
-                }
-            }
-            hg_bulk->segment_published = HG_FALSE;
+        if (na_mem_handles[i]) {
+            serialize_size = NA_Mem_handle_get_serialize_size(na_class,
+                na_mem_handles[i]);
         }
+        ret += sizeof(serialize_size) + serialize_size;
+    }
 
-        for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
-            na_return_t na_ret;
+    return ret;
+}
 
-            if (!hg_bulk->na_mem_handles[i])
-                continue;
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_bulk_serialize_handles(char **buf_ptr, ssize_t *buf_size_left,
+    struct hg_bulk *hg_bulk, na_class_t *na_class,
+    na_mem_handle_t *na_mem_handles)
+{
+    hg_return_t ret = HG_SUCCESS;
+    unsigned int i;
 
-            na_ret = NA_Mem_deregister(na_class, hg_bulk->na_mem_handles[i]);
-            if (na_ret != NA_SUCCESS) {
-                HG_LOG_ERROR("NA_Mem_deregister failed");
-            }
+    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
+        na_size_t serialize_size = 0;
+        na_return_t na_ret;
 
-            na_ret = NA_Mem_handle_free(na_class, hg_bulk->na_mem_handles[i]);
+        if (na_mem_handles[i]) {
+            serialize_size = NA_Mem_handle_get_serialize_size(
+                na_class, na_mem_handles[i]);
+        }
+        ret = hg_bulk_serialize_memcpy(buf_ptr, buf_size_left, &serialize_size,
+            sizeof(serialize_size));
+        if (ret != HG_SUCCESS) {
+            HG_LOG_ERROR("Could not encode serialize size");
+            goto done;
+        }
+        if (na_mem_handles[i]) {
+            na_ret = NA_Mem_handle_serialize(na_class, *buf_ptr,
+                (na_size_t) *buf_size_left, na_mem_handles[i]);
             if (na_ret != NA_SUCCESS) {
-                HG_LOG_ERROR("NA_Mem_handle_free failed");
+                HG_LOG_ERROR("Could not serialize memory handle");
+                ret = HG_NA_ERROR;
+                goto done;
             }
-            hg_bulk->na_mem_handles[i] = NA_MEM_HANDLE_NULL;
+            *buf_ptr += serialize_size;
+            *buf_size_left -= (ssize_t) serialize_size;
         }
-
-        free(hg_bulk->na_mem_handles);
     }
 
-    /* Free segments */
-    if (hg_bulk->segment_alloc) {
-        for (i = 0; i < hg_bulk->segment_count; i++) {
-            free((void *) hg_bulk->segments[i].address);
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_bulk_deserialize_handles(const char **buf_ptr, ssize_t *buf_size_left,
+    struct hg_bulk *hg_bulk, na_class_t *na_class,
+    na_mem_handle_t *na_mem_handles)
+{
+    hg_return_t ret = HG_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
+        na_size_t serialize_size;
+        na_return_t na_ret;
+
+        ret = hg_bulk_deserialize_memcpy(buf_ptr, buf_size_left,
+            &serialize_size, sizeof(serialize_size));
+        if (ret != HG_SUCCESS) {
+            HG_LOG_ERROR("Could not decode serialize size");
+            goto done;
+        }
+        if (serialize_size && na_mem_handles) {
+            na_ret = NA_Mem_handle_deserialize(na_class, &na_mem_handles[i],
+                *buf_ptr, (na_size_t) *buf_size_left);
+            if (na_ret != NA_SUCCESS) {
+                HG_LOG_ERROR("Could not deserialize memory handle");
+                ret = HG_NA_ERROR;
+                goto done;
+            }
+        }
+        if (serialize_size) {
+            if ((*buf_size_left -= (ssize_t) serialize_size) < 0) {
+                HG_LOG_ERROR("Buffer size too small");
+                ret = HG_SIZE_ERROR;
+                goto done;
+            }
+            *buf_ptr += serialize_size;
+        } else if (na_mem_handles) {
+            na_mem_handles[i] = NA_MEM_HANDLE_NULL;
         }
     }
-    free(hg_bulk->segments);
-    free(hg_bulk);
 
 done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static const char *
+hg_bulk_get_rail_addr_string(struct hg_bulk *hg_bulk, unsigned int rail)
+{
+    const char *self_string = NULL;
+
+    /* Forwarded handles keep the addr of their origin */
+    if (hg_bulk->rails[rail - 1].addr_string)
+        return hg_bulk->rails[rail - 1].addr_string;
+
+    hg_core_get_rail(hg_bulk->hg_class, rail, NULL, &self_string);
+
+    return self_string;
+}
+
 /*---------------------------------------------------------------------------*/
 static void
 hg_bulk_offset_translate(struct hg_bulk *hg_bulk, hg_size_t offset,
@@ -638,12 +1149,15 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static hg_return_t
-hg_bulk_transfer_pieces(na_bulk_op_t na_bulk_op, na_addr_t origin_addr,
-    struct hg_bulk *hg_bulk_origin, hg_size_t origin_segment_start_index,
+hg_bulk_transfer_pieces(na_bulk_op_t na_bulk_op, na_class_t *na_class,
+    na_context_t *na_context, na_addr_t origin_addr,
+    struct hg_bulk *hg_bulk_origin, na_mem_handle_t *origin_mem_handles,
+    hg_size_t origin_segment_start_index,
     hg_size_t origin_segment_start_offset, struct hg_bulk *hg_bulk_local,
-    hg_size_t local_segment_start_index, hg_size_t local_segment_start_offset,
-    hg_size_t size, hg_bool_t scatter_gather,
-    struct hg_bulk_op_id *hg_bulk_op_id, unsigned int *na_op_count)
+    na_mem_handle_t *local_mem_handles, hg_size_t local_segment_start_index,
+    hg_size_t local_segment_start_offset, hg_size_t size,
+    hg_bool_t scatter_gather, struct hg_bulk_op_id *hg_bulk_op_id,
+    na_op_id_t *na_op_ids, unsigned int *na_op_count)
 {
     hg_size_t origin_segment_index = origin_segment_start_index;
     hg_size_t local_segment_index = local_segment_start_index;
@@ -674,16 +1188,15 @@ hg_bulk_transfer_pieces(na_bulk_op_t na_bulk_op, na_addr_t origin_addr,
         }
 
         if (na_bulk_op) {
-            na_ret = na_bulk_op(HG_Core_class_get_na(hg_bulk_op_id->hg_class),
-                hg_core_get_na_context(hg_bulk_op_id->context),
+            na_ret = na_bulk_op(na_class, na_context,
                 hg_bulk_transfer_cb, hg_bulk_op_id,
-                hg_bulk_local->na_mem_handles[local_segment_index],
+                local_mem_handles[local_segment_index],
                 hg_bulk_local->segments[local_segment_index].address,
                 local_segment_offset,
-                hg_bulk_origin->na_mem_handles[origin_segment_index],
+                origin_mem_handles[origin_segment_index],
                 hg_bulk_origin->segments[origin_segment_index].address,
                 origin_segment_offset, transfer_size, origin_addr,
-                &hg_bulk_op_id->na_op_ids[count]);
+                &na_op_ids[count]);
             if (na_ret != NA_SUCCESS) {
                 HG_LOG_ERROR("Could not transfer data");
                 ret = HG_NA_ERROR;
@@ -736,10 +1249,12 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
     struct hg_bulk_op_id *hg_bulk_op_id = NULL;
     na_bulk_op_t na_bulk_op;
     na_addr_t na_origin_addr = HG_Core_addr_get_na(origin_addr);
-    na_class_t *na_class = HG_Core_class_get_na(hg_bulk_origin->hg_class);
+    struct hg_class *hg_class = hg_bulk_origin->hg_class;
+    na_class_t *na_class = HG_Core_class_get_na(hg_class);
     hg_bool_t is_self = NA_Addr_is_self(na_class, na_origin_addr);
     hg_bool_t scatter_gather =
-        (na_class->mem_handle_create_segments && !is_self) ? HG_TRUE : HG_FALSE;
+        (hg_bulk_rails_use_segments(hg_class) && !is_self) ?
+            HG_TRUE : HG_FALSE;
     hg_return_t ret = HG_SUCCESS;
     unsigned int i;
 
@@ -759,29 +1274,39 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
             goto done;
     }
 
+    /* Stripe large transfers across NA rails */
+    if ((hg_core_get_rail_count(hg_class) > 1) && !is_self
+        && !hg_bulk_origin->eager_mode && (size >= HG_BULK_RAIL_MIN_SIZE)) {
+        struct hg_bulk_stripe *stripes;
+        unsigned int stripe_count;
+
+        stripes = (struct hg_bulk_stripe *) malloc(
+            hg_core_get_rail_count(hg_class) * sizeof(struct hg_bulk_stripe));
+        if (!stripes) {
+            HG_LOG_ERROR("Could not allocate stripes");
+            ret = HG_NOMEM_ERROR;
+            goto done;
+        }
+        stripe_count = hg_bulk_get_stripes(hg_class, hg_bulk_origin,
+            hg_bulk_local, size, stripes);
+        if (stripe_count > 1) {
+            ret = hg_bulk_transfer_rails(context, callback, arg, op,
+                na_bulk_op, na_origin_addr, hg_bulk_origin, origin_offset,
+                hg_bulk_local, local_offset, stripes, stripe_count, op_id);
+            goto done;
+        }
+        /* Only one usable rail */
+        free(stripes);
+    }
+
     /* Allocate op_id */
-    hg_bulk_op_id = (struct hg_bulk_op_id *) malloc(
-        sizeof(struct hg_bulk_op_id));
+    hg_bulk_op_id = hg_bulk_op_id_create(context, callback, arg, op,
+        hg_bulk_origin, hg_bulk_local, is_self);
     if (!hg_bulk_op_id) {
         HG_LOG_ERROR("Could not allocate HG Bulk operation ID");
         ret = HG_NOMEM_ERROR;
         goto done;
     }
-    hg_bulk_op_id->hg_class = hg_bulk_origin->hg_class;
-    hg_bulk_op_id->context = context;
-    hg_bulk_op_id->callback = callback;
-    hg_bulk_op_id->arg = arg;
-    hg_atomic_set32(&hg_bulk_op_id->completed, 0);
-    hg_atomic_set32(&hg_bulk_op_id->canceled, 0);
-    hg_bulk_op_id->op_count = 1; /* Default */
-    hg_atomic_set32(&hg_bulk_op_id->op_completed_count, 0);
-    hg_bulk_op_id->op = op;
-    hg_bulk_op_id->hg_bulk_origin = hg_bulk_origin;
-    hg_atomic_incr32(&hg_bulk_origin->ref_count); /* Increment ref count */
-    hg_bulk_op_id->hg_bulk_local = hg_bulk_local;
-    hg_atomic_incr32(&hg_bulk_local->ref_count); /* Increment ref count */
-    hg_bulk_op_id->na_op_ids = NULL;
-    hg_bulk_op_id->is_self = is_self;
 
     /* Translate bulk_offset */
     if (origin_offset && !scatter_gather)
@@ -795,11 +1320,11 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
 
     /* Figure out number of NA operations required */
     if (!scatter_gather) {
-        hg_bulk_transfer_pieces(NULL, NA_ADDR_NULL, hg_bulk_origin,
-            origin_segment_start_index, origin_segment_start_offset,
-            hg_bulk_local, local_segment_start_index,
-            local_segment_start_offset, size, HG_FALSE, NULL,
-            &hg_bulk_op_id->op_count);
+        hg_bulk_transfer_pieces(NULL, NULL, NULL, NA_ADDR_NULL,
+            hg_bulk_origin, NULL, origin_segment_start_index,
+            origin_segment_start_offset, hg_bulk_local, NULL,
+            local_segment_start_index, local_segment_start_offset, size,
+            HG_FALSE, NULL, NULL, &hg_bulk_op_id->op_count);
         if (!hg_bulk_op_id->op_count) {
             HG_LOG_ERROR("Could not get bulk op_count");
             ret = HG_INVALID_PARAM;
@@ -821,10 +1346,13 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
     if (op_id && op_id != HG_OP_ID_IGNORE) *op_id = (hg_op_id_t) hg_bulk_op_id;
 
     /* Do actual transfer */
-    ret = hg_bulk_transfer_pieces(na_bulk_op, na_origin_addr, hg_bulk_origin,
-        origin_segment_start_index, origin_segment_start_offset, hg_bulk_local,
-        local_segment_start_index, local_segment_start_offset, size,
-        scatter_gather, hg_bulk_op_id, NULL);
+    ret = hg_bulk_transfer_pieces(na_bulk_op, na_class,
+        hg_core_get_na_context(context), na_origin_addr, hg_bulk_origin,
+        hg_bulk_origin->na_mem_handles, origin_segment_start_index,
+        origin_segment_start_offset, hg_bulk_local,
+        hg_bulk_local->na_mem_handles, local_segment_start_index,
+        local_segment_start_offset, size, scatter_gather, hg_bulk_op_id,
+        hg_bulk_op_id->na_op_ids, NULL);
     if (ret != HG_SUCCESS) {
         HG_LOG_ERROR("Could not transfer data pieces");
         goto done;
@@ -838,6 +1366,340 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static struct hg_bulk_op_id *
+hg_bulk_op_id_create(hg_context_t *context, hg_cb_t callback, void *arg,
+    hg_bulk_op_t op, struct hg_bulk *hg_bulk_origin,
+    struct hg_bulk *hg_bulk_local, hg_bool_t is_self)
+{
+    struct hg_bulk_op_id *hg_bulk_op_id;
+
+    hg_bulk_op_id = (struct hg_bulk_op_id *) malloc(
+        sizeof(struct hg_bulk_op_id));
+    if (!hg_bulk_op_id)
+        goto done;
+    hg_bulk_op_id->hg_class = hg_bulk_origin->hg_class;
+    hg_bulk_op_id->context = context;
+    hg_bulk_op_id->callback = callback;
+    hg_bulk_op_id->arg = arg;
+    hg_atomic_set32(&hg_bulk_op_id->completed, 0);
+    hg_atomic_set32(&hg_bulk_op_id->canceled, 0);
+    hg_bulk_op_id->op_count = 1; /* Default */
+    hg_atomic_set32(&hg_bulk_op_id->op_completed_count, 0);
+    hg_bulk_op_id->op = op;
+    hg_bulk_op_id->hg_bulk_origin = hg_bulk_origin;
+    hg_atomic_incr32(&hg_bulk_origin->ref_count); /* Increment ref count */
+    hg_bulk_op_id->hg_bulk_local = hg_bulk_local;
+    hg_atomic_incr32(&hg_bulk_local->ref_count); /* Increment ref count */
+    hg_bulk_op_id->na_op_ids = NULL;
+    hg_bulk_op_id->is_self = is_self;
+    hg_bulk_op_id->ret = HG_SUCCESS;
+    hg_bulk_op_id->na_bulk_op = NULL;
+    hg_bulk_op_id->na_origin_addr = NA_ADDR_NULL;
+    hg_bulk_op_id->scatter_gather = HG_FALSE;
+    hg_bulk_op_id->stripes = NULL;
+    hg_bulk_op_id->stripe_count = 0;
+    hg_atomic_set32(&hg_bulk_op_id->lookup_count, 0);
+
+done:
+    return hg_bulk_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+hg_bulk_get_stripes(struct hg_class *hg_class, struct hg_bulk *hg_bulk_origin,
+    struct hg_bulk *hg_bulk_local, hg_size_t size,
+    struct hg_bulk_stripe *stripes)
+{
+    hg_uint64_t total_weight = 0;
+    hg_size_t offset = 0;
+    unsigned int count = 0, i, j;
+
+    /* Select rails on which both handles are registered, stripe size is
+     * temporarily used to store the rail weight */
+    for (i = 0; i < hg_core_get_rail_count(hg_class); i++) {
+        hg_uint32_t weight;
+
+        hg_core_get_rail(hg_class, i, &weight, NULL);
+        if (!weight)
+            continue;
+        if (i > 0 && (!hg_bulk_get_rail_handles(hg_bulk_origin, i)
+            || !hg_bulk_origin->rails[i - 1].addr_string
+            || !hg_bulk_get_rail_handles(hg_bulk_local, i)))
+            continue;
+
+        stripes[count].rail = i;
+        stripes[count].size = weight;
+        total_weight += weight;
+        count++;
+    }
+    if (count < 2)
+        return count;
+
+    /* Weighted chunks, last rail takes the remainder */
+    for (i = 0; i < count; i++) {
+        hg_size_t stripe_size;
+
+        if (i == count - 1)
+            stripe_size = size - offset;
+        else {
+            stripe_size = (hg_size_t) ((double) size
+                * (double) stripes[i].size / (double) total_weight);
+            stripe_size -= stripe_size % HG_BULK_RAIL_ALIGN;
+        }
+        stripes[i].offset = offset;
+        stripes[i].size = stripe_size;
+        offset += stripe_size;
+    }
+
+    /* Remove empty stripes */
+    for (i = 0, j = 0; i < count; i++)
+        if (stripes[i].size)
+            stripes[j++] = stripes[i];
+
+    return j;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_bulk_transfer_rails(hg_context_t *context, hg_cb_t callback, void *arg,
+    hg_bulk_op_t op, na_bulk_op_t na_bulk_op, na_addr_t na_origin_addr,
+    struct hg_bulk *hg_bulk_origin, hg_size_t origin_offset,
+    struct hg_bulk *hg_bulk_local, hg_size_t local_offset,
+    struct hg_bulk_stripe *stripes, unsigned int stripe_count,
+    hg_op_id_t *op_id)
+{
+    struct hg_class *hg_class = hg_bulk_origin->hg_class;
+    struct hg_bulk_op_id *hg_bulk_op_id = NULL;
+    unsigned int op_count = 0, i;
+    hg_return_t ret = HG_SUCCESS;
+
+    hg_bulk_op_id = hg_bulk_op_id_create(context, callback, arg, op,
+        hg_bulk_origin, hg_bulk_local, HG_FALSE);
+    if (!hg_bulk_op_id) {
+        HG_LOG_ERROR("Could not allocate HG Bulk operation ID");
+        free(stripes);
+        ret = HG_NOMEM_ERROR;
+        goto done;
+    }
+    hg_bulk_op_id->na_bulk_op = na_bulk_op;
+    hg_bulk_op_id->na_origin_addr = na_origin_addr;
+    hg_bulk_op_id->scatter_gather = hg_bulk_rails_use_segments(hg_class);
+    hg_bulk_op_id->stripes = stripes;
+    hg_bulk_op_id->stripe_count = stripe_count;
+
+    /* Figure out number of NA operations required by each stripe */
+    for (i = 0; i < stripe_count; i++) {
+        struct hg_bulk_stripe *stripe = &stripes[i];
+
+        stripe->hg_bulk_op_id = hg_bulk_op_id;
+        stripe->na_addr = NA_ADDR_NULL;
+        stripe->op_index = op_count;
+        if (hg_bulk_op_id->scatter_gather) {
+            stripe->origin_segment_index = 0;
+            stripe->origin_segment_offset = origin_offset + stripe->offset;
+            stripe->local_segment_index = 0;
+            stripe->local_segment_offset = local_offset + stripe->offset;
+            stripe->op_count = 1;
+        } else {
+            hg_bulk_offset_translate(hg_bulk_origin,
+                origin_offset + stripe->offset, &stripe->origin_segment_index,
+                &stripe->origin_segment_offset);
+            hg_bulk_offset_translate(hg_bulk_local,
+                local_offset + stripe->offset, &stripe->local_segment_index,
+                &stripe->local_segment_offset);
+            hg_bulk_transfer_pieces(NULL, NULL, NULL, NA_ADDR_NULL,
+                hg_bulk_origin, NULL, stripe->origin_segment_index,
+                stripe->origin_segment_offset, hg_bulk_local, NULL,
+                stripe->local_segment_index, stripe->local_segment_offset,
+                stripe->size, HG_FALSE, NULL, NULL, &stripe->op_count);
+        }
+        op_count += stripe->op_count;
+    }
+
+    /* Allocate memory for NA operation IDs */
+    hg_bulk_op_id->na_op_ids = malloc(sizeof(na_op_id_t) * op_count);
+    if (!hg_bulk_op_id->na_op_ids) {
+        HG_LOG_ERROR("Could not allocate memory for op_ids");
+        ret = HG_NOMEM_ERROR;
+        goto done;
+    }
+    for (i = 0; i < op_count; i++)
+        hg_bulk_op_id->na_op_ids[i] = NA_OP_ID_NULL;
+
+    /* One extra count is released once all stripes have been issued */
+    hg_bulk_op_id->op_count = op_count + 1;
+
+    /* Assign op_id */
+    if (op_id && op_id != HG_OP_ID_IGNORE) *op_id = (hg_op_id_t) hg_bulk_op_id;
+
+    /* Resolve origin addrs of rails, stripes are issued once the last
+     * lookup completes */
+    hg_atomic_set32(&hg_bulk_op_id->lookup_count, 1);
+    for (i = 0; i < stripe_count; i++) {
+        struct hg_bulk_stripe *stripe = &stripes[i];
+        const char *addr_string;
+        na_return_t na_ret;
+
+        if (!stripe->rail) {
+            stripe->na_addr = na_origin_addr;
+            continue;
+        }
+
+        addr_string = hg_bulk_origin->rails[stripe->rail - 1].addr_string;
+        stripe->na_addr = hg_core_rail_addr_find(hg_class, stripe->rail,
+            addr_string);
+        if (stripe->na_addr != NA_ADDR_NULL)
+            continue;
+
+        hg_atomic_incr32(&hg_bulk_op_id->lookup_count);
+        na_ret = NA_Addr_lookup(
+            hg_core_get_rail(hg_class, stripe->rail, NULL, NULL),
+            hg_core_get_rail_na_context(context, stripe->rail),
+            hg_bulk_rail_lookup_cb, stripe, addr_string, NA_OP_ID_IGNORE);
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_WARNING("Could not look up %s, using first rail",
+                addr_string);
+            hg_atomic_decr32(&hg_bulk_op_id->lookup_count);
+            stripe->rail = 0;
+            stripe->na_addr = na_origin_addr;
+        }
+    }
+    if (!hg_atomic_decr32(&hg_bulk_op_id->lookup_count))
+        hg_bulk_transfer_stripes(hg_bulk_op_id);
+
+done:
+    if (ret != HG_SUCCESS && hg_bulk_op_id) {
+        hg_bulk_free(hg_bulk_origin);
+        hg_bulk_free(hg_bulk_local);
+        free(hg_bulk_op_id->stripes);
+        free(hg_bulk_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_bulk_rail_lookup_cb(const struct na_cb_info *callback_info)
+{
+    struct hg_bulk_stripe *stripe = (struct hg_bulk_stripe *)
+        callback_info->arg;
+    struct hg_bulk_op_id *hg_bulk_op_id = stripe->hg_bulk_op_id;
+
+    if (callback_info->ret == NA_SUCCESS) {
+        stripe->na_addr = hg_core_rail_addr_insert(hg_bulk_op_id->hg_class,
+            stripe->rail,
+            hg_bulk_op_id->hg_bulk_origin->rails[stripe->rail - 1].addr_string,
+            callback_info->info.lookup.addr);
+    }
+    if (stripe->na_addr == NA_ADDR_NULL) {
+        /* Memory is also reachable through the first rail */
+        HG_LOG_WARNING("Could not look up addr of rail %u, using first rail",
+            stripe->rail);
+        stripe->rail = 0;
+        stripe->na_addr = hg_bulk_op_id->na_origin_addr;
+    }
+
+    if (!hg_atomic_decr32(&hg_bulk_op_id->lookup_count))
+        hg_bulk_transfer_stripes(hg_bulk_op_id);
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_bulk_transfer_stripes(struct hg_bulk_op_id *hg_bulk_op_id)
+{
+    struct hg_bulk *hg_bulk_origin = hg_bulk_op_id->hg_bulk_origin;
+    struct hg_bulk *hg_bulk_local = hg_bulk_op_id->hg_bulk_local;
+    unsigned int i;
+
+    for (i = 0; i < hg_bulk_op_id->stripe_count; i++) {
+        struct hg_bulk_stripe *stripe = &hg_bulk_op_id->stripes[i];
+        unsigned int count = 0;
+        hg_return_t ret;
+
+        if (!hg_atomic_get32(&hg_bulk_op_id->canceled)) {
+            ret = hg_bulk_transfer_pieces(hg_bulk_op_id->na_bulk_op,
+                hg_core_get_rail(hg_bulk_op_id->hg_class, stripe->rail, NULL,
+                    NULL),
+                hg_core_get_rail_na_context(hg_bulk_op_id->context,
+                    stripe->rail),
+                stripe->na_addr, hg_bulk_origin,
+                hg_bulk_get_rail_handles(hg_bulk_origin, stripe->rail),
+                stripe->origin_segment_index, stripe->origin_segment_offset,
+                hg_bulk_local,
+                hg_bulk_get_rail_handles(hg_bulk_local, stripe->rail),
+                stripe->local_segment_index, stripe->local_segment_offset,
+                stripe->size, hg_bulk_op_id->scatter_gather, hg_bulk_op_id,
+                &hg_bulk_op_id->na_op_ids[stripe->op_index], &count);
+            if (ret != HG_SUCCESS) {
+                HG_LOG_ERROR("Could not transfer data pieces on rail %u",
+                    stripe->rail);
+                hg_bulk_op_id->ret = ret;
+            }
+        }
+
+        /* Operations that were not issued will never complete */
+        hg_bulk_transfer_skip(hg_bulk_op_id, stripe->op_count - count);
+    }
+
+    /* Release extra count */
+    hg_bulk_transfer_skip(hg_bulk_op_id, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_bulk_transfer_skip(struct hg_bulk_op_id *hg_bulk_op_id, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+        if ((unsigned int) hg_atomic_incr32(&hg_bulk_op_id->op_completed_count)
+            == hg_bulk_op_id->op_count)
+            hg_bulk_complete(hg_bulk_op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_bulk_cancel_stripes(struct hg_bulk_op_id *hg_bulk_op_id)
+{
+    hg_uint32_t i;
+    unsigned int j;
+    hg_return_t ret = HG_SUCCESS;
+
+    /* Stripes that are still waiting for addr lookups are not issued */
+    hg_atomic_set32(&hg_bulk_op_id->canceled, 1);
+
+    /* Cancel NA operations issued on each rail */
+    for (i = 0; i < hg_bulk_op_id->stripe_count; i++) {
+        struct hg_bulk_stripe *stripe = &hg_bulk_op_id->stripes[i];
+
+        for (j = stripe->op_index; j < stripe->op_index + stripe->op_count;
+            j++) {
+            na_return_t na_ret;
+
+            if (hg_bulk_op_id->na_op_ids[j] == NA_OP_ID_NULL)
+                continue;
+
+            na_ret = NA_Cancel(
+                hg_core_get_rail(hg_bulk_op_id->hg_class, stripe->rail, NULL,
+                    NULL),
+                hg_core_get_rail_na_context(hg_bulk_op_id->context,
+                    stripe->rail),
+                hg_bulk_op_id->na_op_ids[j]);
+            if (na_ret != NA_SUCCESS) {
+                HG_LOG_ERROR("Could not cancel op id");
+                ret = HG_NA_ERROR;
+                goto done;
+            }
+        }
+    }
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static hg_return_t
 hg_bulk_complete(struct hg_bulk_op_id *hg_bulk_op_id)
@@ -888,7 +1750,7 @@ hg_bulk_trigger_entry(struct hg_bulk_op_id *hg_bulk_op_id)
         hg_cb_info.arg = hg_bulk_op_id->arg;
         hg_cb_info.ret =
             hg_atomic_get32(&hg_bulk_op_id->canceled) ? HG_CANCELED :
-                HG_SUCCESS;
+                hg_bulk_op_id->ret;
         hg_cb_info.type = HG_CB_BULK;
         hg_cb_info.info.bulk.op = hg_bulk_op_id->op;
         hg_cb_info.info.bulk.origin_handle =
@@ -912,6 +1774,7 @@ hg_bulk_trigger_entry(struct hg_bulk_op_id *hg_bulk_op_id)
     }
 
     /* Free op */
+    free(hg_bulk_op_id->stripes);
     free(hg_bulk_op_id->na_op_ids);
     free(hg_bulk_op_id);
 
@@ -1094,15 +1957,23 @@ HG_Bulk_get_serialize_size(hg_bulk_t handle, hg_bool_t request_eager)
 
     /* NA mem handles */
     ret += sizeof(hg_bulk->na_mem_handle_count);
-    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
-        na_size_t serialize_size = 0;
+    ret += hg_bulk_get_handles_serialize_size(hg_bulk,
+        HG_Core_class_get_na(hg_bulk->hg_class), hg_bulk->na_mem_handles);
 
-        if (hg_bulk->na_mem_handles[i]) {
-            serialize_size = NA_Mem_handle_get_serialize_size(
-                HG_Core_class_get_na(hg_bulk->hg_class),
-                hg_bulk->na_mem_handles[i]);
-        }
-        ret += sizeof(serialize_size) + serialize_size;
+    /* NA mem handles and origin addr of additional rails */
+    if (hg_bulk->rail_count)
+        ret += sizeof(hg_bulk->rail_count);
+    for (i = 0; i < hg_bulk->rail_count; i++) {
+        const char *addr_string = hg_bulk_get_rail_addr_string(hg_bulk, i + 1);
+        hg_uint32_t addr_string_len = 0;
+
+        if (hg_bulk->rails[i].na_mem_handles && addr_string)
+            addr_string_len = (hg_uint32_t) strlen(addr_string) + 1;
+        ret += sizeof(addr_string_len) + addr_string_len;
+        if (addr_string_len)
+            ret += hg_bulk_get_handles_serialize_size(hg_bulk,
+                hg_core_get_rail(hg_bulk->hg_class, i + 1, NULL, NULL),
+                hg_bulk->rails[i].na_mem_handles);
     }
 
     /* Eager mode */
@@ -1125,6 +1996,7 @@ HG_Bulk_serialize(void *buf, hg_size_t buf_size, hg_bool_t request_eager,
     hg_return_t ret = HG_SUCCESS;
     hg_bool_t eager_mode;
     na_class_t *na_class;
+    hg_uint8_t flags;
     hg_uint32_t i;
 
     if (!hg_bulk) {
@@ -1138,25 +2010,27 @@ HG_Bulk_serialize(void *buf, hg_size_t buf_size, hg_bool_t request_eager,
 
     /* Publish handle at this point if not published yet */
     if (!hg_bulk->segment_published) {
-        for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
-            na_return_t na_ret;
-
-            if (!hg_bulk->na_mem_handles[i])
+        ret = hg_bulk_publish(hg_bulk, na_class, hg_bulk->na_mem_handles);
+        if (ret != HG_SUCCESS)
+            goto done;
+        for (i = 0; i < hg_bulk->rail_count; i++) {
+            if (!hg_bulk->rails[i].na_mem_handles)
                 continue;
-
-            na_ret = NA_Mem_publish(na_class, hg_bulk->na_mem_handles[i]);
-            if (na_ret != NA_SUCCESS) {
-                HG_LOG_ERROR("NA_Mem_publish failed");
-                ret = HG_NA_ERROR;
+            ret = hg_bulk_publish(hg_bulk,
+                hg_core_get_rail(hg_bulk->hg_class, i + 1, NULL, NULL),
+                hg_bulk->rails[i].na_mem_handles);
+            if (ret != HG_SUCCESS)
                 goto done;
-            }
         }
         hg_bulk->segment_published = HG_TRUE;
     }
 
     /* Add the permission flags */
-    ret = hg_bulk_serialize_memcpy(&buf_ptr, &buf_size_left,
-        &hg_bulk->flags, sizeof(hg_bulk->flags));
+    flags = hg_bulk->flags;
+    if (hg_bulk->rail_count)
+        flags |= HG_BULK_SERIALIZE_RAILS;
+    ret = hg_bulk_serialize_memcpy(&buf_ptr, &buf_size_left, &flags,
+        sizeof(flags));
     if (ret != HG_SUCCESS) {
         HG_LOG_ERROR("Could not encode permission flags");
         goto done;
@@ -1197,31 +2071,48 @@ HG_Bulk_serialize(void *buf, hg_size_t buf_size, hg_bool_t request_eager,
     }
 
     /* Add the NA memory handles */
-    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
-        na_size_t serialize_size = 0;
-        na_return_t na_ret;
+    ret = hg_bulk_serialize_handles(&buf_ptr, &buf_size_left, hg_bulk,
+        na_class, hg_bulk->na_mem_handles);
+    if (ret != HG_SUCCESS)
+        goto done;
 
-        if (hg_bulk->na_mem_handles[i]) {
-            serialize_size = NA_Mem_handle_get_serialize_size(
-                na_class, hg_bulk->na_mem_handles[i]);
+    /* Add the number of additional rails */
+    if (hg_bulk->rail_count) {
+        ret = hg_bulk_serialize_memcpy(&buf_ptr, &buf_size_left,
+            &hg_bulk->rail_count, sizeof(hg_bulk->rail_count));
+        if (ret != HG_SUCCESS) {
+            HG_LOG_ERROR("Could not encode rail count");
+            goto done;
         }
-        ret = hg_bulk_serialize_memcpy(&buf_ptr, &buf_size_left, &serialize_size,
-            sizeof(serialize_size));
+    }
+
+    /* Add the origin addr and NA memory handles of each rail, a rail
+     * without addr cannot be used by the target */
+    for (i = 0; i < hg_bulk->rail_count; i++) {
+        const char *addr_string = hg_bulk_get_rail_addr_string(hg_bulk, i + 1);
+        hg_uint32_t addr_string_len = 0;
+
+        if (hg_bulk->rails[i].na_mem_handles && addr_string)
+            addr_string_len = (hg_uint32_t) strlen(addr_string) + 1;
+        ret = hg_bulk_serialize_memcpy(&buf_ptr, &buf_size_left,
+            &addr_string_len, sizeof(addr_string_len));
         if (ret != HG_SUCCESS) {
-            HG_LOG_ERROR("Could not encode serialize size");
+            HG_LOG_ERROR("Could not encode rail addr length");
             goto done;
         }
-        if (hg_bulk->na_mem_handles[i]) {
-            na_ret = NA_Mem_handle_serialize(na_class, buf_ptr,
-                (na_size_t) buf_size_left, hg_bulk->na_mem_handles[i]);
-            if (na_ret != NA_SUCCESS) {
-                HG_LOG_ERROR("Could not serialize memory handle");
-                ret = HG_NA_ERROR;
-                goto done;
-            }
-            buf_ptr += serialize_size;
-            buf_size_left -= (ssize_t) serialize_size;
+        if (!addr_string_len)
+            continue;
+        ret = hg_bulk_serialize_memcpy(&buf_ptr, &buf_size_left, addr_string,
+            addr_string_len);
+        if (ret != HG_SUCCESS) {
+            HG_LOG_ERROR("Could not encode rail addr");
+            goto done;
         }
+        ret = hg_bulk_serialize_handles(&buf_ptr, &buf_size_left, hg_bulk,
+            hg_core_get_rail(hg_bulk->hg_class, i + 1, NULL, NULL),
+            hg_bulk->rails[i].na_mem_handles);
+        if (ret != HG_SUCCESS)
+            goto done;
     }
 
     /* Eager mode is used only when data is set to HG_BULK_READ_ONLY */
@@ -1264,6 +2155,8 @@ HG_Bulk_deserialize(hg_class_t *hg_class, hg_bulk_t *handle, const void *buf,
     struct hg_bulk *hg_bulk = NULL;
     const char *buf_ptr = (const char *) buf;
     ssize_t buf_size_left = (ssize_t) buf_size;
+    hg_uint32_t rail_count = 0;
+    hg_bool_t has_rails;
     hg_return_t ret = HG_SUCCESS;
     hg_uint32_t i;
 
@@ -1290,6 +2183,8 @@ HG_Bulk_deserialize(hg_class_t *hg_class, hg_bulk_t *handle, const void *buf,
         HG_LOG_ERROR("Could not decode permission flags");
         goto done;
     }
+    has_rails = (hg_bool_t) ((hg_bulk->flags & HG_BULK_SERIALIZE_RAILS) != 0);
+    hg_bulk->flags &= (hg_uint8_t) ~HG_BULK_SERIALIZE_RAILS;
 
     /* Get the total size of the segments */
     ret = hg_bulk_deserialize_memcpy(&buf_ptr, &buf_size_left,
@@ -1341,31 +2236,79 @@ HG_Bulk_deserialize(hg_class_t *hg_class, hg_bulk_t *handle, const void *buf,
         goto done;
     }
 
-    for (i = 0; i < hg_bulk->na_mem_handle_count; i++) {
-        na_size_t serialize_size;
-        na_return_t na_ret;
+    ret = hg_bulk_deserialize_handles(&buf_ptr, &buf_size_left, hg_bulk,
+        HG_Core_class_get_na(hg_bulk->hg_class), hg_bulk->na_mem_handles);
+    if (ret != HG_SUCCESS)
+        goto done;
 
+    /* Get the number of additional rails */
+    if (has_rails) {
         ret = hg_bulk_deserialize_memcpy(&buf_ptr, &buf_size_left,
-            &serialize_size, sizeof(serialize_size));
+            &rail_count, sizeof(rail_count));
         if (ret != HG_SUCCESS) {
-            HG_LOG_ERROR("Could not decode serialize size");
+            HG_LOG_ERROR("Could not decode rail count");
             goto done;
         }
-        if (serialize_size) {
-            na_ret = NA_Mem_handle_deserialize(
-                HG_Core_class_get_na(hg_bulk->hg_class),
-                &hg_bulk->na_mem_handles[i], buf_ptr,
-                (na_size_t) buf_size_left);
-            if (na_ret != NA_SUCCESS) {
-                HG_LOG_ERROR("Could not deserialize memory handle");
-                ret = HG_NA_ERROR;
+    }
+
+    /* Only keep rails that are also configured locally */
+    hg_bulk->rail_count = HG_BULK_MIN(rail_count,
+        hg_core_get_rail_count(hg_class) - 1);
+    if (hg_bulk->rail_count) {
+        hg_bulk->rails = (struct hg_bulk_rail *) malloc(
+            hg_bulk->rail_count * sizeof(struct hg_bulk_rail));
+        if (!hg_bulk->rails) {
+            HG_LOG_ERROR("Could not allocate rail array");
+            hg_bulk->rail_count = 0;
+            ret = HG_NOMEM_ERROR;
+            goto done;
+        }
+        memset(hg_bulk->rails, 0,
+            hg_bulk->rail_count * sizeof(struct hg_bulk_rail));
+    }
+
+    /* Get the origin addr and NA memory handles of each rail */
+    for (i = 0; i < rail_count; i++) {
+        struct hg_bulk_rail *hg_bulk_rail =
+            (i < hg_bulk->rail_count) ? &hg_bulk->rails[i] : NULL;
+        hg_uint32_t addr_string_len;
+
+        ret = hg_bulk_deserialize_memcpy(&buf_ptr, &buf_size_left,
+            &addr_string_len, sizeof(addr_string_len));
+        if (ret != HG_SUCCESS) {
+            HG_LOG_ERROR("Could not decode rail addr length");
+            goto done;
+        }
+        if (!addr_string_len)
+            continue;
+        if ((ssize_t) addr_string_len > buf_size_left
+            || buf_ptr[addr_string_len - 1] != '\0') {
+            HG_LOG_ERROR("Invalid rail addr");
+            ret = HG_SIZE_ERROR;
+            goto done;
+        }
+        if (hg_bulk_rail) {
+            hg_bulk_rail->addr_string = strdup(buf_ptr);
+            hg_bulk_rail->na_mem_handles = (na_mem_handle_t *) malloc(
+                hg_bulk->na_mem_handle_count * sizeof(na_mem_handle_t));
+            if (!hg_bulk_rail->addr_string || !hg_bulk_rail->na_mem_handles) {
+                HG_LOG_ERROR("Could not allocate rail handles");
+                ret = HG_NOMEM_ERROR;
                 goto done;
             }
-            buf_ptr += serialize_size;
-            buf_size_left -= (ssize_t) serialize_size;
-        } else {
-            hg_bulk->na_mem_handles[i] = NA_MEM_HANDLE_NULL;
+            memset(hg_bulk_rail->na_mem_handles, 0,
+                hg_bulk->na_mem_handle_count * sizeof(na_mem_handle_t));
         }
+        buf_ptr += addr_string_len;
+        buf_size_left -= (ssize_t) addr_string_len;
+
+        /* Handles of rails that are not configured locally are skipped */
+        ret = hg_bulk_deserialize_handles(&buf_ptr, &buf_size_left, hg_bulk,
+            (hg_bulk_rail) ?
+                hg_core_get_rail(hg_class, i + 1, NULL, NULL) : NULL,
+            (hg_bulk_rail) ? hg_bulk_rail->na_mem_handles : NULL);
+        if (ret != HG_SUCCESS)
+            goto done;
     }
 
     /* Get whether data is serialized or not */
@@ -1511,6 +2454,11 @@ HG_Bulk_cancel(hg_op_id_t op_id)
     if (HG_UTIL_TRUE != hg_atomic_cas32(&hg_bulk_op_id->completed, 1, 0)) {
         unsigned int i = 0;
 
+        if (hg_bulk_op_id->stripes) {
+            ret = hg_bulk_cancel_stripes(hg_bulk_op_id);
+            goto done;
+        }
+
         /* Cancel all NA operations issued */
         for (i = 0; i < hg_bulk_op_id->op_count; i++) {
             na_return_t na_ret;
@@ -17,6 +17,7 @@
 #include "mercury_error.h"
 
 #include "mercury_hash_table.h"
+#include "mercury_hash_string.h"
 #include "mercury_atomic.h"
 #include "mercury_queue.h"
 #include "mercury_list.h"
@@ -33,6 +34,7 @@
 #include "mercury_atomic_queue.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 /****************/
 /* Local Macros */
@@ -42,6 +44,8 @@
 #define HG_CORE_MASK_NBITS          8
 #define HG_CORE_ATOMIC_QUEUE_SIZE   1024
 #define HG_CORE_PENDING_INCR        256
+#define HG_CORE_RAIL_MAX_ADDR_NAME  256
+#define HG_CORE_RAIL_PROGRESS_TIMEOUT 1 /* ms, rails without poll fd */
 
 /* Remove warnings when routine does not use arguments */
 #if defined(__cplusplus)
@@ -59,9 +63,34 @@
 /* Private callback type for HG layer */
 typedef hg_return_t (*handle_create_cb_t)(hg_class_t *, hg_handle_t);
 
+/* NA rail (rail 0 is the class NA class used for RPCs) */
+struct hg_core_rail {
+    na_class_t *na_class;               /* NA class */
+    hg_uint32_t weight;                 /* Share of striped bulk data */
+    char *self_string;                  /* Self addr string (NULL if none) */
+    hg_hash_table_t *addr_map;          /* Looked up addrs by string */
+    hg_thread_spin_t addr_map_lock;     /* Addr map lock */
+};
+
+/* Cached remote addr of a rail */
+struct hg_core_rail_addr {
+    char *name;                         /* Addr string (key) */
+    na_addr_t na_addr;                  /* NA addr */
+};
+
+/* NA context of a rail */
+struct hg_core_rail_context {
+    struct hg_context *context;         /* HG context */
+    na_class_t *na_class;               /* NA class */
+    na_context_t *na_context;           /* NA context */
+    int na_poll_fd;                     /* NA poll descriptor */
+};
+
 /* HG class */
 struct hg_class {
     na_class_t *na_class;               /* NA class */
+    struct hg_core_rail *rails;         /* NA rails (NULL if single rail) */
+    unsigned int rail_count;            /* Number of NA rails */
     hg_hash_table_t *func_map;          /* Function map */
     hg_thread_spin_t func_map_lock;     /* Function map mutex */
     hg_atomic_int32_t request_tag;      /* Atomic used for tag generation */
@@ -81,6 +110,7 @@ struct hg_class {
 struct hg_context {
     struct hg_class *hg_class;                    /* HG class */
     na_context_t *na_context;                     /* NA context */
+    struct hg_core_rail_context *rail_contexts;   /* NA contexts of rails */
     hg_uint8_t id;                                /* Context ID */
     na_tag_t request_mask;                        /* Request tag mask */
     struct hg_poll_set *poll_set;                 /* Context poll set */
@@ -267,6 +297,17 @@ hg_core_init(
         na_class_t *na_init_class
         );
 
+/**
+ * Initialize additional NA rails.
+ */
+static hg_return_t
+hg_core_init_rails(
+        struct hg_class *hg_class,
+        na_class_t **na_classes,
+        const hg_uint32_t *weights,
+        unsigned int count
+        );
+
 /**
  * Finalize class.
  */
@@ -275,6 +316,14 @@ hg_core_finalize(
         struct hg_class *hg_class
         );
 
+/**
+ * Finalize additional NA rails.
+ */
+static void
+hg_core_finalize_rails(
+        struct hg_class *hg_class
+        );
+
 /**
  * Set handle create callback.
  */
@@ -292,6 +341,56 @@ hg_core_get_na_context(
         struct hg_context *context
         );
 
+/**
+ * Get number of NA rails.
+ */
+unsigned int
+hg_core_get_rail_count(
+        struct hg_class *hg_class
+        );
+
+/**
+ * Get NA class, weight and self addr string of rail.
+ */
+na_class_t *
+hg_core_get_rail(
+        struct hg_class *hg_class,
+        unsigned int rail,
+        hg_uint32_t *weight,
+        const char **self_string
+        );
+
+/**
+ * Get NA context of rail.
+ */
+na_context_t *
+hg_core_get_rail_na_context(
+        struct hg_context *context,
+        unsigned int rail
+        );
+
+/**
+ * Find previously looked up addr of rail.
+ */
+na_addr_t
+hg_core_rail_addr_find(
+        struct hg_class *hg_class,
+        unsigned int rail,
+        const char *name
+        );
+
+/**
+ * Cache addr of rail. Return cached addr, na_addr is freed if name was
+ * already present.
+ */
+na_addr_t
+hg_core_rail_addr_insert(
+        struct hg_class *hg_class,
+        unsigned int rail,
+        const char *name,
+        na_addr_t na_addr
+        );
+
 /**
  * Create addr.
  */
@@ -600,6 +699,18 @@ hg_core_completion_queue_notify_cb(
         );
 #endif
 
+/**
+ * Make progress on NA class/context and trigger NA callbacks.
+ */
+static int
+hg_core_progress_na_class(
+        struct hg_context *context,
+        na_class_t *na_class,
+        na_context_t *na_context,
+        unsigned int timeout,
+        hg_util_bool_t *progressed
+        );
+
 /**
  * Progress callback on NA layer when hg_core_progress_poll() is used.
  */
@@ -610,6 +721,25 @@ hg_core_progress_na_cb(
         hg_util_bool_t *progressed
         );
 
+/**
+ * Progress callback on NA rail when hg_core_progress_poll() is used.
+ */
+static int
+hg_core_progress_rail_cb(
+        void *arg,
+        unsigned int timeout,
+        hg_util_bool_t *progressed
+        );
+
+/**
+ * Make non-blocking progress on NA rails, used by hg_core_progress_na().
+ */
+static hg_return_t
+hg_core_progress_rails(
+        struct hg_context *context,
+        unsigned int *completed_count
+        );
+
 /**
  * Callback for HG poll progress that determines when it is safe to block.
  */
@@ -694,6 +824,26 @@ hg_core_int_hash(void *vlocation)
     return *((unsigned int *) vlocation);
 }
 
+/*---------------------------------------------------------------------------*/
+/**
+ * Equal function for rail addr map.
+ */
+static HG_INLINE int
+hg_core_string_equal(void *vlocation1, void *vlocation2)
+{
+    return (strcmp((const char *) vlocation1, (const char *) vlocation2) == 0);
+}
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Hash function for rail addr map.
+ */
+static HG_INLINE unsigned int
+hg_core_string_hash(void *vlocation)
+{
+    return hg_hash_string((const char *) vlocation);
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  * Free function for value in function map.
@@ -986,6 +1136,7 @@ hg_core_init(const char *na_info_string, hg_bool_t na_listen,
     }
     memset(hg_class, 0, sizeof(struct hg_class));
     hg_class->na_class = na_init_class;
+    hg_class->rail_count = 1;
     hg_class->na_ext_init = (na_init_class) ? HG_TRUE : HG_FALSE;
 
     /* Initialize NA */
@@ -1083,6 +1234,9 @@ hg_core_finalize(struct hg_class *hg_class)
     /* Destroy mutex */
     hg_thread_spin_destroy(&hg_class->func_map_lock);
 
+    /* Free rail addrs before NA classes go away */
+    hg_core_finalize_rails(hg_class);
+
     if (!hg_class->na_ext_init) {
         /* Finalize interface */
         if (NA_Finalize(hg_class->na_class) != NA_SUCCESS) {
@@ -1100,6 +1254,123 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_core_init_rails(struct hg_class *hg_class, na_class_t **na_classes,
+    const hg_uint32_t *weights, unsigned int count)
+{
+    hg_uint32_t total_weight = 0;
+    hg_return_t ret = HG_SUCCESS;
+    unsigned int i;
+
+    hg_class->rails = (struct hg_core_rail *) malloc(
+        count * sizeof(struct hg_core_rail));
+    if (!hg_class->rails) {
+        HG_LOG_ERROR("Could not allocate rails");
+        ret = HG_NOMEM_ERROR;
+        goto done;
+    }
+    memset(hg_class->rails, 0, count * sizeof(struct hg_core_rail));
+    hg_class->rail_count = count;
+
+    for (i = 0; i < count; i++) {
+        struct hg_core_rail *rail = &hg_class->rails[i];
+        char addr_string[HG_CORE_RAIL_MAX_ADDR_NAME];
+        na_size_t addr_string_len = HG_CORE_RAIL_MAX_ADDR_NAME;
+        na_addr_t self_addr = NA_ADDR_NULL;
+        na_return_t na_ret;
+
+        rail->na_class = na_classes[i];
+        rail->weight = (weights) ? weights[i] : 1;
+        total_weight += rail->weight;
+        hg_thread_spin_init(&rail->addr_map_lock);
+
+        /* Rail 0 reuses the RPC origin addr */
+        if (i == 0)
+            continue;
+
+        if (!rail->na_class) {
+            HG_LOG_ERROR("NULL NA class for rail %u", i);
+            ret = HG_INVALID_PARAM;
+            goto done;
+        }
+
+        rail->addr_map = hg_hash_table_new(hg_core_string_hash,
+            hg_core_string_equal);
+        if (!rail->addr_map) {
+            HG_LOG_ERROR("Could not create rail addr map");
+            ret = HG_NOMEM_ERROR;
+            goto done;
+        }
+
+        /* Self addr string is sent with bulk handles so that remote peers
+         * can reach memory through that rail */
+        na_ret = NA_Addr_self(rail->na_class, &self_addr);
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_WARNING("Could not get self addr of rail %u", i);
+            continue;
+        }
+        na_ret = NA_Addr_to_string(rail->na_class, addr_string,
+            &addr_string_len, self_addr);
+        NA_Addr_free(rail->na_class, self_addr);
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_WARNING("Could not convert self addr of rail %u", i);
+            continue;
+        }
+        rail->self_string = strdup(addr_string);
+        if (!rail->self_string) {
+            HG_LOG_ERROR("Could not duplicate addr string");
+            ret = HG_NOMEM_ERROR;
+            goto done;
+        }
+    }
+
+    if (!total_weight) {
+        HG_LOG_ERROR("At least one rail must have a non-zero weight");
+        ret = HG_INVALID_PARAM;
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_core_finalize_rails(struct hg_class *hg_class)
+{
+    unsigned int i;
+
+    if (!hg_class->rails)
+        return;
+
+    for (i = 0; i < hg_class->rail_count; i++) {
+        struct hg_core_rail *rail = &hg_class->rails[i];
+
+        if (rail->addr_map) {
+            hg_hash_table_iter_t iter;
+
+            /* Keys are owned by values */
+            hg_hash_table_iterate(rail->addr_map, &iter);
+            while (hg_hash_table_iter_has_more(&iter)) {
+                struct hg_core_rail_addr *rail_addr =
+                    (struct hg_core_rail_addr *) hg_hash_table_iter_next(
+                        &iter);
+
+                NA_Addr_free(rail->na_class, rail_addr->na_addr);
+                free(rail_addr->name);
+                free(rail_addr);
+            }
+            hg_hash_table_free(rail->addr_map);
+        }
+        free(rail->self_string);
+        hg_thread_spin_destroy(&rail->addr_map_lock);
+    }
+    free(hg_class->rails);
+    hg_class->rails = NULL;
+    hg_class->rail_count = 1;
+}
+
 /*---------------------------------------------------------------------------*/
 void
 hg_core_set_handle_create_callback(struct hg_class *hg_class,
@@ -1115,6 +1386,107 @@ hg_core_get_na_context(struct hg_context *context)
     return context->na_context;
 }
 
+/*---------------------------------------------------------------------------*/
+unsigned int
+hg_core_get_rail_count(struct hg_class *hg_class)
+{
+    return hg_class->rail_count;
+}
+
+/*---------------------------------------------------------------------------*/
+na_class_t *
+hg_core_get_rail(struct hg_class *hg_class, unsigned int rail,
+    hg_uint32_t *weight, const char **self_string)
+{
+    if (!hg_class->rails) {
+        if (weight) *weight = 1;
+        if (self_string) *self_string = NULL;
+        return hg_class->na_class;
+    }
+
+    if (weight) *weight = hg_class->rails[rail].weight;
+    if (self_string) *self_string = hg_class->rails[rail].self_string;
+    return hg_class->rails[rail].na_class;
+}
+
+/*---------------------------------------------------------------------------*/
+na_context_t *
+hg_core_get_rail_na_context(struct hg_context *context, unsigned int rail)
+{
+    return (context->rail_contexts) ?
+        context->rail_contexts[rail].na_context : context->na_context;
+}
+
+/*---------------------------------------------------------------------------*/
+na_addr_t
+hg_core_rail_addr_find(struct hg_class *hg_class, unsigned int rail,
+    const char *name)
+{
+    struct hg_core_rail *hg_core_rail = &hg_class->rails[rail];
+    struct hg_core_rail_addr *rail_addr;
+
+    hg_thread_spin_lock(&hg_core_rail->addr_map_lock);
+    rail_addr = (struct hg_core_rail_addr *) hg_hash_table_lookup(
+        hg_core_rail->addr_map, (hg_hash_table_key_t) name);
+    hg_thread_spin_unlock(&hg_core_rail->addr_map_lock);
+
+    return (rail_addr) ? rail_addr->na_addr : NA_ADDR_NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+na_addr_t
+hg_core_rail_addr_insert(struct hg_class *hg_class, unsigned int rail,
+    const char *name, na_addr_t na_addr)
+{
+    struct hg_core_rail *hg_core_rail = &hg_class->rails[rail];
+    struct hg_core_rail_addr *rail_addr, *new_rail_addr;
+
+    new_rail_addr = (struct hg_core_rail_addr *) malloc(
+        sizeof(struct hg_core_rail_addr));
+    if (!new_rail_addr) {
+        HG_LOG_ERROR("Could not allocate rail addr");
+        goto error;
+    }
+    new_rail_addr->name = strdup(name);
+    if (!new_rail_addr->name) {
+        HG_LOG_ERROR("Could not duplicate addr string");
+        free(new_rail_addr);
+        goto error;
+    }
+    new_rail_addr->na_addr = na_addr;
+
+    hg_thread_spin_lock(&hg_core_rail->addr_map_lock);
+    rail_addr = (struct hg_core_rail_addr *) hg_hash_table_lookup(
+        hg_core_rail->addr_map, (hg_hash_table_key_t) name);
+    if (!rail_addr) {
+        if (!hg_hash_table_insert(hg_core_rail->addr_map,
+            (hg_hash_table_key_t) new_rail_addr->name,
+            (hg_hash_table_value_t) new_rail_addr)) {
+            hg_thread_spin_unlock(&hg_core_rail->addr_map_lock);
+            HG_LOG_ERROR("Could not insert rail addr");
+            free(new_rail_addr->name);
+            free(new_rail_addr);
+            goto error;
+        }
+        rail_addr = new_rail_addr;
+        new_rail_addr = NULL;
+    }
+    hg_thread_spin_unlock(&hg_core_rail->addr_map_lock);
+
+    /* Concurrent lookup already cached that addr */
+    if (new_rail_addr) {
+        NA_Addr_free(hg_core_rail->na_class, na_addr);
+        free(new_rail_addr->name);
+        free(new_rail_addr);
+    }
+
+    return rail_addr->na_addr;
+
+error:
+    NA_Addr_free(hg_core_rail->na_class, na_addr);
+    return NA_ADDR_NULL;
+}
+
 /*---------------------------------------------------------------------------*/
 static struct hg_addr *
 hg_core_addr_create(struct hg_class *hg_class)
@@ -2372,11 +2744,10 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static int
-hg_core_progress_na_cb(void *arg, unsigned int timeout,
+hg_core_progress_na_class(struct hg_context *context, na_class_t *na_class,
+    na_context_t *na_context, unsigned int timeout,
     hg_util_bool_t *progressed)
 {
-    struct hg_context *context = (struct hg_context *) arg;
-    struct hg_class *hg_class = context->hg_class;
     unsigned int actual_count = 0;
     na_return_t na_ret;
     unsigned int completed_count = 0;
@@ -2384,7 +2755,7 @@ hg_core_progress_na_cb(void *arg, unsigned int timeout,
     int ret = HG_UTIL_SUCCESS;
 
     /* Check progress on NA (no need to call try_wait here) */
-    na_ret = NA_Progress(hg_class->na_class, context->na_context, timeout);
+    na_ret = NA_Progress(na_class, na_context, timeout);
     if (na_ret != NA_SUCCESS && na_ret != NA_TIMEOUT) {
         HG_LOG_ERROR("Could not make progress on NA");
         ret = HG_UTIL_FAIL;
@@ -2399,7 +2770,7 @@ hg_core_progress_na_cb(void *arg, unsigned int timeout,
     /* Trigger everything we can from NA, if something completed it will
      * be moved to the HG context completion queue */
     do {
-        na_ret = NA_Trigger(context->na_context, 0, 1, cb_ret, &actual_count);
+        na_ret = NA_Trigger(na_context, 0, 1, cb_ret, &actual_count);
 
         /* Return value of callback is completion count */
         completed_count += (unsigned int) cb_ret[0];
@@ -2421,6 +2792,64 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static int
+hg_core_progress_na_cb(void *arg, unsigned int timeout,
+    hg_util_bool_t *progressed)
+{
+    struct hg_context *context = (struct hg_context *) arg;
+
+    return hg_core_progress_na_class(context, context->hg_class->na_class,
+        context->na_context, timeout, progressed);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_core_progress_rail_cb(void *arg, unsigned int timeout,
+    hg_util_bool_t *progressed)
+{
+    struct hg_core_rail_context *rail_context =
+        (struct hg_core_rail_context *) arg;
+
+    return hg_core_progress_na_class(rail_context->context,
+        rail_context->na_class, rail_context->na_context, timeout, progressed);
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_core_progress_rails(struct hg_context *context,
+    unsigned int *completed_count)
+{
+    hg_return_t ret = HG_SUCCESS;
+    unsigned int i;
+
+    for (i = 1; i < context->hg_class->rail_count; i++) {
+        struct hg_core_rail_context *rail_context = &context->rail_contexts[i];
+        unsigned int actual_count = 0;
+        int cb_ret[1] = {0};
+        na_return_t na_ret;
+
+        na_ret = NA_Progress(rail_context->na_class, rail_context->na_context,
+            0);
+        if (na_ret != NA_SUCCESS && na_ret != NA_TIMEOUT) {
+            HG_LOG_ERROR("Could not make progress on NA rail %u", i);
+            ret = HG_NA_ERROR;
+            goto done;
+        }
+
+        do {
+            na_ret = NA_Trigger(rail_context->na_context, 0, 1, cb_ret,
+                &actual_count);
+
+            /* Return value of callback is completion count */
+            *completed_count += (unsigned int) cb_ret[0];
+        } while ((na_ret == NA_SUCCESS) && actual_count);
+    }
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static hg_return_t
 hg_core_progress_na(struct hg_context *context, unsigned int timeout)
@@ -2447,6 +2876,14 @@ hg_core_progress_na(struct hg_context *context, unsigned int timeout)
             completed_count += (unsigned int)cb_ret[0];
         } while ((na_ret == NA_SUCCESS) && actual_count);
 
+        /* Rails do not expose a poll descriptor, poll them as well */
+        if (context->rail_contexts) {
+            ret = hg_core_progress_rails(context, &completed_count);
+            if (ret != HG_SUCCESS)
+                goto done;
+            ret = HG_TIMEOUT;
+        }
+
         /* We can't only verify that the completion queue is not empty, we need
          * to check what was added to the completion queue, as the completion
          * queue may have been concurrently emptied */
@@ -2470,6 +2907,11 @@ hg_core_progress_na(struct hg_context *context, unsigned int timeout)
         else
             progress_timeout = 0;
 
+        /* Do not sleep on the first rail while others may complete */
+        if (context->rail_contexts
+            && progress_timeout > HG_CORE_RAIL_PROGRESS_TIMEOUT)
+            progress_timeout = HG_CORE_RAIL_PROGRESS_TIMEOUT;
+
         /* Otherwise try to make progress on NA */
         na_ret = NA_Progress(hg_class->na_class, context->na_context,
             progress_timeout);
@@ -2483,6 +2925,8 @@ hg_core_progress_na(struct hg_context *context, unsigned int timeout)
             /* Trigger NA callbacks and check whether we completed something */
             continue;
         } else if (na_ret == NA_TIMEOUT) {
+            if (context->rail_contexts && remaining > 0)
+                continue;
             break;
         } else {
             HG_LOG_ERROR("Could not make NA Progress");
@@ -2507,6 +2951,15 @@ hg_core_poll_try_wait_cb(void *arg)
         return NA_FALSE;
     }
 
+    if (hg_context->rail_contexts) {
+        unsigned int i;
+
+        for (i = 1; i < hg_context->hg_class->rail_count; i++)
+            if (!NA_Poll_try_wait(hg_context->rail_contexts[i].na_class,
+                hg_context->rail_contexts[i].na_context))
+                return NA_FALSE;
+    }
+
     return NA_Poll_try_wait(hg_context->hg_class->na_class,
         hg_context->na_context);
 }
@@ -2843,6 +3296,43 @@ done:
     return hg_class;
 }
 
+/*---------------------------------------------------------------------------*/
+hg_class_t *
+HG_Core_init_na_rails(na_class_t **na_classes, const hg_uint32_t *weights,
+    hg_uint32_t count)
+{
+    struct hg_class *hg_class = NULL;
+    hg_return_t ret = HG_SUCCESS;
+
+    if (!na_classes || !count || !na_classes[0]) {
+        HG_LOG_ERROR("NULL NA class");
+        ret = HG_INVALID_PARAM;
+        goto done;
+    }
+
+    hg_class = hg_core_init(NULL, HG_FALSE, na_classes[0]);
+    if (!hg_class) {
+        HG_LOG_ERROR("Cannot initialize HG core layer");
+        ret = HG_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    if (count > 1) {
+        ret = hg_core_init_rails(hg_class, na_classes, weights, count);
+        if (ret != HG_SUCCESS) {
+            HG_LOG_ERROR("Could not initialize NA rails");
+            goto done;
+        }
+    }
+
+done:
+    if (ret != HG_SUCCESS && hg_class) {
+        hg_core_finalize(hg_class);
+        hg_class = NULL;
+    }
+    return hg_class;
+}
+
 /*---------------------------------------------------------------------------*/
 hg_return_t
 HG_Core_finalize(hg_class_t *hg_class)
@@ -2965,7 +3455,9 @@ HG_Core_context_create(hg_class_t *hg_class)
 {
     hg_return_t ret = HG_SUCCESS;
     struct hg_context *context = NULL;
+    hg_bool_t use_poll;
     int na_poll_fd;
+    unsigned int i;
 #ifdef HG_HAS_SELF_FORWARD
     int fd;
 #endif
@@ -3046,9 +3538,56 @@ HG_Core_context_create(hg_class_t *hg_class)
     /* If NA plugin exposes fd, add it to poll set and use appropriate
      * progress function */
     na_poll_fd = NA_Poll_get_fd(hg_class->na_class, context->na_context);
-    if (na_poll_fd > 0) {
+    use_poll = (na_poll_fd > 0);
+
+    /* Create one NA context per additional rail */
+    if (hg_class->rails) {
+        context->rail_contexts = (struct hg_core_rail_context *) malloc(
+            hg_class->rail_count * sizeof(struct hg_core_rail_context));
+        if (!context->rail_contexts) {
+            HG_LOG_ERROR("Could not allocate rail contexts");
+            ret = HG_NOMEM_ERROR;
+            goto done;
+        }
+        memset(context->rail_contexts, 0,
+            hg_class->rail_count * sizeof(struct hg_core_rail_context));
+
+        for (i = 0; i < hg_class->rail_count; i++) {
+            struct hg_core_rail_context *rail_context =
+                &context->rail_contexts[i];
+
+            rail_context->context = context;
+            rail_context->na_class = hg_class->rails[i].na_class;
+            if (i == 0) {
+                rail_context->na_context = context->na_context;
+                rail_context->na_poll_fd = na_poll_fd;
+                continue;
+            }
+            rail_context->na_context =
+                NA_Context_create(rail_context->na_class);
+            if (!rail_context->na_context) {
+                HG_LOG_ERROR("Could not create NA context for rail %u", i);
+                ret = HG_NA_ERROR;
+                goto done;
+            }
+            rail_context->na_poll_fd = NA_Poll_get_fd(rail_context->na_class,
+                rail_context->na_context);
+
+            /* Poll set can only be used if every rail exposes a fd */
+            if (rail_context->na_poll_fd <= 0)
+                use_poll = HG_FALSE;
+        }
+    }
+
+    if (use_poll) {
         hg_poll_add(context->poll_set, na_poll_fd, HG_POLLIN,
             hg_core_progress_na_cb, context);
+        if (context->rail_contexts) {
+            for (i = 1; i < hg_class->rail_count; i++)
+                hg_poll_add(context->poll_set,
+                    context->rail_contexts[i].na_poll_fd, HG_POLLIN,
+                    hg_core_progress_rail_cb, &context->rail_contexts[i]);
+        }
         hg_poll_set_try_wait(context->poll_set, hg_core_poll_try_wait_cb,
             context);
         context->progress = hg_core_progress_poll;
@@ -3076,6 +3615,7 @@ HG_Core_context_destroy(hg_context_t *context)
     unsigned int actual_count;
     int na_poll_fd;
     hg_util_int32_t n_handles;
+    unsigned int i;
 
     if (!context) goto done;
 
@@ -3096,6 +3636,16 @@ HG_Core_context_destroy(hg_context_t *context)
     do {
         na_ret = NA_Trigger(context->na_context, 0, 1, NULL, &actual_count);
     } while ((na_ret == NA_SUCCESS) && actual_count);
+    if (context->rail_contexts) {
+        for (i = 1; i < context->hg_class->rail_count; i++) {
+            if (!context->rail_contexts[i].na_context)
+                continue;
+            do {
+                na_ret = NA_Trigger(context->rail_contexts[i].na_context, 0,
+                    1, NULL, &actual_count);
+            } while ((na_ret == NA_SUCCESS) && actual_count);
+        }
+    }
 
     /* Check that operations have completed */
     ret = hg_core_processing_list_wait(context);
@@ -3150,13 +3700,40 @@ HG_Core_context_destroy(hg_context_t *context)
     /* If NA plugin exposes fd, remove it from poll set */
     na_poll_fd = NA_Poll_get_fd(context->hg_class->na_class,
         context->na_context);
-    if ((na_poll_fd > 0)
+    if ((context->progress == hg_core_progress_poll) && (na_poll_fd > 0)
         && (hg_poll_remove(context->poll_set, na_poll_fd) != HG_UTIL_SUCCESS)) {
         HG_LOG_ERROR("Could not remove NA poll descriptor from poll set");
         ret = HG_PROTOCOL_ERROR;
         goto done;
     }
 
+    /* Remove rail fds and destroy rail NA contexts */
+    if (context->rail_contexts) {
+        for (i = 1; i < context->hg_class->rail_count; i++) {
+            struct hg_core_rail_context *rail_context =
+                &context->rail_contexts[i];
+
+            if (!rail_context->na_context)
+                continue;
+            if ((context->progress == hg_core_progress_poll)
+                && (hg_poll_remove(context->poll_set, rail_context->na_poll_fd)
+                    != HG_UTIL_SUCCESS)) {
+                HG_LOG_ERROR("Could not remove NA rail poll descriptor");
+                ret = HG_PROTOCOL_ERROR;
+                goto done;
+            }
+            if (NA_Context_destroy(rail_context->na_class,
+                rail_context->na_context) != NA_SUCCESS) {
+                HG_LOG_ERROR("Could not destroy NA context of rail %u", i);
+                ret = HG_NA_ERROR;
+                goto done;
+            }
+            rail_context->na_context = NULL;
+        }
+        free(context->rail_contexts);
+        context->rail_contexts = NULL;
+    }
+
     /* Destroy poll set */
     if (hg_poll_destroy(context->poll_set) != HG_UTIL_SUCCESS) {
         HG_LOG_ERROR("Could not destroy poll set");
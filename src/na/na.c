@@ -39,14 +39,60 @@
 
 #define NA_PROGRESS_LOCK 0x80000000 /* 32-bit lock value for serial progress */
 
+/* Message buffer pool */
+#define NA_MSG_BUF_POOL_SLAB_COUNT  64      /* Buffers carved from a slab */
+#define NA_MSG_BUF_POOL_SLAB_MAX    16      /* Slabs allocated at most */
+#define NA_MSG_BUF_POOL_ALIGNMENT   64      /* Buffer alignment in slab */
+#define NA_MSG_BUF_POOL_MAX_SIZE    65536   /* Larger buffers are not pooled */
+
+/* Free queue holds one entry less than its size, size must be a power of 2 */
+#define NA_MSG_BUF_POOL_QUEUE_SIZE \
+    (2 * NA_MSG_BUF_POOL_SLAB_MAX * NA_MSG_BUF_POOL_SLAB_COUNT)
+
+/* Operation ID pool */
+#define NA_OP_ID_POOL_SIZE 256      /* Free op IDs kept per context */
+
 /************************************/
 /* Local Type and Struct Definition */
 /************************************/
 
+/* Slab of message buffers, registered at once by the plugin */
+struct na_msg_buf_slab {
+    char *buf;                  /* Start of slab */
+    na_size_t size;             /* Size of slab */
+    void *plugin_data;          /* Shared by all buffers of the slab */
+};
+
+/* Message buffer pool */
+struct na_msg_buf_pool {
+    struct na_msg_buf_slab slabs[NA_MSG_BUF_POOL_SLAB_MAX];
+    hg_atomic_int32_t slab_count;       /* Number of slabs allocated */
+    struct hg_atomic_queue *free_queue; /* Free buffers, NULL if disabled */
+    na_size_t buf_size;                 /* Size of pooled buffers */
+    hg_thread_mutex_t mutex;            /* Slab allocation mutex */
+};
+
+/* Operation ID pool, op IDs are all of the size of the first one allocated.
+ * Pool is detached from its context when the context is destroyed and freed
+ * once the last op ID taken from it is released. */
+struct na_op_id_pool {
+    struct hg_atomic_queue *free_queue; /* Free op IDs */
+    hg_atomic_int32_t op_size;          /* Size of pooled op IDs */
+    hg_atomic_int32_t ref_count;        /* Context + op IDs not in queue */
+    hg_atomic_int32_t detached;         /* Context destroyed */
+};
+
+/* Header placed in front of op IDs returned by na_op_id_alloc() */
+union na_op_id_header {
+    struct na_op_id_pool *pool; /* Pool op ID returns to, NULL if none */
+    na_uint64_t align;          /* Keep op ID aligned */
+};
+
 struct na_private_class {
     struct na_class na_class;   /* Must remain as first field */
     char * protocol_name;       /* Name of protocol */
     na_bool_t listen;           /* Listen for connections */
+    struct na_msg_buf_pool msg_buf_pool;    /* Message buffer pool */
 };
 
 /* Private context / do not expose private members to plugins */
@@ -59,6 +105,7 @@ struct na_private_context {
     hg_thread_mutex_t completion_queue_mutex;   /* Completion queue mutex */
     hg_thread_cond_t  completion_queue_cond;    /* Completion queue cond */
     hg_atomic_int32_t trigger_waiting;          /* Polling/waiting in trigger */
+    struct na_op_id_pool *op_id_pool;           /* Operation ID pool */
 #ifdef NA_HAS_MULTI_PROGRESS
     hg_thread_mutex_t progress_mutex;           /* Progress mutex */
     hg_thread_cond_t  progress_cond;            /* Progress cond */
@@ -83,6 +130,68 @@ na_info_free(
     struct na_info *na_info
     );
 
+/* Allocate message buffer from plugin */
+static void *
+na_msg_buf_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* Free message buffer allocated from plugin */
+static na_return_t
+na_msg_buf_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
+/* Initialize message buffer pool */
+static na_return_t
+na_msg_buf_pool_init(
+    na_class_t *na_class,
+    struct na_msg_buf_pool *na_msg_buf_pool
+    );
+
+/* Finalize message buffer pool */
+static na_return_t
+na_msg_buf_pool_finalize(
+    na_class_t *na_class,
+    struct na_msg_buf_pool *na_msg_buf_pool
+    );
+
+/* Allocate slab and add its buffers to pool */
+static na_return_t
+na_msg_buf_pool_grow(
+    na_class_t *na_class,
+    struct na_msg_buf_pool *na_msg_buf_pool
+    );
+
+/* Find slab that buf was carved from */
+static NA_INLINE struct na_msg_buf_slab *
+na_msg_buf_pool_find(
+    struct na_msg_buf_pool *na_msg_buf_pool,
+    const void *buf
+    );
+
+/* Create op ID pool */
+static struct na_op_id_pool *
+na_op_id_pool_create(
+    void
+    );
+
+/* Drop reference to op ID pool, free pool on last reference */
+static void
+na_op_id_pool_release(
+    struct na_op_id_pool *na_op_id_pool
+    );
+
+/* Detach op ID pool from its context, later released op IDs are freed */
+static void
+na_op_id_pool_detach(
+    struct na_op_id_pool *na_op_id_pool
+    );
+
 #ifdef NA_DEBUG
 /* Print NA info */
 static void
@@ -107,6 +216,18 @@ extern na_class_t na_cci_class_g;
 #ifdef NA_HAS_OFI
 extern na_class_t na_ofi_class_g;
 #endif
+#ifdef NA_HAS_INPROC
+extern na_class_t na_inproc_class_g;
+#endif
+#ifdef NA_HAS_TCP
+extern na_class_t na_tcp_class_g;
+#endif
+#ifdef NA_HAS_EMU
+extern na_class_t na_emu_class_g;
+#endif
+#ifdef NA_HAS_AUTO
+extern na_class_t na_auto_class_g;
+#endif
 
 static const na_class_t *na_class_table[] = {
 #ifdef NA_HAS_SM
@@ -123,6 +244,18 @@ static const na_class_t *na_class_table[] = {
 #endif
 #ifdef NA_HAS_OFI
     &na_ofi_class_g,
+#endif
+#ifdef NA_HAS_INPROC
+    &na_inproc_class_g,
+#endif
+#ifdef NA_HAS_TCP
+    &na_tcp_class_g, /* Keep last so that "tcp" selects other plugins first */
+#endif
+#ifdef NA_HAS_EMU
+    &na_emu_class_g, /* Only selected by name, wraps other plugins */
+#endif
+#ifdef NA_HAS_AUTO
+    &na_auto_class_g, /* Only selected by name, wraps other plugins */
 #endif
     NULL
 };
@@ -148,6 +281,7 @@ na_info_parse(const char *info_string, struct na_info **na_info_ptr)
     na_info->class_name = NULL;
     na_info->protocol_name = NULL;
     na_info->host_name = NULL;
+    memset(&na_info->na_init_info, 0, sizeof(struct na_init_info));
 
     /* Copy info string and work from that */
     input_string = strdup(info_string);
@@ -256,8 +390,256 @@ na_info_print(struct na_info *na_info)
 #endif
 
 /*---------------------------------------------------------------------------*/
+static void *
+na_msg_buf_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
+{
+    void *ret = NULL;
+
+    if (na_class->msg_buf_alloc)
+        ret = na_class->msg_buf_alloc(na_class, buf_size, plugin_data);
+    else {
+        na_size_t page_size = (na_size_t) hg_mem_get_page_size();
+
+        ret = hg_mem_aligned_alloc(page_size, buf_size);
+        if (!ret) {
+            NA_LOG_ERROR("Could not allocate %d bytes", (int) buf_size);
+            goto done;
+        }
+        memset(ret, 0, buf_size);
+        *plugin_data = (void *)1; /* Sanity check on free */
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    if (na_class->msg_buf_free)
+        ret = na_class->msg_buf_free(na_class, buf, plugin_data);
+    else {
+        if (plugin_data != (void *)1) {
+            NA_LOG_ERROR("Invalid plugin data value");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        hg_mem_aligned_free(buf);
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_msg_buf_pool_init(na_class_t *na_class,
+    struct na_msg_buf_pool *na_msg_buf_pool)
+{
+    na_size_t unexpected_size, expected_size, buf_size;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_atomic_init32(&na_msg_buf_pool->slab_count, 0);
+    na_msg_buf_pool->free_queue = NULL;
+    na_msg_buf_pool->buf_size = 0;
+    hg_thread_mutex_init(&na_msg_buf_pool->mutex);
+
+    /* Buffers fit both messages so that any of them can be reused */
+    unexpected_size = NA_Msg_get_max_unexpected_size(na_class);
+    expected_size = NA_Msg_get_max_expected_size(na_class);
+    buf_size = (unexpected_size > expected_size) ? unexpected_size
+        : expected_size;
+    buf_size = (buf_size + NA_MSG_BUF_POOL_ALIGNMENT - 1)
+        & ~((na_size_t) NA_MSG_BUF_POOL_ALIGNMENT - 1);
+    if (!buf_size || buf_size > NA_MSG_BUF_POOL_MAX_SIZE)
+        goto done;
+
+    na_msg_buf_pool->free_queue =
+        hg_atomic_queue_alloc(NA_MSG_BUF_POOL_QUEUE_SIZE);
+    if (!na_msg_buf_pool->free_queue) {
+        NA_LOG_ERROR("Could not allocate message buffer queue");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    na_msg_buf_pool->buf_size = buf_size;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_msg_buf_pool_finalize(na_class_t *na_class,
+    struct na_msg_buf_pool *na_msg_buf_pool)
+{
+    int slab_count = hg_atomic_get32(&na_msg_buf_pool->slab_count);
+    na_return_t ret = NA_SUCCESS;
+    int i;
+
+    if (na_msg_buf_pool->free_queue) {
+        if (hg_atomic_queue_count(na_msg_buf_pool->free_queue)
+            != (unsigned int) slab_count * NA_MSG_BUF_POOL_SLAB_COUNT) {
+            NA_LOG_WARNING("Message buffers are still in use");
+        }
+        hg_atomic_queue_free(na_msg_buf_pool->free_queue);
+        na_msg_buf_pool->free_queue = NULL;
+    }
+
+    for (i = 0; i < slab_count; i++) {
+        na_return_t slab_ret = na_msg_buf_free(na_class,
+            na_msg_buf_pool->slabs[i].buf,
+            na_msg_buf_pool->slabs[i].plugin_data);
+
+        if (slab_ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not free message buffer slab");
+            ret = slab_ret;
+        }
+    }
+    hg_atomic_set32(&na_msg_buf_pool->slab_count, 0);
+    hg_thread_mutex_destroy(&na_msg_buf_pool->mutex);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_msg_buf_pool_grow(na_class_t *na_class,
+    struct na_msg_buf_pool *na_msg_buf_pool)
+{
+    struct na_msg_buf_slab *na_msg_buf_slab;
+    int slab_count;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_mutex_lock(&na_msg_buf_pool->mutex);
+
+    /* Another thread may have grown the pool in the meantime */
+    if (!hg_atomic_queue_is_empty(na_msg_buf_pool->free_queue))
+        goto done;
+
+    /* Pool is exhausted, buffers are then allocated individually */
+    slab_count = hg_atomic_get32(&na_msg_buf_pool->slab_count);
+    if (slab_count == NA_MSG_BUF_POOL_SLAB_MAX) {
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+
+    /* Registration of the whole slab is shared by its buffers */
+    na_msg_buf_slab = &na_msg_buf_pool->slabs[slab_count];
+    na_msg_buf_slab->size =
+        na_msg_buf_pool->buf_size * NA_MSG_BUF_POOL_SLAB_COUNT;
+    na_msg_buf_slab->buf = (char *) na_msg_buf_alloc(na_class,
+        na_msg_buf_slab->size, &na_msg_buf_slab->plugin_data);
+    if (!na_msg_buf_slab->buf) {
+        NA_LOG_ERROR("Could not allocate message buffer slab");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+
+    /* Make slab visible to free before its buffers can be used */
+    hg_atomic_incr32(&na_msg_buf_pool->slab_count);
+
+    for (i = 0; i < NA_MSG_BUF_POOL_SLAB_COUNT; i++) {
+        if (hg_atomic_queue_push(na_msg_buf_pool->free_queue,
+            na_msg_buf_slab->buf + i * na_msg_buf_pool->buf_size)
+            != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("Could not push message buffer to free queue");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    }
+
+done:
+    hg_thread_mutex_unlock(&na_msg_buf_pool->mutex);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE struct na_msg_buf_slab *
+na_msg_buf_pool_find(struct na_msg_buf_pool *na_msg_buf_pool, const void *buf)
+{
+    int slab_count = hg_atomic_get32(&na_msg_buf_pool->slab_count);
+    int i;
+
+    for (i = 0; i < slab_count; i++) {
+        struct na_msg_buf_slab *na_msg_buf_slab = &na_msg_buf_pool->slabs[i];
+
+        if ((const char *) buf >= na_msg_buf_slab->buf && (const char *) buf
+            < na_msg_buf_slab->buf + na_msg_buf_slab->size)
+            return na_msg_buf_slab;
+    }
+
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_op_id_pool *
+na_op_id_pool_create(void)
+{
+    struct na_op_id_pool *na_op_id_pool;
+
+    na_op_id_pool = (struct na_op_id_pool *) malloc(
+        sizeof(struct na_op_id_pool));
+    if (!na_op_id_pool)
+        return NULL;
+
+    na_op_id_pool->free_queue = hg_atomic_queue_alloc(NA_OP_ID_POOL_SIZE);
+    if (!na_op_id_pool->free_queue) {
+        free(na_op_id_pool);
+        return NULL;
+    }
+    hg_atomic_init32(&na_op_id_pool->op_size, 0);
+    hg_atomic_init32(&na_op_id_pool->ref_count, 1);
+    hg_atomic_init32(&na_op_id_pool->detached, 0);
+
+    return na_op_id_pool;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_op_id_pool_release(struct na_op_id_pool *na_op_id_pool)
+{
+    union na_op_id_header *na_op_id_header;
+
+    if (hg_atomic_decr32(&na_op_id_pool->ref_count) > 0)
+        return;
+
+    /* Op IDs may still have been pushed after the pool was detached */
+    while ((na_op_id_header = (union na_op_id_header *) hg_atomic_queue_pop_mc(
+        na_op_id_pool->free_queue)) != NULL)
+        free(na_op_id_header);
+    hg_atomic_queue_free(na_op_id_pool->free_queue);
+    free(na_op_id_pool);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_op_id_pool_detach(struct na_op_id_pool *na_op_id_pool)
+{
+    union na_op_id_header *na_op_id_header;
+
+    hg_atomic_set32(&na_op_id_pool->detached, 1);
+    while ((na_op_id_header = (union na_op_id_header *) hg_atomic_queue_pop_mc(
+        na_op_id_pool->free_queue)) != NULL)
+        free(na_op_id_header);
+
+    /* Drop context reference */
+    na_op_id_pool_release(na_op_id_pool);
+}
+
 na_class_t *
 NA_Initialize(const char *info_string, na_bool_t listen)
+{
+    return NA_Initialize_opt(info_string, listen, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+na_class_t *
+NA_Initialize_opt(const char *info_string, na_bool_t listen,
+    const struct na_init_info *na_init_info)
 {
     struct na_private_class *na_private_class = NULL;
     struct na_info *na_info = NULL;
@@ -288,6 +670,8 @@ NA_Initialize(const char *info_string, na_bool_t listen)
         NA_LOG_ERROR("Could not parse host string");
         goto done;
     }
+    if (na_init_info)
+        na_info->na_init_info = *na_init_info;
 
 #ifdef NA_DEBUG
     na_info_print(na_info);
@@ -374,6 +758,14 @@ NA_Initialize(const char *info_string, na_bool_t listen)
     }
     na_private_class->listen = listen;
 
+    ret = na_msg_buf_pool_init(&na_private_class->na_class,
+        &na_private_class->msg_buf_pool);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not initialize message buffer pool");
+        na_private_class->na_class.finalize(&na_private_class->na_class);
+        goto done;
+    }
+
 done:
     if (ret != NA_SUCCESS) {
         if (na_private_class) {
@@ -392,7 +784,7 @@ NA_Finalize(na_class_t *na_class)
 {
     struct na_private_class *na_private_class =
         (struct na_private_class *) na_class;
-    na_return_t ret = NA_SUCCESS;
+    na_return_t pool_ret, ret = NA_SUCCESS;
 
     if (!na_private_class) goto done;
     if (!na_class->finalize) {
@@ -401,7 +793,16 @@ NA_Finalize(na_class_t *na_class)
         goto done;
     }
 
+    /* Slabs must be released before the plugin goes away */
+    pool_ret = na_msg_buf_pool_finalize(&na_private_class->na_class,
+        &na_private_class->msg_buf_pool);
+    if (pool_ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not finalize message buffer pool");
+    }
+
     ret = na_private_class->na_class.finalize(&na_private_class->na_class);
+    if (ret == NA_SUCCESS)
+        ret = pool_ret;
 
     free(na_private_class->protocol_name);
     free(na_private_class);
@@ -544,6 +945,14 @@ NA_Context_create(na_class_t *na_class)
     hg_thread_cond_init(&na_private_context->completion_queue_cond);
     hg_atomic_init32(&na_private_context->trigger_waiting, 0);
 
+    /* Initialize operation ID pool */
+    na_private_context->op_id_pool = na_op_id_pool_create();
+    if (!na_private_context->op_id_pool) {
+        NA_LOG_ERROR("Could not allocate operation ID pool");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+
 #ifdef NA_HAS_MULTI_PROGRESS
     /* Initialize progress mutex/cond */
     hg_thread_mutex_init(&na_private_context->progress_mutex);
@@ -605,6 +1014,10 @@ NA_Context_destroy(na_class_t *na_class, na_context_t *context)
         }
     }
 
+    /* Free operation IDs kept in pool, op IDs that are still in use are
+     * freed when they get released */
+    na_op_id_pool_detach(na_private_context->op_id_pool);
+
 #ifdef NA_HAS_MULTI_PROGRESS
     /* Destroy progress mutex/cond */
     hg_thread_mutex_destroy(&na_private_context->progress_mutex);
@@ -966,6 +1379,7 @@ done:
 void *
 NA_Msg_buf_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
 {
+    struct na_msg_buf_pool *na_msg_buf_pool;
     void *ret = NULL;
 
     if (!na_class) {
@@ -980,21 +1394,23 @@ NA_Msg_buf_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
         NA_LOG_ERROR("NULL pointer to plugin data");
         goto done;
     }
+    na_msg_buf_pool = &((struct na_private_class *) na_class)->msg_buf_pool;
 
-    if (na_class->msg_buf_alloc)
-        ret = na_class->msg_buf_alloc(na_class, buf_size, plugin_data);
-    else {
-        na_size_t page_size = (na_size_t) hg_mem_get_page_size();
-
-        ret = hg_mem_aligned_alloc(page_size, buf_size);
-        if (!ret) {
-            NA_LOG_ERROR("Could not allocate %d bytes", (int) buf_size);
+    /* Message sized buffers are taken from registered slabs */
+    if (na_msg_buf_pool->free_queue && buf_size <= na_msg_buf_pool->buf_size) {
+        ret = hg_atomic_queue_pop_mc(na_msg_buf_pool->free_queue);
+        if (!ret && na_msg_buf_pool_grow(na_class, na_msg_buf_pool)
+            == NA_SUCCESS)
+            ret = hg_atomic_queue_pop_mc(na_msg_buf_pool->free_queue);
+        if (ret) {
+            *plugin_data = na_msg_buf_pool_find(na_msg_buf_pool,
+                ret)->plugin_data;
             goto done;
         }
-        memset(ret, 0, buf_size);
-        *plugin_data = (void *)1; /* Sanity check on free */
     }
 
+    ret = na_msg_buf_alloc(na_class, buf_size, plugin_data);
+
 done:
     return ret;
 }
@@ -1003,6 +1419,7 @@ done:
 na_return_t
 NA_Msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
 {
+    struct na_msg_buf_pool *na_msg_buf_pool;
     na_return_t ret = NA_SUCCESS;
 
     if (!na_class) {
@@ -1020,18 +1437,22 @@ NA_Msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
         ret = NA_INVALID_PARAM;
         goto done;
     }
+    na_msg_buf_pool = &((struct na_private_class *) na_class)->msg_buf_pool;
 
-    if (na_class->msg_buf_free)
-        ret = na_class->msg_buf_free(na_class, buf, plugin_data);
-    else {
-        if (plugin_data != (void *)1) {
-            NA_LOG_ERROR("Invalid plugin data value");
+    /* Buffers carved from slabs go back to the pool */
+    if (na_msg_buf_pool->free_queue
+        && na_msg_buf_pool_find(na_msg_buf_pool, buf)) {
+        /* Slab memory is released on finalize if buffer cannot be queued */
+        if (hg_atomic_queue_push(na_msg_buf_pool->free_queue, buf)
+            != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("Could not push message buffer to free queue");
             ret = NA_PROTOCOL_ERROR;
-            goto done;
         }
-        hg_mem_aligned_free(buf);
+        goto done;
     }
 
+    ret = na_msg_buf_free(na_class, buf, plugin_data);
+
 done:
     return ret;
 }
@@ -1273,6 +1694,80 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+void *
+NA_Mem_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
+{
+    void *ret = NULL;
+
+    if (!na_class) {
+        NA_LOG_ERROR("NULL NA class");
+        goto done;
+    }
+    if (!buf_size) {
+        NA_LOG_ERROR("NULL buffer size");
+        goto done;
+    }
+    if (!plugin_data) {
+        NA_LOG_ERROR("NULL pointer to plugin data");
+        goto done;
+    }
+
+    if (na_class->mem_alloc)
+        ret = na_class->mem_alloc(na_class, buf_size, plugin_data);
+    else {
+        na_size_t page_size = (na_size_t) hg_mem_get_page_size();
+
+        ret = hg_mem_aligned_alloc(page_size, buf_size);
+        if (!ret) {
+            NA_LOG_ERROR("Could not allocate %d bytes", (int) buf_size);
+            goto done;
+        }
+        memset(ret, 0, buf_size);
+        *plugin_data = (void *)1; /* Sanity check on free */
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Mem_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_class) {
+        NA_LOG_ERROR("NULL NA class");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+    if (!buf) {
+        NA_LOG_ERROR("NULL buffer");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+    if (!plugin_data) {
+        NA_LOG_ERROR("NULL pointer to plugin data");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    if (na_class->mem_free)
+        ret = na_class->mem_free(na_class, buf, plugin_data);
+    else {
+        if (plugin_data != (void *)1) {
+            NA_LOG_ERROR("Invalid plugin data value");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        hg_mem_aligned_free(buf);
+    }
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_return_t
 NA_Mem_handle_create(na_class_t *na_class, void *buf, na_size_t buf_size,
@@ -2038,3 +2533,61 @@ na_cb_completion_add(na_context_t *context,
 
     return ret;
 }
+
+/*---------------------------------------------------------------------------*/
+void *
+na_op_id_alloc(na_context_t *context, na_size_t op_size)
+{
+    struct na_op_id_pool *na_op_id_pool = NULL;
+    union na_op_id_header *na_op_id_header = NULL;
+
+    if (context) {
+        na_op_id_pool = ((struct na_private_context *) context)->op_id_pool;
+
+        /* First allocation sets the size of pooled op IDs */
+        hg_atomic_cas32(&na_op_id_pool->op_size, 0, (hg_util_int32_t) op_size);
+        if ((na_size_t) hg_atomic_get32(&na_op_id_pool->op_size) == op_size)
+            na_op_id_header = (union na_op_id_header *) hg_atomic_queue_pop_mc(
+                na_op_id_pool->free_queue);
+        else
+            na_op_id_pool = NULL;
+    }
+
+    if (!na_op_id_header) {
+        na_op_id_header = (union na_op_id_header *) malloc(
+            sizeof(union na_op_id_header) + op_size);
+        if (!na_op_id_header)
+            return NULL;
+        na_op_id_header->pool = na_op_id_pool;
+    }
+
+    /* Op ID keeps pool alive until it is released */
+    if (na_op_id_pool)
+        hg_atomic_incr32(&na_op_id_pool->ref_count);
+
+    return na_op_id_header + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+na_op_id_free(void *op_id)
+{
+    struct na_op_id_pool *na_op_id_pool;
+    union na_op_id_header *na_op_id_header;
+
+    if (!op_id)
+        return;
+
+    na_op_id_header = (union na_op_id_header *) op_id - 1;
+    na_op_id_pool = na_op_id_header->pool;
+    if (!na_op_id_pool) {
+        free(na_op_id_header);
+        return;
+    }
+
+    /* Keep op ID in pool unless pool is full or context was destroyed */
+    if (hg_atomic_get32(&na_op_id_pool->detached) || hg_atomic_queue_push(
+        na_op_id_pool->free_queue, na_op_id_header) != HG_UTIL_SUCCESS)
+        free(na_op_id_header);
+    na_op_id_pool_release(na_op_id_pool);
+}
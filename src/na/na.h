@@ -86,6 +86,22 @@ struct na_cb_info {
 /* Callback type */
 typedef int (*na_cb_t)(const struct na_cb_info *callback_info);
 
+/* Init info (options that can be passed to NA_Initialize_opt()) */
+struct na_init_info {
+    na_bool_t use_huge_pages;   /* Back shared buffers with huge pages if
+                                   supported by the plugin and the system */
+    na_uint32_t max_unexpected; /* Number of unexpected messages that can be
+                                   buffered before a recv is posted without
+                                   allocating memory (0 for plugin default),
+                                   plugins fall back to allocating memory
+                                   once that number is exceeded */
+    na_size_t rma_chunk_size;   /* Size of chunks that plugins emulating RMA
+                                   over messages split transfers into
+                                   (0 for plugin default) */
+    na_uint32_t rma_window;     /* Number of such chunks kept in flight
+                                   (0 for plugin default) */
+};
+
 /*****************/
 /* Public Macros */
 /*****************/
@@ -137,6 +153,27 @@ NA_Initialize(
         na_bool_t   listen
         ) NA_WARN_UNUSED_RESULT;
 
+/**
+ * Initialize the network abstraction layer with options provided by
+ * na_init_info. Passing NULL for na_init_info is equivalent to calling
+ * NA_Initialize(). Plugins ignore options that they do not support.
+ * Must be finalized with NA_Finalize().
+ *
+ * \param info_string [IN]      host address with port number (e.g.,
+ *                              "tcp://localhost:3344" or
+ *                              "bmi+tcp://localhost:3344")
+ * \param listen [IN]           listen for incoming connections
+ * \param na_init_info [IN]     (Optional) NA init info, NULL if no info
+ *
+ * \return Pointer to NA class or NULL in case of failure
+ */
+NA_EXPORT na_class_t *
+NA_Initialize_opt(
+        const char *info_string,
+        na_bool_t   listen,
+        const struct na_init_info *na_init_info
+        ) NA_WARN_UNUSED_RESULT;
+
 /**
  * Finalize the network abstraction layer.
  *
@@ -227,6 +264,10 @@ NA_Context_create(
 
 /**
  * Destroy a context created by using NA_Context_create().
+ * All completed operations must have been triggered. Operation IDs that were
+ * returned for that context and are still in use (e.g., not yet released with
+ * NA_Op_destroy()) remain valid and may be released after the context is
+ * destroyed, their memory is then freed instead of being reused.
  *
  * \param na_class [IN/OUT]     pointer to NA class
  * \param context [IN/OUT]      pointer to context of execution
@@ -452,6 +493,9 @@ NA_Msg_get_max_tag(
  * If size is 0, NA_Msg_buf_alloc() returns NULL. The plugin_data output
  * parameter can be used by the underlying plugin implementation to store
  * internal memory information.
+ * Buffers that do not exceed the maximum message size are taken from
+ * slabs that the plugin registers at once, plugin_data then refers to
+ * the registration of the slab. Their content is not initialized.
  *
  * \param na_class [IN/OUT]     pointer to NA class
  * \param buf_size [IN]         buffer size
@@ -690,6 +734,47 @@ NA_Msg_recv_expected(
         na_op_id_t   *op_id
         );
 
+/**
+ * Allocate buf_size bytes of memory that is suitable for RMA operations and
+ * return a pointer to the allocated memory. If size is 0, NA_Mem_alloc()
+ * returns NULL. Plugins may use this call to allocate memory that can be
+ * accessed more efficiently by remote peers (e.g., shared memory that remote
+ * processes can map directly), memory must still be registered through
+ * NA_Mem_handle_create() before it can be used. The plugin_data output
+ * parameter can be used by the underlying plugin implementation to store
+ * internal memory information.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param buf_size [IN]         buffer size
+ * \param plugin_data [OUT]     pointer to internal plugin data
+ *
+ * \return Pointer to allocated memory or NULL in case of failure
+ */
+NA_EXPORT void *
+NA_Mem_alloc(
+        na_class_t *na_class,
+        na_size_t buf_size,
+        void **plugin_data
+        ) NA_WARN_UNUSED_RESULT;
+
+/**
+ * The NA_Mem_free() function releases the memory space pointed to by buf,
+ * which must have been returned by a previous call to NA_Mem_alloc().
+ * Memory handles created on that buffer must be freed first.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param buf [IN]              pointer to buffer
+ * \param plugin_data [IN]      pointer to internal plugin data
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+NA_EXPORT na_return_t
+NA_Mem_free(
+        na_class_t *na_class,
+        void *buf,
+        void *plugin_data
+        );
+
 /**
  * Create memory handle for RMA operations.
  * For non-contiguous memory, use NA_Mem_handle_create_segments() instead.
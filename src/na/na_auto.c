@@ -0,0 +1,2620 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_private.h"
+#include "na_error.h"
+
+#include "mercury_queue.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_atomic.h"
+#include "mercury_poll.h"
+#include "mercury_time.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Plugin constants */
+#define NA_AUTO_MAX_INFO_STRING     256
+#define NA_AUTO_MAX_HOSTNAME        256
+#define NA_AUTO_MAX_ADDR_STRING     1024
+#define NA_AUTO_UNEXPECTED_COUNT    32      /* Recvs posted on each class */
+#define NA_AUTO_TRIGGER_MAX         64      /* Completions triggered at once */
+#define NA_AUTO_PROGRESS_TIMEOUT    1       /* ms, classes polled in turn */
+#define NA_AUTO_DESTROY_RETRY       1000    /* Progress calls on destroy */
+
+/* Shared-memory class brought up alongside the primary class */
+#define NA_AUTO_SM_INFO_STRING      "na+sm"
+
+/* Separator of address string components:
+ *   auto+<hostname>;<sm addr>;<primary addr> */
+#define NA_AUTO_ADDR_SEP            ';'
+
+/* Private data access */
+#define NA_AUTO_PRIVATE_DATA(na_class) \
+    ((struct na_auto_private_data *)(na_class->private_data))
+#define NA_AUTO_CONTEXT(context) \
+    ((struct na_auto_context *)(context->plugin_context))
+
+/* Inner classes and contexts */
+#define NA_AUTO_CLASS(na_class, route) \
+    (NA_AUTO_PRIVATE_DATA(na_class)->classes[route])
+#define NA_AUTO_INNER_CONTEXT(context, route) \
+    (NA_AUTO_CONTEXT(context)->contexts[route])
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Classes used to reach a peer */
+typedef enum {
+    NA_AUTO_PRIMARY,            /* Network class */
+    NA_AUTO_SM,                 /* Shared-memory class, peer is on node */
+    NA_AUTO_ROUTE_MAX
+} na_auto_route_t;
+
+/* Address */
+struct na_auto_addr {
+    na_addr_t addrs[NA_AUTO_ROUTE_MAX]; /* NA_ADDR_NULL if not reachable */
+    na_bool_t self;                     /* Self address */
+    hg_atomic_int32_t ref_count;        /* Ref count */
+};
+
+/* Operation ID */
+struct na_auto_op_id {
+    na_class_t *na_class;
+    na_context_t *context;
+    struct na_cb_completion_data completion_data;
+    na_op_id_t op_ids[NA_AUTO_ROUTE_MAX];   /* Operation IDs of inner classes */
+    na_bool_t own_op_ids[NA_AUTO_ROUTE_MAX];/* Inner class supports op_create */
+    na_auto_route_t route;          /* Class the operation was posted to */
+    hg_atomic_int32_t completed;    /* Operation completed */
+    hg_atomic_int32_t canceled;     /* Operation canceled */
+    hg_atomic_int32_t ref_count;    /* Ref count */
+    struct na_auto_addr *addr;      /* Address being looked up */
+    char *name;                     /* Primary name if sm lookup fails */
+    void *buf;                      /* Unexpected recv buffer */
+    na_size_t buf_size;             /* Unexpected recv buffer size */
+    na_bool_t queued;               /* Waiting for unexpected message */
+    HG_QUEUE_ENTRY(na_auto_op_id) entry;
+};
+
+/* Unexpected recv posted on inner class */
+struct na_auto_unexpected {
+    na_class_t *na_class;
+    na_context_t *context;
+    na_auto_route_t route;          /* Inner class */
+    void *buf;                      /* Message buffer */
+    na_size_t buf_size;             /* Message buffer size */
+    void *plugin_data;              /* Message buffer plugin data */
+    na_op_id_t op_id;               /* Operation ID of inner class */
+    na_bool_t own_op_id;            /* Inner class supports op_create */
+    na_bool_t posted;               /* Posted to inner class */
+    na_size_t actual_buf_size;      /* Received size */
+    na_addr_t source;               /* Source of inner class */
+    na_tag_t tag;                   /* Received tag */
+    HG_QUEUE_ENTRY(na_auto_unexpected) entry;
+};
+
+/* Poll callback arg */
+struct na_auto_poll_arg {
+    na_class_t *na_class;           /* Inner class */
+    na_context_t *context;          /* Inner context */
+};
+
+/* Context */
+struct na_auto_context {
+    na_context_t *contexts[NA_AUTO_ROUTE_MAX];  /* Contexts of inner classes */
+    struct na_auto_poll_arg poll_args[NA_AUTO_ROUTE_MAX];
+    hg_poll_set_t *poll_set;        /* NULL if classes cannot be polled */
+    struct na_auto_unexpected *unexpected;      /* Unexpected recvs */
+    na_bool_t unexpected_posted;    /* Unexpected recvs posted */
+    na_bool_t destroying;           /* Unexpected recvs are not reposted */
+    HG_QUEUE_HEAD(na_auto_unexpected) unexpected_msg_queue;
+    HG_QUEUE_HEAD(na_auto_unexpected) unexpected_repost_queue;
+    HG_QUEUE_HEAD(na_auto_op_id) unexpected_op_queue;
+    hg_thread_mutex_t unexpected_mutex;         /* Unexpected queues lock */
+};
+
+/* Memory handle */
+struct na_auto_mem_handle {
+    na_mem_handle_t handles[NA_AUTO_ROUTE_MAX]; /* Handles of inner classes */
+};
+
+/* Private data */
+struct na_auto_private_data {
+    na_class_t *classes[NA_AUTO_ROUTE_MAX];     /* Inner classes */
+    char hostname[NA_AUTO_MAX_HOSTNAME];        /* Node identification */
+    na_size_t unexpected_header_size;           /* Reserved header size */
+    na_size_t expected_header_size;             /* Reserved header size */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Class used to reach addr.
+ */
+static NA_INLINE na_auto_route_t
+na_auto_addr_route(
+    struct na_auto_addr *na_auto_addr
+    );
+
+/**
+ * Offset of inner class message within message buffer. Messages reserve
+ * the header of the primary class, the sm class uses no header.
+ */
+static NA_INLINE na_size_t
+na_auto_msg_offset(
+    const na_class_t *na_class,
+    na_auto_route_t route,
+    na_bool_t expected
+    );
+
+/**
+ * Allocate address.
+ */
+static struct na_auto_addr *
+na_auto_addr_alloc(
+    void
+    );
+
+/**
+ * Setup operation.
+ */
+static na_return_t
+na_auto_op_setup(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    na_op_id_t *op_id,
+    struct na_auto_op_id **op_ptr
+    );
+
+/**
+ * Post lookup to inner class.
+ */
+static na_return_t
+na_auto_lookup_post(
+    struct na_auto_op_id *na_auto_op_id,
+    na_auto_route_t route,
+    const char *name
+    );
+
+/**
+ * Callback of inner class lookups.
+ */
+static int
+na_auto_lookup_cb(
+    const struct na_cb_info *callback_info
+    );
+
+/**
+ * Send message on class used to reach dest.
+ */
+static na_return_t
+na_auto_msg_send(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Post unexpected recvs on all inner classes.
+ */
+static na_return_t
+na_auto_unexpected_post_all(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/**
+ * Post unexpected recv on inner class.
+ */
+static na_return_t
+na_auto_unexpected_post(
+    struct na_auto_unexpected *na_auto_unexpected
+    );
+
+/**
+ * Repost unexpected recvs once inner classes have released them.
+ */
+static na_return_t
+na_auto_unexpected_repost(
+    struct na_auto_context *na_auto_context
+    );
+
+/**
+ * Callback of inner class unexpected recvs.
+ */
+static int
+na_auto_unexpected_cb(
+    const struct na_cb_info *callback_info
+    );
+
+/**
+ * Copy unexpected message to operation and complete it.
+ */
+static na_return_t
+na_auto_unexpected_match(
+    struct na_auto_unexpected *na_auto_unexpected,
+    struct na_auto_op_id *na_auto_op_id
+    );
+
+/**
+ * RMA on class used to reach remote_addr.
+ */
+static na_return_t
+na_auto_rma(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Callback of inner class operations.
+ */
+static int
+na_auto_cb(
+    const struct na_cb_info *callback_info
+    );
+
+/**
+ * Complete operation.
+ */
+static na_return_t
+na_auto_complete(
+    struct na_auto_op_id *na_auto_op_id
+    );
+
+/**
+ * Release memory.
+ */
+static void
+na_auto_release(
+    void *arg
+    );
+
+/**
+ * Trigger completions of inner classes.
+ */
+static na_return_t
+na_auto_trigger(
+    struct na_auto_context *na_auto_context,
+    na_bool_t *progressed
+    );
+
+/**
+ * Progress callback of poll set.
+ */
+static int
+na_auto_progress_cb(
+    void *arg,
+    unsigned int timeout,
+    hg_util_bool_t *progressed
+    );
+
+/**
+ * Check whether it is safe to block on poll set.
+ */
+static hg_util_bool_t
+na_auto_poll_try_wait_cb(
+    void *arg
+    );
+
+/**
+ * Allocate operation ID, from context pool if context is not NULL.
+ */
+static struct na_auto_op_id *
+na_auto_op_alloc(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* check_protocol */
+static na_bool_t
+na_auto_check_protocol(
+    const char *protocol_name
+    );
+
+/* initialize */
+static na_return_t
+na_auto_initialize(
+    na_class_t *na_class,
+    const struct na_info *na_info,
+    na_bool_t listen
+    );
+
+/* finalize */
+static na_return_t
+na_auto_finalize(
+    na_class_t *na_class
+    );
+
+/* check_feature */
+static na_bool_t
+na_auto_check_feature(
+    na_class_t *na_class,
+    na_uint8_t feature
+    );
+
+/* context_create */
+static na_return_t
+na_auto_context_create(
+    na_class_t *na_class,
+    void **context
+    );
+
+/* context_destroy */
+static na_return_t
+na_auto_context_destroy(
+    na_class_t *na_class,
+    void *context
+    );
+
+/* op_create */
+static na_op_id_t
+na_auto_op_create(
+    na_class_t *na_class
+    );
+
+/* op_destroy */
+static na_return_t
+na_auto_op_destroy(
+    na_class_t *na_class,
+    na_op_id_t op_id
+    );
+
+/* addr_lookup */
+static na_return_t
+na_auto_addr_lookup(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const char *name,
+    na_op_id_t *op_id
+    );
+
+/* addr_free */
+static na_return_t
+na_auto_addr_free(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_self */
+static na_return_t
+na_auto_addr_self(
+    na_class_t *na_class,
+    na_addr_t *addr
+    );
+
+/* addr_dup */
+static na_return_t
+na_auto_addr_dup(
+    na_class_t *na_class,
+    na_addr_t addr,
+    na_addr_t *new_addr
+    );
+
+/* addr_is_self */
+static na_bool_t
+na_auto_addr_is_self(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_to_string */
+static na_return_t
+na_auto_addr_to_string(
+    na_class_t *na_class,
+    char *buf,
+    na_size_t *buf_size,
+    na_addr_t addr
+    );
+
+/* msg_get_max_unexpected_size */
+static na_size_t
+na_auto_msg_get_max_unexpected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_expected_size */
+static na_size_t
+na_auto_msg_get_max_expected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_unexpected_header_size */
+static na_size_t
+na_auto_msg_get_unexpected_header_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_expected_header_size */
+static na_size_t
+na_auto_msg_get_expected_header_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_tag */
+static na_tag_t
+na_auto_msg_get_max_tag(
+    const na_class_t *na_class
+    );
+
+/* msg_buf_alloc */
+static void *
+na_auto_msg_buf_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* msg_buf_free */
+static na_return_t
+na_auto_msg_buf_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
+/* msg_init_unexpected */
+static na_return_t
+na_auto_msg_init_unexpected(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size
+    );
+
+/* msg_send_unexpected */
+static na_return_t
+na_auto_msg_send_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_unexpected */
+static na_return_t
+na_auto_msg_recv_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_tag_t mask,
+    na_op_id_t *op_id
+    );
+
+/* msg_init_expected */
+static na_return_t
+na_auto_msg_init_expected(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size
+    );
+
+/* msg_send_expected */
+static na_return_t
+na_auto_msg_send_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_expected */
+static na_return_t
+na_auto_msg_recv_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t source,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* mem_alloc */
+static void *
+na_auto_mem_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* mem_free */
+static na_return_t
+na_auto_mem_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
+/* mem_handle */
+static na_return_t
+na_auto_mem_handle_create(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    unsigned long flags,
+    na_mem_handle_t *mem_handle
+    );
+
+static na_return_t
+na_auto_mem_handle_create_segments(
+    na_class_t *na_class,
+    struct na_segment *segments,
+    na_size_t segment_count,
+    unsigned long flags,
+    na_mem_handle_t *mem_handle
+    );
+
+static na_return_t
+na_auto_mem_handle_free(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_register */
+static na_return_t
+na_auto_mem_register(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_deregister */
+static na_return_t
+na_auto_mem_deregister(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_publish */
+static na_return_t
+na_auto_mem_publish(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_unpublish */
+static na_return_t
+na_auto_mem_unpublish(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_handle serialization */
+static na_size_t
+na_auto_mem_handle_get_serialize_size(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_auto_mem_handle_serialize(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_auto_mem_handle_deserialize(
+    na_class_t *na_class,
+    na_mem_handle_t *mem_handle,
+    const void *buf,
+    na_size_t buf_size
+    );
+
+/* put */
+static na_return_t
+na_auto_put(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* get */
+static na_return_t
+na_auto_get(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* poll_get_fd */
+static int
+na_auto_poll_get_fd(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* poll_try_wait */
+static na_bool_t
+na_auto_poll_try_wait(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* progress */
+static na_return_t
+na_auto_progress(
+    na_class_t *na_class,
+    na_context_t *context,
+    unsigned int timeout
+    );
+
+/* cancel */
+static na_return_t
+na_auto_cancel(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_op_id_t op_id
+    );
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+const na_class_t na_auto_class_g = {
+    NULL,                                   /* private_data */
+    "auto",                                 /* name */
+    na_auto_check_protocol,                 /* check_protocol */
+    na_auto_initialize,                     /* initialize */
+    na_auto_finalize,                       /* finalize */
+    NULL,                                   /* cleanup */
+    na_auto_check_feature,                  /* check_feature */
+    na_auto_context_create,                 /* context_create */
+    na_auto_context_destroy,                /* context_destroy */
+    na_auto_op_create,                      /* op_create */
+    na_auto_op_destroy,                     /* op_destroy */
+    na_auto_addr_lookup,                    /* addr_lookup */
+    na_auto_addr_free,                      /* addr_free */
+    na_auto_addr_self,                      /* addr_self */
+    na_auto_addr_dup,                       /* addr_dup */
+    na_auto_addr_is_self,                   /* addr_is_self */
+    na_auto_addr_to_string,                 /* addr_to_string */
+    na_auto_msg_get_max_unexpected_size,    /* msg_get_max_unexpected_size */
+    na_auto_msg_get_max_expected_size,      /* msg_get_max_expected_size */
+    na_auto_msg_get_unexpected_header_size, /* msg_get_unexpected_header_size */
+    na_auto_msg_get_expected_header_size,   /* msg_get_expected_header_size */
+    na_auto_msg_get_max_tag,                /* msg_get_max_tag */
+    na_auto_msg_buf_alloc,                  /* msg_buf_alloc */
+    na_auto_msg_buf_free,                   /* msg_buf_free */
+    na_auto_msg_init_unexpected,            /* msg_init_unexpected */
+    na_auto_msg_send_unexpected,            /* msg_send_unexpected */
+    na_auto_msg_recv_unexpected,            /* msg_recv_unexpected */
+    na_auto_msg_init_expected,              /* msg_init_expected */
+    na_auto_msg_send_expected,              /* msg_send_expected */
+    na_auto_msg_recv_expected,              /* msg_recv_expected */
+    na_auto_mem_alloc,                      /* mem_alloc */
+    na_auto_mem_free,                       /* mem_free */
+    na_auto_mem_handle_create,              /* mem_handle_create */
+    na_auto_mem_handle_create_segments,     /* mem_handle_create_segments */
+    na_auto_mem_handle_free,                /* mem_handle_free */
+    na_auto_mem_register,                   /* mem_register */
+    na_auto_mem_deregister,                 /* mem_deregister */
+    na_auto_mem_publish,                    /* mem_publish */
+    na_auto_mem_unpublish,                  /* mem_unpublish */
+    na_auto_mem_handle_get_serialize_size,  /* mem_handle_get_serialize_size */
+    na_auto_mem_handle_serialize,           /* mem_handle_serialize */
+    na_auto_mem_handle_deserialize,         /* mem_handle_deserialize */
+    na_auto_put,                            /* put */
+    na_auto_get,                            /* get */
+    na_auto_poll_get_fd,                    /* poll_get_fd */
+    na_auto_poll_try_wait,                  /* poll_try_wait */
+    na_auto_progress,                       /* progress */
+    na_auto_cancel                          /* cancel */
+};
+
+/********************/
+/* Plugin callbacks */
+/********************/
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_auto_route_t
+na_auto_addr_route(struct na_auto_addr *na_auto_addr)
+{
+    return (na_auto_addr->addrs[NA_AUTO_SM] != NA_ADDR_NULL) ?
+        NA_AUTO_SM : NA_AUTO_PRIMARY;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_auto_msg_offset(const na_class_t *na_class, na_auto_route_t route,
+    na_bool_t expected)
+{
+    if (route == NA_AUTO_PRIMARY)
+        return 0;
+
+    return (expected) ? NA_AUTO_PRIVATE_DATA(na_class)->expected_header_size
+        : NA_AUTO_PRIVATE_DATA(na_class)->unexpected_header_size;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_auto_addr *
+na_auto_addr_alloc(void)
+{
+    struct na_auto_addr *na_auto_addr = NULL;
+
+    na_auto_addr = (struct na_auto_addr *) malloc(sizeof(struct na_auto_addr));
+    if (!na_auto_addr) {
+        NA_LOG_ERROR("Could not allocate NA AUTO addr");
+        goto done;
+    }
+    memset(na_auto_addr, 0, sizeof(struct na_auto_addr));
+    hg_atomic_init32(&na_auto_addr->ref_count, 1);
+
+done:
+    return na_auto_addr;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_op_setup(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, na_op_id_t *op_id,
+    struct na_auto_op_id **op_ptr)
+{
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_auto_op_id = (struct na_auto_op_id *) *op_id;
+        hg_atomic_incr32(&na_auto_op_id->ref_count);
+    } else {
+        na_auto_op_id = na_auto_op_alloc(na_class, context);
+        if (!na_auto_op_id) {
+            NA_LOG_ERROR("Could not allocate NA AUTO operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_auto_op_id->context = context;
+    na_auto_op_id->completion_data.callback_info.type = cb_type;
+    na_auto_op_id->completion_data.callback = callback;
+    na_auto_op_id->completion_data.callback_info.arg = arg;
+    na_auto_op_id->completion_data.callback_info.ret = NA_SUCCESS;
+    hg_atomic_set32(&na_auto_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_auto_op_id->canceled, NA_FALSE);
+    na_auto_op_id->route = NA_AUTO_PRIMARY;
+    na_auto_op_id->addr = NULL;
+    na_auto_op_id->name = NULL;
+    na_auto_op_id->queued = NA_FALSE;
+    /* Inner classes otherwise allocate a new one for every operation */
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++)
+        if (!na_auto_op_id->own_op_ids[i])
+            na_auto_op_id->op_ids[i] = NA_OP_ID_NULL;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_auto_op_id;
+
+    *op_ptr = na_auto_op_id;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_lookup_post(struct na_auto_op_id *na_auto_op_id,
+    na_auto_route_t route, const char *name)
+{
+    na_class_t *na_class = na_auto_op_id->na_class;
+
+    na_auto_op_id->route = route;
+
+    return NA_Addr_lookup(NA_AUTO_CLASS(na_class, route),
+        NA_AUTO_INNER_CONTEXT(na_auto_op_id->context, route),
+        na_auto_lookup_cb, na_auto_op_id, name,
+        &na_auto_op_id->op_ids[route]);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_auto_lookup_cb(const struct na_cb_info *callback_info)
+{
+    struct na_auto_op_id *na_auto_op_id =
+        (struct na_auto_op_id *) callback_info->arg;
+    struct na_cb_info *op_callback_info =
+        &na_auto_op_id->completion_data.callback_info;
+    na_auto_route_t route = na_auto_op_id->route;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Not owned operation IDs are released once this returns */
+    if (!na_auto_op_id->own_op_ids[route])
+        na_auto_op_id->op_ids[route] = NA_OP_ID_NULL;
+
+    if (callback_info->ret == NA_SUCCESS) {
+        na_auto_op_id->addr->addrs[route] = callback_info->info.lookup.addr;
+        goto complete;
+    }
+
+    /* Peer may share the host name without sharing the node */
+    if (route == NA_AUTO_SM && na_auto_op_id->name
+        && !hg_atomic_get32(&na_auto_op_id->canceled)) {
+        NA_LOG_DEBUG("Could not reach peer through sm, using %s",
+            na_auto_op_id->name);
+        ret = na_auto_lookup_post(na_auto_op_id, NA_AUTO_PRIMARY,
+            na_auto_op_id->name);
+        if (ret == NA_SUCCESS)
+            return 0;
+        NA_LOG_ERROR("Could not post lookup");
+    }
+    op_callback_info->ret = (ret != NA_SUCCESS) ? ret : callback_info->ret;
+
+complete:
+    ret = na_auto_complete(na_auto_op_id);
+
+    return (ret == NA_SUCCESS) ? 0 : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, void *plugin_data, na_addr_t dest, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) dest;
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    na_auto_route_t route = na_auto_addr_route(na_auto_addr);
+    na_bool_t expected = (cb_type == NA_CB_SEND_EXPECTED);
+    na_size_t offset = na_auto_msg_offset(na_class, route, expected);
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_auto_op_setup(na_class, context, cb_type, callback, arg, op_id,
+        &na_auto_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+    na_auto_op_id->route = route;
+
+    /* Buffers are allocated by the primary class, sm does not need them */
+    if (route != NA_AUTO_PRIMARY)
+        plugin_data = NULL;
+
+    if (expected)
+        ret = NA_Msg_send_expected(NA_AUTO_CLASS(na_class, route),
+            NA_AUTO_INNER_CONTEXT(context, route), na_auto_cb, na_auto_op_id,
+            (const char *) buf + offset, buf_size - offset, plugin_data,
+            na_auto_addr->addrs[route], tag, &na_auto_op_id->op_ids[route]);
+    else
+        ret = NA_Msg_send_unexpected(NA_AUTO_CLASS(na_class, route),
+            NA_AUTO_INNER_CONTEXT(context, route), na_auto_cb, na_auto_op_id,
+            (const char *) buf + offset, buf_size - offset, plugin_data,
+            na_auto_addr->addrs[route], tag, &na_auto_op_id->op_ids[route]);
+
+done:
+    if (ret != NA_SUCCESS && na_auto_op_id) {
+        na_auto_op_destroy(na_class, (na_op_id_t) na_auto_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_unexpected_post_all(na_class_t *na_class, na_context_t *context)
+{
+    struct na_auto_context *na_auto_context = NA_AUTO_CONTEXT(context);
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_auto_context->unexpected = (struct na_auto_unexpected *) malloc(
+        NA_AUTO_ROUTE_MAX * NA_AUTO_UNEXPECTED_COUNT
+        * sizeof(struct na_auto_unexpected));
+    if (!na_auto_context->unexpected) {
+        NA_LOG_ERROR("Could not allocate unexpected recvs");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_auto_context->unexpected, 0, NA_AUTO_ROUTE_MAX
+        * NA_AUTO_UNEXPECTED_COUNT * sizeof(struct na_auto_unexpected));
+    na_auto_context->unexpected_posted = NA_TRUE;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX * NA_AUTO_UNEXPECTED_COUNT; i++) {
+        struct na_auto_unexpected *na_auto_unexpected =
+            &na_auto_context->unexpected[i];
+        na_auto_route_t route =
+            (na_auto_route_t) (i / NA_AUTO_UNEXPECTED_COUNT);
+        na_class_t *inner_class = NA_AUTO_CLASS(na_class, route);
+
+        na_auto_unexpected->na_class = na_class;
+        na_auto_unexpected->context = context;
+        na_auto_unexpected->route = route;
+        na_auto_unexpected->buf_size =
+            NA_Msg_get_max_unexpected_size(inner_class);
+        na_auto_unexpected->buf = NA_Msg_buf_alloc(inner_class,
+            na_auto_unexpected->buf_size, &na_auto_unexpected->plugin_data);
+        if (!na_auto_unexpected->buf) {
+            NA_LOG_ERROR("Could not allocate unexpected buffer");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        na_auto_unexpected->op_id = NA_Op_create(inner_class);
+        na_auto_unexpected->own_op_id =
+            (na_auto_unexpected->op_id != NA_OP_ID_NULL);
+
+        ret = na_auto_unexpected_post(na_auto_unexpected);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not post unexpected recv");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_unexpected_post(struct na_auto_unexpected *na_auto_unexpected)
+{
+    na_auto_route_t route = na_auto_unexpected->route;
+    na_return_t ret;
+
+    na_auto_unexpected->posted = NA_TRUE;
+    ret = NA_Msg_recv_unexpected(
+        NA_AUTO_CLASS(na_auto_unexpected->na_class, route),
+        NA_AUTO_INNER_CONTEXT(na_auto_unexpected->context, route),
+        na_auto_unexpected_cb, na_auto_unexpected, na_auto_unexpected->buf,
+        na_auto_unexpected->buf_size, na_auto_unexpected->plugin_data, 0,
+        &na_auto_unexpected->op_id);
+    if (ret != NA_SUCCESS)
+        na_auto_unexpected->posted = NA_FALSE;
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_unexpected_repost(struct na_auto_context *na_auto_context)
+{
+    struct na_auto_unexpected *na_auto_unexpected;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_mutex_lock(&na_auto_context->unexpected_mutex);
+    while (!na_auto_context->destroying && (na_auto_unexpected =
+        HG_QUEUE_FIRST(&na_auto_context->unexpected_repost_queue)) != NULL) {
+        HG_QUEUE_POP_HEAD(&na_auto_context->unexpected_repost_queue, entry);
+        ret = na_auto_unexpected_post(na_auto_unexpected);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not repost unexpected recv");
+            break;
+        }
+    }
+    hg_thread_mutex_unlock(&na_auto_context->unexpected_mutex);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_auto_unexpected_cb(const struct na_cb_info *callback_info)
+{
+    struct na_auto_unexpected *na_auto_unexpected =
+        (struct na_auto_unexpected *) callback_info->arg;
+    struct na_auto_context *na_auto_context =
+        NA_AUTO_CONTEXT(na_auto_unexpected->context);
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Not owned operation IDs are released once this returns */
+    if (!na_auto_unexpected->own_op_id)
+        na_auto_unexpected->op_id = NA_OP_ID_NULL;
+    na_auto_unexpected->posted = NA_FALSE;
+
+    if (callback_info->ret != NA_SUCCESS) {
+        if (callback_info->ret != NA_CANCELED)
+            NA_LOG_ERROR("Unexpected recv failed");
+        goto done;
+    }
+    na_auto_unexpected->actual_buf_size =
+        callback_info->info.recv_unexpected.actual_buf_size;
+    na_auto_unexpected->source = callback_info->info.recv_unexpected.source;
+    na_auto_unexpected->tag = callback_info->info.recv_unexpected.tag;
+
+    /* Message is kept until an operation is posted */
+    hg_thread_mutex_lock(&na_auto_context->unexpected_mutex);
+    na_auto_op_id = HG_QUEUE_FIRST(&na_auto_context->unexpected_op_queue);
+    if (na_auto_op_id) {
+        HG_QUEUE_POP_HEAD(&na_auto_context->unexpected_op_queue, entry);
+        na_auto_op_id->queued = NA_FALSE;
+    } else
+        HG_QUEUE_PUSH_TAIL(&na_auto_context->unexpected_msg_queue,
+            na_auto_unexpected, entry);
+    hg_thread_mutex_unlock(&na_auto_context->unexpected_mutex);
+
+    if (na_auto_op_id)
+        ret = na_auto_unexpected_match(na_auto_unexpected, na_auto_op_id);
+
+done:
+    return (ret == NA_SUCCESS) ? 0 : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_unexpected_match(struct na_auto_unexpected *na_auto_unexpected,
+    struct na_auto_op_id *na_auto_op_id)
+{
+    struct na_cb_info_recv_unexpected *recv_unexpected_info =
+        &na_auto_op_id->completion_data.callback_info.info.recv_unexpected;
+    na_size_t offset = na_auto_msg_offset(na_auto_unexpected->na_class,
+        na_auto_unexpected->route, NA_FALSE);
+    na_size_t copy_size = na_auto_unexpected->actual_buf_size;
+    struct na_auto_context *na_auto_context =
+        NA_AUTO_CONTEXT(na_auto_unexpected->context);
+    struct na_auto_addr *na_auto_addr = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Sender does not send more than fits, but do not trust it */
+    if (offset + copy_size > na_auto_op_id->buf_size) {
+        NA_LOG_ERROR("Unexpected message exceeds buffer size");
+        copy_size = (offset < na_auto_op_id->buf_size) ?
+            na_auto_op_id->buf_size - offset : 0;
+        na_auto_op_id->completion_data.callback_info.ret = NA_SIZE_ERROR;
+    }
+    memcpy((char *) na_auto_op_id->buf + offset, na_auto_unexpected->buf,
+        copy_size);
+
+    /* Replies go back through the class the message came from */
+    na_auto_addr = na_auto_addr_alloc();
+    if (!na_auto_addr) {
+        NA_Addr_free(NA_AUTO_CLASS(na_auto_unexpected->na_class,
+            na_auto_unexpected->route), na_auto_unexpected->source);
+        na_auto_op_id->completion_data.callback_info.ret = NA_NOMEM_ERROR;
+    } else
+        na_auto_addr->addrs[na_auto_unexpected->route] =
+            na_auto_unexpected->source;
+    na_auto_unexpected->source = NA_ADDR_NULL;
+    recv_unexpected_info->actual_buf_size = offset + copy_size;
+    recv_unexpected_info->source = (na_addr_t) na_auto_addr;
+    recv_unexpected_info->tag = na_auto_unexpected->tag;
+
+    /* Buffer can be used again, inner operation is still being triggered */
+    hg_thread_mutex_lock(&na_auto_context->unexpected_mutex);
+    HG_QUEUE_PUSH_TAIL(&na_auto_context->unexpected_repost_queue,
+        na_auto_unexpected, entry);
+    hg_thread_mutex_unlock(&na_auto_context->unexpected_mutex);
+
+    if (na_auto_complete(na_auto_op_id) != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        ret = NA_PROTOCOL_ERROR;
+    }
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_rma(na_class_t *na_class, na_context_t *context, na_cb_type_t cb_type,
+    na_cb_t callback, void *arg, na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset, na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset, na_size_t length, na_addr_t remote_addr,
+    na_op_id_t *op_id)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) remote_addr;
+    struct na_auto_mem_handle *local_handle =
+        (struct na_auto_mem_handle *) local_mem_handle;
+    struct na_auto_mem_handle *remote_handle =
+        (struct na_auto_mem_handle *) remote_mem_handle;
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    na_auto_route_t route = na_auto_addr_route(na_auto_addr);
+    na_return_t ret = NA_SUCCESS;
+
+    if (!local_handle->handles[route] || !remote_handle->handles[route]) {
+        NA_LOG_ERROR("Memory handle was not registered with class of peer");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    ret = na_auto_op_setup(na_class, context, cb_type, callback, arg, op_id,
+        &na_auto_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+    na_auto_op_id->route = route;
+
+    if (cb_type == NA_CB_PUT)
+        ret = NA_Put(NA_AUTO_CLASS(na_class, route),
+            NA_AUTO_INNER_CONTEXT(context, route), na_auto_cb, na_auto_op_id,
+            local_handle->handles[route], local_offset,
+            remote_handle->handles[route], remote_offset, length,
+            na_auto_addr->addrs[route], &na_auto_op_id->op_ids[route]);
+    else
+        ret = NA_Get(NA_AUTO_CLASS(na_class, route),
+            NA_AUTO_INNER_CONTEXT(context, route), na_auto_cb, na_auto_op_id,
+            local_handle->handles[route], local_offset,
+            remote_handle->handles[route], remote_offset, length,
+            na_auto_addr->addrs[route], &na_auto_op_id->op_ids[route]);
+
+done:
+    if (ret != NA_SUCCESS && na_auto_op_id) {
+        na_auto_op_destroy(na_class, (na_op_id_t) na_auto_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_auto_cb(const struct na_cb_info *callback_info)
+{
+    struct na_auto_op_id *na_auto_op_id =
+        (struct na_auto_op_id *) callback_info->arg;
+    na_auto_route_t route = na_auto_op_id->route;
+
+    /* Not owned operation IDs are released once this returns */
+    if (!na_auto_op_id->own_op_ids[route])
+        na_auto_op_id->op_ids[route] = NA_OP_ID_NULL;
+
+    na_auto_op_id->completion_data.callback_info.ret = callback_info->ret;
+
+    return (na_auto_complete(na_auto_op_id) == NA_SUCCESS) ? 0 : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_complete(struct na_auto_op_id *na_auto_op_id)
+{
+    struct na_cb_info *callback_info =
+        &na_auto_op_id->completion_data.callback_info;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_auto_op_id->canceled)
+        && callback_info->ret == NA_SUCCESS)
+        callback_info->ret = NA_CANCELED;
+
+    switch (callback_info->type) {
+        case NA_CB_LOOKUP:
+            if (callback_info->ret == NA_SUCCESS)
+                callback_info->info.lookup.addr =
+                    (na_addr_t) na_auto_op_id->addr;
+            else {
+                na_auto_addr_free(na_auto_op_id->na_class,
+                    (na_addr_t) na_auto_op_id->addr);
+                callback_info->info.lookup.addr = NA_ADDR_NULL;
+            }
+            na_auto_op_id->addr = NULL;
+            free(na_auto_op_id->name);
+            na_auto_op_id->name = NULL;
+            break;
+        case NA_CB_RECV_UNEXPECTED:
+            if (callback_info->ret != NA_SUCCESS) {
+                /* In case of cancellation where no recv'd data */
+                if (callback_info->info.recv_unexpected.source)
+                    na_auto_addr_free(na_auto_op_id->na_class,
+                        callback_info->info.recv_unexpected.source);
+                callback_info->info.recv_unexpected.actual_buf_size = 0;
+                callback_info->info.recv_unexpected.source = NA_ADDR_NULL;
+                callback_info->info.recv_unexpected.tag = 0;
+            }
+            break;
+        default:
+            break;
+    }
+
+    /* Mark op id as completed */
+    hg_atomic_set32(&na_auto_op_id->completed, NA_TRUE);
+
+    ret = na_cb_completion_add(na_auto_op_id->context,
+        &na_auto_op_id->completion_data);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add callback to completion queue");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_auto_release(void *arg)
+{
+    struct na_auto_op_id *na_auto_op_id = (struct na_auto_op_id *) arg;
+
+    if (na_auto_op_id && !hg_atomic_get32(&na_auto_op_id->completed)) {
+        NA_LOG_WARNING("Releasing resources from an uncompleted operation");
+    }
+    na_auto_op_destroy(NULL, na_auto_op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_trigger(struct na_auto_context *na_auto_context,
+    na_bool_t *progressed)
+{
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Completions of inner classes complete operations */
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        unsigned int count = 0;
+
+        do {
+            ret = NA_Trigger(na_auto_context->contexts[i], 0,
+                NA_AUTO_TRIGGER_MAX, NULL, &count);
+            if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+                NA_LOG_ERROR("Could not trigger inner class callbacks");
+                goto done;
+            }
+            if (count)
+                *progressed = NA_TRUE;
+        } while (count == NA_AUTO_TRIGGER_MAX);
+    }
+
+    ret = na_auto_unexpected_repost(na_auto_context);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_auto_progress_cb(void *arg, unsigned int NA_UNUSED timeout,
+    hg_util_bool_t *progressed)
+{
+    struct na_auto_poll_arg *na_auto_poll_arg =
+        (struct na_auto_poll_arg *) arg;
+    na_return_t ret;
+
+    /* Poll set has already waited */
+    ret = NA_Progress(na_auto_poll_arg->na_class, na_auto_poll_arg->context,
+        0);
+    if (ret == NA_SUCCESS)
+        *progressed = HG_UTIL_TRUE;
+    else if (ret != NA_TIMEOUT) {
+        NA_LOG_ERROR("Could not make progress on inner class");
+        return HG_UTIL_FAIL;
+    }
+
+    return HG_UTIL_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_util_bool_t
+na_auto_poll_try_wait_cb(void *arg)
+{
+    struct na_auto_context *na_auto_context = (struct na_auto_context *) arg;
+    unsigned int i;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++)
+        if (!NA_Poll_try_wait(na_auto_context->poll_args[i].na_class,
+            na_auto_context->contexts[i]))
+            return HG_UTIL_FALSE;
+
+    return HG_UTIL_TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_auto_op_id *
+na_auto_op_alloc(na_class_t *na_class, na_context_t *context)
+{
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    unsigned int i;
+
+    na_auto_op_id = (struct na_auto_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_auto_op_id));
+    if (!na_auto_op_id) {
+        NA_LOG_ERROR("Could not allocate NA AUTO operation ID");
+        goto done;
+    }
+    memset(na_auto_op_id, 0, sizeof(struct na_auto_op_id));
+    na_auto_op_id->na_class = na_class;
+    hg_atomic_init32(&na_auto_op_id->ref_count, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_auto_op_id->completed, NA_TRUE);
+
+    /* Operations of inner classes are reused every time, pooled operations
+     * leave them to the inner classes, which allocate them from their pools */
+    for (i = 0; i < NA_AUTO_ROUTE_MAX && !context; i++) {
+        na_auto_op_id->op_ids[i] = NA_Op_create(NA_AUTO_CLASS(na_class, i));
+        na_auto_op_id->own_op_ids[i] =
+            (na_auto_op_id->op_ids[i] != NA_OP_ID_NULL);
+    }
+
+    /* Set op ID release callbacks */
+    na_auto_op_id->completion_data.plugin_callback = na_auto_release;
+    na_auto_op_id->completion_data.plugin_callback_args = na_auto_op_id;
+
+done:
+    return na_auto_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_auto_check_protocol(const char *protocol_name)
+{
+    /* Primary class must be named, "+" can only be found in the protocol
+     * name when the auto class was explicitly requested, which prevents
+     * it from being selected for protocols that no plugin supports */
+    return (strchr(protocol_name, '+') != NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t listen)
+{
+    struct na_auto_private_data *na_auto_private_data = NULL;
+    char info_string[NA_AUTO_MAX_INFO_STRING];
+    na_class_t *primary_class;
+    na_return_t ret = NA_SUCCESS;
+
+    /**
+     * Primary class is initialized from what follows "auto+":
+     *   auto+<class>+<protocol>[://[<host string>]]
+     */
+    if (na_info->host_name)
+        ret = (snprintf(info_string, NA_AUTO_MAX_INFO_STRING, "%s://%s",
+            na_info->protocol_name, na_info->host_name)
+            < NA_AUTO_MAX_INFO_STRING) ? NA_SUCCESS : NA_SIZE_ERROR;
+    else
+        ret = (snprintf(info_string, NA_AUTO_MAX_INFO_STRING, "%s",
+            na_info->protocol_name)
+            < NA_AUTO_MAX_INFO_STRING) ? NA_SUCCESS : NA_SIZE_ERROR;
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Exceeding max info string");
+        goto done;
+    }
+
+    na_auto_private_data = (struct na_auto_private_data *) malloc(
+        sizeof(struct na_auto_private_data));
+    if (!na_auto_private_data) {
+        NA_LOG_ERROR("Could not allocate NA private data class");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_auto_private_data, 0, sizeof(struct na_auto_private_data));
+    na_class->private_data = na_auto_private_data;
+
+    /* Peers sharing the host name are assumed to be on the same node,
+     * lookup falls back to the primary class otherwise */
+    if (gethostname(na_auto_private_data->hostname, NA_AUTO_MAX_HOSTNAME)
+        != 0) {
+        NA_LOG_ERROR("gethostname() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_auto_private_data->hostname[NA_AUTO_MAX_HOSTNAME - 1] = '\0';
+
+    primary_class = NA_Initialize_opt(info_string, listen,
+        &na_info->na_init_info);
+    if (!primary_class) {
+        NA_LOG_ERROR("Could not initialize primary class with %s",
+            info_string);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_auto_private_data->classes[NA_AUTO_PRIMARY] = primary_class;
+
+    na_auto_private_data->classes[NA_AUTO_SM] =
+        NA_Initialize(NA_AUTO_SM_INFO_STRING, listen);
+    if (!na_auto_private_data->classes[NA_AUTO_SM]) {
+        NA_LOG_ERROR("Could not initialize sm class");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* sm defines no header, messages reserve room for the primary one */
+    na_auto_private_data->unexpected_header_size =
+        NA_Msg_get_unexpected_header_size(primary_class);
+    na_auto_private_data->expected_header_size =
+        NA_Msg_get_expected_header_size(primary_class);
+
+    /* Both classes must support it for the handle to be usable */
+    if (!primary_class->mem_handle_create_segments
+        || !NA_AUTO_CLASS(na_class, NA_AUTO_SM)->mem_handle_create_segments)
+        na_class->mem_handle_create_segments = NULL;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_finalize(na_class_t *na_class)
+{
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_class->private_data) {
+        goto done;
+    }
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        if (!NA_AUTO_CLASS(na_class, i))
+            continue;
+        ret = NA_Finalize(NA_AUTO_CLASS(na_class, i));
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not finalize inner class");
+            goto done;
+        }
+    }
+
+    free(na_class->private_data);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_auto_check_feature(na_class_t *na_class, na_uint8_t feature)
+{
+    return NA_Check_feature(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY), feature);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_context_create(na_class_t *na_class, void **context)
+{
+    struct na_auto_context *na_auto_context = NULL;
+    na_bool_t use_poll = NA_TRUE;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_auto_context = (struct na_auto_context *) malloc(
+        sizeof(struct na_auto_context));
+    if (!na_auto_context) {
+        NA_LOG_ERROR("Could not allocate NA AUTO context");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_auto_context, 0, sizeof(struct na_auto_context));
+    HG_QUEUE_INIT(&na_auto_context->unexpected_msg_queue);
+    HG_QUEUE_INIT(&na_auto_context->unexpected_repost_queue);
+    HG_QUEUE_INIT(&na_auto_context->unexpected_op_queue);
+    hg_thread_mutex_init(&na_auto_context->unexpected_mutex);
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        na_class_t *inner_class = NA_AUTO_CLASS(na_class, i);
+
+        na_auto_context->contexts[i] = NA_Context_create(inner_class);
+        if (!na_auto_context->contexts[i]) {
+            NA_LOG_ERROR("Could not create context of inner class");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        na_auto_context->poll_args[i].na_class = inner_class;
+        na_auto_context->poll_args[i].context = na_auto_context->contexts[i];
+        if (!inner_class->na_poll_get_fd
+            || NA_Poll_get_fd(inner_class, na_auto_context->contexts[i]) <= 0)
+            use_poll = NA_FALSE;
+    }
+
+    /* Wait on both classes at once if they can be polled */
+    if (use_poll) {
+        na_auto_context->poll_set = hg_poll_create();
+        if (!na_auto_context->poll_set) {
+            NA_LOG_ERROR("Could not create poll set");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        hg_poll_set_try_wait(na_auto_context->poll_set,
+            na_auto_poll_try_wait_cb, na_auto_context);
+        for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+            if (hg_poll_add(na_auto_context->poll_set,
+                NA_Poll_get_fd(na_auto_context->poll_args[i].na_class,
+                    na_auto_context->contexts[i]), HG_POLLIN,
+                na_auto_progress_cb, &na_auto_context->poll_args[i])
+                != HG_UTIL_SUCCESS) {
+                NA_LOG_ERROR("Could not add fd to poll set");
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+            }
+        }
+    }
+
+    *context = na_auto_context;
+
+done:
+    if (ret != NA_SUCCESS && na_auto_context) {
+        if (na_auto_context->poll_set)
+            hg_poll_destroy(na_auto_context->poll_set);
+        for (i = 0; i < NA_AUTO_ROUTE_MAX; i++)
+            if (na_auto_context->contexts[i])
+                NA_Context_destroy(NA_AUTO_CLASS(na_class, i),
+                    na_auto_context->contexts[i]);
+        hg_thread_mutex_destroy(&na_auto_context->unexpected_mutex);
+        free(na_auto_context);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_context_destroy(na_class_t *na_class, void *context)
+{
+    struct na_auto_context *na_auto_context =
+        (struct na_auto_context *) context;
+    struct na_auto_unexpected *na_auto_unexpected;
+    unsigned int i, retry;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!HG_QUEUE_IS_EMPTY(&na_auto_context->unexpected_op_queue)) {
+        NA_LOG_ERROR("Unexpected operations are still pending");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Cancel unexpected recvs and wait for inner classes to complete them */
+    na_auto_context->destroying = NA_TRUE;
+    if (na_auto_context->unexpected_posted) {
+        na_bool_t posted = NA_FALSE;
+
+        for (i = 0; i < NA_AUTO_ROUTE_MAX * NA_AUTO_UNEXPECTED_COUNT; i++) {
+            na_auto_unexpected = &na_auto_context->unexpected[i];
+            if (!na_auto_unexpected->posted)
+                continue;
+            ret = NA_Cancel(NA_AUTO_CLASS(na_class, na_auto_unexpected->route),
+                na_auto_context->contexts[na_auto_unexpected->route],
+                na_auto_unexpected->op_id);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not cancel unexpected recv");
+                goto done;
+            }
+        }
+
+        for (retry = 0; retry < NA_AUTO_DESTROY_RETRY; retry++) {
+            na_bool_t progressed = NA_FALSE;
+
+            posted = NA_FALSE;
+            for (i = 0; i < NA_AUTO_ROUTE_MAX * NA_AUTO_UNEXPECTED_COUNT; i++)
+                if (na_auto_context->unexpected[i].posted)
+                    posted = NA_TRUE;
+            if (!posted)
+                break;
+            for (i = 0; i < NA_AUTO_ROUTE_MAX; i++)
+                NA_Progress(NA_AUTO_CLASS(na_class, i),
+                    na_auto_context->contexts[i], 0);
+            ret = na_auto_trigger(na_auto_context, &progressed);
+            if (ret != NA_SUCCESS)
+                goto done;
+        }
+        if (posted) {
+            NA_LOG_ERROR("Unexpected recvs could not be canceled");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        /* Messages that were never received */
+        while ((na_auto_unexpected =
+            HG_QUEUE_FIRST(&na_auto_context->unexpected_msg_queue)) != NULL) {
+            HG_QUEUE_POP_HEAD(&na_auto_context->unexpected_msg_queue, entry);
+            NA_Addr_free(NA_AUTO_CLASS(na_class, na_auto_unexpected->route),
+                na_auto_unexpected->source);
+        }
+
+        for (i = 0; i < NA_AUTO_ROUTE_MAX * NA_AUTO_UNEXPECTED_COUNT; i++) {
+            na_class_t *inner_class;
+
+            na_auto_unexpected = &na_auto_context->unexpected[i];
+            inner_class = NA_AUTO_CLASS(na_class, na_auto_unexpected->route);
+            if (na_auto_unexpected->own_op_id)
+                NA_Op_destroy(inner_class, na_auto_unexpected->op_id);
+            if (na_auto_unexpected->buf)
+                NA_Msg_buf_free(inner_class, na_auto_unexpected->buf,
+                    na_auto_unexpected->plugin_data);
+        }
+        free(na_auto_context->unexpected);
+        na_auto_context->unexpected = NULL;
+        na_auto_context->unexpected_posted = NA_FALSE;
+    }
+
+    if (na_auto_context->poll_set) {
+        for (i = 0; i < NA_AUTO_ROUTE_MAX; i++)
+            hg_poll_remove(na_auto_context->poll_set,
+                NA_Poll_get_fd(NA_AUTO_CLASS(na_class, i),
+                    na_auto_context->contexts[i]));
+        hg_poll_destroy(na_auto_context->poll_set);
+        na_auto_context->poll_set = NULL;
+    }
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Context_destroy(NA_AUTO_CLASS(na_class, i),
+            na_auto_context->contexts[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not destroy context of inner class");
+            goto done;
+        }
+    }
+
+    hg_thread_mutex_destroy(&na_auto_context->unexpected_mutex);
+    free(na_auto_context);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_auto_op_create(na_class_t *na_class)
+{
+    return (na_op_id_t) na_auto_op_alloc(na_class, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
+{
+    struct na_auto_op_id *na_auto_op_id = (struct na_auto_op_id *) op_id;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_decr32(&na_auto_op_id->ref_count)) {
+        /* Cannot free yet */
+        goto done;
+    }
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        if (!na_auto_op_id->own_op_ids[i])
+            continue;
+        ret = NA_Op_destroy(NA_AUTO_CLASS(na_auto_op_id->na_class, i),
+            na_auto_op_id->op_ids[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not destroy operation of inner class");
+        }
+    }
+    na_op_id_free(na_auto_op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_auto_private_data *na_auto_private_data =
+        NA_AUTO_PRIVATE_DATA(na_class);
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    char *name_string = NULL, *sm_name, *primary_name;
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_auto_op_setup(na_class, context, NA_CB_LOOKUP, callback, arg,
+        op_id, &na_auto_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+    na_auto_op_id->addr = na_auto_addr_alloc();
+    if (!na_auto_op_id->addr) {
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+
+    /* Names of other classes only reach the primary class */
+    name_string = strdup(name);
+    if (!name_string) {
+        NA_LOG_ERROR("Could not duplicate string");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    sm_name = strchr(name_string, NA_AUTO_ADDR_SEP);
+    primary_name = (sm_name) ? strchr(sm_name + 1, NA_AUTO_ADDR_SEP) : NULL;
+    if (!primary_name) {
+        ret = na_auto_lookup_post(na_auto_op_id, NA_AUTO_PRIMARY, name);
+        goto done;
+    }
+    *sm_name++ = '\0';
+    *primary_name++ = '\0';
+
+    if (*sm_name && !strcmp(name_string, na_auto_private_data->hostname)) {
+        if (*primary_name) {
+            na_auto_op_id->name = strdup(primary_name);
+            if (!na_auto_op_id->name) {
+                NA_LOG_ERROR("Could not duplicate string");
+                ret = NA_NOMEM_ERROR;
+                goto done;
+            }
+        }
+        ret = na_auto_lookup_post(na_auto_op_id, NA_AUTO_SM, sm_name);
+        if (ret == NA_SUCCESS || !*primary_name)
+            goto done;
+        NA_LOG_DEBUG("Could not reach peer through sm, using %s",
+            primary_name);
+        free(na_auto_op_id->name);
+        na_auto_op_id->name = NULL;
+    }
+    if (!*primary_name) {
+        NA_LOG_ERROR("Peer is not on this node and has no primary addr");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+    ret = na_auto_lookup_post(na_auto_op_id, NA_AUTO_PRIMARY, primary_name);
+
+done:
+    free(name_string);
+    if (ret != NA_SUCCESS && na_auto_op_id) {
+        if (na_auto_op_id->addr)
+            na_auto_addr_free(na_class, (na_addr_t) na_auto_op_id->addr);
+        na_auto_op_id->addr = NULL;
+        free(na_auto_op_id->name);
+        na_auto_op_id->name = NULL;
+        na_auto_op_destroy(na_class, (na_op_id_t) na_auto_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_addr_free(na_class_t *na_class, na_addr_t addr)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) addr;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_decr32(&na_auto_addr->ref_count)) {
+        /* Cannot free yet */
+        goto done;
+    }
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        if (na_auto_addr->addrs[i] == NA_ADDR_NULL)
+            continue;
+        ret = NA_Addr_free(NA_AUTO_CLASS(na_class, i), na_auto_addr->addrs[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not free addr of inner class");
+        }
+    }
+    free(na_auto_addr);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_addr_self(na_class_t *na_class, na_addr_t *addr)
+{
+    struct na_auto_addr *na_auto_addr = NULL;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_auto_addr = na_auto_addr_alloc();
+    if (!na_auto_addr) {
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    na_auto_addr->self = NA_TRUE;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Addr_self(NA_AUTO_CLASS(na_class, i), &na_auto_addr->addrs[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not get self addr of inner class");
+            goto done;
+        }
+    }
+
+    *addr = (na_addr_t) na_auto_addr;
+
+done:
+    if (ret != NA_SUCCESS && na_auto_addr) {
+        na_auto_addr_free(na_class, (na_addr_t) na_auto_addr);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_addr_dup(na_class_t NA_UNUSED *na_class, na_addr_t addr,
+    na_addr_t *new_addr)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) addr;
+
+    hg_atomic_incr32(&na_auto_addr->ref_count);
+    *new_addr = addr;
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_auto_addr_is_self(na_class_t NA_UNUSED *na_class, na_addr_t addr)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) addr;
+
+    return na_auto_addr->self;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_addr_to_string(na_class_t *na_class, char *buf, na_size_t *buf_size,
+    na_addr_t addr)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) addr;
+    char addr_strings[NA_AUTO_ROUTE_MAX][NA_AUTO_MAX_ADDR_STRING];
+    char addr_string[NA_AUTO_MAX_ADDR_STRING];
+    na_size_t string_len;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        na_size_t addr_string_size = NA_AUTO_MAX_ADDR_STRING;
+
+        addr_strings[i][0] = '\0';
+        if (na_auto_addr->addrs[i] == NA_ADDR_NULL)
+            continue;
+        ret = NA_Addr_to_string(NA_AUTO_CLASS(na_class, i), addr_strings[i],
+            &addr_string_size, na_auto_addr->addrs[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not convert addr of inner class to string");
+            goto done;
+        }
+    }
+
+    /* Class name is kept so that lookup only strips that part */
+    string_len = (na_size_t) snprintf(addr_string, NA_AUTO_MAX_ADDR_STRING,
+        "auto+%s%c%s%c%s", NA_AUTO_PRIVATE_DATA(na_class)->hostname,
+        NA_AUTO_ADDR_SEP, addr_strings[NA_AUTO_SM], NA_AUTO_ADDR_SEP,
+        addr_strings[NA_AUTO_PRIMARY]);
+    if (string_len >= NA_AUTO_MAX_ADDR_STRING) {
+        NA_LOG_ERROR("Exceeding max addr string");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+    if (buf) {
+        if (string_len >= *buf_size) {
+            NA_LOG_ERROR("Buffer size too small to copy addr");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        } else {
+            strcpy(buf, addr_string);
+        }
+    }
+
+    *buf_size = string_len + 1;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_auto_msg_get_max_unexpected_size(const na_class_t *na_class)
+{
+    na_size_t primary_size = NA_Msg_get_max_unexpected_size(
+        NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY));
+    na_size_t sm_size = NA_Msg_get_max_unexpected_size(
+        NA_AUTO_CLASS(na_class, NA_AUTO_SM))
+        + na_auto_msg_offset(na_class, NA_AUTO_SM, NA_FALSE);
+
+    return (primary_size < sm_size) ? primary_size : sm_size;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_auto_msg_get_max_expected_size(const na_class_t *na_class)
+{
+    na_size_t primary_size = NA_Msg_get_max_expected_size(
+        NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY));
+    na_size_t sm_size = NA_Msg_get_max_expected_size(
+        NA_AUTO_CLASS(na_class, NA_AUTO_SM))
+        + na_auto_msg_offset(na_class, NA_AUTO_SM, NA_TRUE);
+
+    return (primary_size < sm_size) ? primary_size : sm_size;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_auto_msg_get_unexpected_header_size(const na_class_t *na_class)
+{
+    return NA_AUTO_PRIVATE_DATA(na_class)->unexpected_header_size;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_auto_msg_get_expected_header_size(const na_class_t *na_class)
+{
+    return NA_AUTO_PRIVATE_DATA(na_class)->expected_header_size;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_tag_t
+na_auto_msg_get_max_tag(const na_class_t *na_class)
+{
+    na_tag_t primary_tag = NA_Msg_get_max_tag(
+        NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY));
+    na_tag_t sm_tag = NA_Msg_get_max_tag(NA_AUTO_CLASS(na_class, NA_AUTO_SM));
+
+    return (primary_tag < sm_tag) ? primary_tag : sm_tag;
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_auto_msg_buf_alloc(na_class_t *na_class, na_size_t buf_size,
+    void **plugin_data)
+{
+    return NA_Msg_buf_alloc(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY),
+        buf_size, plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    return NA_Msg_buf_free(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY), buf,
+        plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_init_unexpected(na_class_t *na_class, void *buf,
+    na_size_t buf_size)
+{
+    /* Header of sm is empty */
+    return NA_Msg_init_unexpected(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY),
+        buf, buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest, na_tag_t tag, na_op_id_t *op_id)
+{
+    return na_auto_msg_send(na_class, context, NA_CB_SEND_UNEXPECTED,
+        callback, arg, buf, buf_size, plugin_data, dest, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_tag_t NA_UNUSED mask, na_op_id_t *op_id)
+{
+    struct na_auto_context *na_auto_context = NA_AUTO_CONTEXT(context);
+    struct na_auto_unexpected *na_auto_unexpected = NULL;
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_auto_op_setup(na_class, context, NA_CB_RECV_UNEXPECTED, callback,
+        arg, op_id, &na_auto_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+    na_auto_op_id->buf = buf;
+    na_auto_op_id->buf_size = buf_size;
+    na_auto_op_id->completion_data.callback_info.info.recv_unexpected.source =
+        NA_ADDR_NULL;
+
+    /* Messages arrive on either class and are copied to posted buffers */
+    hg_thread_mutex_lock(&na_auto_context->unexpected_mutex);
+    if (!na_auto_context->unexpected_posted) {
+        ret = na_auto_unexpected_post_all(na_class, context);
+        if (ret != NA_SUCCESS) {
+            hg_thread_mutex_unlock(&na_auto_context->unexpected_mutex);
+            NA_LOG_ERROR("Could not post unexpected recvs");
+            goto done;
+        }
+    }
+    na_auto_unexpected =
+        HG_QUEUE_FIRST(&na_auto_context->unexpected_msg_queue);
+    if (na_auto_unexpected)
+        HG_QUEUE_POP_HEAD(&na_auto_context->unexpected_msg_queue, entry);
+    else {
+        na_auto_op_id->queued = NA_TRUE;
+        HG_QUEUE_PUSH_TAIL(&na_auto_context->unexpected_op_queue,
+            na_auto_op_id, entry);
+    }
+    hg_thread_mutex_unlock(&na_auto_context->unexpected_mutex);
+
+    if (na_auto_unexpected) {
+        ret = na_auto_unexpected_match(na_auto_unexpected, na_auto_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not match unexpected message");
+        }
+        /* Operation was completed */
+        ret = NA_SUCCESS;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_auto_op_id) {
+        na_auto_op_destroy(na_class, (na_op_id_t) na_auto_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_init_expected(na_class_t *na_class, void *buf, na_size_t buf_size)
+{
+    /* Header of sm is empty */
+    return NA_Msg_init_expected(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY), buf,
+        buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest, na_tag_t tag, na_op_id_t *op_id)
+{
+    return na_auto_msg_send(na_class, context, NA_CB_SEND_EXPECTED, callback,
+        arg, buf, buf_size, plugin_data, dest, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t source, na_tag_t tag, na_op_id_t *op_id)
+{
+    struct na_auto_addr *na_auto_addr = (struct na_auto_addr *) source;
+    struct na_auto_op_id *na_auto_op_id = NULL;
+    na_auto_route_t route = na_auto_addr_route(na_auto_addr);
+    na_size_t offset = na_auto_msg_offset(na_class, route, NA_TRUE);
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_auto_op_setup(na_class, context, NA_CB_RECV_EXPECTED, callback,
+        arg, op_id, &na_auto_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+    na_auto_op_id->route = route;
+
+    /* Buffers are allocated by the primary class, sm does not need them */
+    if (route != NA_AUTO_PRIMARY)
+        plugin_data = NULL;
+
+    /* Peer replies through the class used to send it the request */
+    ret = NA_Msg_recv_expected(NA_AUTO_CLASS(na_class, route),
+        NA_AUTO_INNER_CONTEXT(context, route), na_auto_cb, na_auto_op_id,
+        (char *) buf + offset, buf_size - offset, plugin_data,
+        na_auto_addr->addrs[route], tag, &na_auto_op_id->op_ids[route]);
+
+done:
+    if (ret != NA_SUCCESS && na_auto_op_id) {
+        na_auto_op_destroy(na_class, (na_op_id_t) na_auto_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_auto_mem_alloc(na_class_t *na_class, na_size_t buf_size,
+    void **plugin_data)
+{
+    return NA_Mem_alloc(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY), buf_size,
+        plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    return NA_Mem_free(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY), buf,
+        plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_handle_create(na_class_t *na_class, void *buf, na_size_t buf_size,
+    unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle = NULL;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_auto_mem_handle = (struct na_auto_mem_handle *) malloc(
+        sizeof(struct na_auto_mem_handle));
+    if (!na_auto_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA AUTO memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_auto_mem_handle, 0, sizeof(struct na_auto_mem_handle));
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Mem_handle_create(NA_AUTO_CLASS(na_class, i), buf, buf_size,
+            flags, &na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not create memory handle of inner class");
+            goto done;
+        }
+    }
+
+    *mem_handle = (na_mem_handle_t) na_auto_mem_handle;
+
+done:
+    if (ret != NA_SUCCESS && na_auto_mem_handle) {
+        na_auto_mem_handle_free(na_class, (na_mem_handle_t) na_auto_mem_handle);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_handle_create_segments(na_class_t *na_class,
+    struct na_segment *segments, na_size_t segment_count, unsigned long flags,
+    na_mem_handle_t *mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle = NULL;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_auto_mem_handle = (struct na_auto_mem_handle *) malloc(
+        sizeof(struct na_auto_mem_handle));
+    if (!na_auto_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA AUTO memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_auto_mem_handle, 0, sizeof(struct na_auto_mem_handle));
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Mem_handle_create_segments(NA_AUTO_CLASS(na_class, i),
+            segments, segment_count, flags, &na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not create memory handle of inner class");
+            goto done;
+        }
+    }
+
+    *mem_handle = (na_mem_handle_t) na_auto_mem_handle;
+
+done:
+    if (ret != NA_SUCCESS && na_auto_mem_handle) {
+        na_auto_mem_handle_free(na_class, (na_mem_handle_t) na_auto_mem_handle);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_handle_free(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        if (na_auto_mem_handle->handles[i] == NA_MEM_HANDLE_NULL)
+            continue;
+        ret = NA_Mem_handle_free(NA_AUTO_CLASS(na_class, i),
+            na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not free memory handle of inner class");
+        }
+    }
+    free(na_auto_mem_handle);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_register(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Mem_register(NA_AUTO_CLASS(na_class, i),
+            na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not register memory handle of inner class");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_deregister(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Mem_deregister(NA_AUTO_CLASS(na_class, i),
+            na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not deregister memory handle of inner class");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_publish(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Mem_publish(NA_AUTO_CLASS(na_class, i),
+            na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not publish memory handle of inner class");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_unpublish(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        ret = NA_Mem_unpublish(NA_AUTO_CLASS(na_class, i),
+            na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not unpublish memory handle of inner class");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_auto_mem_handle_get_serialize_size(na_class_t *na_class,
+    na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    na_size_t ret = 0;
+    unsigned int i;
+
+    /* Handle of each class is preceded by its size */
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++)
+        ret += sizeof(na_size_t) + NA_Mem_handle_get_serialize_size(
+            NA_AUTO_CLASS(na_class, i), na_auto_mem_handle->handles[i]);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_handle_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle =
+        (struct na_auto_mem_handle *) mem_handle;
+    char *buf_ptr = (char *) buf;
+    na_size_t buf_size_left = buf_size;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        na_size_t serialize_size = NA_Mem_handle_get_serialize_size(
+            NA_AUTO_CLASS(na_class, i), na_auto_mem_handle->handles[i]);
+
+        if (buf_size_left < sizeof(na_size_t) + serialize_size) {
+            NA_LOG_ERROR("Buffer size too small for serializing handle");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        }
+        memcpy(buf_ptr, &serialize_size, sizeof(na_size_t));
+        buf_ptr += sizeof(na_size_t);
+        buf_size_left -= sizeof(na_size_t);
+
+        ret = NA_Mem_handle_serialize(NA_AUTO_CLASS(na_class, i), buf_ptr,
+            serialize_size, na_auto_mem_handle->handles[i]);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not serialize memory handle of inner class");
+            goto done;
+        }
+        buf_ptr += serialize_size;
+        buf_size_left -= serialize_size;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_mem_handle_deserialize(na_class_t *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size)
+{
+    struct na_auto_mem_handle *na_auto_mem_handle = NULL;
+    const char *buf_ptr = (const char *) buf;
+    na_size_t buf_size_left = buf_size;
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_auto_mem_handle = (struct na_auto_mem_handle *) malloc(
+        sizeof(struct na_auto_mem_handle));
+    if (!na_auto_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA AUTO memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_auto_mem_handle, 0, sizeof(struct na_auto_mem_handle));
+
+    for (i = 0; i < NA_AUTO_ROUTE_MAX; i++) {
+        na_size_t serialize_size;
+
+        if (buf_size_left < sizeof(na_size_t)) {
+            NA_LOG_ERROR("Buffer size too small for deserializing handle");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        }
+        memcpy(&serialize_size, buf_ptr, sizeof(na_size_t));
+        buf_ptr += sizeof(na_size_t);
+        buf_size_left -= sizeof(na_size_t);
+        if (buf_size_left < serialize_size) {
+            NA_LOG_ERROR("Buffer size too small for deserializing handle");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        }
+
+        /* Handle of sm is only used if the peer is on this node */
+        ret = NA_Mem_handle_deserialize(NA_AUTO_CLASS(na_class, i),
+            &na_auto_mem_handle->handles[i], buf_ptr, serialize_size);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not deserialize memory handle of inner class");
+            goto done;
+        }
+        buf_ptr += serialize_size;
+        buf_size_left -= serialize_size;
+    }
+
+    *mem_handle = (na_mem_handle_t) na_auto_mem_handle;
+
+done:
+    if (ret != NA_SUCCESS && na_auto_mem_handle) {
+        na_auto_mem_handle_free(na_class, (na_mem_handle_t) na_auto_mem_handle);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id)
+{
+    return na_auto_rma(na_class, context, NA_CB_PUT, callback, arg,
+        local_mem_handle, local_offset, remote_mem_handle, remote_offset,
+        length, remote_addr, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id)
+{
+    return na_auto_rma(na_class, context, NA_CB_GET, callback, arg,
+        local_mem_handle, local_offset, remote_mem_handle, remote_offset,
+        length, remote_addr, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_auto_poll_get_fd(na_class_t NA_UNUSED *na_class, na_context_t *context)
+{
+    struct na_auto_context *na_auto_context = NA_AUTO_CONTEXT(context);
+
+    /* Progress must be used to wait if classes cannot be polled */
+    if (!na_auto_context->poll_set)
+        return -1;
+
+    return hg_poll_get_fd(na_auto_context->poll_set);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_auto_poll_try_wait(na_class_t NA_UNUSED *na_class, na_context_t *context)
+{
+    return (na_bool_t) na_auto_poll_try_wait_cb(NA_AUTO_CONTEXT(context));
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_progress(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout)
+{
+    struct na_auto_context *na_auto_context = NA_AUTO_CONTEXT(context);
+    double remaining = timeout / 1000.0; /* Convert timeout in ms into s */
+    na_return_t ret = NA_TIMEOUT;
+
+    do {
+        hg_time_t t1, t2;
+        na_bool_t progressed = NA_FALSE;
+
+        /* Completions of inner classes are not seen on the fds */
+        ret = na_auto_trigger(na_auto_context, &progressed);
+        if (ret != NA_SUCCESS)
+            goto done;
+        if (progressed) {
+            ret = NA_SUCCESS;
+            goto done;
+        }
+
+        if (timeout)
+            hg_time_get_current(&t1);
+
+        if (na_auto_context->poll_set) {
+            hg_util_bool_t poll_progressed = HG_UTIL_FALSE;
+
+            if (hg_poll_wait(na_auto_context->poll_set,
+                (unsigned int) (remaining * 1000.0), &poll_progressed)
+                != HG_UTIL_SUCCESS) {
+                NA_LOG_ERROR("hg_poll_wait() failed");
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+            }
+            progressed = (na_bool_t) poll_progressed;
+        } else {
+            unsigned int primary_timeout =
+                (unsigned int) (remaining * 1000.0);
+
+            /* Classes are polled in turn, sm without blocking */
+            ret = NA_Progress(NA_AUTO_CLASS(na_class, NA_AUTO_SM),
+                na_auto_context->contexts[NA_AUTO_SM], 0);
+            if (ret == NA_SUCCESS)
+                progressed = NA_TRUE;
+            else if (ret != NA_TIMEOUT) {
+                NA_LOG_ERROR("Could not make progress on sm class");
+                goto done;
+            }
+            if (progressed || primary_timeout > NA_AUTO_PROGRESS_TIMEOUT)
+                primary_timeout = (progressed) ? 0 : NA_AUTO_PROGRESS_TIMEOUT;
+            ret = NA_Progress(NA_AUTO_CLASS(na_class, NA_AUTO_PRIMARY),
+                na_auto_context->contexts[NA_AUTO_PRIMARY], primary_timeout);
+            if (ret == NA_SUCCESS)
+                progressed = NA_TRUE;
+            else if (ret != NA_TIMEOUT) {
+                NA_LOG_ERROR("Could not make progress on primary class");
+                goto done;
+            }
+        }
+
+        ret = na_auto_trigger(na_auto_context, &progressed);
+        if (ret != NA_SUCCESS)
+            goto done;
+        if (progressed) {
+            ret = NA_SUCCESS;
+            goto done;
+        }
+
+        if (timeout) {
+            hg_time_get_current(&t2);
+            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+        }
+        ret = NA_TIMEOUT;
+    } while (remaining > 0);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_auto_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
+{
+    struct na_auto_op_id *na_auto_op_id = (struct na_auto_op_id *) op_id;
+    struct na_auto_context *na_auto_context = NA_AUTO_CONTEXT(context);
+    na_auto_route_t route = na_auto_op_id->route;
+    na_bool_t dequeued = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_auto_op_id->completed))
+        goto done;
+    hg_atomic_set32(&na_auto_op_id->canceled, NA_TRUE);
+
+    /* Unexpected recv is not posted to inner classes */
+    if (na_auto_op_id->completion_data.callback_info.type
+        == NA_CB_RECV_UNEXPECTED) {
+        hg_thread_mutex_lock(&na_auto_context->unexpected_mutex);
+        if (na_auto_op_id->queued) {
+            HG_QUEUE_REMOVE(&na_auto_context->unexpected_op_queue,
+                na_auto_op_id, na_auto_op_id, entry);
+            na_auto_op_id->queued = NA_FALSE;
+            dequeued = NA_TRUE;
+        }
+        hg_thread_mutex_unlock(&na_auto_context->unexpected_mutex);
+
+        if (dequeued) {
+            ret = na_auto_complete(na_auto_op_id);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not complete operation");
+            }
+        }
+        goto done;
+    }
+
+    if (na_auto_op_id->op_ids[route] == NA_OP_ID_NULL)
+        goto done;
+
+    ret = NA_Cancel(NA_AUTO_CLASS(na_class, route),
+        na_auto_context->contexts[route], na_auto_op_id->op_ids[route]);
+
+done:
+    return ret;
+}
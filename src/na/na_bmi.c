@@ -46,6 +46,13 @@
 #define NA_BMI_RMA_TAG (NA_BMI_RMA_REQUEST_TAG + 1)
 #define NA_BMI_MAX_RMA_TAG (NA_TAG_UB >> 1)
 
+/* Default size of RMA chunks and number of chunks in flight */
+#define NA_BMI_RMA_CHUNK_SIZE (1 << 20)
+#define NA_BMI_RMA_WINDOW 4
+#define NA_BMI_RMA_WINDOW_MAX 16
+
+#define NA_BMI_MIN(a, b) (((a) < (b)) ? (a) : (b))
+
 #define NA_BMI_PRIVATE_DATA(na_class) \
     ((struct na_bmi_private_data *)(na_class->private_data))
 
@@ -85,10 +92,32 @@ struct na_bmi_rma_info {
     na_ptr_t base;                /* Initial address of memory */
     bmi_size_t disp;              /* Offset from initial address */
     bmi_size_t count;             /* Number of entries */
-    bmi_msg_tag_t transfer_tag;   /* Tag used for the data transfer */
+    bmi_size_t chunk_size;        /* Size of transferred chunks */
+    na_uint32_t window;           /* Number of chunks in flight */
+    bmi_msg_tag_t transfer_tag;   /* First of window tags used for data */
     bmi_msg_tag_t completion_tag; /* Tag used for completion ack */
 };
 
+/* Data transfer split into chunks, chunk i uses window slot i % window */
+struct na_bmi_rma_pipeline {
+    char *buf;                    /* Local buffer */
+    bmi_size_t count;             /* Size of transfer */
+    bmi_size_t chunk_size;        /* Size of chunks */
+    na_uint32_t window;           /* Number of chunks in flight */
+    bmi_msg_tag_t tag;            /* Tag of first window slot */
+    BMI_addr_t addr;              /* Peer addr */
+    na_bool_t send;               /* Send or recv chunks */
+    bmi_size_t chunk_count;       /* Number of chunks to post */
+    bmi_size_t chunk_next;        /* Next chunk to post */
+    bmi_size_t chunk_completed;   /* Number of chunks completed */
+    bmi_op_id_t op_ids[NA_BMI_RMA_WINDOW_MAX]; /* Chunks in flight */
+    bmi_size_t actual_sizes[NA_BMI_RMA_WINDOW_MAX];
+};
+
+#define NA_BMI_RMA_PIPELINE_DONE(pipeline) \
+    ((pipeline)->chunk_next == (pipeline)->chunk_count \
+        && (pipeline)->chunk_completed == (pipeline)->chunk_next)
+
 struct na_bmi_info_lookup {
     na_addr_t addr;
 };
@@ -115,11 +144,10 @@ struct na_bmi_info_recv_expected {
 
 struct na_bmi_info_put {
     bmi_op_id_t request_op_id;
-    bmi_op_id_t transfer_op_id;
-    hg_atomic_int32_t transfer_completed;
-    bmi_size_t  transfer_actual_size;
+    struct na_bmi_rma_pipeline transfer;
     bmi_op_id_t completion_op_id;
     na_bool_t   completion_flag;
+    na_bool_t   completion_received;
     bmi_size_t  completion_actual_size;
     na_bool_t   internal_progress;
     BMI_addr_t  remote_addr;
@@ -128,8 +156,7 @@ struct na_bmi_info_put {
 
 struct na_bmi_info_get {
     bmi_op_id_t request_op_id;
-    bmi_op_id_t transfer_op_id;
-    bmi_size_t  transfer_actual_size;
+    struct na_bmi_rma_pipeline transfer;
     na_bool_t   internal_progress;
     BMI_addr_t  remote_addr;
     struct na_bmi_rma_info *rma_info;
@@ -164,6 +191,8 @@ struct na_bmi_private_data {
     HG_QUEUE_HEAD(na_bmi_op_id) unexpected_op_queue; /* Unexpected op queue */
     hg_thread_mutex_t unexpected_op_queue_mutex;     /* Mutex */
     hg_atomic_int32_t rma_tag;                       /* Atomic RMA tag value */
+    bmi_size_t rma_chunk_size;                       /* Size of RMA chunks */
+    na_uint32_t rma_window;                          /* RMA chunks in flight */
 };
 
 /********************/
@@ -222,6 +251,12 @@ na_bmi_context_destroy(
         void                *context
         );
 
+/* Allocate operation ID, from context pool if context is not NULL */
+static struct na_bmi_op_id *
+na_bmi_op_alloc(
+        na_context_t    *context
+        );
+
 /* op_create */
 static na_op_id_t
 na_bmi_op_create(
@@ -497,6 +532,33 @@ na_bmi_progress_rma_completion(
         struct na_bmi_op_id *na_bmi_op_id
         );
 
+static void
+na_bmi_rma_pipeline_init(
+        struct na_bmi_rma_pipeline   *pipeline,
+        const struct na_bmi_rma_info *na_bmi_rma_info,
+        BMI_addr_t                    addr,
+        char                         *buf,
+        na_bool_t                     send
+        );
+
+static na_return_t
+na_bmi_rma_pipeline_post(
+        struct na_bmi_op_id        *na_bmi_op_id,
+        struct na_bmi_rma_pipeline *pipeline
+        );
+
+static na_bool_t
+na_bmi_rma_pipeline_complete(
+        struct na_bmi_rma_pipeline *pipeline,
+        bmi_op_id_t                 bmi_op_id
+        );
+
+static int
+na_bmi_rma_pipeline_cancel(
+        struct na_bmi_rma_pipeline *pipeline,
+        bmi_context_id              bmi_context
+        );
+
 static na_return_t
 na_bmi_complete(
         struct na_bmi_op_id *na_bmi_op_id
@@ -550,6 +612,8 @@ const na_class_t na_bmi_class_g = {
         NULL,                                 /* msg_init_expected */
         na_bmi_msg_send_expected,             /* msg_send_expected */
         na_bmi_msg_recv_expected,             /* msg_recv_expected */
+        NULL,                                 /* mem_alloc */
+        NULL,                                 /* mem_free */
         na_bmi_mem_handle_create,             /* mem_handle_create */
         NULL,                                 /* mem_handle_create_segment */
         na_bmi_mem_handle_free,               /* mem_handle_free */
@@ -574,20 +638,22 @@ const na_class_t na_bmi_class_g = {
 
 /*---------------------------------------------------------------------------*/
 static NA_INLINE bmi_msg_tag_t
-na_bmi_gen_rma_tag(na_class_t *na_class)
+na_bmi_gen_rma_tag(na_class_t *na_class, na_uint32_t count)
 {
-    bmi_msg_tag_t tag;
-
-    /* Compare and swap tag if reached max tag */
-    if (hg_atomic_cas32(&NA_BMI_PRIVATE_DATA(na_class)->rma_tag,
-            NA_BMI_MAX_RMA_TAG, NA_BMI_RMA_TAG)) {
-        tag = NA_BMI_RMA_TAG;
-    } else {
-        /* Increment tag */
-        tag = hg_atomic_incr32(&NA_BMI_PRIVATE_DATA(na_class)->rma_tag);
-    }
+    hg_atomic_int32_t *rma_tag = &NA_BMI_PRIVATE_DATA(na_class)->rma_tag;
+    hg_util_int32_t tag, next;
 
-    return tag;
+    /* Reserve count consecutive tags, wrap around if reached max tag */
+    do {
+        tag = hg_atomic_get32(rma_tag);
+        next = (tag > (hg_util_int32_t) NA_BMI_MAX_RMA_TAG
+            - (hg_util_int32_t) count) ?
+            (hg_util_int32_t) NA_BMI_RMA_TAG + (hg_util_int32_t) count - 1 :
+            tag + (hg_util_int32_t) count;
+    } while (!hg_atomic_cas32(rma_tag, tag, next));
+
+    /* Return first tag */
+    return (bmi_msg_tag_t) (next - (hg_util_int32_t) count + 1);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -689,7 +755,19 @@ na_bmi_initialize(na_class_t * na_class, const struct na_info *na_info,
     else {
         ret = na_bmi_init(na_class, NULL, NULL, flag);
     }
+    if (ret != NA_SUCCESS)
+        goto done;
 
+    /* Emulated RMA is pipelined, the window is bounded by the number of
+     * tags reserved per transfer */
+    NA_BMI_PRIVATE_DATA(na_class)->rma_chunk_size =
+        (na_info->na_init_info.rma_chunk_size) ?
+        (bmi_size_t) na_info->na_init_info.rma_chunk_size :
+        NA_BMI_RMA_CHUNK_SIZE;
+    NA_BMI_PRIVATE_DATA(na_class)->rma_window =
+        (na_info->na_init_info.rma_window) ?
+        NA_BMI_MIN(na_info->na_init_info.rma_window, NA_BMI_RMA_WINDOW_MAX) :
+        NA_BMI_RMA_WINDOW;
 
 done:
     return ret;
@@ -837,12 +915,13 @@ na_bmi_context_destroy(na_class_t NA_UNUSED *na_class, void *context)
 }
 
 /*---------------------------------------------------------------------------*/
-static na_op_id_t
-na_bmi_op_create(na_class_t NA_UNUSED *na_class)
+static struct na_bmi_op_id *
+na_bmi_op_alloc(na_context_t *context)
 {
     struct na_bmi_op_id *na_bmi_op_id = NULL;
 
-    na_bmi_op_id = (struct na_bmi_op_id *) malloc(sizeof(struct na_bmi_op_id));
+    na_bmi_op_id = (struct na_bmi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_bmi_op_id));
     if (!na_bmi_op_id) {
         NA_LOG_ERROR("Could not allocate NA BMI operation ID");
         goto done;
@@ -853,7 +932,14 @@ na_bmi_op_create(na_class_t NA_UNUSED *na_class)
     hg_atomic_set32(&na_bmi_op_id->completed, 1);
 
 done:
-    return (na_op_id_t) na_bmi_op_id;
+    return na_bmi_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_bmi_op_create(na_class_t NA_UNUSED *na_class)
+{
+    return (na_op_id_t) na_bmi_op_alloc(NULL);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -867,7 +953,7 @@ na_bmi_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
         /* Cannot free yet */
         goto done;
     }
-    free(na_bmi_op_id);
+    na_op_id_free(na_bmi_op_id);
 
 done:
     return ret;
@@ -888,7 +974,7 @@ na_bmi_addr_lookup(na_class_t *na_class, na_context_t *context,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1109,7 +1195,7 @@ na_bmi_msg_send_unexpected(na_class_t *na_class,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1170,7 +1256,7 @@ na_bmi_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1336,7 +1422,7 @@ na_bmi_msg_send_expected(na_class_t *na_class, na_context_t *context,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1401,7 +1487,7 @@ na_bmi_msg_recv_expected(na_class_t *na_class, na_context_t *context,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1606,7 +1692,7 @@ na_bmi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1619,11 +1705,9 @@ na_bmi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_bmi_op_id->arg = arg;
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.put.request_op_id = 0;
-    na_bmi_op_id->info.put.transfer_op_id = 0;
-    hg_atomic_set32(&na_bmi_op_id->info.put.transfer_completed, NA_FALSE);
-    na_bmi_op_id->info.put.transfer_actual_size = 0;
     na_bmi_op_id->info.put.completion_op_id = 0;
     na_bmi_op_id->info.put.completion_flag = NA_FALSE;
+    na_bmi_op_id->info.put.completion_received = NA_FALSE;
     na_bmi_op_id->info.put.completion_actual_size = 0;
     na_bmi_op_id->info.put.internal_progress = NA_FALSE;
     na_bmi_op_id->info.put.remote_addr = na_bmi_addr->bmi_addr;
@@ -1642,9 +1726,15 @@ na_bmi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_bmi_rma_info->base = bmi_remote_mem_handle->base;
     na_bmi_rma_info->disp = bmi_remote_offset;
     na_bmi_rma_info->count = bmi_length;
-    na_bmi_rma_info->transfer_tag = na_bmi_gen_rma_tag(na_class);
-    na_bmi_rma_info->completion_tag = na_bmi_gen_rma_tag(na_class);
+    na_bmi_rma_info->chunk_size = NA_BMI_PRIVATE_DATA(na_class)->rma_chunk_size;
+    na_bmi_rma_info->window = NA_BMI_PRIVATE_DATA(na_class)->rma_window;
+    na_bmi_rma_info->transfer_tag =
+            na_bmi_gen_rma_tag(na_class, na_bmi_rma_info->window);
+    na_bmi_rma_info->completion_tag = na_bmi_gen_rma_tag(na_class, 1);
     na_bmi_op_id->info.put.rma_info = na_bmi_rma_info;
+    na_bmi_rma_pipeline_init(&na_bmi_op_id->info.put.transfer, na_bmi_rma_info,
+            na_bmi_addr->bmi_addr,
+            (char *) bmi_local_mem_handle->base + bmi_local_offset, NA_TRUE);
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
@@ -1661,22 +1751,12 @@ na_bmi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         goto done;
     }
 
-    /* Post the BMI send request */
-    bmi_ret = BMI_post_send(
-            &na_bmi_op_id->info.put.transfer_op_id, na_bmi_addr->bmi_addr,
-            (char *) bmi_local_mem_handle->base + bmi_local_offset, bmi_length,
-            BMI_EXT_ALLOC, na_bmi_rma_info->transfer_tag, na_bmi_op_id,
-            *bmi_context, NULL);
-    if (bmi_ret < 0) {
-        NA_LOG_ERROR("BMI_post_send() failed");
-        ret = NA_PROTOCOL_ERROR;
+    /* Post the first window of BMI send requests, remaining chunks are
+     * posted as previous ones complete */
+    ret = na_bmi_rma_pipeline_post(na_bmi_op_id,
+            &na_bmi_op_id->info.put.transfer);
+    if (ret != NA_SUCCESS)
         goto done;
-    }
-
-    /* Immediate completion */
-    if (bmi_ret) {
-        hg_atomic_set32(&na_bmi_op_id->info.put.transfer_completed, NA_TRUE);
-    }
 
     /* Post the BMI recv request */
     bmi_ret = BMI_post_recv(
@@ -1693,10 +1773,13 @@ na_bmi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
 
     /* If immediate completion, directly add to completion queue */
     if (bmi_ret) {
-        ret = na_bmi_complete(na_bmi_op_id);
-        if (ret != NA_SUCCESS) {
-            NA_LOG_ERROR("Could not complete operation");
-            goto done;
+        na_bmi_op_id->info.put.completion_received = NA_TRUE;
+        if (NA_BMI_RMA_PIPELINE_DONE(&na_bmi_op_id->info.put.transfer)) {
+            ret = na_bmi_complete(na_bmi_op_id);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not complete operation");
+                goto done;
+            }
         }
     }
 
@@ -1748,7 +1831,7 @@ na_bmi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         na_bmi_op_id = (struct na_bmi_op_id *) *op_id;
         hg_atomic_incr32(&na_bmi_op_id->ref_count);
     } else {
-        na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+        na_bmi_op_id = na_bmi_op_alloc(context);
         if (!na_bmi_op_id) {
             NA_LOG_ERROR("Could not allocate NA BMI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1761,8 +1844,6 @@ na_bmi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_bmi_op_id->arg = arg;
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.get.request_op_id = 0;
-    na_bmi_op_id->info.get.transfer_op_id = 0;
-    na_bmi_op_id->info.get.transfer_actual_size = 0;
     na_bmi_op_id->info.get.internal_progress = NA_FALSE;
     na_bmi_op_id->info.get.remote_addr = na_bmi_addr->bmi_addr;
     na_bmi_op_id->info.get.rma_info = NULL;
@@ -1780,9 +1861,15 @@ na_bmi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_bmi_rma_info->base = bmi_remote_mem_handle->base;
     na_bmi_rma_info->disp = bmi_remote_offset;
     na_bmi_rma_info->count = bmi_length;
-    na_bmi_rma_info->transfer_tag = na_bmi_gen_rma_tag(na_class);
+    na_bmi_rma_info->chunk_size = NA_BMI_PRIVATE_DATA(na_class)->rma_chunk_size;
+    na_bmi_rma_info->window = NA_BMI_PRIVATE_DATA(na_class)->rma_window;
+    na_bmi_rma_info->transfer_tag =
+            na_bmi_gen_rma_tag(na_class, na_bmi_rma_info->window);
     na_bmi_rma_info->completion_tag = 0; /* not used */
     na_bmi_op_id->info.get.rma_info = na_bmi_rma_info;
+    na_bmi_rma_pipeline_init(&na_bmi_op_id->info.get.transfer, na_bmi_rma_info,
+            na_bmi_addr->bmi_addr,
+            (char *) bmi_local_mem_handle->base + bmi_local_offset, NA_FALSE);
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
@@ -1799,20 +1886,15 @@ na_bmi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         goto done;
     }
 
-    /* Post the BMI recv request */
-    bmi_ret = BMI_post_recv(
-            &na_bmi_op_id->info.get.transfer_op_id, na_bmi_addr->bmi_addr,
-            (char *) bmi_local_mem_handle->base + bmi_local_offset, bmi_length,
-            &na_bmi_op_id->info.get.transfer_actual_size, BMI_EXT_ALLOC,
-            na_bmi_rma_info->transfer_tag, na_bmi_op_id, *bmi_context, NULL);
-    if (bmi_ret < 0) {
-        NA_LOG_ERROR("BMI_post_recv() failed");
-        ret = NA_PROTOCOL_ERROR;
+    /* Post the first window of BMI recv requests, remaining chunks are
+     * posted as previous ones complete */
+    ret = na_bmi_rma_pipeline_post(na_bmi_op_id,
+            &na_bmi_op_id->info.get.transfer);
+    if (ret != NA_SUCCESS)
         goto done;
-    }
 
     /* If immediate completion, directly add to completion queue */
-    if (bmi_ret) {
+    if (NA_BMI_RMA_PIPELINE_DONE(&na_bmi_op_id->info.get.transfer)) {
         ret = na_bmi_complete(na_bmi_op_id);
         if (ret != NA_SUCCESS) {
             NA_LOG_ERROR("Could not complete operation");
@@ -2023,14 +2105,23 @@ na_bmi_progress_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
                 ret = na_bmi_complete(na_bmi_op_id);
                 break;
             case NA_CB_PUT:
-                if (!hg_atomic_get32(&na_bmi_op_id->info.put.transfer_completed)
-                    && na_bmi_op_id->info.put.transfer_op_id == bmi_op_id) {
+                if (na_bmi_rma_pipeline_complete(
+                    &na_bmi_op_id->info.put.transfer, bmi_op_id)) {
+                    /* Keep the window full */
+                    ret = na_bmi_rma_pipeline_post(na_bmi_op_id,
+                        &na_bmi_op_id->info.put.transfer);
+                    if (ret != NA_SUCCESS)
+                        goto done;
+                    if (!NA_BMI_RMA_PIPELINE_DONE(
+                        &na_bmi_op_id->info.put.transfer))
+                        break;
+
                     if (na_bmi_op_id->info.put.internal_progress) {
-                        hg_atomic_set32(&na_bmi_op_id->info.put.transfer_completed, NA_TRUE);
                         /* Progress completion and send an ack after the put */
                         ret = na_bmi_progress_rma_completion(na_bmi_op_id);
-                    } else {
-                        /* Nothing */
+                    } else if (na_bmi_op_id->info.put.completion_received) {
+                        /* Ack received before last chunk completed */
+                        ret = na_bmi_complete(na_bmi_op_id);
                     }
                 }
                 else if (na_bmi_op_id->info.put.completion_op_id == bmi_op_id) {
@@ -2043,14 +2134,19 @@ na_bmi_progress_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
                         na_bmi_release(na_bmi_op_id);
                     } else {
                         /* Check ack completion flag */
-                        if (!na_bmi_op_id->info.put.completion_flag) {
+                        if (!na_bmi_op_id->info.put.completion_flag
+                            && !(na_bmi_op_id->cancel & NA_BMI_CANCEL_R)) {
                             NA_LOG_ERROR("Error during transfer, ack received is %u",
                                 na_bmi_op_id->info.put.completion_flag);
                             ret = NA_PROTOCOL_ERROR;
                             goto done;
                         }
-                        /* No internal progress but actual put */
-                        ret = na_bmi_complete(na_bmi_op_id);
+                        /* No internal progress but actual put, local sends
+                         * may not all be completed yet */
+                        na_bmi_op_id->info.put.completion_received = NA_TRUE;
+                        if (NA_BMI_RMA_PIPELINE_DONE(
+                            &na_bmi_op_id->info.put.transfer))
+                            ret = na_bmi_complete(na_bmi_op_id);
                     }
                 }
                 else if (na_bmi_op_id->info.put.request_op_id == bmi_op_id) {
@@ -2062,7 +2158,17 @@ na_bmi_progress_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
                 }
                 break;
             case NA_CB_GET:
-                if (na_bmi_op_id->info.get.transfer_op_id == bmi_op_id) {
+                if (na_bmi_rma_pipeline_complete(
+                    &na_bmi_op_id->info.get.transfer, bmi_op_id)) {
+                    /* Keep the window full */
+                    ret = na_bmi_rma_pipeline_post(na_bmi_op_id,
+                        &na_bmi_op_id->info.get.transfer);
+                    if (ret != NA_SUCCESS)
+                        goto done;
+                    if (!NA_BMI_RMA_PIPELINE_DONE(
+                        &na_bmi_op_id->info.get.transfer))
+                        break;
+
                     if (na_bmi_op_id->info.get.internal_progress) {
                         hg_atomic_set32(&na_bmi_op_id->completed, 1);
 
@@ -2103,9 +2209,7 @@ na_bmi_progress_rma(na_class_t NA_UNUSED *na_class, na_context_t *context,
 {
     struct na_bmi_rma_info *na_bmi_rma_info = NULL;
     struct na_bmi_op_id *na_bmi_op_id = NULL;
-    bmi_context_id *bmi_context = (bmi_context_id *) context->plugin_context;
     na_return_t ret = NA_SUCCESS;
-    int bmi_ret;
 
     if (unexpected_info->size != sizeof(struct na_bmi_rma_info)) {
         NA_LOG_ERROR("Unexpected message size does not match RMA info struct");
@@ -2121,9 +2225,15 @@ na_bmi_progress_rma(na_class_t NA_UNUSED *na_class, na_context_t *context,
         goto done;
     }
     memcpy(na_bmi_rma_info, unexpected_info->buffer, (size_t) unexpected_info->size);
+    if (!na_bmi_rma_info->chunk_size || !na_bmi_rma_info->window
+        || na_bmi_rma_info->window > NA_BMI_RMA_WINDOW_MAX) {
+        NA_LOG_ERROR("Invalid RMA pipeline parameters");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
 
     /* Allocate na_op_id */
-    na_bmi_op_id = (struct na_bmi_op_id *) na_bmi_op_create(na_class);
+    na_bmi_op_id = na_bmi_op_alloc(context);
     if (!na_bmi_op_id) {
         NA_LOG_ERROR("Could not allocate NA BMI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -2140,62 +2250,49 @@ na_bmi_progress_rma(na_class_t NA_UNUSED *na_class, na_context_t *context,
         case NA_BMI_RMA_PUT:
             na_bmi_op_id->type = NA_CB_PUT;
             na_bmi_op_id->info.put.request_op_id = 0;
-            na_bmi_op_id->info.put.transfer_op_id = 0;
-            hg_atomic_set32(&na_bmi_op_id->info.put.transfer_completed, NA_FALSE);
-            na_bmi_op_id->info.put.transfer_actual_size = 0;
             na_bmi_op_id->info.put.completion_op_id = 0;
             na_bmi_op_id->info.put.completion_flag = NA_FALSE;
+            na_bmi_op_id->info.put.completion_received = NA_FALSE;
             na_bmi_op_id->info.put.completion_actual_size = 0;
             na_bmi_op_id->info.put.internal_progress = NA_TRUE;
             na_bmi_op_id->info.put.remote_addr = unexpected_info->addr;
             na_bmi_op_id->info.put.rma_info = na_bmi_rma_info;
             na_bmi_op_id->cancel = 0;
+            na_bmi_rma_pipeline_init(&na_bmi_op_id->info.put.transfer,
+                    na_bmi_rma_info, unexpected_info->addr,
+                    (char *) na_bmi_rma_info->base + na_bmi_rma_info->disp,
+                    NA_FALSE);
 
             /* Start receiving data */
-            bmi_ret = BMI_post_recv(&na_bmi_op_id->info.put.transfer_op_id,
-                    na_bmi_op_id->info.put.remote_addr,
-                    (char *) na_bmi_rma_info->base + na_bmi_rma_info->disp,
-                    na_bmi_rma_info->count,
-                    &na_bmi_op_id->info.put.transfer_actual_size,
-                    BMI_EXT_ALLOC, na_bmi_rma_info->transfer_tag, na_bmi_op_id,
-                    *bmi_context, NULL);
-            if (bmi_ret < 0) {
-                NA_LOG_ERROR("BMI_post_recv() failed");
-                ret = NA_PROTOCOL_ERROR;
+            ret = na_bmi_rma_pipeline_post(na_bmi_op_id,
+                    &na_bmi_op_id->info.put.transfer);
+            if (ret != NA_SUCCESS)
                 goto done;
-            }
 
             /* Immediate completion */
-            if (bmi_ret) {
-                hg_atomic_set32(&na_bmi_op_id->info.put.transfer_completed, NA_TRUE);
+            if (NA_BMI_RMA_PIPELINE_DONE(&na_bmi_op_id->info.put.transfer))
                 ret = na_bmi_progress_rma_completion(na_bmi_op_id);
-            }
             break;
             /* Remote wants to do a get so do a send */
         case NA_BMI_RMA_GET:
             na_bmi_op_id->type = NA_CB_GET;
             na_bmi_op_id->info.get.request_op_id = 0;
-            na_bmi_op_id->info.get.transfer_op_id = 0;
-            na_bmi_op_id->info.get.transfer_actual_size = 0;
             na_bmi_op_id->info.get.internal_progress = NA_TRUE;
             na_bmi_op_id->info.get.remote_addr = unexpected_info->addr;
             na_bmi_op_id->info.get.rma_info = na_bmi_rma_info;
             na_bmi_op_id->cancel = 0;
+            na_bmi_rma_pipeline_init(&na_bmi_op_id->info.get.transfer,
+                    na_bmi_rma_info, unexpected_info->addr,
+                    (char *) na_bmi_rma_info->base + na_bmi_rma_info->disp,
+                    NA_TRUE);
 
             /* Start sending data */
-            bmi_ret = BMI_post_send(&na_bmi_op_id->info.get.transfer_op_id,
-                    na_bmi_op_id->info.get.remote_addr,
-                    (char *) na_bmi_rma_info->base + na_bmi_rma_info->disp,
-                    na_bmi_rma_info->count, BMI_EXT_ALLOC,
-                    na_bmi_rma_info->transfer_tag, na_bmi_op_id,
-                    *bmi_context, NULL);
-            if (bmi_ret < 0) {
-                NA_LOG_ERROR("BMI_post_send() failed");
-                ret = NA_PROTOCOL_ERROR;
+            ret = na_bmi_rma_pipeline_post(na_bmi_op_id,
+                    &na_bmi_op_id->info.get.transfer);
+            if (ret != NA_SUCCESS)
                 goto done;
-            }
 
-            if (bmi_ret) {
+            if (NA_BMI_RMA_PIPELINE_DONE(&na_bmi_op_id->info.get.transfer)) {
                 hg_atomic_set32(&na_bmi_op_id->completed, 1);
 
                 free(na_bmi_op_id->info.get.rma_info);
@@ -2213,7 +2310,7 @@ na_bmi_progress_rma(na_class_t NA_UNUSED *na_class, na_context_t *context,
 
 done:
     if (ret != NA_SUCCESS) {
-        free(na_bmi_op_id);
+        na_op_id_free(na_bmi_op_id);
         free(na_bmi_rma_info);
     }
     return ret;
@@ -2261,6 +2358,118 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+na_bmi_rma_pipeline_init(struct na_bmi_rma_pipeline *pipeline,
+        const struct na_bmi_rma_info *na_bmi_rma_info, BMI_addr_t addr,
+        char *buf, na_bool_t send)
+{
+    memset(pipeline, 0, sizeof(struct na_bmi_rma_pipeline));
+    pipeline->buf = buf;
+    pipeline->count = na_bmi_rma_info->count;
+    pipeline->chunk_size = na_bmi_rma_info->chunk_size;
+    pipeline->window = na_bmi_rma_info->window;
+    pipeline->tag = na_bmi_rma_info->transfer_tag;
+    pipeline->addr = addr;
+    pipeline->send = send;
+
+    /* Always transfer at least one (possibly empty) chunk */
+    pipeline->chunk_count = (pipeline->count + pipeline->chunk_size - 1)
+        / pipeline->chunk_size;
+    if (!pipeline->chunk_count)
+        pipeline->chunk_count = 1;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_bmi_rma_pipeline_post(struct na_bmi_op_id *na_bmi_op_id,
+        struct na_bmi_rma_pipeline *pipeline)
+{
+    bmi_context_id *bmi_context =
+            (bmi_context_id *) na_bmi_op_id->context->plugin_context;
+    na_return_t ret = NA_SUCCESS;
+
+    while (pipeline->chunk_next < pipeline->chunk_count) {
+        na_uint32_t slot =
+                (na_uint32_t) (pipeline->chunk_next % pipeline->window);
+        bmi_size_t offset = pipeline->chunk_next * pipeline->chunk_size;
+        bmi_size_t size = NA_BMI_MIN(pipeline->chunk_size,
+                pipeline->count - offset);
+        int bmi_ret;
+
+        /* Wait for previous chunk of that slot to complete, chunks of a
+         * given slot are matched in order */
+        if (pipeline->op_ids[slot])
+            break;
+
+        if (pipeline->send)
+            bmi_ret = BMI_post_send(&pipeline->op_ids[slot], pipeline->addr,
+                    pipeline->buf + offset, size, BMI_EXT_ALLOC,
+                    pipeline->tag + (bmi_msg_tag_t) slot, na_bmi_op_id,
+                    *bmi_context, NULL);
+        else
+            bmi_ret = BMI_post_recv(&pipeline->op_ids[slot], pipeline->addr,
+                    pipeline->buf + offset, size,
+                    &pipeline->actual_sizes[slot], BMI_EXT_ALLOC,
+                    pipeline->tag + (bmi_msg_tag_t) slot, na_bmi_op_id,
+                    *bmi_context, NULL);
+        if (bmi_ret < 0) {
+            NA_LOG_ERROR("%s() failed",
+                    (pipeline->send) ? "BMI_post_send" : "BMI_post_recv");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        pipeline->chunk_next++;
+
+        /* Immediate completion */
+        if (bmi_ret) {
+            pipeline->op_ids[slot] = 0;
+            pipeline->chunk_completed++;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_bmi_rma_pipeline_complete(struct na_bmi_rma_pipeline *pipeline,
+        bmi_op_id_t bmi_op_id)
+{
+    na_uint32_t i;
+
+    for (i = 0; i < pipeline->window; i++) {
+        if (pipeline->op_ids[i] && pipeline->op_ids[i] == bmi_op_id) {
+            pipeline->op_ids[i] = 0;
+            pipeline->chunk_completed++;
+            return NA_TRUE;
+        }
+    }
+
+    return NA_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_bmi_rma_pipeline_cancel(struct na_bmi_rma_pipeline *pipeline,
+        bmi_context_id bmi_context)
+{
+    int bmi_ret = 0;
+    na_uint32_t i;
+
+    /* Do not post any further chunk, transfer is done once chunks in flight
+     * have completed */
+    pipeline->chunk_count = pipeline->chunk_next;
+
+    for (i = 0; i < pipeline->window; i++) {
+        if (pipeline->op_ids[i])
+            bmi_ret |= BMI_cancel(pipeline->op_ids[i], bmi_context);
+    }
+
+    return bmi_ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_bmi_complete(struct na_bmi_op_id *na_bmi_op_id)
@@ -2457,9 +2666,9 @@ na_bmi_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
             bmi_ret |= BMI_cancel(na_bmi_op_id->info.put.request_op_id,
                                  *bmi_context);
 
-            /* cancel put (expected send) */
-            bmi_ret |= BMI_cancel(na_bmi_op_id->info.put.transfer_op_id,
-                                 *bmi_context);
+            /* cancel put (expected sends in flight) */
+            bmi_ret |= na_bmi_rma_pipeline_cancel(
+                    &na_bmi_op_id->info.put.transfer, *bmi_context);
 
             /* cancel ack (expected recv) */
             bmi_ret |= BMI_cancel(na_bmi_op_id->info.put.completion_op_id,
@@ -2477,9 +2686,9 @@ na_bmi_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
             bmi_ret |= BMI_cancel(na_bmi_op_id->info.get.request_op_id,
                                   *bmi_context);
 
-            /* cancel get (expected recv) */
-            bmi_ret |= BMI_cancel(na_bmi_op_id->info.get.transfer_op_id,
-                                  *bmi_context);
+            /* cancel get (expected recvs in flight) */
+            bmi_ret |= na_bmi_rma_pipeline_cancel(
+                    &na_bmi_op_id->info.get.transfer, *bmi_context);
             if (bmi_ret < 0) {
                 NA_LOG_ERROR("BMI_cancel() failed");
                 ret = NA_PROTOCOL_ERROR;
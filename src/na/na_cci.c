@@ -209,6 +209,10 @@ na_cci_init(na_class_t * na_class);
 static na_return_t
 na_cci_finalize(na_class_t * na_class);
 
+/* Allocate operation ID, from context pool if context is not NULL */
+static na_cci_op_id_t *
+na_cci_op_alloc(na_context_t *context);
+
 /* op_create */
 static na_op_id_t
 na_cci_op_create(na_class_t *na_class);
@@ -390,6 +394,8 @@ const na_class_t na_cci_class_g = {
     NULL,                                   /* msg_init_expected */
     na_cci_msg_send_expected,               /* msg_send_expected */
     na_cci_msg_recv_expected,               /* msg_recv_expected */
+    NULL,                                   /* mem_alloc */
+    NULL,                                   /* mem_free */
     na_cci_mem_handle_create,               /* mem_handle_create */
     NULL,                                   /* mem_handle_create_segment */
     na_cci_mem_handle_free,                 /* mem_handle_free */
@@ -736,12 +742,13 @@ na_cci_finalize(na_class_t * na_class)
 }
 
 /*---------------------------------------------------------------------------*/
-static na_op_id_t
-na_cci_op_create(na_class_t NA_UNUSED *na_class)
+static na_cci_op_id_t *
+na_cci_op_alloc(na_context_t *context)
 {
     na_cci_op_id_t *na_cci_op_id = NULL;
 
-    na_cci_op_id = (na_cci_op_id_t *) malloc(sizeof(na_cci_op_id_t));
+    na_cci_op_id = (na_cci_op_id_t *) na_op_id_alloc(context,
+        sizeof(na_cci_op_id_t));
     if (!na_cci_op_id) {
         NA_LOG_ERROR("Could not allocate NA CCI operation ID");
         goto done;
@@ -752,7 +759,14 @@ na_cci_op_create(na_class_t NA_UNUSED *na_class)
     hg_atomic_set32(&na_cci_op_id->completed, 1);
 
 done:
-    return (na_op_id_t) na_cci_op_id;
+    return na_cci_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_cci_op_create(na_class_t NA_UNUSED *na_class)
+{
+    return (na_op_id_t) na_cci_op_alloc(NULL);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -784,7 +798,7 @@ na_cci_addr_lookup(na_class_t * na_class, na_context_t * context,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -888,7 +902,7 @@ op_id_decref(na_cci_op_id_t *na_cci_op_id)
         return;
 
     /* No more references, cleanup */
-    free(na_cci_op_id);
+    na_op_id_free(na_cci_op_id);
 
     return;
 }
@@ -1044,7 +1058,7 @@ na_cci_msg_send_unexpected(na_class_t *na_class, na_context_t * context,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1104,7 +1118,7 @@ na_cci_msg_recv_unexpected(na_class_t * na_class, na_context_t * context,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1277,7 +1291,7 @@ na_cci_msg_send_expected(na_class_t *na_class, na_context_t * context,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1349,7 +1363,7 @@ na_cci_msg_recv_expected(na_class_t * na_class,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1615,7 +1629,7 @@ na_cci_put(na_class_t * na_class, na_context_t * context, na_cb_t callback,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -1691,7 +1705,7 @@ na_cci_get(na_class_t * na_class, na_context_t * context, na_cb_t callback,
         na_cci_op_id = (na_cci_op_id_t *) *op_id;
         hg_atomic_incr32(&na_cci_op_id->refcnt);
     } else {
-        na_cci_op_id = (na_cci_op_id_t *) na_cci_op_create(na_class);
+        na_cci_op_id = na_cci_op_alloc(context);
         if (!na_cci_op_id) {
             NA_LOG_ERROR("Could not create NA CCI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -0,0 +1,1930 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_private.h"
+#include "na_error.h"
+
+#include "mercury_list.h"
+#include "mercury_queue.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_atomic.h"
+#include "mercury_time.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Plugin constants */
+#define NA_EMU_MAX_INFO_STRING  256
+#define NA_EMU_WHEEL_SIZE       1024    /* Timer wheel slots (power of 2) */
+#define NA_EMU_WHEEL_TICK       10      /* Timer wheel resolution (us) */
+#define NA_EMU_TRIGGER_MAX      64      /* Completions triggered at once */
+
+/* Environment variables used to configure emulation */
+#define NA_EMU_ENV_LATENCY          "NA_EMU_LATENCY"        /* us */
+#define NA_EMU_ENV_BANDWIDTH        "NA_EMU_BANDWIDTH"      /* MB/s */
+#define NA_EMU_ENV_JITTER           "NA_EMU_JITTER"         /* us */
+#define NA_EMU_ENV_JITTER_DIST      "NA_EMU_JITTER_DIST"    /* see below */
+#define NA_EMU_ENV_UNEXPECTED_DROP  "NA_EMU_UNEXPECTED_DROP" /* [0, 1] */
+#define NA_EMU_ENV_UNEXPECTED_DELAY "NA_EMU_UNEXPECTED_DELAY" /* us */
+#define NA_EMU_ENV_SEED             "NA_EMU_SEED"
+
+/* Private data access */
+#define NA_EMU_PRIVATE_DATA(na_class) \
+    ((struct na_emu_private_data *)(na_class->private_data))
+#define NA_EMU_CONTEXT(context) \
+    ((struct na_emu_context *)(context->plugin_context))
+
+/* Wrapped class */
+#define NA_EMU_CLASS(na_class) \
+    (NA_EMU_PRIVATE_DATA(na_class)->wrapped_class)
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Jitter distributions */
+typedef enum {
+    NA_EMU_JITTER_UNIFORM,      /* Uniform in [0, jitter] */
+    NA_EMU_JITTER_NORMAL,       /* Normal of std deviation jitter */
+    NA_EMU_JITTER_EXPONENTIAL   /* Exponential of mean jitter */
+} na_emu_jitter_dist_t;
+
+/* Action taken when timer expires */
+typedef enum {
+    NA_EMU_TIMER_POST,          /* Post deferred send to wrapped class */
+    NA_EMU_TIMER_COMPLETE       /* Complete operation */
+} na_emu_timer_t;
+
+/* Emulated network conditions */
+struct na_emu_params {
+    double latency;                     /* One-way latency (us) */
+    double bandwidth;                   /* Bandwidth (bytes/us, 0 if none) */
+    double jitter;                      /* Jitter (us) */
+    na_emu_jitter_dist_t jitter_dist;   /* Jitter distribution */
+    double unexpected_drop;             /* Unexpected msg drop probability */
+    double unexpected_delay;            /* Unexpected msg extra delay (us) */
+    na_uint64_t seed;                   /* Random seed */
+};
+
+/* Deferred send */
+struct na_emu_info_send {
+    const void *buf;
+    na_size_t buf_size;
+    void *plugin_data;
+    na_addr_t dest;
+    na_tag_t tag;
+};
+
+/* Operation ID */
+struct na_emu_op_id {
+    na_class_t *na_class;
+    na_context_t *context;
+    struct na_cb_completion_data completion_data;
+    na_op_id_t op_id;               /* Operation ID of wrapped class */
+    na_bool_t own_op_id;            /* Wrapped class supports op_create */
+    hg_atomic_int32_t completed;    /* Operation completed */
+    hg_atomic_int32_t canceled;     /* Operation canceled */
+    hg_atomic_int32_t ref_count;    /* Ref count */
+    na_emu_timer_t timer;           /* Action on timer expiration */
+    na_uint64_t due;                /* Time of completion (us) */
+    na_uint64_t tick;               /* Timer wheel tick */
+    na_bool_t scheduled;            /* In timer wheel */
+    struct na_emu_info_send send;   /* Deferred send */
+    na_addr_t addr;                 /* Held while send is deferred */
+    HG_LIST_ENTRY(na_emu_op_id) entry;
+};
+
+/* List of timers */
+HG_LIST_HEAD_DECL(na_emu_timer_list, na_emu_op_id);
+
+/* Hashed timer wheel */
+struct na_emu_wheel {
+    struct na_emu_timer_list slots[NA_EMU_WHEEL_SIZE];
+    na_uint64_t tick;               /* Next tick to expire */
+    unsigned int count;             /* Number of timers */
+};
+
+/* Context */
+struct na_emu_context {
+    na_context_t *context;          /* Context of wrapped class */
+    struct na_emu_wheel wheel;      /* Pending timers */
+    hg_thread_mutex_t wheel_mutex;  /* Timer wheel lock */
+};
+
+/* Private data */
+struct na_emu_private_data {
+    na_class_t *wrapped_class;      /* Wrapped class */
+    struct na_emu_params params;    /* Emulated conditions */
+    na_bool_t enabled;              /* Any of the conditions is set */
+    na_uint64_t rand_state;         /* Random generator state */
+    na_uint64_t link_free;          /* Time link is available again (us) */
+    na_uint64_t last_arrival;       /* Arrival time of last message (us) */
+    hg_thread_mutex_t link_mutex;   /* Random generator and link lock */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Get emulation parameters from environment.
+ */
+static na_return_t
+na_emu_params_get(
+    struct na_emu_params *params
+    );
+
+/**
+ * Get current time in us.
+ */
+static NA_INLINE na_uint64_t
+na_emu_now(
+    void
+    );
+
+/**
+ * Draw random number in [0, 1).
+ */
+static double
+na_emu_rand(
+    struct na_emu_private_data *na_emu_private_data
+    );
+
+/**
+ * Draw jitter (us, may be negative).
+ */
+static double
+na_emu_jitter(
+    struct na_emu_private_data *na_emu_private_data
+    );
+
+/**
+ * Reserve link for a transfer of buf_size bytes and return the time at which
+ * the transfer completes after crossing the link hops times.
+ */
+static na_uint64_t
+na_emu_link_reserve(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    unsigned int hops,
+    na_bool_t unexpected,
+    na_bool_t ordered
+    );
+
+/**
+ * Add timer to wheel.
+ */
+static void
+na_emu_wheel_add(
+    struct na_emu_context *na_emu_context,
+    struct na_emu_op_id *na_emu_op_id
+    );
+
+/**
+ * Remove expired timers from wheel and return them in expired list.
+ */
+static void
+na_emu_wheel_expire(
+    struct na_emu_context *na_emu_context,
+    na_uint64_t now,
+    struct na_emu_timer_list *expired_list
+    );
+
+/**
+ * Get time of next timer (0 if none).
+ */
+static na_uint64_t
+na_emu_wheel_next(
+    struct na_emu_context *na_emu_context
+    );
+
+/**
+ * Setup operation.
+ */
+static na_return_t
+na_emu_op_setup(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    na_op_id_t *op_id,
+    struct na_emu_op_id **op_ptr
+    );
+
+/**
+ * Send message (deferred when emulation is enabled).
+ */
+static na_return_t
+na_emu_msg_send(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Post send to wrapped class.
+ */
+static na_return_t
+na_emu_msg_post(
+    struct na_emu_op_id *na_emu_op_id
+    );
+
+/**
+ * Fire expired timer.
+ */
+static na_return_t
+na_emu_timer_fire(
+    struct na_emu_op_id *na_emu_op_id
+    );
+
+/**
+ * Callback of wrapped class operations.
+ */
+static int
+na_emu_cb(
+    const struct na_cb_info *callback_info
+    );
+
+/**
+ * Complete operation.
+ */
+static na_return_t
+na_emu_complete(
+    struct na_emu_op_id *na_emu_op_id
+    );
+
+/**
+ * Release memory.
+ */
+static void
+na_emu_release(
+    void *arg
+    );
+
+/**
+ * Allocate operation ID, from context pool if context is not NULL.
+ */
+static struct na_emu_op_id *
+na_emu_op_alloc(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* check_protocol */
+static na_bool_t
+na_emu_check_protocol(
+    const char *protocol_name
+    );
+
+/* initialize */
+static na_return_t
+na_emu_initialize(
+    na_class_t *na_class,
+    const struct na_info *na_info,
+    na_bool_t listen
+    );
+
+/* finalize */
+static na_return_t
+na_emu_finalize(
+    na_class_t *na_class
+    );
+
+/* check_feature */
+static na_bool_t
+na_emu_check_feature(
+    na_class_t *na_class,
+    na_uint8_t feature
+    );
+
+/* context_create */
+static na_return_t
+na_emu_context_create(
+    na_class_t *na_class,
+    void **context
+    );
+
+/* context_destroy */
+static na_return_t
+na_emu_context_destroy(
+    na_class_t *na_class,
+    void *context
+    );
+
+/* op_create */
+static na_op_id_t
+na_emu_op_create(
+    na_class_t *na_class
+    );
+
+/* op_destroy */
+static na_return_t
+na_emu_op_destroy(
+    na_class_t *na_class,
+    na_op_id_t op_id
+    );
+
+/* addr_lookup */
+static na_return_t
+na_emu_addr_lookup(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const char *name,
+    na_op_id_t *op_id
+    );
+
+/* addr_free */
+static na_return_t
+na_emu_addr_free(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_self */
+static na_return_t
+na_emu_addr_self(
+    na_class_t *na_class,
+    na_addr_t *addr
+    );
+
+/* addr_dup */
+static na_return_t
+na_emu_addr_dup(
+    na_class_t *na_class,
+    na_addr_t addr,
+    na_addr_t *new_addr
+    );
+
+/* addr_is_self */
+static na_bool_t
+na_emu_addr_is_self(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_to_string */
+static na_return_t
+na_emu_addr_to_string(
+    na_class_t *na_class,
+    char *buf,
+    na_size_t *buf_size,
+    na_addr_t addr
+    );
+
+/* msg_get_max_unexpected_size */
+static na_size_t
+na_emu_msg_get_max_unexpected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_expected_size */
+static na_size_t
+na_emu_msg_get_max_expected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_unexpected_header_size */
+static na_size_t
+na_emu_msg_get_unexpected_header_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_expected_header_size */
+static na_size_t
+na_emu_msg_get_expected_header_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_tag */
+static na_tag_t
+na_emu_msg_get_max_tag(
+    const na_class_t *na_class
+    );
+
+/* msg_buf_alloc */
+static void *
+na_emu_msg_buf_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* msg_buf_free */
+static na_return_t
+na_emu_msg_buf_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
+/* msg_init_unexpected */
+static na_return_t
+na_emu_msg_init_unexpected(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size
+    );
+
+/* msg_send_unexpected */
+static na_return_t
+na_emu_msg_send_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_unexpected */
+static na_return_t
+na_emu_msg_recv_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_tag_t mask,
+    na_op_id_t *op_id
+    );
+
+/* msg_init_expected */
+static na_return_t
+na_emu_msg_init_expected(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size
+    );
+
+/* msg_send_expected */
+static na_return_t
+na_emu_msg_send_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_expected */
+static na_return_t
+na_emu_msg_recv_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t source,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* mem_alloc */
+static void *
+na_emu_mem_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* mem_free */
+static na_return_t
+na_emu_mem_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
+/* mem_handle */
+static na_return_t
+na_emu_mem_handle_create(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    unsigned long flags,
+    na_mem_handle_t *mem_handle
+    );
+
+static na_return_t
+na_emu_mem_handle_create_segments(
+    na_class_t *na_class,
+    struct na_segment *segments,
+    na_size_t segment_count,
+    unsigned long flags,
+    na_mem_handle_t *mem_handle
+    );
+
+static na_return_t
+na_emu_mem_handle_free(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_register */
+static na_return_t
+na_emu_mem_register(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_deregister */
+static na_return_t
+na_emu_mem_deregister(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_publish */
+static na_return_t
+na_emu_mem_publish(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_unpublish */
+static na_return_t
+na_emu_mem_unpublish(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_handle serialization */
+static na_size_t
+na_emu_mem_handle_get_serialize_size(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_emu_mem_handle_serialize(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_emu_mem_handle_deserialize(
+    na_class_t *na_class,
+    na_mem_handle_t *mem_handle,
+    const void *buf,
+    na_size_t buf_size
+    );
+
+/* put */
+static na_return_t
+na_emu_put(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* get */
+static na_return_t
+na_emu_get(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* poll_get_fd */
+static int
+na_emu_poll_get_fd(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* poll_try_wait */
+static na_bool_t
+na_emu_poll_try_wait(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* progress */
+static na_return_t
+na_emu_progress(
+    na_class_t *na_class,
+    na_context_t *context,
+    unsigned int timeout
+    );
+
+/* cancel */
+static na_return_t
+na_emu_cancel(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_op_id_t op_id
+    );
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+const na_class_t na_emu_class_g = {
+    NULL,                                   /* private_data */
+    "emu",                                  /* name */
+    na_emu_check_protocol,                  /* check_protocol */
+    na_emu_initialize,                      /* initialize */
+    na_emu_finalize,                        /* finalize */
+    NULL,                                   /* cleanup */
+    na_emu_check_feature,                   /* check_feature */
+    na_emu_context_create,                  /* context_create */
+    na_emu_context_destroy,                 /* context_destroy */
+    na_emu_op_create,                       /* op_create */
+    na_emu_op_destroy,                      /* op_destroy */
+    na_emu_addr_lookup,                     /* addr_lookup */
+    na_emu_addr_free,                       /* addr_free */
+    na_emu_addr_self,                       /* addr_self */
+    na_emu_addr_dup,                        /* addr_dup */
+    na_emu_addr_is_self,                    /* addr_is_self */
+    na_emu_addr_to_string,                  /* addr_to_string */
+    na_emu_msg_get_max_unexpected_size,     /* msg_get_max_unexpected_size */
+    na_emu_msg_get_max_expected_size,       /* msg_get_max_expected_size */
+    na_emu_msg_get_unexpected_header_size,  /* msg_get_unexpected_header_size */
+    na_emu_msg_get_expected_header_size,    /* msg_get_expected_header_size */
+    na_emu_msg_get_max_tag,                 /* msg_get_max_tag */
+    na_emu_msg_buf_alloc,                   /* msg_buf_alloc */
+    na_emu_msg_buf_free,                    /* msg_buf_free */
+    na_emu_msg_init_unexpected,             /* msg_init_unexpected */
+    na_emu_msg_send_unexpected,             /* msg_send_unexpected */
+    na_emu_msg_recv_unexpected,             /* msg_recv_unexpected */
+    na_emu_msg_init_expected,               /* msg_init_expected */
+    na_emu_msg_send_expected,               /* msg_send_expected */
+    na_emu_msg_recv_expected,               /* msg_recv_expected */
+    na_emu_mem_alloc,                       /* mem_alloc */
+    na_emu_mem_free,                        /* mem_free */
+    na_emu_mem_handle_create,               /* mem_handle_create */
+    na_emu_mem_handle_create_segments,      /* mem_handle_create_segments */
+    na_emu_mem_handle_free,                 /* mem_handle_free */
+    na_emu_mem_register,                    /* mem_register */
+    na_emu_mem_deregister,                  /* mem_deregister */
+    na_emu_mem_publish,                     /* mem_publish */
+    na_emu_mem_unpublish,                   /* mem_unpublish */
+    na_emu_mem_handle_get_serialize_size,   /* mem_handle_get_serialize_size */
+    na_emu_mem_handle_serialize,            /* mem_handle_serialize */
+    na_emu_mem_handle_deserialize,          /* mem_handle_deserialize */
+    na_emu_put,                             /* put */
+    na_emu_get,                             /* get */
+    na_emu_poll_get_fd,                     /* poll_get_fd */
+    na_emu_poll_try_wait,                   /* poll_try_wait */
+    na_emu_progress,                        /* progress */
+    na_emu_cancel                           /* cancel */
+};
+
+/********************/
+/* Plugin callbacks */
+/********************/
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_params_get(struct na_emu_params *params)
+{
+    const char *env;
+    na_return_t ret = NA_SUCCESS;
+
+    memset(params, 0, sizeof(struct na_emu_params));
+    params->jitter_dist = NA_EMU_JITTER_UNIFORM;
+    params->seed = 1;
+
+    if ((env = getenv(NA_EMU_ENV_LATENCY)) != NULL)
+        params->latency = strtod(env, NULL);
+    /* MB/s is the same as bytes/us */
+    if ((env = getenv(NA_EMU_ENV_BANDWIDTH)) != NULL)
+        params->bandwidth = strtod(env, NULL);
+    if ((env = getenv(NA_EMU_ENV_JITTER)) != NULL)
+        params->jitter = strtod(env, NULL);
+    if ((env = getenv(NA_EMU_ENV_JITTER_DIST)) != NULL) {
+        if (!strcmp(env, "uniform"))
+            params->jitter_dist = NA_EMU_JITTER_UNIFORM;
+        else if (!strcmp(env, "normal"))
+            params->jitter_dist = NA_EMU_JITTER_NORMAL;
+        else if (!strcmp(env, "exponential"))
+            params->jitter_dist = NA_EMU_JITTER_EXPONENTIAL;
+        else {
+            NA_LOG_ERROR("Unknown jitter distribution: %s", env);
+            ret = NA_INVALID_PARAM;
+            goto done;
+        }
+    }
+    if ((env = getenv(NA_EMU_ENV_UNEXPECTED_DROP)) != NULL)
+        params->unexpected_drop = strtod(env, NULL);
+    if ((env = getenv(NA_EMU_ENV_UNEXPECTED_DELAY)) != NULL)
+        params->unexpected_delay = strtod(env, NULL);
+    if ((env = getenv(NA_EMU_ENV_SEED)) != NULL)
+        params->seed = (na_uint64_t) strtoull(env, NULL, 0);
+
+    if (params->latency < 0 || params->bandwidth < 0 || params->jitter < 0
+        || params->unexpected_drop < 0 || params->unexpected_drop > 1
+        || params->unexpected_delay < 0) {
+        NA_LOG_ERROR("Invalid emulation parameters");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    /* Xorshift state must not be zero */
+    if (!params->seed)
+        params->seed = 1;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_uint64_t
+na_emu_now(void)
+{
+    hg_time_t now;
+
+    hg_time_get_current(&now);
+
+    return (na_uint64_t) now.tv_sec * 1000000 + (na_uint64_t) now.tv_usec;
+}
+
+/*---------------------------------------------------------------------------*/
+static double
+na_emu_rand(struct na_emu_private_data *na_emu_private_data)
+{
+    na_uint64_t x = na_emu_private_data->rand_state;
+
+    /* Xorshift64*, only top 53 bits are used */
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    na_emu_private_data->rand_state = x;
+
+    return (double) ((x * 2685821657736338717ULL) >> 11)
+        / 9007199254740992.0;
+}
+
+/*---------------------------------------------------------------------------*/
+static double
+na_emu_jitter(struct na_emu_private_data *na_emu_private_data)
+{
+    double jitter = na_emu_private_data->params.jitter;
+    double u1, u2;
+
+    if (jitter == 0)
+        return 0;
+
+    switch (na_emu_private_data->params.jitter_dist) {
+        case NA_EMU_JITTER_NORMAL:
+            /* Box-Muller */
+            u1 = 1.0 - na_emu_rand(na_emu_private_data);
+            u2 = na_emu_rand(na_emu_private_data);
+            return jitter * sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+        case NA_EMU_JITTER_EXPONENTIAL:
+            u1 = 1.0 - na_emu_rand(na_emu_private_data);
+            return -jitter * log(u1);
+        case NA_EMU_JITTER_UNIFORM:
+        default:
+            return jitter * na_emu_rand(na_emu_private_data);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static na_uint64_t
+na_emu_link_reserve(na_class_t *na_class, na_size_t buf_size,
+    unsigned int hops, na_bool_t unexpected, na_bool_t ordered)
+{
+    struct na_emu_private_data *na_emu_private_data =
+        NA_EMU_PRIVATE_DATA(na_class);
+    struct na_emu_params *params = &na_emu_private_data->params;
+    na_uint64_t now = na_emu_now(), start, arrival;
+    double delay;
+
+    hg_thread_mutex_lock(&na_emu_private_data->link_mutex);
+
+    /* Transfers are serialized on the link when bandwidth is capped */
+    start = (na_emu_private_data->link_free > now) ?
+        na_emu_private_data->link_free : now;
+    if (params->bandwidth > 0)
+        start += (na_uint64_t) ((double) buf_size / params->bandwidth);
+    na_emu_private_data->link_free = start;
+
+    delay = params->latency * hops + na_emu_jitter(na_emu_private_data);
+    if (unexpected)
+        delay += params->unexpected_delay;
+    arrival = start + (na_uint64_t) ((delay > 0) ? delay : 0);
+
+    /* Jitter does not reorder messages */
+    if (ordered) {
+        if (arrival < na_emu_private_data->last_arrival)
+            arrival = na_emu_private_data->last_arrival;
+        na_emu_private_data->last_arrival = arrival;
+    }
+
+    hg_thread_mutex_unlock(&na_emu_private_data->link_mutex);
+
+    return arrival;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_emu_wheel_add(struct na_emu_context *na_emu_context,
+    struct na_emu_op_id *na_emu_op_id)
+{
+    struct na_emu_wheel *wheel = &na_emu_context->wheel;
+    na_uint64_t tick = na_emu_op_id->due / NA_EMU_WHEEL_TICK;
+
+    hg_thread_mutex_lock(&na_emu_context->wheel_mutex);
+
+    /* Timers already expired go to next slot */
+    if (tick < wheel->tick)
+        tick = wheel->tick;
+    na_emu_op_id->tick = tick;
+    na_emu_op_id->scheduled = NA_TRUE;
+    HG_LIST_INSERT_HEAD(&wheel->slots[tick & (NA_EMU_WHEEL_SIZE - 1)],
+        na_emu_op_id, entry);
+    wheel->count++;
+
+    hg_thread_mutex_unlock(&na_emu_context->wheel_mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_emu_wheel_expire(struct na_emu_context *na_emu_context, na_uint64_t now,
+    struct na_emu_timer_list *expired_list)
+{
+    struct na_emu_wheel *wheel = &na_emu_context->wheel;
+    na_uint64_t now_tick = now / NA_EMU_WHEEL_TICK, tick;
+
+    hg_thread_mutex_lock(&na_emu_context->wheel_mutex);
+
+    if (!wheel->count || now_tick < wheel->tick) {
+        if (now_tick >= wheel->tick)
+            wheel->tick = now_tick + 1;
+        goto unlock;
+    }
+
+    /* No need to go around more than once */
+    tick = wheel->tick;
+    if (now_tick - tick >= NA_EMU_WHEEL_SIZE)
+        tick = now_tick - NA_EMU_WHEEL_SIZE + 1;
+
+    for (; tick <= now_tick && wheel->count; tick++) {
+        struct na_emu_op_id *na_emu_op_id, *next;
+
+        na_emu_op_id = HG_LIST_FIRST(
+            &wheel->slots[tick & (NA_EMU_WHEEL_SIZE - 1)]);
+        while (na_emu_op_id) {
+            next = HG_LIST_NEXT(na_emu_op_id, entry);
+            /* Timers of later rounds stay in slot */
+            if (na_emu_op_id->tick <= now_tick) {
+                HG_LIST_REMOVE(na_emu_op_id, entry);
+                na_emu_op_id->scheduled = NA_FALSE;
+                wheel->count--;
+                HG_LIST_INSERT_HEAD(expired_list, na_emu_op_id, entry);
+            }
+            na_emu_op_id = next;
+        }
+    }
+    wheel->tick = now_tick + 1;
+
+unlock:
+    hg_thread_mutex_unlock(&na_emu_context->wheel_mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_uint64_t
+na_emu_wheel_next(struct na_emu_context *na_emu_context)
+{
+    struct na_emu_wheel *wheel = &na_emu_context->wheel;
+    na_uint64_t next = 0;
+    unsigned int i;
+
+    hg_thread_mutex_lock(&na_emu_context->wheel_mutex);
+
+    if (!wheel->count)
+        goto unlock;
+
+    /* First non-empty slot, may be early if timer is for a later round */
+    for (i = 0; i < NA_EMU_WHEEL_SIZE; i++) {
+        if (!HG_LIST_IS_EMPTY(
+            &wheel->slots[(wheel->tick + i) & (NA_EMU_WHEEL_SIZE - 1)]))
+            break;
+    }
+    next = (wheel->tick + i) * NA_EMU_WHEEL_TICK;
+
+unlock:
+    hg_thread_mutex_unlock(&na_emu_context->wheel_mutex);
+
+    return next;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_op_setup(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, na_op_id_t *op_id,
+    struct na_emu_op_id **op_ptr)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_emu_op_id = (struct na_emu_op_id *) *op_id;
+        hg_atomic_incr32(&na_emu_op_id->ref_count);
+    } else {
+        na_emu_op_id = na_emu_op_alloc(na_class, context);
+        if (!na_emu_op_id) {
+            NA_LOG_ERROR("Could not allocate NA EMU operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_emu_op_id->context = context;
+    na_emu_op_id->completion_data.callback_info.type = cb_type;
+    na_emu_op_id->completion_data.callback = callback;
+    na_emu_op_id->completion_data.callback_info.arg = arg;
+    na_emu_op_id->completion_data.callback_info.ret = NA_SUCCESS;
+    hg_atomic_set32(&na_emu_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_emu_op_id->canceled, NA_FALSE);
+    na_emu_op_id->due = 0;
+    na_emu_op_id->addr = NA_ADDR_NULL;
+    /* Wrapped class otherwise allocates a new one for every operation */
+    if (!na_emu_op_id->own_op_id)
+        na_emu_op_id->op_id = NA_OP_ID_NULL;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_emu_op_id;
+
+    *op_ptr = na_emu_op_id;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, void *plugin_data, na_addr_t dest, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_emu_private_data *na_emu_private_data =
+        NA_EMU_PRIVATE_DATA(na_class);
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_bool_t unexpected = (cb_type == NA_CB_SEND_UNEXPECTED);
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_emu_op_setup(na_class, context, cb_type, callback, arg, op_id,
+        &na_emu_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+    na_emu_op_id->send.buf = buf;
+    na_emu_op_id->send.buf_size = buf_size;
+    na_emu_op_id->send.plugin_data = plugin_data;
+    na_emu_op_id->send.dest = dest;
+    na_emu_op_id->send.tag = tag;
+
+    if (!na_emu_private_data->enabled) {
+        ret = na_emu_msg_post(na_emu_op_id);
+        goto done;
+    }
+
+    /* Message is lost but sender does not know */
+    if (unexpected && na_emu_private_data->params.unexpected_drop > 0) {
+        double r;
+
+        hg_thread_mutex_lock(&na_emu_private_data->link_mutex);
+        r = na_emu_rand(na_emu_private_data);
+        hg_thread_mutex_unlock(&na_emu_private_data->link_mutex);
+        if (r < na_emu_private_data->params.unexpected_drop) {
+            NA_LOG_DEBUG("Dropping unexpected message (tag=%u)", tag);
+            ret = na_emu_complete(na_emu_op_id);
+            goto done;
+        }
+    }
+
+    /* Caller may free addr before the message is posted */
+    ret = NA_Addr_dup(NA_EMU_CLASS(na_class), dest, &na_emu_op_id->addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not duplicate addr");
+        goto done;
+    }
+    na_emu_op_id->send.dest = na_emu_op_id->addr;
+
+    /* Message reaches the wrapped class once it has crossed the link */
+    na_emu_op_id->timer = NA_EMU_TIMER_POST;
+    na_emu_op_id->due = na_emu_link_reserve(na_class, buf_size, 1,
+        unexpected, NA_TRUE);
+    na_emu_wheel_add(NA_EMU_CONTEXT(context), na_emu_op_id);
+
+done:
+    if (ret != NA_SUCCESS && na_emu_op_id) {
+        na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_post(struct na_emu_op_id *na_emu_op_id)
+{
+    na_class_t *na_class = na_emu_op_id->na_class;
+    na_context_t *context = NA_EMU_CONTEXT(na_emu_op_id->context)->context;
+    na_return_t ret;
+
+    na_emu_op_id->due = 0;
+    if (na_emu_op_id->completion_data.callback_info.type
+        == NA_CB_SEND_UNEXPECTED)
+        ret = NA_Msg_send_unexpected(NA_EMU_CLASS(na_class), context,
+            na_emu_cb, na_emu_op_id, na_emu_op_id->send.buf,
+            na_emu_op_id->send.buf_size, na_emu_op_id->send.plugin_data,
+            na_emu_op_id->send.dest, na_emu_op_id->send.tag,
+            &na_emu_op_id->op_id);
+    else
+        ret = NA_Msg_send_expected(NA_EMU_CLASS(na_class), context,
+            na_emu_cb, na_emu_op_id, na_emu_op_id->send.buf,
+            na_emu_op_id->send.buf_size, na_emu_op_id->send.plugin_data,
+            na_emu_op_id->send.dest, na_emu_op_id->send.tag,
+            &na_emu_op_id->op_id);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_timer_fire(struct na_emu_op_id *na_emu_op_id)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_emu_op_id->timer) {
+        case NA_EMU_TIMER_POST:
+            ret = na_emu_msg_post(na_emu_op_id);
+            if (ret != NA_SUCCESS) {
+                /* Report failure through operation */
+                NA_LOG_ERROR("Could not post deferred send");
+                na_emu_op_id->completion_data.callback_info.ret = ret;
+                ret = na_emu_complete(na_emu_op_id);
+            }
+            break;
+        case NA_EMU_TIMER_COMPLETE:
+            ret = na_emu_complete(na_emu_op_id);
+            break;
+        default:
+            NA_LOG_ERROR("Unknown timer");
+            ret = NA_PROTOCOL_ERROR;
+            break;
+    }
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_emu_cb(const struct na_cb_info *callback_info)
+{
+    struct na_emu_op_id *na_emu_op_id =
+        (struct na_emu_op_id *) callback_info->arg;
+
+    /* Not owned operation IDs are released once this returns */
+    if (!na_emu_op_id->own_op_id)
+        na_emu_op_id->op_id = NA_OP_ID_NULL;
+
+    /* Keep info of wrapped class (lookup addr, unexpected source etc) */
+    na_emu_op_id->completion_data.callback_info.ret = callback_info->ret;
+    na_emu_op_id->completion_data.callback_info.info = callback_info->info;
+
+    if (callback_info->ret == NA_SUCCESS && na_emu_op_id->due > na_emu_now()) {
+        na_emu_op_id->timer = NA_EMU_TIMER_COMPLETE;
+        na_emu_wheel_add(NA_EMU_CONTEXT(na_emu_op_id->context), na_emu_op_id);
+        return 0;
+    }
+
+    return (na_emu_complete(na_emu_op_id) == NA_SUCCESS) ? 0 : -1;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_complete(struct na_emu_op_id *na_emu_op_id)
+{
+    struct na_cb_info *callback_info =
+        &na_emu_op_id->completion_data.callback_info;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_emu_op_id->canceled)
+        && callback_info->ret == NA_SUCCESS)
+        callback_info->ret = NA_CANCELED;
+    if (callback_info->type == NA_CB_RECV_UNEXPECTED
+        && callback_info->ret != NA_SUCCESS) {
+        /* In case of cancellation where no recv'd data */
+        callback_info->info.recv_unexpected.actual_buf_size = 0;
+        callback_info->info.recv_unexpected.source = NA_ADDR_NULL;
+        callback_info->info.recv_unexpected.tag = 0;
+    }
+
+    if (na_emu_op_id->addr != NA_ADDR_NULL) {
+        ret = NA_Addr_free(NA_EMU_CLASS(na_emu_op_id->na_class),
+            na_emu_op_id->addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not free addr");
+            goto done;
+        }
+        na_emu_op_id->addr = NA_ADDR_NULL;
+    }
+
+    /* Mark op id as completed */
+    hg_atomic_set32(&na_emu_op_id->completed, NA_TRUE);
+
+    ret = na_cb_completion_add(na_emu_op_id->context,
+        &na_emu_op_id->completion_data);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add callback to completion queue");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_emu_release(void *arg)
+{
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) arg;
+
+    if (na_emu_op_id && !hg_atomic_get32(&na_emu_op_id->completed)) {
+        NA_LOG_WARNING("Releasing resources from an uncompleted operation");
+    }
+    na_emu_op_destroy(NULL, na_emu_op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_emu_op_id *
+na_emu_op_alloc(na_class_t *na_class, na_context_t *context)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+
+    na_emu_op_id = (struct na_emu_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_emu_op_id));
+    if (!na_emu_op_id) {
+        NA_LOG_ERROR("Could not allocate NA EMU operation ID");
+        goto done;
+    }
+    memset(na_emu_op_id, 0, sizeof(struct na_emu_op_id));
+    na_emu_op_id->na_class = na_class;
+    hg_atomic_init32(&na_emu_op_id->ref_count, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_emu_op_id->completed, NA_TRUE);
+
+    /* Wrapped class operation is reused every time, pooled operations leave
+     * it to the wrapped class, which allocates it from its own pool */
+    if (!context) {
+        na_emu_op_id->op_id = NA_Op_create(NA_EMU_CLASS(na_class));
+        na_emu_op_id->own_op_id = (na_emu_op_id->op_id != NA_OP_ID_NULL);
+    }
+
+    /* Set op ID release callbacks */
+    na_emu_op_id->completion_data.plugin_callback = na_emu_release;
+    na_emu_op_id->completion_data.plugin_callback_args = na_emu_op_id;
+
+done:
+    return na_emu_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_emu_check_protocol(const char *protocol_name)
+{
+    /* Wrapped class must be named, "+" can only be found in the protocol
+     * name when the emu class was explicitly requested, which prevents
+     * it from being selected for protocols that no plugin supports */
+    return (strchr(protocol_name, '+') != NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t listen)
+{
+    struct na_emu_private_data *na_emu_private_data = NULL;
+    char info_string[NA_EMU_MAX_INFO_STRING];
+    struct na_emu_params *params;
+    na_return_t ret = NA_SUCCESS;
+
+    /**
+     * Wrapped class is initialized from what follows "emu+":
+     *   emu+<class>+<protocol>[://[<host string>]]
+     */
+    if (na_info->host_name)
+        ret = (snprintf(info_string, NA_EMU_MAX_INFO_STRING, "%s://%s",
+            na_info->protocol_name, na_info->host_name)
+            < NA_EMU_MAX_INFO_STRING) ? NA_SUCCESS : NA_SIZE_ERROR;
+    else
+        ret = (snprintf(info_string, NA_EMU_MAX_INFO_STRING, "%s",
+            na_info->protocol_name)
+            < NA_EMU_MAX_INFO_STRING) ? NA_SUCCESS : NA_SIZE_ERROR;
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Exceeding max info string");
+        goto done;
+    }
+
+    na_emu_private_data = (struct na_emu_private_data *) malloc(
+        sizeof(struct na_emu_private_data));
+    if (!na_emu_private_data) {
+        NA_LOG_ERROR("Could not allocate NA private data class");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_emu_private_data, 0, sizeof(struct na_emu_private_data));
+    hg_thread_mutex_init(&na_emu_private_data->link_mutex);
+    na_class->private_data = na_emu_private_data;
+
+    params = &na_emu_private_data->params;
+    ret = na_emu_params_get(params);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not get emulation parameters");
+        goto done;
+    }
+    na_emu_private_data->rand_state = params->seed;
+
+    /* Operations go straight to wrapped class if nothing is emulated */
+    na_emu_private_data->enabled = (params->latency > 0
+        || params->bandwidth > 0 || params->jitter > 0
+        || params->unexpected_drop > 0 || params->unexpected_delay > 0);
+    NA_LOG_DEBUG("Emulating latency=%gus, bandwidth=%gMB/s, jitter=%gus, "
+        "unexpected drop=%g, unexpected delay=%gus", params->latency,
+        params->bandwidth, params->jitter, params->unexpected_drop,
+        params->unexpected_delay);
+
+    na_emu_private_data->wrapped_class = NA_Initialize_opt(info_string, listen,
+        &na_info->na_init_info);
+    if (!na_emu_private_data->wrapped_class) {
+        NA_LOG_ERROR("Could not initialize wrapped class with %s",
+            info_string);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_finalize(na_class_t *na_class)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_class->private_data) {
+        goto done;
+    }
+
+    if (NA_EMU_CLASS(na_class)) {
+        ret = NA_Finalize(NA_EMU_CLASS(na_class));
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not finalize wrapped class");
+            goto done;
+        }
+    }
+
+    hg_thread_mutex_destroy(&NA_EMU_PRIVATE_DATA(na_class)->link_mutex);
+    free(na_class->private_data);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_emu_check_feature(na_class_t *na_class, na_uint8_t feature)
+{
+    return NA_Check_feature(NA_EMU_CLASS(na_class), feature);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_context_create(na_class_t *na_class, void **context)
+{
+    struct na_emu_context *na_emu_context = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_emu_context = (struct na_emu_context *) malloc(
+        sizeof(struct na_emu_context));
+    if (!na_emu_context) {
+        NA_LOG_ERROR("Could not allocate NA EMU context");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_emu_context, 0, sizeof(struct na_emu_context));
+    hg_thread_mutex_init(&na_emu_context->wheel_mutex);
+    na_emu_context->wheel.tick = na_emu_now() / NA_EMU_WHEEL_TICK;
+
+    na_emu_context->context = NA_Context_create(NA_EMU_CLASS(na_class));
+    if (!na_emu_context->context) {
+        NA_LOG_ERROR("Could not create context of wrapped class");
+        hg_thread_mutex_destroy(&na_emu_context->wheel_mutex);
+        free(na_emu_context);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    *context = na_emu_context;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_context_destroy(na_class_t *na_class, void *context)
+{
+    struct na_emu_context *na_emu_context = (struct na_emu_context *) context;
+    na_return_t ret = NA_SUCCESS;
+
+    if (na_emu_context->wheel.count) {
+        NA_LOG_ERROR("Timers are still pending");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    ret = NA_Context_destroy(NA_EMU_CLASS(na_class), na_emu_context->context);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not destroy context of wrapped class");
+        goto done;
+    }
+
+    hg_thread_mutex_destroy(&na_emu_context->wheel_mutex);
+    free(na_emu_context);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_emu_op_create(na_class_t *na_class)
+{
+    return (na_op_id_t) na_emu_op_alloc(na_class, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_decr32(&na_emu_op_id->ref_count)) {
+        /* Cannot free yet */
+        goto done;
+    }
+    if (na_emu_op_id->own_op_id) {
+        ret = NA_Op_destroy(NA_EMU_CLASS(na_emu_op_id->na_class),
+            na_emu_op_id->op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not destroy operation of wrapped class");
+        }
+    }
+    na_op_id_free(na_emu_op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_emu_op_setup(na_class, context, NA_CB_LOOKUP, callback, arg,
+        op_id, &na_emu_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = NA_Addr_lookup(NA_EMU_CLASS(na_class),
+        NA_EMU_CONTEXT(context)->context, na_emu_cb, na_emu_op_id, name,
+        &na_emu_op_id->op_id);
+
+done:
+    if (ret != NA_SUCCESS && na_emu_op_id) {
+        na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_free(na_class_t *na_class, na_addr_t addr)
+{
+    return NA_Addr_free(NA_EMU_CLASS(na_class), addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_self(na_class_t *na_class, na_addr_t *addr)
+{
+    return NA_Addr_self(NA_EMU_CLASS(na_class), addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_dup(na_class_t *na_class, na_addr_t addr, na_addr_t *new_addr)
+{
+    return NA_Addr_dup(NA_EMU_CLASS(na_class), addr, new_addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_emu_addr_is_self(na_class_t *na_class, na_addr_t addr)
+{
+    return NA_Addr_is_self(NA_EMU_CLASS(na_class), addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_to_string(na_class_t *na_class, char *buf, na_size_t *buf_size,
+    na_addr_t addr)
+{
+    return NA_Addr_to_string(NA_EMU_CLASS(na_class), buf, buf_size, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_emu_msg_get_max_unexpected_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_max_unexpected_size(NA_EMU_CLASS(na_class));
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_emu_msg_get_max_expected_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_max_expected_size(NA_EMU_CLASS(na_class));
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_emu_msg_get_unexpected_header_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_unexpected_header_size(NA_EMU_CLASS(na_class));
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_emu_msg_get_expected_header_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_expected_header_size(NA_EMU_CLASS(na_class));
+}
+
+/*---------------------------------------------------------------------------*/
+static na_tag_t
+na_emu_msg_get_max_tag(const na_class_t *na_class)
+{
+    return NA_Msg_get_max_tag(NA_EMU_CLASS(na_class));
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_emu_msg_buf_alloc(na_class_t *na_class, na_size_t buf_size,
+    void **plugin_data)
+{
+    return NA_Msg_buf_alloc(NA_EMU_CLASS(na_class), buf_size, plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    return NA_Msg_buf_free(NA_EMU_CLASS(na_class), buf, plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_init_unexpected(na_class_t *na_class, void *buf,
+    na_size_t buf_size)
+{
+    return NA_Msg_init_unexpected(NA_EMU_CLASS(na_class), buf, buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest, na_tag_t tag, na_op_id_t *op_id)
+{
+    return na_emu_msg_send(na_class, context, NA_CB_SEND_UNEXPECTED, callback,
+        arg, buf, buf_size, plugin_data, dest, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_tag_t mask, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Delays are applied by senders */
+    ret = na_emu_op_setup(na_class, context, NA_CB_RECV_UNEXPECTED, callback,
+        arg, op_id, &na_emu_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = NA_Msg_recv_unexpected(NA_EMU_CLASS(na_class),
+        NA_EMU_CONTEXT(context)->context, na_emu_cb, na_emu_op_id, buf,
+        buf_size, plugin_data, mask, &na_emu_op_id->op_id);
+
+done:
+    if (ret != NA_SUCCESS && na_emu_op_id) {
+        na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_init_expected(na_class_t *na_class, void *buf, na_size_t buf_size)
+{
+    return NA_Msg_init_expected(NA_EMU_CLASS(na_class), buf, buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest, na_tag_t tag, na_op_id_t *op_id)
+{
+    return na_emu_msg_send(na_class, context, NA_CB_SEND_EXPECTED, callback,
+        arg, buf, buf_size, plugin_data, dest, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t source, na_tag_t tag, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Delays are applied by senders */
+    ret = na_emu_op_setup(na_class, context, NA_CB_RECV_EXPECTED, callback,
+        arg, op_id, &na_emu_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = NA_Msg_recv_expected(NA_EMU_CLASS(na_class),
+        NA_EMU_CONTEXT(context)->context, na_emu_cb, na_emu_op_id, buf,
+        buf_size, plugin_data, source, tag, &na_emu_op_id->op_id);
+
+done:
+    if (ret != NA_SUCCESS && na_emu_op_id) {
+        na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_emu_mem_alloc(na_class_t *na_class, na_size_t buf_size,
+    void **plugin_data)
+{
+    return NA_Mem_alloc(NA_EMU_CLASS(na_class), buf_size, plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    return NA_Mem_free(NA_EMU_CLASS(na_class), buf, plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_create(na_class_t *na_class, void *buf, na_size_t buf_size,
+    unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    return NA_Mem_handle_create(NA_EMU_CLASS(na_class), buf, buf_size, flags,
+        mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_create_segments(na_class_t *na_class,
+    struct na_segment *segments, na_size_t segment_count, unsigned long flags,
+    na_mem_handle_t *mem_handle)
+{
+    return NA_Mem_handle_create_segments(NA_EMU_CLASS(na_class), segments,
+        segment_count, flags, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_free(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_handle_free(NA_EMU_CLASS(na_class), mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_register(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_register(NA_EMU_CLASS(na_class), mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_deregister(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_deregister(NA_EMU_CLASS(na_class), mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_publish(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_publish(NA_EMU_CLASS(na_class), mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_unpublish(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_unpublish(NA_EMU_CLASS(na_class), mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_emu_mem_handle_get_serialize_size(na_class_t *na_class,
+    na_mem_handle_t mem_handle)
+{
+    return NA_Mem_handle_get_serialize_size(NA_EMU_CLASS(na_class),
+        mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_handle_serialize(NA_EMU_CLASS(na_class), buf, buf_size,
+        mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_deserialize(na_class_t *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size)
+{
+    return NA_Mem_handle_deserialize(NA_EMU_CLASS(na_class), mem_handle, buf,
+        buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_emu_op_setup(na_class, context, NA_CB_PUT, callback, arg, op_id,
+        &na_emu_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    /* Data moves right away, completion waits for the round trip */
+    if (NA_EMU_PRIVATE_DATA(na_class)->enabled)
+        na_emu_op_id->due = na_emu_link_reserve(na_class, length, 2,
+            NA_FALSE, NA_FALSE);
+
+    ret = NA_Put(NA_EMU_CLASS(na_class), NA_EMU_CONTEXT(context)->context,
+        na_emu_cb, na_emu_op_id, local_mem_handle, local_offset,
+        remote_mem_handle, remote_offset, length, remote_addr,
+        &na_emu_op_id->op_id);
+
+done:
+    if (ret != NA_SUCCESS && na_emu_op_id) {
+        na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_emu_op_setup(na_class, context, NA_CB_GET, callback, arg, op_id,
+        &na_emu_op_id);
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    /* Data moves right away, completion waits for the round trip */
+    if (NA_EMU_PRIVATE_DATA(na_class)->enabled)
+        na_emu_op_id->due = na_emu_link_reserve(na_class, length, 2,
+            NA_FALSE, NA_FALSE);
+
+    ret = NA_Get(NA_EMU_CLASS(na_class), NA_EMU_CONTEXT(context)->context,
+        na_emu_cb, na_emu_op_id, local_mem_handle, local_offset,
+        remote_mem_handle, remote_offset, length, remote_addr,
+        &na_emu_op_id->op_id);
+
+done:
+    if (ret != NA_SUCCESS && na_emu_op_id) {
+        na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_emu_poll_get_fd(na_class_t *na_class, na_context_t *context)
+{
+    /* Timers are not visible from the fd, progress must be used to wait */
+    if (NA_EMU_PRIVATE_DATA(na_class)->enabled)
+        return -1;
+
+    return NA_Poll_get_fd(NA_EMU_CLASS(na_class),
+        NA_EMU_CONTEXT(context)->context);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_emu_poll_try_wait(na_class_t *na_class, na_context_t *context)
+{
+    /* Pending timers do not prevent from blocking in progress, which never
+     * waits past the next timer */
+    return NA_Poll_try_wait(NA_EMU_CLASS(na_class),
+        NA_EMU_CONTEXT(context)->context);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_progress(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout)
+{
+    struct na_emu_context *na_emu_context = NA_EMU_CONTEXT(context);
+    na_uint64_t now = na_emu_now();
+    na_uint64_t deadline = now + (na_uint64_t) timeout * 1000;
+    na_return_t ret = NA_TIMEOUT;
+
+    for (;;) {
+        struct na_emu_timer_list expired_list;
+        struct na_emu_op_id *na_emu_op_id;
+        na_bool_t progressed = NA_FALSE;
+        na_uint64_t next = na_emu_wheel_next(na_emu_context), wait;
+        unsigned int count = 0;
+
+        /* Do not sleep past next timer, remaining sub-ms waits are polled */
+        wait = (deadline > now) ? deadline - now : 0;
+        if (next && next < now + wait)
+            wait = (next > now) ? next - now : 0;
+
+        ret = NA_Progress(NA_EMU_CLASS(na_class), na_emu_context->context,
+            (unsigned int) (wait / 1000));
+        if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+            NA_LOG_ERROR("Could not make progress on wrapped class");
+            goto done;
+        }
+        if (ret == NA_SUCCESS)
+            progressed = NA_TRUE;
+
+        /* Completions of wrapped class complete or schedule operations */
+        do {
+            ret = NA_Trigger(na_emu_context->context, 0, NA_EMU_TRIGGER_MAX,
+                NULL, &count);
+            if (ret != NA_SUCCESS && ret != NA_TIMEOUT) {
+                NA_LOG_ERROR("Could not trigger wrapped class callbacks");
+                goto done;
+            }
+            if (count)
+                progressed = NA_TRUE;
+        } while (count == NA_EMU_TRIGGER_MAX);
+
+        now = na_emu_now();
+        HG_LIST_INIT(&expired_list);
+        na_emu_wheel_expire(na_emu_context, now, &expired_list);
+        while ((na_emu_op_id = HG_LIST_FIRST(&expired_list)) != NULL) {
+            HG_LIST_REMOVE(na_emu_op_id, entry);
+            ret = na_emu_timer_fire(na_emu_op_id);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not fire timer");
+                goto done;
+            }
+            progressed = NA_TRUE;
+        }
+
+        if (progressed) {
+            ret = NA_SUCCESS;
+            break;
+        }
+        if (now >= deadline) {
+            ret = NA_TIMEOUT;
+            break;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) op_id;
+    struct na_emu_context *na_emu_context = NA_EMU_CONTEXT(context);
+    na_bool_t unscheduled = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_emu_op_id->completed))
+        goto done;
+
+    /* Deferred send has not reached wrapped class yet */
+    hg_thread_mutex_lock(&na_emu_context->wheel_mutex);
+    if (na_emu_op_id->scheduled && na_emu_op_id->timer == NA_EMU_TIMER_POST) {
+        HG_LIST_REMOVE(na_emu_op_id, entry);
+        na_emu_op_id->scheduled = NA_FALSE;
+        na_emu_context->wheel.count--;
+        unscheduled = NA_TRUE;
+    }
+    hg_thread_mutex_unlock(&na_emu_context->wheel_mutex);
+
+    if (unscheduled) {
+        hg_atomic_set32(&na_emu_op_id->canceled, NA_TRUE);
+        ret = na_emu_complete(na_emu_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+        }
+        goto done;
+    }
+
+    /* Operations already completed by wrapped class complete on time */
+    if (na_emu_op_id->scheduled || na_emu_op_id->op_id == NA_OP_ID_NULL)
+        goto done;
+
+    ret = NA_Cancel(NA_EMU_CLASS(na_class), na_emu_context->context,
+        na_emu_op_id->op_id);
+
+done:
+    return ret;
+}
@@ -0,0 +1,2322 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_private.h"
+#include "na_error.h"
+
+#include "mercury_queue.h"
+#include "mercury_list.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_rwlock.h"
+#include "mercury_thread_spin.h"
+#include "mercury_atomic.h"
+#include "mercury_atomic_queue.h"
+#include "mercury_event.h"
+#include "mercury_poll.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Plugin constants */
+#define NA_INPROC_MAX_ADDR_NAME     256
+#define NA_INPROC_QUEUE_SIZE        1024 /* Incoming messages (power of 2) */
+
+/* Msg sizes */
+#define NA_INPROC_UNEXPECTED_SIZE   4096
+#define NA_INPROC_EXPECTED_SIZE     NA_INPROC_UNEXPECTED_SIZE
+
+/* Max tag */
+#define NA_INPROC_MAX_TAG           NA_TAG_UB
+
+/* Private data access */
+#define NA_INPROC_PRIVATE_DATA(na_class) \
+    ((struct na_inproc_private_data *)(na_class->private_data))
+
+/* Min macro */
+#define NA_INPROC_MIN(a, b) \
+    (((a) < (b)) ? (a) : (b))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Endpoint of a class, shared with the addrs of other classes that point to
+ * it so that it outlives the class */
+struct na_inproc_endpoint {
+    char name[NA_INPROC_MAX_ADDR_NAME];         /* Name within process */
+    struct hg_atomic_queue *msg_queue;          /* Incoming send ops */
+    HG_QUEUE_HEAD(na_inproc_op_id) backfill_queue; /* When msg queue is full */
+    hg_atomic_int32_t backfill_count;           /* Send ops in backfill */
+    hg_thread_mutex_t backfill_mutex;           /* Backfill queue lock */
+    hg_thread_rwlock_t rwlock;                  /* Write locked on close */
+    na_bool_t closed;                           /* Class finalized */
+    int notify;                                 /* Wakes up owner */
+    hg_atomic_int32_t waiting;                  /* Owner blocked in progress */
+    hg_atomic_int32_t ref_count;                /* Ref count */
+    HG_LIST_ENTRY(na_inproc_endpoint) entry;    /* Endpoint list entry */
+};
+
+/* Address */
+struct na_inproc_addr {
+    struct na_inproc_endpoint *endpoint;        /* Endpoint of peer */
+    na_bool_t self;                             /* Self address */
+    na_bool_t cached;                           /* In peer list */
+    hg_atomic_int32_t ref_count;                /* Ref count */
+    HG_LIST_ENTRY(na_inproc_addr) entry;        /* Peer list entry */
+};
+
+/* Unexpected message info */
+struct na_inproc_unexpected_info {
+    struct na_inproc_addr *na_inproc_addr;
+    void *buf;
+    na_size_t buf_size;
+    na_tag_t tag;
+    HG_QUEUE_ENTRY(na_inproc_unexpected_info) entry;
+};
+
+/* Memory handle */
+struct na_inproc_mem_handle {
+    na_ptr_t base;          /* Base address of region */
+    na_size_t size;         /* Size of region */
+    unsigned long flags;    /* Flag of operation access */
+};
+
+/* Lookup info */
+struct na_inproc_info_lookup {
+    struct na_inproc_addr *na_inproc_addr;
+};
+
+/* Send unexpected and expected (buffer is read by target) */
+struct na_inproc_info_send {
+    struct na_inproc_endpoint *source;
+    const void *buf;
+    na_size_t buf_size;
+    na_tag_t tag;
+};
+
+/* Unexpected recv info */
+struct na_inproc_info_recv_unexpected {
+    void *buf;
+    na_size_t buf_size;
+    na_size_t actual_buf_size;
+    struct na_inproc_addr *na_inproc_addr;
+    na_tag_t tag;
+};
+
+/* Expected recv info */
+struct na_inproc_info_recv_expected {
+    void *buf;
+    na_size_t buf_size;
+    struct na_inproc_addr *na_inproc_addr;
+    na_tag_t tag;
+};
+
+/* Operation ID */
+struct na_inproc_op_id {
+    na_class_t *na_class;
+    na_context_t *context;
+    struct na_cb_completion_data completion_data;
+    hg_atomic_int32_t completed;    /* Operation completed */
+    hg_atomic_int32_t canceled;     /* Operation canceled */
+    na_return_t ret;                /* Return code of operation */
+    union {
+        struct na_inproc_info_lookup lookup;
+        struct na_inproc_info_send send;
+        struct na_inproc_info_recv_unexpected recv_unexpected;
+        struct na_inproc_info_recv_expected recv_expected;
+    } info;
+    hg_atomic_int32_t ref_count;    /* Ref count */
+    HG_QUEUE_ENTRY(na_inproc_op_id) entry;
+};
+
+/* Private data */
+struct na_inproc_private_data {
+    struct na_inproc_endpoint *endpoint;
+    struct na_inproc_addr *self_addr;
+    hg_poll_set_t *poll_set;
+    HG_LIST_HEAD(na_inproc_addr) peer_addr_list;
+    HG_QUEUE_HEAD(na_inproc_unexpected_info) unexpected_msg_queue;
+    HG_QUEUE_HEAD(na_inproc_op_id) unexpected_op_queue;
+    HG_QUEUE_HEAD(na_inproc_op_id) expected_op_queue;
+    hg_thread_spin_t peer_addr_list_lock;
+    hg_thread_spin_t unexpected_msg_queue_lock;
+    hg_thread_spin_t unexpected_op_queue_lock;
+    hg_thread_spin_t expected_op_queue_lock;
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Strip protocol from "inproc://name" string.
+ */
+static const char *
+na_inproc_parse_name(
+    const char *name
+    );
+
+/**
+ * Create endpoint and add it to endpoint list (NULL name picks one).
+ */
+static na_return_t
+na_inproc_endpoint_open(
+    const char *name,
+    struct na_inproc_endpoint **endpoint_ptr
+    );
+
+/**
+ * Remove endpoint from endpoint list and fail messages not yet received.
+ */
+static na_return_t
+na_inproc_endpoint_close(
+    struct na_inproc_endpoint *na_inproc_endpoint
+    );
+
+/**
+ * Release endpoint reference.
+ */
+static void
+na_inproc_endpoint_release(
+    struct na_inproc_endpoint *na_inproc_endpoint
+    );
+
+/**
+ * Hand send op over to target endpoint.
+ */
+static na_return_t
+na_inproc_endpoint_push(
+    struct na_inproc_endpoint *na_inproc_endpoint,
+    struct na_inproc_op_id *na_inproc_op_id
+    );
+
+/**
+ * Take next send op handed over to endpoint.
+ */
+static struct na_inproc_op_id *
+na_inproc_endpoint_pop(
+    struct na_inproc_endpoint *na_inproc_endpoint
+    );
+
+/**
+ * Wake up endpoint owner if it is blocked in progress.
+ */
+static void
+na_inproc_endpoint_notify(
+    struct na_inproc_endpoint *na_inproc_endpoint
+    );
+
+/**
+ * Get addr of endpoint (reference is taken).
+ */
+static na_return_t
+na_inproc_addr_get(
+    na_class_t *na_class,
+    struct na_inproc_endpoint *na_inproc_endpoint,
+    struct na_inproc_addr **addr_ptr
+    );
+
+/**
+ * Send message.
+ */
+static na_return_t
+na_inproc_msg_send(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    struct na_inproc_addr *na_inproc_addr,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Start RMA operation (data is copied right away).
+ */
+static na_return_t
+na_inproc_rma(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    struct na_inproc_mem_handle *local_mem_handle,
+    na_offset_t local_offset,
+    struct na_inproc_mem_handle *remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Progress callback.
+ */
+static int
+na_inproc_progress_cb(
+    void *arg,
+    unsigned int timeout,
+    hg_util_bool_t *progressed
+    );
+
+/**
+ * Receive messages handed over to endpoint.
+ */
+static na_return_t
+na_inproc_progress_msgs(
+    na_class_t *na_class,
+    na_bool_t *progressed
+    );
+
+/**
+ * Receive unexpected message.
+ */
+static na_return_t
+na_inproc_progress_unexpected(
+    na_class_t *na_class,
+    struct na_inproc_op_id *send_op_id
+    );
+
+/**
+ * Receive expected message.
+ */
+static na_return_t
+na_inproc_progress_expected(
+    na_class_t *na_class,
+    struct na_inproc_op_id *send_op_id
+    );
+
+/**
+ * Complete send op once target is done with its buffer.
+ */
+static na_return_t
+na_inproc_send_complete(
+    struct na_inproc_op_id *send_op_id,
+    na_return_t ret
+    );
+
+/**
+ * Complete operation.
+ */
+static na_return_t
+na_inproc_complete(
+    struct na_inproc_op_id *na_inproc_op_id
+    );
+
+/**
+ * Release memory.
+ */
+static void
+na_inproc_release(
+    void *arg
+    );
+
+/**
+ * Allocate operation ID, from context pool if context is not NULL.
+ */
+static struct na_inproc_op_id *
+na_inproc_op_alloc(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* check_protocol */
+static na_bool_t
+na_inproc_check_protocol(
+    const char *protocol_name
+    );
+
+/* initialize */
+static na_return_t
+na_inproc_initialize(
+    na_class_t *na_class,
+    const struct na_info *na_info,
+    na_bool_t listen
+    );
+
+/* finalize */
+static na_return_t
+na_inproc_finalize(
+    na_class_t *na_class
+    );
+
+/* check_feature */
+static na_bool_t
+na_inproc_check_feature(
+    na_class_t *na_class,
+    na_uint8_t feature
+    );
+
+/* op_create */
+static na_op_id_t
+na_inproc_op_create(
+    na_class_t *na_class
+    );
+
+/* op_destroy */
+static na_return_t
+na_inproc_op_destroy(
+    na_class_t *na_class,
+    na_op_id_t op_id
+    );
+
+/* addr_lookup */
+static na_return_t
+na_inproc_addr_lookup(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const char *name,
+    na_op_id_t *op_id
+    );
+
+/* addr_free */
+static na_return_t
+na_inproc_addr_free(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_self */
+static na_return_t
+na_inproc_addr_self(
+    na_class_t *na_class,
+    na_addr_t *addr
+    );
+
+/* addr_dup */
+static na_return_t
+na_inproc_addr_dup(
+    na_class_t *na_class,
+    na_addr_t addr,
+    na_addr_t *new_addr
+    );
+
+/* addr_is_self */
+static na_bool_t
+na_inproc_addr_is_self(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_to_string */
+static na_return_t
+na_inproc_addr_to_string(
+    na_class_t *na_class,
+    char *buf,
+    na_size_t *buf_size,
+    na_addr_t addr
+    );
+
+/* msg_get_max_unexpected_size */
+static na_size_t
+na_inproc_msg_get_max_unexpected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_expected_size */
+static na_size_t
+na_inproc_msg_get_max_expected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_tag */
+static na_tag_t
+na_inproc_msg_get_max_tag(
+    const na_class_t *na_class
+    );
+
+/* msg_send_unexpected */
+static na_return_t
+na_inproc_msg_send_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_unexpected */
+static na_return_t
+na_inproc_msg_recv_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_tag_t mask,
+    na_op_id_t *op_id
+    );
+
+/* msg_send_expected */
+static na_return_t
+na_inproc_msg_send_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_expected */
+static na_return_t
+na_inproc_msg_recv_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t source,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* mem_handle */
+static na_return_t
+na_inproc_mem_handle_create(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    unsigned long flags,
+    na_mem_handle_t *mem_handle
+    );
+
+static na_return_t
+na_inproc_mem_handle_free(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_handle serialization */
+static na_size_t
+na_inproc_mem_handle_get_serialize_size(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_inproc_mem_handle_serialize(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_inproc_mem_handle_deserialize(
+    na_class_t *na_class,
+    na_mem_handle_t *mem_handle,
+    const void *buf,
+    na_size_t buf_size
+    );
+
+/* put */
+static na_return_t
+na_inproc_put(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* get */
+static na_return_t
+na_inproc_get(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* poll_get_fd */
+static int
+na_inproc_poll_get_fd(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* poll_try_wait */
+static na_bool_t
+na_inproc_poll_try_wait(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* progress */
+static na_return_t
+na_inproc_progress(
+    na_class_t *na_class,
+    na_context_t *context,
+    unsigned int timeout
+    );
+
+/* cancel */
+static na_return_t
+na_inproc_cancel(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_op_id_t op_id
+    );
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+const na_class_t na_inproc_class_g = {
+    NULL,                                   /* private_data */
+    "inproc",                               /* name */
+    na_inproc_check_protocol,               /* check_protocol */
+    na_inproc_initialize,                   /* initialize */
+    na_inproc_finalize,                     /* finalize */
+    NULL,                                   /* cleanup */
+    na_inproc_check_feature,                /* check_feature */
+    NULL,                                   /* context_create */
+    NULL,                                   /* context_destroy */
+    na_inproc_op_create,                    /* op_create */
+    na_inproc_op_destroy,                   /* op_destroy */
+    na_inproc_addr_lookup,                  /* addr_lookup */
+    na_inproc_addr_free,                    /* addr_free */
+    na_inproc_addr_self,                    /* addr_self */
+    na_inproc_addr_dup,                     /* addr_dup */
+    na_inproc_addr_is_self,                 /* addr_is_self */
+    na_inproc_addr_to_string,               /* addr_to_string */
+    na_inproc_msg_get_max_unexpected_size,  /* msg_get_max_unexpected_size */
+    na_inproc_msg_get_max_expected_size,    /* msg_get_max_expected_size */
+    NULL,                                   /* msg_get_unexpected_header_size */
+    NULL,                                   /* msg_get_expected_header_size */
+    na_inproc_msg_get_max_tag,              /* msg_get_max_tag */
+    NULL,                                   /* msg_buf_alloc */
+    NULL,                                   /* msg_buf_free */
+    NULL,                                   /* msg_init_unexpected */
+    na_inproc_msg_send_unexpected,          /* msg_send_unexpected */
+    na_inproc_msg_recv_unexpected,          /* msg_recv_unexpected */
+    NULL,                                   /* msg_init_expected */
+    na_inproc_msg_send_expected,            /* msg_send_expected */
+    na_inproc_msg_recv_expected,            /* msg_recv_expected */
+    NULL,                                   /* mem_alloc */
+    NULL,                                   /* mem_free */
+    na_inproc_mem_handle_create,            /* mem_handle_create */
+    NULL,                                   /* mem_handle_create_segments */
+    na_inproc_mem_handle_free,              /* mem_handle_free */
+    NULL,                                   /* mem_register */
+    NULL,                                   /* mem_deregister */
+    NULL,                                   /* mem_publish */
+    NULL,                                   /* mem_unpublish */
+    na_inproc_mem_handle_get_serialize_size, /* mem_handle_get_serialize_size */
+    na_inproc_mem_handle_serialize,         /* mem_handle_serialize */
+    na_inproc_mem_handle_deserialize,       /* mem_handle_deserialize */
+    na_inproc_put,                          /* put */
+    na_inproc_get,                          /* get */
+    na_inproc_poll_get_fd,                  /* poll_get_fd */
+    na_inproc_poll_try_wait,                /* poll_try_wait */
+    na_inproc_progress,                     /* progress */
+    na_inproc_cancel                        /* cancel */
+};
+
+/* Endpoints of all classes within process */
+static HG_LIST_HEAD(na_inproc_endpoint)
+na_inproc_endpoint_list_g = HG_LIST_HEAD_INITIALIZER(na_inproc_endpoint);
+
+/* Protects endpoint list */
+static hg_thread_mutex_t na_inproc_endpoint_list_mutex_g =
+    HG_THREAD_MUTEX_INITIALIZER;
+
+/* Used to name anonymous endpoints */
+static hg_atomic_int32_t na_inproc_endpoint_id_g = HG_ATOMIC_VAR_INIT(0);
+
+/********************/
+/* Plugin callbacks */
+/********************/
+
+/*---------------------------------------------------------------------------*/
+static const char *
+na_inproc_parse_name(const char *name)
+{
+    const char *sep;
+
+    /* Skip protocol if any: <protocol>://<name> */
+    if ((sep = strstr(name, "://")) != NULL)
+        name = sep + 3;
+
+    return name;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_endpoint_open(const char *name,
+    struct na_inproc_endpoint **endpoint_ptr)
+{
+    struct na_inproc_endpoint *na_inproc_endpoint = NULL, *var_endpoint;
+    na_return_t ret = NA_SUCCESS;
+
+    if (name && strlen(name) >= NA_INPROC_MAX_ADDR_NAME) {
+        NA_LOG_ERROR("Exceeding max addr name");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    na_inproc_endpoint = (struct na_inproc_endpoint *) malloc(
+        sizeof(struct na_inproc_endpoint));
+    if (!na_inproc_endpoint) {
+        NA_LOG_ERROR("Could not allocate NA INPROC endpoint");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_inproc_endpoint, 0, sizeof(struct na_inproc_endpoint));
+    na_inproc_endpoint->notify = -1;
+    HG_QUEUE_INIT(&na_inproc_endpoint->backfill_queue);
+    hg_atomic_init32(&na_inproc_endpoint->backfill_count, 0);
+    hg_atomic_init32(&na_inproc_endpoint->waiting, 0);
+    hg_atomic_init32(&na_inproc_endpoint->ref_count, 1);
+    hg_thread_mutex_init(&na_inproc_endpoint->backfill_mutex);
+    hg_thread_rwlock_init(&na_inproc_endpoint->rwlock);
+
+    if (name)
+        strcpy(na_inproc_endpoint->name, name);
+    else
+        sprintf(na_inproc_endpoint->name, "%d",
+            (int) hg_atomic_incr32(&na_inproc_endpoint_id_g));
+
+    na_inproc_endpoint->msg_queue = hg_atomic_queue_alloc(NA_INPROC_QUEUE_SIZE);
+    if (!na_inproc_endpoint->msg_queue) {
+        NA_LOG_ERROR("Could not allocate msg queue");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+
+    na_inproc_endpoint->notify = hg_event_create();
+    if (na_inproc_endpoint->notify == -1) {
+        NA_LOG_ERROR("hg_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Names must be unique within process */
+    hg_thread_mutex_lock(&na_inproc_endpoint_list_mutex_g);
+    HG_LIST_FOREACH(var_endpoint, &na_inproc_endpoint_list_g, entry) {
+        if (!strcmp(var_endpoint->name, na_inproc_endpoint->name))
+            break;
+    }
+    if (var_endpoint) {
+        hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+        NA_LOG_ERROR("Name %s is already in use", na_inproc_endpoint->name);
+        ret = NA_ADDRINUSE_ERROR;
+        goto done;
+    }
+    HG_LIST_INSERT_HEAD(&na_inproc_endpoint_list_g, na_inproc_endpoint, entry);
+    hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+
+    *endpoint_ptr = na_inproc_endpoint;
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_endpoint) {
+        na_inproc_endpoint->closed = NA_TRUE;
+        na_inproc_endpoint_release(na_inproc_endpoint);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_endpoint_close(struct na_inproc_endpoint *na_inproc_endpoint)
+{
+    struct na_inproc_op_id *na_inproc_op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Lookups can no longer find endpoint */
+    hg_thread_mutex_lock(&na_inproc_endpoint_list_mutex_g);
+    HG_LIST_REMOVE(na_inproc_endpoint, entry);
+    hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+
+    /* Wait for senders that are pushing messages, none can push after */
+    hg_thread_rwlock_wrlock(&na_inproc_endpoint->rwlock);
+    na_inproc_endpoint->closed = NA_TRUE;
+    hg_thread_rwlock_release_wrlock(&na_inproc_endpoint->rwlock);
+
+    /* Messages that were not received fail on the sender side */
+    while ((na_inproc_op_id = na_inproc_endpoint_pop(na_inproc_endpoint))
+        != NULL) {
+        ret = na_inproc_send_complete(na_inproc_op_id, NA_PROTOCOL_ERROR);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_endpoint_release(struct na_inproc_endpoint *na_inproc_endpoint)
+{
+    if (hg_atomic_decr32(&na_inproc_endpoint->ref_count))
+        return;
+
+    if (na_inproc_endpoint->notify != -1)
+        hg_event_destroy(na_inproc_endpoint->notify);
+    hg_atomic_queue_free(na_inproc_endpoint->msg_queue);
+    hg_thread_rwlock_destroy(&na_inproc_endpoint->rwlock);
+    hg_thread_mutex_destroy(&na_inproc_endpoint->backfill_mutex);
+    free(na_inproc_endpoint);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_endpoint_push(struct na_inproc_endpoint *na_inproc_endpoint,
+    struct na_inproc_op_id *na_inproc_op_id)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_rwlock_rdlock(&na_inproc_endpoint->rwlock);
+    if (na_inproc_endpoint->closed) {
+        NA_LOG_ERROR("Endpoint %s is closed", na_inproc_endpoint->name);
+        ret = NA_PROTOCOL_ERROR;
+        goto unlock;
+    }
+
+    /* Messages go to backfill queue as long as it is not empty so that they
+     * are received in order */
+    if (hg_atomic_get32(&na_inproc_endpoint->backfill_count)
+        || hg_atomic_queue_push(na_inproc_endpoint->msg_queue,
+            na_inproc_op_id) != HG_UTIL_SUCCESS) {
+        hg_thread_mutex_lock(&na_inproc_endpoint->backfill_mutex);
+        HG_QUEUE_PUSH_TAIL(&na_inproc_endpoint->backfill_queue,
+            na_inproc_op_id, entry);
+        hg_atomic_incr32(&na_inproc_endpoint->backfill_count);
+        hg_thread_mutex_unlock(&na_inproc_endpoint->backfill_mutex);
+    }
+
+    /* Pairs with fence in na_inproc_poll_try_wait() */
+    hg_atomic_fence();
+    if (hg_atomic_get32(&na_inproc_endpoint->waiting)
+        && hg_event_set(na_inproc_endpoint->notify) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("Could not send completion notification");
+        ret = NA_PROTOCOL_ERROR;
+        goto unlock;
+    }
+
+unlock:
+    hg_thread_rwlock_release_rdlock(&na_inproc_endpoint->rwlock);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_inproc_op_id *
+na_inproc_endpoint_pop(struct na_inproc_endpoint *na_inproc_endpoint)
+{
+    struct na_inproc_op_id *na_inproc_op_id;
+
+    na_inproc_op_id = (struct na_inproc_op_id *) hg_atomic_queue_pop_mc(
+        na_inproc_endpoint->msg_queue);
+    if (!na_inproc_op_id
+        && hg_atomic_get32(&na_inproc_endpoint->backfill_count)) {
+        hg_thread_mutex_lock(&na_inproc_endpoint->backfill_mutex);
+        na_inproc_op_id = HG_QUEUE_FIRST(&na_inproc_endpoint->backfill_queue);
+        if (na_inproc_op_id) {
+            HG_QUEUE_POP_HEAD(&na_inproc_endpoint->backfill_queue, entry);
+            hg_atomic_decr32(&na_inproc_endpoint->backfill_count);
+        }
+        hg_thread_mutex_unlock(&na_inproc_endpoint->backfill_mutex);
+    }
+
+    return na_inproc_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_endpoint_notify(struct na_inproc_endpoint *na_inproc_endpoint)
+{
+    hg_atomic_fence();
+    if (!hg_atomic_get32(&na_inproc_endpoint->waiting))
+        return;
+
+    hg_thread_rwlock_rdlock(&na_inproc_endpoint->rwlock);
+    if (!na_inproc_endpoint->closed
+        && hg_event_set(na_inproc_endpoint->notify) != HG_UTIL_SUCCESS)
+        NA_LOG_ERROR("Could not send completion notification");
+    hg_thread_rwlock_release_rdlock(&na_inproc_endpoint->rwlock);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_get(na_class_t *na_class,
+    struct na_inproc_endpoint *na_inproc_endpoint,
+    struct na_inproc_addr **addr_ptr)
+{
+    struct na_inproc_addr *na_inproc_addr;
+    na_return_t ret = NA_SUCCESS;
+
+    if (na_inproc_endpoint == NA_INPROC_PRIVATE_DATA(na_class)->endpoint) {
+        na_inproc_addr = NA_INPROC_PRIVATE_DATA(na_class)->self_addr;
+        hg_atomic_incr32(&na_inproc_addr->ref_count);
+        goto done;
+    }
+
+    /* Reuse addr of that peer if any */
+    hg_thread_spin_lock(&NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+    HG_LIST_FOREACH(na_inproc_addr,
+        &NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list, entry) {
+        if (na_inproc_addr->endpoint == na_inproc_endpoint) {
+            hg_atomic_incr32(&na_inproc_addr->ref_count);
+            break;
+        }
+    }
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+    if (na_inproc_addr)
+        goto done;
+
+    na_inproc_addr = (struct na_inproc_addr *) malloc(
+        sizeof(struct na_inproc_addr));
+    if (!na_inproc_addr) {
+        NA_LOG_ERROR("Could not allocate NA INPROC addr");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_inproc_addr, 0, sizeof(struct na_inproc_addr));
+    hg_atomic_incr32(&na_inproc_endpoint->ref_count);
+    na_inproc_addr->endpoint = na_inproc_endpoint;
+    hg_atomic_init32(&na_inproc_addr->ref_count, 1);
+
+    /* Addr is kept for subsequent lookups until released */
+    hg_thread_spin_lock(&NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+    HG_LIST_INSERT_HEAD(&NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list,
+        na_inproc_addr, entry);
+    na_inproc_addr->cached = NA_TRUE;
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+
+done:
+    *addr_ptr = na_inproc_addr;
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, struct na_inproc_addr *na_inproc_addr, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size > ((cb_type == NA_CB_SEND_UNEXPECTED) ?
+        NA_INPROC_UNEXPECTED_SIZE : NA_INPROC_EXPECTED_SIZE)) {
+        NA_LOG_ERROR("Exceeds message size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_inproc_op_id = (struct na_inproc_op_id *) *op_id;
+        hg_atomic_incr32(&na_inproc_op_id->ref_count);
+    } else {
+        na_inproc_op_id = na_inproc_op_alloc(na_class, context);
+        if (!na_inproc_op_id) {
+            NA_LOG_ERROR("Could not allocate NA INPROC operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_inproc_op_id->context = context;
+    na_inproc_op_id->completion_data.callback_info.type = cb_type;
+    na_inproc_op_id->completion_data.callback = callback;
+    na_inproc_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_inproc_op_id->canceled, NA_FALSE);
+    na_inproc_op_id->ret = NA_SUCCESS;
+    na_inproc_op_id->info.send.source =
+        NA_INPROC_PRIVATE_DATA(na_class)->endpoint;
+    hg_atomic_incr32(&na_inproc_op_id->info.send.source->ref_count);
+    na_inproc_op_id->info.send.buf = buf;
+    na_inproc_op_id->info.send.buf_size = buf_size;
+    na_inproc_op_id->info.send.tag = tag;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_inproc_op_id;
+
+    /* Buffer is not copied, target copies it into the recv buffer and
+     * completes the op once done */
+    ret = na_inproc_endpoint_push(na_inproc_addr->endpoint, na_inproc_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not push message");
+        na_inproc_endpoint_release(na_inproc_op_id->info.send.source);
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_op_id) {
+        na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_rma(na_class_t *na_class, na_context_t *context, na_cb_type_t cb_type,
+    na_cb_t callback, void *arg,
+    struct na_inproc_mem_handle *local_mem_handle, na_offset_t local_offset,
+    struct na_inproc_mem_handle *remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_op_id_t *op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    char *local_buf, *remote_buf;
+    na_return_t ret = NA_SUCCESS;
+
+    if (local_offset + length > local_mem_handle->size
+        || remote_offset + length > remote_mem_handle->size) {
+        NA_LOG_ERROR("Exceeding memory region size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_inproc_op_id = (struct na_inproc_op_id *) *op_id;
+        hg_atomic_incr32(&na_inproc_op_id->ref_count);
+    } else {
+        na_inproc_op_id = na_inproc_op_alloc(na_class, context);
+        if (!na_inproc_op_id) {
+            NA_LOG_ERROR("Could not allocate NA INPROC operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_inproc_op_id->context = context;
+    na_inproc_op_id->completion_data.callback_info.type = cb_type;
+    na_inproc_op_id->completion_data.callback = callback;
+    na_inproc_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_inproc_op_id->canceled, NA_FALSE);
+    na_inproc_op_id->ret = NA_SUCCESS;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_inproc_op_id;
+
+    /* Remote region is in the same address space */
+    local_buf = (char *) local_mem_handle->base + local_offset;
+    remote_buf = (char *) remote_mem_handle->base + remote_offset;
+    if (cb_type == NA_CB_PUT)
+        memcpy(remote_buf, local_buf, length);
+    else
+        memcpy(local_buf, remote_buf, length);
+
+    ret = na_inproc_complete(na_inproc_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_op_id) {
+        na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_inproc_progress_cb(void *arg, unsigned int NA_UNUSED timeout,
+    hg_util_bool_t *progressed)
+{
+    na_class_t *na_class = (na_class_t *) arg;
+    hg_util_bool_t notified = HG_UTIL_FALSE;
+    na_return_t na_ret;
+
+    /* Notification means that messages arrived or that ops completed */
+    if (hg_event_get(NA_INPROC_PRIVATE_DATA(na_class)->endpoint->notify,
+        &notified) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("Could not get completion notification");
+        na_ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    na_ret = na_inproc_progress_msgs(na_class, (na_bool_t *) progressed);
+    if (na_ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not make progress on messages");
+        goto done;
+    }
+    if (notified)
+        *progressed = HG_UTIL_TRUE;
+
+done:
+    return (na_ret == NA_SUCCESS) ? HG_UTIL_SUCCESS : HG_UTIL_FAIL;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_progress_msgs(na_class_t *na_class, na_bool_t *progressed)
+{
+    struct na_inproc_op_id *send_op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    while ((send_op_id = na_inproc_endpoint_pop(
+        NA_INPROC_PRIVATE_DATA(na_class)->endpoint)) != NULL) {
+        switch (send_op_id->completion_data.callback_info.type) {
+            case NA_CB_SEND_UNEXPECTED:
+                ret = na_inproc_progress_unexpected(na_class, send_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not make progress on unexpected msg");
+                    goto done;
+                }
+                break;
+            case NA_CB_SEND_EXPECTED:
+                ret = na_inproc_progress_expected(na_class, send_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not make progress on expected msg");
+                    goto done;
+                }
+                break;
+            default:
+                NA_LOG_ERROR("Unknown message type");
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+        }
+        *progressed = NA_TRUE;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_progress_unexpected(na_class_t *na_class,
+    struct na_inproc_op_id *send_op_id)
+{
+    struct na_inproc_unexpected_info *na_inproc_unexpected_info = NULL;
+    struct na_inproc_op_id *na_inproc_op_id;
+    struct na_inproc_addr *na_inproc_addr = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    ret = na_inproc_addr_get(na_class, send_op_id->info.send.source,
+        &na_inproc_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not get source addr");
+        goto done;
+    }
+
+    /* Pop op ID from queue */
+    hg_thread_spin_lock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    na_inproc_op_id = HG_QUEUE_FIRST(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue);
+    HG_QUEUE_POP_HEAD(&NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue,
+        entry);
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+
+    if (na_inproc_op_id) {
+        /* Copy straight from sender buffer, addr reference is transferred to
+         * the operation */
+        na_inproc_op_id->info.recv_unexpected.actual_buf_size = NA_INPROC_MIN(
+            send_op_id->info.send.buf_size,
+            na_inproc_op_id->info.recv_unexpected.buf_size);
+        memcpy(na_inproc_op_id->info.recv_unexpected.buf,
+            send_op_id->info.send.buf,
+            na_inproc_op_id->info.recv_unexpected.actual_buf_size);
+        na_inproc_op_id->info.recv_unexpected.na_inproc_addr = na_inproc_addr;
+        na_inproc_op_id->info.recv_unexpected.tag = send_op_id->info.send.tag;
+
+        ret = na_inproc_complete(na_inproc_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+    } else {
+        /* If no error and message arrived, keep a copy of the struct in
+         * the unexpected message queue (should rarely happen) */
+        na_inproc_unexpected_info = (struct na_inproc_unexpected_info *) malloc(
+            sizeof(struct na_inproc_unexpected_info));
+        if (!na_inproc_unexpected_info) {
+            NA_LOG_ERROR("Could not allocate unexpected info");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        na_inproc_unexpected_info->buf = malloc(send_op_id->info.send.buf_size);
+        if (!na_inproc_unexpected_info->buf) {
+            NA_LOG_ERROR("Could not allocate unexpected buffer");
+            free(na_inproc_unexpected_info);
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        memcpy(na_inproc_unexpected_info->buf, send_op_id->info.send.buf,
+            send_op_id->info.send.buf_size);
+        na_inproc_unexpected_info->buf_size = send_op_id->info.send.buf_size;
+        na_inproc_unexpected_info->na_inproc_addr = na_inproc_addr;
+        na_inproc_unexpected_info->tag = send_op_id->info.send.tag;
+
+        hg_thread_spin_lock(
+            &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+        HG_QUEUE_PUSH_TAIL(
+            &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue,
+            na_inproc_unexpected_info, entry);
+        hg_thread_spin_unlock(
+            &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    }
+
+    /* Sender buffer can be reused */
+    ret = na_inproc_send_complete(send_op_id, NA_SUCCESS);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_addr && !na_inproc_unexpected_info)
+        na_inproc_addr_free(na_class, (na_addr_t) na_inproc_addr);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_progress_expected(na_class_t *na_class,
+    struct na_inproc_op_id *send_op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_spin_lock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    HG_QUEUE_FOREACH(na_inproc_op_id,
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue, entry) {
+        if (na_inproc_op_id->info.recv_expected.na_inproc_addr->endpoint
+            == send_op_id->info.send.source
+            && na_inproc_op_id->info.recv_expected.tag
+            == send_op_id->info.send.tag) {
+            HG_QUEUE_REMOVE(
+                &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue,
+                na_inproc_op_id, na_inproc_op_id, entry);
+            break;
+        }
+    }
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+    if (!na_inproc_op_id) {
+        /* No match if either the message was not pre-posted or it was
+         * canceled */
+        NA_LOG_WARNING("Ignored expected message received (canceled?)");
+    } else {
+        memcpy(na_inproc_op_id->info.recv_expected.buf,
+            send_op_id->info.send.buf, NA_INPROC_MIN(
+                send_op_id->info.send.buf_size,
+                na_inproc_op_id->info.recv_expected.buf_size));
+
+        ret = na_inproc_complete(na_inproc_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+    }
+
+    /* Sender buffer can be reused */
+    ret = na_inproc_send_complete(send_op_id, NA_SUCCESS);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_send_complete(struct na_inproc_op_id *send_op_id, na_return_t ret)
+{
+    struct na_inproc_endpoint *source = send_op_id->info.send.source;
+
+    send_op_id->ret = ret;
+    ret = na_inproc_complete(send_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+    /* Sender may be blocked in progress of another class, its endpoint
+     * reference was taken when the message was pushed */
+    na_inproc_endpoint_notify(source);
+
+done:
+    na_inproc_endpoint_release(source);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_complete(struct na_inproc_op_id *na_inproc_op_id)
+{
+    struct na_cb_info *callback_info = NULL;
+    na_bool_t canceled =
+        (na_bool_t) hg_atomic_get32(&na_inproc_op_id->canceled);
+    na_return_t ret = NA_SUCCESS;
+
+    /* Init callback info */
+    callback_info = &na_inproc_op_id->completion_data.callback_info;
+    callback_info->ret = (canceled) ? NA_CANCELED : na_inproc_op_id->ret;
+
+    switch (callback_info->type) {
+        case NA_CB_LOOKUP:
+            callback_info->info.lookup.addr =
+                (na_addr_t) na_inproc_op_id->info.lookup.na_inproc_addr;
+            break;
+        case NA_CB_SEND_UNEXPECTED:
+            break;
+        case NA_CB_RECV_UNEXPECTED:
+            if (callback_info->ret != NA_SUCCESS) {
+                /* In case of cancellation where no recv'd data */
+                callback_info->info.recv_unexpected.actual_buf_size = 0;
+                callback_info->info.recv_unexpected.source = NA_ADDR_NULL;
+                callback_info->info.recv_unexpected.tag = 0;
+                break;
+            }
+
+            /* Fill callback info */
+            callback_info->info.recv_unexpected.actual_buf_size =
+                na_inproc_op_id->info.recv_unexpected.actual_buf_size;
+            callback_info->info.recv_unexpected.source = (na_addr_t)
+                na_inproc_op_id->info.recv_unexpected.na_inproc_addr;
+            callback_info->info.recv_unexpected.tag =
+                na_inproc_op_id->info.recv_unexpected.tag;
+            break;
+        case NA_CB_SEND_EXPECTED:
+            break;
+        case NA_CB_RECV_EXPECTED:
+            break;
+        case NA_CB_PUT:
+        case NA_CB_GET:
+            break;
+        default:
+            NA_LOG_ERROR("Operation not supported");
+            ret = NA_INVALID_PARAM;
+            break;
+    }
+
+    /* Mark op id as completed */
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_TRUE);
+
+    ret = na_cb_completion_add(na_inproc_op_id->context,
+        &na_inproc_op_id->completion_data);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add callback to completion queue");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_release(void *arg)
+{
+    struct na_inproc_op_id *na_inproc_op_id = (struct na_inproc_op_id *) arg;
+
+    if (na_inproc_op_id && !hg_atomic_get32(&na_inproc_op_id->completed)) {
+        NA_LOG_WARNING("Releasing resources from an uncompleted operation");
+    }
+    na_inproc_op_destroy(NULL, na_inproc_op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_inproc_op_id *
+na_inproc_op_alloc(na_class_t *na_class, na_context_t *context)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+
+    na_inproc_op_id = (struct na_inproc_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_inproc_op_id));
+    if (!na_inproc_op_id) {
+        NA_LOG_ERROR("Could not allocate NA INPROC operation ID");
+        goto done;
+    }
+    memset(na_inproc_op_id, 0, sizeof(struct na_inproc_op_id));
+    na_inproc_op_id->na_class = na_class;
+    hg_atomic_init32(&na_inproc_op_id->ref_count, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_inproc_op_id->completed, NA_TRUE);
+
+    /* Set op ID release callbacks */
+    na_inproc_op_id->completion_data.plugin_callback = na_inproc_release;
+    na_inproc_op_id->completion_data.plugin_callback_args = na_inproc_op_id;
+
+done:
+    return na_inproc_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_inproc_check_protocol(const char *protocol_name)
+{
+    na_bool_t accept = NA_FALSE;
+
+    if (!strcmp("inproc", protocol_name))
+        accept = NA_TRUE;
+
+    return accept;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t NA_UNUSED listen)
+{
+    struct na_inproc_addr *na_inproc_addr = NULL;
+    const char *name = NULL;
+    hg_poll_set_t *poll_set;
+    na_return_t ret = NA_SUCCESS;
+
+    if (na_info->host_name) {
+        name = na_inproc_parse_name(na_info->host_name);
+        if (!name[0])
+            name = NULL;
+    }
+
+    /* Initialize private data */
+    na_class->private_data = malloc(sizeof(struct na_inproc_private_data));
+    if (!na_class->private_data) {
+        NA_LOG_ERROR("Could not allocate NA private data class");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_class->private_data, 0, sizeof(struct na_inproc_private_data));
+
+    /* Initialize queues */
+    HG_LIST_INIT(&NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list);
+    HG_QUEUE_INIT(&NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue);
+    HG_QUEUE_INIT(&NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue);
+    HG_QUEUE_INIT(&NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue);
+
+    /* Initialize mutexes */
+    hg_thread_spin_init(&NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+    hg_thread_spin_init(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    hg_thread_spin_init(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    hg_thread_spin_init(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+    /* Classes that do not listen still need an endpoint to be replied to */
+    ret = na_inproc_endpoint_open(name,
+        &NA_INPROC_PRIVATE_DATA(na_class)->endpoint);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not open endpoint");
+        goto done;
+    }
+
+    /* Create self addr */
+    na_inproc_addr = (struct na_inproc_addr *) malloc(
+        sizeof(struct na_inproc_addr));
+    if (!na_inproc_addr) {
+        NA_LOG_ERROR("Could not allocate NA INPROC addr");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_inproc_addr, 0, sizeof(struct na_inproc_addr));
+    na_inproc_addr->endpoint = NA_INPROC_PRIVATE_DATA(na_class)->endpoint;
+    hg_atomic_incr32(&na_inproc_addr->endpoint->ref_count);
+    na_inproc_addr->self = NA_TRUE;
+    hg_atomic_init32(&na_inproc_addr->ref_count, 1);
+    NA_INPROC_PRIVATE_DATA(na_class)->self_addr = na_inproc_addr;
+
+    /* Create poll set to wait for notifications */
+    poll_set = hg_poll_create();
+    if (!poll_set) {
+        NA_LOG_ERROR("Cannot create poll set");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    NA_INPROC_PRIVATE_DATA(na_class)->poll_set = poll_set;
+
+    if (hg_poll_add(poll_set, na_inproc_addr->endpoint->notify, HG_POLLIN,
+        na_inproc_progress_cb, na_class) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("hg_poll_add failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_finalize(na_class_t *na_class)
+{
+    struct na_inproc_endpoint *na_inproc_endpoint;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_class->private_data) {
+        goto done;
+    }
+    na_inproc_endpoint = NA_INPROC_PRIVATE_DATA(na_class)->endpoint;
+
+    /* Check that unexpected op queue is empty */
+    if (!HG_QUEUE_IS_EMPTY(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue)) {
+        NA_LOG_ERROR("Unexpected op queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that unexpected message queue is empty */
+    if (!HG_QUEUE_IS_EMPTY(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue)) {
+        NA_LOG_ERROR("Unexpected msg queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that expected op queue is empty */
+    if (!HG_QUEUE_IS_EMPTY(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue)) {
+        NA_LOG_ERROR("Expected op queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Remove from poll set */
+    if (NA_INPROC_PRIVATE_DATA(na_class)->poll_set) {
+        if (na_inproc_endpoint && hg_poll_remove(
+            NA_INPROC_PRIVATE_DATA(na_class)->poll_set,
+            na_inproc_endpoint->notify) != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_remove() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        if (hg_poll_destroy(NA_INPROC_PRIVATE_DATA(na_class)->poll_set)
+            != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_destroy() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    }
+
+    /* Close endpoint, peers may still hold addrs pointing to it */
+    if (na_inproc_endpoint) {
+        ret = na_inproc_endpoint_close(na_inproc_endpoint);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not close endpoint");
+            goto done;
+        }
+    }
+
+    /* Free self addr */
+    if (NA_INPROC_PRIVATE_DATA(na_class)->self_addr) {
+        ret = na_inproc_addr_free(na_class,
+            NA_INPROC_PRIVATE_DATA(na_class)->self_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not free self addr");
+            goto done;
+        }
+    }
+    if (na_inproc_endpoint)
+        na_inproc_endpoint_release(na_inproc_endpoint);
+
+    /* Destroy mutexes */
+    hg_thread_spin_destroy(
+        &NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+    hg_thread_spin_destroy(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+    free(na_class->private_data);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_inproc_check_feature(na_class_t NA_UNUSED *na_class, na_uint8_t feature)
+{
+    na_bool_t ret = NA_FALSE;
+
+    switch (feature) {
+        case NA_HAS_TAG_MASK:
+            ret = NA_FALSE;
+            break;
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_inproc_op_create(na_class_t *na_class)
+{
+    return (na_op_id_t) na_inproc_op_alloc(na_class, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = (struct na_inproc_op_id *) op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_decr32(&na_inproc_op_id->ref_count)) {
+        /* Cannot free yet */
+        goto done;
+    }
+    na_op_id_free(na_inproc_op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    struct na_inproc_endpoint *na_inproc_endpoint;
+    na_return_t ret = NA_SUCCESS;
+
+    /**
+     * Clean up name, strings can be of the format:
+     *   <protocol>://<name>
+     */
+    name = na_inproc_parse_name(name);
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_inproc_op_id = (struct na_inproc_op_id *) *op_id;
+        hg_atomic_incr32(&na_inproc_op_id->ref_count);
+    } else {
+        na_inproc_op_id = na_inproc_op_alloc(na_class, context);
+        if (!na_inproc_op_id) {
+            NA_LOG_ERROR("Could not allocate NA INPROC operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_inproc_op_id->context = context;
+    na_inproc_op_id->completion_data.callback_info.type = NA_CB_LOOKUP;
+    na_inproc_op_id->completion_data.callback = callback;
+    na_inproc_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_inproc_op_id->canceled, NA_FALSE);
+    na_inproc_op_id->ret = NA_SUCCESS;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_inproc_op_id;
+
+    /* Endpoint reference is taken while list is locked so that it cannot be
+     * released meanwhile */
+    hg_thread_mutex_lock(&na_inproc_endpoint_list_mutex_g);
+    HG_LIST_FOREACH(na_inproc_endpoint, &na_inproc_endpoint_list_g, entry) {
+        if (!strcmp(na_inproc_endpoint->name, name)) {
+            hg_atomic_incr32(&na_inproc_endpoint->ref_count);
+            break;
+        }
+    }
+    hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+    if (!na_inproc_endpoint) {
+        NA_LOG_ERROR("Could not find %s", name);
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    ret = na_inproc_addr_get(na_class, na_inproc_endpoint,
+        &na_inproc_op_id->info.lookup.na_inproc_addr);
+    na_inproc_endpoint_release(na_inproc_endpoint);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not get addr");
+        goto done;
+    }
+
+    ret = na_inproc_complete(na_inproc_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_op_id) {
+        na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_free(na_class_t *na_class, na_addr_t addr)
+{
+    struct na_inproc_addr *na_inproc_addr = (struct na_inproc_addr *) addr;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_inproc_addr) {
+        NA_LOG_ERROR("NULL INPROC addr");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    /* Lookups must not be able to grab a released addr */
+    hg_thread_spin_lock(&NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+    if (hg_atomic_decr32(&na_inproc_addr->ref_count)) {
+        hg_thread_spin_unlock(
+            &NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+        /* Cannot free yet */
+        goto done;
+    }
+    if (na_inproc_addr->cached) {
+        HG_LIST_REMOVE(na_inproc_addr, entry);
+        na_inproc_addr->cached = NA_FALSE;
+    }
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->peer_addr_list_lock);
+
+    na_inproc_endpoint_release(na_inproc_addr->endpoint);
+    free(na_inproc_addr);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_self(na_class_t *na_class, na_addr_t *addr)
+{
+    struct na_inproc_addr *na_inproc_addr =
+        NA_INPROC_PRIVATE_DATA(na_class)->self_addr;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Increment refcount */
+    hg_atomic_incr32(&na_inproc_addr->ref_count);
+
+    *addr = (na_addr_t) na_inproc_addr;
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_dup(na_class_t NA_UNUSED *na_class, na_addr_t addr,
+    na_addr_t *new_addr)
+{
+    struct na_inproc_addr *na_inproc_addr = (struct na_inproc_addr *) addr;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Increment refcount */
+    hg_atomic_incr32(&na_inproc_addr->ref_count);
+
+    *new_addr = (na_addr_t) na_inproc_addr;
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_inproc_addr_is_self(na_class_t NA_UNUSED *na_class, na_addr_t addr)
+{
+    struct na_inproc_addr *na_inproc_addr = (struct na_inproc_addr *) addr;
+
+    return na_inproc_addr->self;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_to_string(na_class_t NA_UNUSED *na_class, char *buf,
+    na_size_t *buf_size, na_addr_t addr)
+{
+    struct na_inproc_addr *na_inproc_addr = (struct na_inproc_addr *) addr;
+    na_size_t string_len;
+    char addr_string[NA_INPROC_MAX_ADDR_NAME + 16];
+    na_return_t ret = NA_SUCCESS;
+
+    sprintf(addr_string, "inproc://%s", na_inproc_addr->endpoint->name);
+    string_len = strlen(addr_string);
+    if (buf) {
+        if (string_len >= *buf_size) {
+            NA_LOG_ERROR("Buffer size too small to copy addr");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        } else {
+            strcpy(buf, addr_string);
+        }
+    }
+
+    *buf_size = string_len + 1;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_inproc_msg_get_max_unexpected_size(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_INPROC_UNEXPECTED_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_inproc_msg_get_max_expected_size(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_INPROC_EXPECTED_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_tag_t
+na_inproc_msg_get_max_tag(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_INPROC_MAX_TAG;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    return na_inproc_msg_send(na_class, context, NA_CB_SEND_UNEXPECTED,
+        callback, arg, buf, buf_size, (struct na_inproc_addr *) dest, tag,
+        op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_tag_t NA_UNUSED mask, na_op_id_t *op_id)
+{
+    struct na_inproc_unexpected_info *na_inproc_unexpected_info;
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size > NA_INPROC_UNEXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds unexpected size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_inproc_op_id = (struct na_inproc_op_id *) *op_id;
+        hg_atomic_incr32(&na_inproc_op_id->ref_count);
+    } else {
+        na_inproc_op_id = na_inproc_op_alloc(na_class, context);
+        if (!na_inproc_op_id) {
+            NA_LOG_ERROR("Could not allocate NA INPROC operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_inproc_op_id->context = context;
+    na_inproc_op_id->completion_data.callback_info.type =
+        NA_CB_RECV_UNEXPECTED;
+    na_inproc_op_id->completion_data.callback = callback;
+    na_inproc_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_inproc_op_id->canceled, NA_FALSE);
+    na_inproc_op_id->ret = NA_SUCCESS;
+    na_inproc_op_id->info.recv_unexpected.buf = buf;
+    na_inproc_op_id->info.recv_unexpected.buf_size = buf_size;
+    na_inproc_op_id->info.recv_unexpected.na_inproc_addr = NULL;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_inproc_op_id;
+
+    /* Look for an unexpected message already received */
+    hg_thread_spin_lock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    na_inproc_unexpected_info = HG_QUEUE_FIRST(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue);
+    HG_QUEUE_POP_HEAD(&NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue,
+        entry);
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    if (na_inproc_unexpected_info) {
+        /* Addr reference is transferred to the operation */
+        na_inproc_op_id->info.recv_unexpected.actual_buf_size = NA_INPROC_MIN(
+            na_inproc_unexpected_info->buf_size, buf_size);
+        memcpy(buf, na_inproc_unexpected_info->buf,
+            na_inproc_op_id->info.recv_unexpected.actual_buf_size);
+        na_inproc_op_id->info.recv_unexpected.na_inproc_addr =
+            na_inproc_unexpected_info->na_inproc_addr;
+        na_inproc_op_id->info.recv_unexpected.tag =
+            na_inproc_unexpected_info->tag;
+        free(na_inproc_unexpected_info->buf);
+        free(na_inproc_unexpected_info);
+
+        ret = na_inproc_complete(na_inproc_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+    } else {
+        /* Nothing has been received yet so add op_id to progress queue */
+        hg_thread_spin_lock(
+            &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+        HG_QUEUE_PUSH_TAIL(
+            &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue,
+            na_inproc_op_id, entry);
+        hg_thread_spin_unlock(
+            &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_op_id) {
+        na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    return na_inproc_msg_send(na_class, context, NA_CB_SEND_EXPECTED,
+        callback, arg, buf, buf_size, (struct na_inproc_addr *) dest, tag,
+        op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t source, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size > NA_INPROC_EXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds expected size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_inproc_op_id = (struct na_inproc_op_id *) *op_id;
+        hg_atomic_incr32(&na_inproc_op_id->ref_count);
+    } else {
+        na_inproc_op_id = na_inproc_op_alloc(na_class, context);
+        if (!na_inproc_op_id) {
+            NA_LOG_ERROR("Could not allocate NA INPROC operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_inproc_op_id->context = context;
+    na_inproc_op_id->completion_data.callback_info.type = NA_CB_RECV_EXPECTED;
+    na_inproc_op_id->completion_data.callback = callback;
+    na_inproc_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_inproc_op_id->canceled, NA_FALSE);
+    na_inproc_op_id->ret = NA_SUCCESS;
+    na_inproc_op_id->info.recv_expected.buf = buf;
+    na_inproc_op_id->info.recv_expected.buf_size = buf_size;
+    na_inproc_op_id->info.recv_expected.na_inproc_addr =
+        (struct na_inproc_addr *) source;
+    na_inproc_op_id->info.recv_expected.tag = tag;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_inproc_op_id;
+
+    /* Expected messages must always be pre-posted, therefore a message should
+     * never arrive before that call returns (not completes), simply add
+     * op_id to queue */
+    hg_thread_spin_lock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    HG_QUEUE_PUSH_TAIL(&NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue,
+        na_inproc_op_id, entry);
+    hg_thread_spin_unlock(
+        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+done:
+    if (ret != NA_SUCCESS && na_inproc_op_id) {
+        na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_inproc_mem_handle = (struct na_inproc_mem_handle *) malloc(
+        sizeof(struct na_inproc_mem_handle));
+    if (!na_inproc_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA INPROC memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    na_inproc_mem_handle->base = (na_ptr_t) buf;
+    na_inproc_mem_handle->size = buf_size;
+    na_inproc_mem_handle->flags = flags;
+
+    *mem_handle = (na_mem_handle_t) na_inproc_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_free(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle =
+        (struct na_inproc_mem_handle *) mem_handle;
+
+    free(na_inproc_mem_handle);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_inproc_mem_handle_get_serialize_size(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t NA_UNUSED mem_handle)
+{
+    return sizeof(struct na_inproc_mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_serialize(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle =
+        (struct na_inproc_mem_handle *) mem_handle;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size < sizeof(struct na_inproc_mem_handle)) {
+        NA_LOG_ERROR("Buffer size too small for serializing handle");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Handle is only ever deserialized within the same process */
+    memcpy(buf, na_inproc_mem_handle, sizeof(struct na_inproc_mem_handle));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_deserialize(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size < sizeof(struct na_inproc_mem_handle)) {
+        NA_LOG_ERROR("Buffer size too small for deserializing handle");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    na_inproc_mem_handle = (struct na_inproc_mem_handle *) malloc(
+        sizeof(struct na_inproc_mem_handle));
+    if (!na_inproc_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA INPROC memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memcpy(na_inproc_mem_handle, buf, sizeof(struct na_inproc_mem_handle));
+
+    *mem_handle = (na_mem_handle_t) na_inproc_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t NA_UNUSED remote_addr, na_op_id_t *op_id)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle_remote =
+        (struct na_inproc_mem_handle *) remote_mem_handle;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_inproc_mem_handle_remote->flags) {
+        case NA_MEM_READ_ONLY:
+            NA_LOG_ERROR("Registered memory requires write permission");
+            ret = NA_PERMISSION_ERROR;
+            goto done;
+        case NA_MEM_WRITE_ONLY:
+        case NA_MEM_READWRITE:
+            break;
+        default:
+            NA_LOG_ERROR("Invalid memory access flag");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    ret = na_inproc_rma(na_class, context, NA_CB_PUT, callback, arg,
+        (struct na_inproc_mem_handle *) local_mem_handle, local_offset,
+        na_inproc_mem_handle_remote, remote_offset, length, op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t NA_UNUSED remote_addr, na_op_id_t *op_id)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle_remote =
+        (struct na_inproc_mem_handle *) remote_mem_handle;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_inproc_mem_handle_remote->flags) {
+        case NA_MEM_WRITE_ONLY:
+            NA_LOG_ERROR("Registered memory requires read permission");
+            ret = NA_PERMISSION_ERROR;
+            goto done;
+        case NA_MEM_READ_ONLY:
+        case NA_MEM_READWRITE:
+            break;
+        default:
+            NA_LOG_ERROR("Invalid memory access flag");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    ret = na_inproc_rma(na_class, context, NA_CB_GET, callback, arg,
+        (struct na_inproc_mem_handle *) local_mem_handle, local_offset,
+        na_inproc_mem_handle_remote, remote_offset, length, op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_inproc_poll_get_fd(na_class_t *na_class, na_context_t NA_UNUSED *context)
+{
+    int fd;
+
+    fd = hg_poll_get_fd(NA_INPROC_PRIVATE_DATA(na_class)->poll_set);
+    if (fd == HG_UTIL_FAIL) {
+        NA_LOG_ERROR("Could not get poll fd from poll set");
+    }
+
+    return fd;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_inproc_poll_try_wait(na_class_t *na_class, na_context_t NA_UNUSED *context)
+{
+    struct na_inproc_endpoint *na_inproc_endpoint =
+        NA_INPROC_PRIVATE_DATA(na_class)->endpoint;
+
+    /* Senders only notify once this is set, pairs with fence in
+     * na_inproc_endpoint_push() */
+    hg_atomic_set32(&na_inproc_endpoint->waiting, 1);
+    hg_atomic_fence();
+
+    return hg_atomic_queue_is_empty(na_inproc_endpoint->msg_queue)
+        && !hg_atomic_get32(&na_inproc_endpoint->backfill_count);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_progress(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout)
+{
+    struct na_inproc_endpoint *na_inproc_endpoint =
+        NA_INPROC_PRIVATE_DATA(na_class)->endpoint;
+    na_bool_t progressed = NA_FALSE;
+    na_return_t ret = NA_TIMEOUT;
+
+    /* Messages are received without any syscall if there are some */
+    ret = na_inproc_progress_msgs(na_class, &progressed);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not make progress on messages");
+        goto done;
+    }
+    if (progressed || !timeout) {
+        hg_atomic_set32(&na_inproc_endpoint->waiting, 0);
+        ret = (progressed) ? NA_SUCCESS : NA_TIMEOUT;
+        goto done;
+    }
+
+    /* Block until notified */
+    if (hg_poll_wait(NA_INPROC_PRIVATE_DATA(na_class)->poll_set,
+        (na_inproc_poll_try_wait(na_class, context)) ? timeout : 0,
+        (hg_util_bool_t *) &progressed) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("hg_poll_wait() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    hg_atomic_set32(&na_inproc_endpoint->waiting, 0);
+
+    /* We progressed, return success */
+    ret = (progressed) ? NA_SUCCESS : NA_TIMEOUT;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
+    na_op_id_t op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = (struct na_inproc_op_id *) op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_inproc_op_id->completed))
+        goto done;
+
+    switch (na_inproc_op_id->completion_data.callback_info.type) {
+        case NA_CB_LOOKUP:
+            /* Nothing */
+            break;
+        case NA_CB_SEND_UNEXPECTED:
+            /* Nothing, target completes the operation */
+            break;
+        case NA_CB_RECV_UNEXPECTED: {
+            struct na_inproc_op_id *na_inproc_var_op_id = NULL;
+
+            /* Must remove op_id from unexpected op_id queue */
+            hg_thread_spin_lock(
+                &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+            HG_QUEUE_FOREACH(na_inproc_var_op_id,
+                &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue, entry) {
+                if (na_inproc_var_op_id == na_inproc_op_id) {
+                    HG_QUEUE_REMOVE(
+                        &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue,
+                        na_inproc_var_op_id, na_inproc_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_INPROC_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+
+            /* Cancel op id */
+            if (na_inproc_var_op_id == na_inproc_op_id) {
+                hg_atomic_set32(&na_inproc_op_id->canceled, NA_TRUE);
+                ret = na_inproc_complete(na_inproc_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+        }
+            break;
+        case NA_CB_SEND_EXPECTED:
+            /* Nothing, target completes the operation */
+            break;
+        case NA_CB_RECV_EXPECTED: {
+            struct na_inproc_op_id *na_inproc_var_op_id = NULL;
+
+            /* Must remove op_id from expected op_id queue */
+            hg_thread_spin_lock(
+                &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+            HG_QUEUE_FOREACH(na_inproc_var_op_id,
+                &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue, entry) {
+                if (na_inproc_var_op_id == na_inproc_op_id) {
+                    HG_QUEUE_REMOVE(
+                        &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue,
+                        na_inproc_var_op_id, na_inproc_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_INPROC_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+            /* Cancel op id */
+            if (na_inproc_var_op_id == na_inproc_op_id) {
+                hg_atomic_set32(&na_inproc_op_id->canceled, NA_TRUE);
+                ret = na_inproc_complete(na_inproc_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+        }
+            break;
+        case NA_CB_PUT:
+        case NA_CB_GET:
+            /* Nothing, data is copied right away */
+            break;
+        default:
+            NA_LOG_ERROR("Operation not supported");
+            ret = NA_INVALID_PARAM;
+            break;
+    }
+
+done:
+    return ret;
+}
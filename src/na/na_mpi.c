@@ -48,6 +48,9 @@ static int MPI_MAX_TAG = 32767;
 #define NA_MPI_RMA_TAG (NA_MPI_RMA_REQUEST_TAG + 1)
 #define NA_MPI_MAX_RMA_TAG (MPI_MAX_TAG >> 1)
 
+/* Initial number of request slots */
+#define NA_MPI_REQUEST_COUNT_INIT 64
+
 #define NA_MPI_PRIVATE_DATA(na_class) \
     ((struct na_mpi_private_data *)(na_class->private_data))
 
@@ -66,6 +69,7 @@ struct na_mpi_addr {
     MPI_Comm  comm;              /* Communicator */
     MPI_Comm  rma_comm;          /* Communicator used for one sided emulation */
     int       rank;              /* Rank in this communicator */
+    int       win_rank;          /* Rank in RMA window (resolved on first use) */
     na_bool_t unexpected;        /* Address generated from unexpected recv */
     na_bool_t self;              /* Boolean for self */
     na_bool_t dynamic;           /* Address generated using MPI DPM routines */
@@ -77,6 +81,7 @@ struct na_mpi_addr {
 struct na_mpi_mem_handle {
     na_ptr_t base;     /* Initial address of memory */
     MPI_Aint size;    /* Size of memory */
+    MPI_Aint disp;     /* Displacement of memory in RMA window */
     na_uint8_t attr;   /* Flag of operation access */
 };
 
@@ -132,6 +137,8 @@ struct na_mpi_info_put {
     MPI_Request data_request;
     struct na_mpi_rma_info *rma_info;
     na_bool_t internal_progress; /* Used for internal RMA emulation */
+    na_bool_t one_sided;         /* Issued through RMA window */
+    int win_rank;                /* Target rank in RMA window */
 };
 
 /* na_mpi_info_get */
@@ -140,6 +147,7 @@ struct na_mpi_info_get {
     MPI_Request data_request;
     struct na_mpi_rma_info *rma_info;
     na_bool_t internal_progress; /* Used for internal RMA emulation */
+    na_bool_t one_sided;         /* Issued through RMA window */
 };
 
 struct na_mpi_op_id {
@@ -149,6 +157,7 @@ struct na_mpi_op_id {
     void *arg;
     na_bool_t completed; /* Operation completed */
     na_bool_t canceled;  /* Operation canceled */
+    int request_count;   /* Number of requests not completed yet */
     union {
       struct na_mpi_info_lookup lookup;
       struct na_mpi_info_send_unexpected send_unexpected;
@@ -162,6 +171,12 @@ struct na_mpi_op_id {
     struct na_cb_completion_data completion_data;
 };
 
+/* Owner of an outstanding request */
+struct na_mpi_request_slot {
+    struct na_mpi_op_id *op_id; /* Operation ID */
+    MPI_Request *request;       /* Request field of operation ID */
+};
+
 struct na_mpi_private_data {
     na_bool_t listening;                    /* Used in server mode */
     na_bool_t mpi_ext_initialized;          /* MPI externally initialized */
@@ -169,6 +184,9 @@ struct na_mpi_private_data {
     char port_name[MPI_MAX_PORT_NAME];      /* Server local port name used for
                                                dynamic connection */
     MPI_Comm intra_comm;                    /* MPI intra-communicator */
+    MPI_Win win;                            /* Dynamic window exposing
+                                               registered memory (static
+                                               mode only) */
 
     hg_thread_t        accept_thread; /* Thread for accepting new connections */
     hg_thread_mutex_t  accept_mutex;  /* Mutex */
@@ -183,8 +201,13 @@ struct na_mpi_private_data {
 
     hg_atomic_int32_t  rma_tag;              /* Atomic RMA tag value */
 
-    HG_LIST_HEAD(na_mpi_op_id) op_id_list;  /* List of na_mpi_op_ids */
-    hg_thread_mutex_t  op_id_list_mutex;    /* Mutex */
+    MPI_Request *requests;                  /* Outstanding requests */
+    struct na_mpi_request_slot *request_slots; /* Owners of requests */
+    int *request_indices;                   /* MPI_Testsome() indices */
+    MPI_Status *request_statuses;           /* MPI_Testsome() statuses */
+    int request_count;                      /* Number of requests */
+    int request_max;                        /* Size of request arrays */
+    hg_thread_mutex_t  request_mutex;       /* Mutex */
 };
 
 /********************/
@@ -248,6 +271,20 @@ na_mpi_gen_rma_tag(
         na_class_t *na_class
         );
 
+/* request_add */
+static na_return_t
+na_mpi_request_add(
+        na_class_t          *na_class,
+        struct na_mpi_op_id *na_mpi_op_id
+        );
+
+/* addr_win_rank */
+static na_return_t
+na_mpi_addr_win_rank(
+        struct na_mpi_addr *na_mpi_addr,
+        int *win_rank
+        );
+
 /* verify */
 static na_bool_t
 na_mpi_check_protocol(
@@ -486,10 +523,12 @@ na_mpi_progress_unexpected(
 /* na_mpi_progress_unexpected_msg */
 static na_return_t
 na_mpi_progress_unexpected_msg(
-        na_class_t         *na_class,
-        na_context_t       *context,
-        struct na_mpi_addr *na_mpi_addr,
-        const MPI_Status   *status
+        na_class_t          *na_class,
+        na_context_t        *context,
+        struct na_mpi_addr  *na_mpi_addr,
+        struct na_mpi_op_id *na_mpi_op_id,
+        MPI_Message         *message,
+        const MPI_Status    *status
         );
 
 /* na_mpi_progress_unexpected_rma */
@@ -498,6 +537,7 @@ na_mpi_progress_unexpected_rma(
         na_class_t         *na_class,
         na_context_t       *context,
         struct na_mpi_addr *na_mpi_addr,
+        MPI_Message        *message,
         const MPI_Status   *status
         );
 
@@ -564,6 +604,8 @@ const na_class_t na_mpi_class_g = {
         NULL,                                 /* msg_init_expected */
         na_mpi_msg_send_expected,             /* msg_send_expected */
         na_mpi_msg_recv_expected,             /* msg_recv_expected */
+        NULL,                                 /* mem_alloc */
+        NULL,                                 /* mem_free */
         na_mpi_mem_handle_create,             /* mem_handle_create */
         NULL,                                 /* mem_handle_create_segment */
         na_mpi_mem_handle_free,               /* mem_handle_free */
@@ -746,6 +788,7 @@ na_mpi_accept(na_class_t *na_class)
     na_mpi_addr->comm = new_comm;
     na_mpi_addr->rma_comm = new_rma_comm;
     na_mpi_addr->rank = MPI_ANY_SOURCE;
+    na_mpi_addr->win_rank = MPI_UNDEFINED;
     na_mpi_addr->unexpected = NA_FALSE;
     na_mpi_addr->dynamic = (na_bool_t)
             (!NA_MPI_PRIVATE_DATA(na_class)->use_static_inter_comm);
@@ -872,6 +915,148 @@ na_mpi_gen_rma_tag(na_class_t *na_class)
     return tag;
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_mpi_request_add(na_class_t *na_class, struct na_mpi_op_id *na_mpi_op_id)
+{
+    struct na_mpi_private_data *priv = NA_MPI_PRIVATE_DATA(na_class);
+    MPI_Request *requests[2];
+    int i, count = 0;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_mpi_op_id->type) {
+        case NA_CB_SEND_UNEXPECTED:
+            requests[count++] = &na_mpi_op_id->info.send_unexpected.data_request;
+            break;
+        case NA_CB_SEND_EXPECTED:
+            requests[count++] = &na_mpi_op_id->info.send_expected.data_request;
+            break;
+        case NA_CB_RECV_EXPECTED:
+            requests[count++] = &na_mpi_op_id->info.recv_expected.data_request;
+            break;
+        case NA_CB_PUT:
+            if (na_mpi_op_id->info.put.rma_request != MPI_REQUEST_NULL)
+                requests[count++] = &na_mpi_op_id->info.put.rma_request;
+            requests[count++] = &na_mpi_op_id->info.put.data_request;
+            break;
+        case NA_CB_GET:
+            if (na_mpi_op_id->info.get.rma_request != MPI_REQUEST_NULL)
+                requests[count++] = &na_mpi_op_id->info.get.rma_request;
+            requests[count++] = &na_mpi_op_id->info.get.data_request;
+            break;
+        default:
+            NA_LOG_ERROR("Operation type does not use requests");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    hg_thread_mutex_lock(&priv->request_mutex);
+
+    /* Grow request arrays if needed */
+    if (priv->request_count + count > priv->request_max) {
+        int new_max = (priv->request_max) ? priv->request_max * 2
+            : NA_MPI_REQUEST_COUNT_INIT;
+        MPI_Request *new_requests;
+        struct na_mpi_request_slot *new_slots;
+        int *new_indices;
+        MPI_Status *new_statuses;
+
+        new_requests = (MPI_Request *) realloc(priv->requests,
+            (size_t) new_max * sizeof(MPI_Request));
+        if (new_requests)
+            priv->requests = new_requests;
+        new_slots = (struct na_mpi_request_slot *) realloc(priv->request_slots,
+            (size_t) new_max * sizeof(struct na_mpi_request_slot));
+        if (new_slots)
+            priv->request_slots = new_slots;
+        new_indices = (int *) realloc(priv->request_indices,
+            (size_t) new_max * sizeof(int));
+        if (new_indices)
+            priv->request_indices = new_indices;
+        new_statuses = (MPI_Status *) realloc(priv->request_statuses,
+            (size_t) new_max * sizeof(MPI_Status));
+        if (new_statuses)
+            priv->request_statuses = new_statuses;
+        if (!new_requests || !new_slots || !new_indices || !new_statuses) {
+            hg_thread_mutex_unlock(&priv->request_mutex);
+            NA_LOG_ERROR("Could not grow request arrays");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        priv->request_max = new_max;
+    }
+
+    /* All requests are added at once so that the op_id cannot complete
+     * before all of them have been posted */
+    na_mpi_op_id->request_count = count;
+    for (i = 0; i < count; i++) {
+        priv->requests[priv->request_count] = *requests[i];
+        priv->request_slots[priv->request_count].op_id = na_mpi_op_id;
+        priv->request_slots[priv->request_count].request = requests[i];
+        priv->request_count++;
+    }
+
+    hg_thread_mutex_unlock(&priv->request_mutex);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_mpi_addr_win_rank(struct na_mpi_addr *na_mpi_addr, int *win_rank)
+{
+    MPI_Group remote_group = MPI_GROUP_NULL, world_group = MPI_GROUP_NULL;
+    int is_inter = 0;
+    na_return_t ret = NA_SUCCESS;
+    int mpi_ret;
+
+    if (na_mpi_addr->win_rank != MPI_UNDEFINED)
+        goto done;
+
+    if (na_mpi_addr->self) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &na_mpi_addr->win_rank);
+        goto done;
+    }
+
+    /* Window is created on MPI_COMM_WORLD, translate rank from the group of
+     * the remote communicator */
+    MPI_Comm_test_inter(na_mpi_addr->comm, &is_inter);
+    if (is_inter)
+        mpi_ret = MPI_Comm_remote_group(na_mpi_addr->comm, &remote_group);
+    else
+        mpi_ret = MPI_Comm_group(na_mpi_addr->comm, &remote_group);
+    if (mpi_ret != MPI_SUCCESS) {
+        NA_LOG_ERROR("Could not get remote group");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    mpi_ret = MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+    if (mpi_ret != MPI_SUCCESS) {
+        NA_LOG_ERROR("Could not get world group");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    mpi_ret = MPI_Group_translate_ranks(remote_group, 1, &na_mpi_addr->rank,
+            world_group, &na_mpi_addr->win_rank);
+    if (mpi_ret != MPI_SUCCESS
+            || na_mpi_addr->win_rank == MPI_UNDEFINED) {
+        NA_LOG_ERROR("Could not translate rank");
+        na_mpi_addr->win_rank = MPI_UNDEFINED;
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    if (remote_group != MPI_GROUP_NULL)
+        MPI_Group_free(&remote_group);
+    if (world_group != MPI_GROUP_NULL)
+        MPI_Group_free(&world_group);
+    if (ret == NA_SUCCESS)
+        *win_rank = na_mpi_addr->win_rank;
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_return_t
 NA_MPI_Set_init_intra_comm(MPI_Comm intra_comm)
@@ -1012,8 +1197,14 @@ na_mpi_initialize(na_class_t *na_class, const struct na_info *na_info,
         goto done;
     }
     NA_MPI_PRIVATE_DATA(na_class)->accept_thread = 0;
+    NA_MPI_PRIVATE_DATA(na_class)->win = MPI_WIN_NULL;
     HG_LIST_INIT(&NA_MPI_PRIVATE_DATA(na_class)->remote_list);
-    HG_LIST_INIT(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list);
+    NA_MPI_PRIVATE_DATA(na_class)->requests = NULL;
+    NA_MPI_PRIVATE_DATA(na_class)->request_slots = NULL;
+    NA_MPI_PRIVATE_DATA(na_class)->request_indices = NULL;
+    NA_MPI_PRIVATE_DATA(na_class)->request_statuses = NULL;
+    NA_MPI_PRIVATE_DATA(na_class)->request_count = 0;
+    NA_MPI_PRIVATE_DATA(na_class)->request_max = 0;
     HG_QUEUE_INIT(&NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue);
 
     /* Check flags */
@@ -1100,13 +1291,34 @@ na_mpi_initialize(na_class_t *na_class, const struct na_info *na_info,
             ret = NA_PROTOCOL_ERROR;
             goto done;
         }
+
+        /* All processes of MPI_COMM_WORLD take part in the split, expose
+         * registered memory through a dynamic window so that put/get do not
+         * require any progress from the target */
+        mpi_ret = MPI_Win_create_dynamic(MPI_INFO_NULL, MPI_COMM_WORLD,
+                &NA_MPI_PRIVATE_DATA(na_class)->win);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("Could not create dynamic window");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        /* Passive target synchronization for the lifetime of the window */
+        mpi_ret = MPI_Win_lock_all(MPI_MODE_NOCHECK,
+                NA_MPI_PRIVATE_DATA(na_class)->win);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("Could not lock window");
+            MPI_Win_free(&NA_MPI_PRIVATE_DATA(na_class)->win);
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
     }
 
     /* Initialize mutex/cond */
     hg_thread_mutex_init(&NA_MPI_PRIVATE_DATA(na_class)->accept_mutex);
     hg_thread_cond_init(&NA_MPI_PRIVATE_DATA(na_class)->accept_cond);
     hg_thread_mutex_init(&NA_MPI_PRIVATE_DATA(na_class)->remote_list_mutex);
-    hg_thread_mutex_init(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    hg_thread_mutex_init(&NA_MPI_PRIVATE_DATA(na_class)->request_mutex);
     hg_thread_mutex_init(
             &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue_mutex);
 
@@ -1181,6 +1393,22 @@ na_mpi_finalize(na_class_t *na_class)
         ret = NA_PROTOCOL_ERROR;
     }
 
+    /* Free RMA window */
+    if (NA_MPI_PRIVATE_DATA(na_class)->win != MPI_WIN_NULL) {
+        mpi_ret = MPI_Win_unlock_all(NA_MPI_PRIVATE_DATA(na_class)->win);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("Could not unlock window");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        mpi_ret = MPI_Win_free(&NA_MPI_PRIVATE_DATA(na_class)->win);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("Could not free window");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    }
+
     /* Free the private dup'ed comm */
     mpi_ret = MPI_Comm_free(&NA_MPI_PRIVATE_DATA(na_class)->intra_comm);
     if (mpi_ret != MPI_SUCCESS) {
@@ -1211,10 +1439,14 @@ na_mpi_finalize(na_class_t *na_class)
     hg_thread_mutex_destroy(&NA_MPI_PRIVATE_DATA(na_class)->accept_mutex);
     hg_thread_cond_destroy(&NA_MPI_PRIVATE_DATA(na_class)->accept_cond);
     hg_thread_mutex_destroy(&NA_MPI_PRIVATE_DATA(na_class)->remote_list_mutex);
-    hg_thread_mutex_destroy(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    hg_thread_mutex_destroy(&NA_MPI_PRIVATE_DATA(na_class)->request_mutex);
     hg_thread_mutex_destroy(
             &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue_mutex);
 
+    free(NA_MPI_PRIVATE_DATA(na_class)->requests);
+    free(NA_MPI_PRIVATE_DATA(na_class)->request_slots);
+    free(NA_MPI_PRIVATE_DATA(na_class)->request_indices);
+    free(NA_MPI_PRIVATE_DATA(na_class)->request_statuses);
     free(na_class->private_data);
 
  done:
@@ -1232,7 +1464,8 @@ na_mpi_addr_lookup(na_class_t *na_class, na_context_t *context,
     int mpi_ret;
 
     /* Allocate op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1254,6 +1487,7 @@ na_mpi_addr_lookup(na_class_t *na_class, na_context_t *context,
     }
     na_mpi_addr->rank = 0;
     na_mpi_addr->comm = MPI_COMM_NULL;
+    na_mpi_addr->win_rank = MPI_UNDEFINED;
     na_mpi_addr->rma_comm = MPI_COMM_NULL;
     na_mpi_addr->unexpected = NA_FALSE;
     na_mpi_addr->self = NA_FALSE;
@@ -1334,7 +1568,7 @@ na_mpi_addr_lookup(na_class_t *na_class, na_context_t *context,
 done:
     if (ret != NA_SUCCESS) {
         free(na_mpi_addr);
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
     }
 
     return ret;
@@ -1357,6 +1591,7 @@ na_mpi_addr_self(na_class_t *na_class, na_addr_t *addr)
     na_mpi_addr->comm = MPI_COMM_NULL;
     na_mpi_addr->rma_comm = MPI_COMM_NULL;
     na_mpi_addr->rank = 0;
+    na_mpi_addr->win_rank = MPI_UNDEFINED;
     na_mpi_addr->unexpected = NA_FALSE;
     na_mpi_addr->self = NA_TRUE;
     na_mpi_addr->dynamic = NA_FALSE;
@@ -1494,7 +1729,8 @@ na_mpi_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
     int mpi_ret;
 
     /* Allocate op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1520,15 +1756,16 @@ na_mpi_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
         goto done;
     }
 
-    /* Append op_id to op_id list */
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-    HG_LIST_INSERT_HEAD(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list,
-        na_mpi_op_id, entry);
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    /* Track requests of op_id until completion */
+    ret = na_mpi_request_add(na_class, na_mpi_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add requests");
+        goto done;
+    }
 
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
     }
     return ret;
 }
@@ -1543,7 +1780,8 @@ na_mpi_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
     na_return_t ret = NA_SUCCESS;
 
     /* Allocate na_op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1584,7 +1822,7 @@ na_mpi_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
 
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
     }
     return ret;
 }
@@ -1604,7 +1842,8 @@ na_mpi_msg_send_expected(na_class_t *na_class, na_context_t *context,
     int mpi_ret;
 
     /* Allocate op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1630,15 +1869,16 @@ na_mpi_msg_send_expected(na_class_t *na_class, na_context_t *context,
         goto done;
     }
 
-    /* Append op_id to op_id list assign op_id */
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-    HG_LIST_INSERT_HEAD(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list,
-        na_mpi_op_id, entry);
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    /* Track requests of op_id until completion */
+    ret = na_mpi_request_add(na_class, na_mpi_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add requests");
+        goto done;
+    }
 
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
     }
     return ret;
 }
@@ -1658,7 +1898,8 @@ na_mpi_msg_recv_expected(na_class_t *na_class, na_context_t *context,
     int mpi_ret;
 
     /* Allocate op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1686,15 +1927,16 @@ na_mpi_msg_recv_expected(na_class_t *na_class, na_context_t *context,
         goto done;
     }
 
-    /* Append op_id to op_id list */
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-    HG_LIST_INSERT_HEAD(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list,
-        na_mpi_op_id, entry);
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    /* Track requests of op_id until completion */
+    ret = na_mpi_request_add(na_class, na_mpi_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add requests");
+        goto done;
+    }
 
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
     }
     return ret;
 }
@@ -1744,16 +1986,62 @@ na_mpi_mem_handle_free(na_class_t NA_UNUSED *na_class,
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_mpi_mem_register(na_class_t NA_UNUSED *na_class, na_mem_handle_t NA_UNUSED mem_handle)
+na_mpi_mem_register(na_class_t *na_class, na_mem_handle_t mem_handle)
 {
-    return NA_SUCCESS;
+    struct na_mpi_mem_handle *na_mpi_mem_handle =
+            (struct na_mpi_mem_handle *) mem_handle;
+    MPI_Win win = NA_MPI_PRIVATE_DATA(na_class)->win;
+    na_return_t ret = NA_SUCCESS;
+    int mpi_ret;
+
+    /* Nothing to expose without window */
+    if (win == MPI_WIN_NULL || !na_mpi_mem_handle->size)
+        goto done;
+
+    mpi_ret = MPI_Win_attach(win, (void *) na_mpi_mem_handle->base,
+            na_mpi_mem_handle->size);
+    if (mpi_ret != MPI_SUCCESS) {
+        NA_LOG_ERROR("MPI_Win_attach() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Dynamic windows are addressed with absolute displacements */
+    mpi_ret = MPI_Get_address((void *) na_mpi_mem_handle->base,
+            &na_mpi_mem_handle->disp);
+    if (mpi_ret != MPI_SUCCESS) {
+        NA_LOG_ERROR("MPI_Get_address() failed");
+        MPI_Win_detach(win, (void *) na_mpi_mem_handle->base);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_mpi_mem_deregister(na_class_t NA_UNUSED *na_class, na_mem_handle_t NA_UNUSED mem_handle)
+na_mpi_mem_deregister(na_class_t *na_class, na_mem_handle_t mem_handle)
 {
-    return NA_SUCCESS;
+    struct na_mpi_mem_handle *na_mpi_mem_handle =
+            (struct na_mpi_mem_handle *) mem_handle;
+    MPI_Win win = NA_MPI_PRIVATE_DATA(na_class)->win;
+    na_return_t ret = NA_SUCCESS;
+    int mpi_ret;
+
+    if (win == MPI_WIN_NULL || !na_mpi_mem_handle->size)
+        goto done;
+
+    mpi_ret = MPI_Win_detach(win, (void *) na_mpi_mem_handle->base);
+    if (mpi_ret != MPI_SUCCESS) {
+        NA_LOG_ERROR("MPI_Win_detach() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    return ret;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1833,6 +2121,7 @@ na_mpi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     struct na_mpi_addr *na_mpi_addr = (struct na_mpi_addr *) remote_addr;
     int mpi_length = (int) length; /* TODO careful here that we don't send more
                                     * than 2GB */
+    MPI_Win win = NA_MPI_PRIVATE_DATA(na_class)->win;
     struct na_mpi_op_id *na_mpi_op_id = NULL;
     struct na_mpi_rma_info *na_mpi_rma_info = NULL;
     na_return_t ret = NA_SUCCESS;
@@ -1853,7 +2142,8 @@ na_mpi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     }
 
     /* Allocate op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1869,54 +2159,85 @@ na_mpi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_mpi_op_id->info.put.data_request = MPI_REQUEST_NULL;
     na_mpi_op_id->info.put.internal_progress = NA_FALSE;
     na_mpi_op_id->info.put.rma_info = NULL;
+    na_mpi_op_id->info.put.one_sided = NA_FALSE;
 
-    /* Allocate rma info (use calloc to avoid uninitialized transfer) */
-    na_mpi_rma_info =
-            (struct na_mpi_rma_info *) calloc(1, sizeof(struct na_mpi_rma_info));
-    if (!na_mpi_rma_info) {
-        NA_LOG_ERROR("Could not allocate NA MPI RMA info");
-        ret = NA_NOMEM_ERROR;
-        goto done;
-    }
-    na_mpi_rma_info->op = NA_MPI_RMA_PUT;
-    na_mpi_rma_info->base = mpi_remote_mem_handle->base;
-    na_mpi_rma_info->disp = mpi_remote_offset;
-    na_mpi_rma_info->count = mpi_length;
-    na_mpi_rma_info->tag = na_mpi_gen_rma_tag(na_class);
-    na_mpi_op_id->info.put.rma_info = na_mpi_rma_info;
-
-    /* Assign op_id */
-    if (op_id && op_id != NA_OP_ID_IGNORE) *op_id = (na_op_id_t) na_mpi_op_id;
+    /* Directly access remote memory when it is exposed through window */
+    if (win != MPI_WIN_NULL) {
+        ret = na_mpi_addr_win_rank(na_mpi_addr,
+                &na_mpi_op_id->info.put.win_rank);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not resolve window rank");
+            goto done;
+        }
+        na_mpi_op_id->info.put.one_sided = NA_TRUE;
+
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE)
+            *op_id = (na_op_id_t) na_mpi_op_id;
+
+        /* Request only ensures local completion, remote completion is
+         * ensured by flushing the window when the request completes */
+        mpi_ret = MPI_Rput((char *) mpi_local_mem_handle->base
+                + mpi_local_offset, mpi_length, MPI_BYTE,
+                na_mpi_op_id->info.put.win_rank,
+                mpi_remote_mem_handle->disp + mpi_remote_offset, mpi_length,
+                MPI_BYTE, win, &na_mpi_op_id->info.put.data_request);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("MPI_Rput() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    } else {
+        /* Allocate rma info (use calloc to avoid uninitialized transfer) */
+        na_mpi_rma_info = (struct na_mpi_rma_info *) calloc(1,
+                sizeof(struct na_mpi_rma_info));
+        if (!na_mpi_rma_info) {
+            NA_LOG_ERROR("Could not allocate NA MPI RMA info");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        na_mpi_rma_info->op = NA_MPI_RMA_PUT;
+        na_mpi_rma_info->base = mpi_remote_mem_handle->base;
+        na_mpi_rma_info->disp = mpi_remote_offset;
+        na_mpi_rma_info->count = mpi_length;
+        na_mpi_rma_info->tag = na_mpi_gen_rma_tag(na_class);
+        na_mpi_op_id->info.put.rma_info = na_mpi_rma_info;
+
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE)
+            *op_id = (na_op_id_t) na_mpi_op_id;
+
+        /* Post the MPI send request */
+        mpi_ret = MPI_Isend(na_mpi_rma_info, sizeof(struct na_mpi_rma_info),
+                MPI_BYTE, na_mpi_addr->rank, NA_MPI_RMA_REQUEST_TAG,
+                na_mpi_addr->rma_comm, &na_mpi_op_id->info.put.rma_request);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("MPI_Isend() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
 
-    /* Post the MPI send request */
-    mpi_ret = MPI_Isend(na_mpi_rma_info, sizeof(struct na_mpi_rma_info),
-            MPI_BYTE, na_mpi_addr->rank, NA_MPI_RMA_REQUEST_TAG,
-            na_mpi_addr->rma_comm, &na_mpi_op_id->info.put.rma_request);
-    if (mpi_ret != MPI_SUCCESS) {
-        NA_LOG_ERROR("MPI_Isend() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+        /* Simply do a non blocking synchronous send */
+        mpi_ret = MPI_Issend((char*) mpi_local_mem_handle->base
+                + mpi_local_offset, mpi_length, MPI_BYTE, na_mpi_addr->rank,
+                (int) na_mpi_rma_info->tag, na_mpi_addr->rma_comm, &na_mpi_op_id->info.put.data_request);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("MPI_Issend() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
     }
 
-    /* Simply do a non blocking synchronous send */
-    mpi_ret = MPI_Issend((char*) mpi_local_mem_handle->base + mpi_local_offset,
-            mpi_length, MPI_BYTE, na_mpi_addr->rank, (int) na_mpi_rma_info->tag,
-            na_mpi_addr->rma_comm, &na_mpi_op_id->info.put.data_request);
-    if (mpi_ret != MPI_SUCCESS) {
-        NA_LOG_ERROR("MPI_Issend() failed");
-        ret = NA_PROTOCOL_ERROR;
+    /* Track requests of op_id until completion */
+    ret = na_mpi_request_add(na_class, na_mpi_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add requests");
         goto done;
     }
 
-    /* Append op_id to op_id list */
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-    HG_LIST_INSERT_HEAD(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list,
-        na_mpi_op_id, entry);
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
         free(na_mpi_rma_info);
     }
     return ret;
@@ -1938,6 +2259,7 @@ na_mpi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     struct na_mpi_addr *na_mpi_addr = (struct na_mpi_addr *) remote_addr;
     int mpi_length = (int) length; /* TODO careful here that we don't send more
                                     * than 2GB */
+    MPI_Win win = NA_MPI_PRIVATE_DATA(na_class)->win;
     struct na_mpi_op_id *na_mpi_op_id = NULL;
     struct na_mpi_rma_info *na_mpi_rma_info = NULL;
     na_return_t ret = NA_SUCCESS;
@@ -1958,7 +2280,8 @@ na_mpi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     }
 
     /* Allocate op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -1974,54 +2297,84 @@ na_mpi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_mpi_op_id->info.get.data_request = MPI_REQUEST_NULL;
     na_mpi_op_id->info.put.internal_progress = NA_FALSE;
     na_mpi_op_id->info.get.rma_info = NULL;
+    na_mpi_op_id->info.get.one_sided = NA_FALSE;
 
-    /* Allocate rma info (use calloc to avoid uninitialized transfer) */
-    na_mpi_rma_info =
-            (struct na_mpi_rma_info *) calloc(1, sizeof(struct na_mpi_rma_info));
-    if (!na_mpi_rma_info) {
-        NA_LOG_ERROR("Could not allocate NA MPI RMA info");
-        ret = NA_NOMEM_ERROR;
-        goto done;
-    }
-    na_mpi_rma_info->op = NA_MPI_RMA_GET;
-    na_mpi_rma_info->base = mpi_remote_mem_handle->base;
-    na_mpi_rma_info->disp = mpi_remote_offset;
-    na_mpi_rma_info->count = mpi_length;
-    na_mpi_rma_info->tag = na_mpi_gen_rma_tag(na_class);
-    na_mpi_op_id->info.get.rma_info = na_mpi_rma_info;
+    /* Directly access remote memory when it is exposed through window */
+    if (win != MPI_WIN_NULL) {
+        int win_rank;
 
-    /* Assign op_id */
-    if (op_id && op_id != NA_OP_ID_IGNORE) *op_id = (na_op_id_t) na_mpi_op_id;
+        ret = na_mpi_addr_win_rank(na_mpi_addr, &win_rank);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not resolve window rank");
+            goto done;
+        }
+        na_mpi_op_id->info.get.one_sided = NA_TRUE;
 
-    /* Post the MPI send request */
-    mpi_ret = MPI_Isend(na_mpi_rma_info, sizeof(struct na_mpi_rma_info),
-            MPI_BYTE, na_mpi_addr->rank, NA_MPI_RMA_REQUEST_TAG,
-            na_mpi_addr->rma_comm, &na_mpi_op_id->info.get.rma_request);
-    if (mpi_ret != MPI_SUCCESS) {
-        NA_LOG_ERROR("MPI_Isend() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE)
+            *op_id = (na_op_id_t) na_mpi_op_id;
+
+        /* Data is available locally once request completes */
+        mpi_ret = MPI_Rget((char *) mpi_local_mem_handle->base
+                + mpi_local_offset, mpi_length, MPI_BYTE, win_rank,
+                mpi_remote_mem_handle->disp + mpi_remote_offset, mpi_length,
+                MPI_BYTE, win, &na_mpi_op_id->info.get.data_request);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("MPI_Rget() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    } else {
+        /* Allocate rma info (use calloc to avoid uninitialized transfer) */
+        na_mpi_rma_info = (struct na_mpi_rma_info *) calloc(1,
+                sizeof(struct na_mpi_rma_info));
+        if (!na_mpi_rma_info) {
+            NA_LOG_ERROR("Could not allocate NA MPI RMA info");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        na_mpi_rma_info->op = NA_MPI_RMA_GET;
+        na_mpi_rma_info->base = mpi_remote_mem_handle->base;
+        na_mpi_rma_info->disp = mpi_remote_offset;
+        na_mpi_rma_info->count = mpi_length;
+        na_mpi_rma_info->tag = na_mpi_gen_rma_tag(na_class);
+        na_mpi_op_id->info.get.rma_info = na_mpi_rma_info;
+
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE)
+            *op_id = (na_op_id_t) na_mpi_op_id;
+
+        /* Post the MPI send request */
+        mpi_ret = MPI_Isend(na_mpi_rma_info, sizeof(struct na_mpi_rma_info),
+                MPI_BYTE, na_mpi_addr->rank, NA_MPI_RMA_REQUEST_TAG,
+                na_mpi_addr->rma_comm, &na_mpi_op_id->info.get.rma_request);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("MPI_Isend() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        /* Simply do an asynchronous recv */
+        mpi_ret = MPI_Irecv((char*) mpi_local_mem_handle->base
+                + mpi_local_offset, mpi_length, MPI_BYTE, na_mpi_addr->rank,
+                (int) na_mpi_rma_info->tag, na_mpi_addr->rma_comm, &na_mpi_op_id->info.get.data_request);
+        if (mpi_ret != MPI_SUCCESS) {
+            NA_LOG_ERROR("MPI_Irecv() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
     }
 
-    /* Simply do an asynchronous recv */
-    mpi_ret = MPI_Irecv((char*) mpi_local_mem_handle->base + mpi_local_offset,
-            mpi_length, MPI_BYTE, na_mpi_addr->rank, (int) na_mpi_rma_info->tag,
-            na_mpi_addr->rma_comm, &na_mpi_op_id->info.get.data_request);
-    if (mpi_ret != MPI_SUCCESS) {
-        NA_LOG_ERROR("MPI_Irecv() failed");
-        ret = NA_PROTOCOL_ERROR;
+    /* Track requests of op_id until completion */
+    ret = na_mpi_request_add(na_class, na_mpi_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add requests");
         goto done;
     }
 
-    /* Append op_id to op_id list */
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-    HG_LIST_INSERT_HEAD(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list,
-        na_mpi_op_id, entry);
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
         free(na_mpi_rma_info);
     }
     return ret;
@@ -2085,42 +2438,59 @@ na_mpi_progress_unexpected(na_class_t *na_class, na_context_t *context,
     hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->remote_list_mutex);
 
     HG_LIST_FOREACH(probe_addr, &NA_MPI_PRIVATE_DATA(na_class)->remote_list, entry) {
-        MPI_Status status1, status2;
+        struct na_mpi_op_id *na_mpi_op_id = NULL;
+        MPI_Message message;
+        MPI_Status status;
         int flag = 0;
 
-        /* First look for user unexpected message */
-        mpi_ret = MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, probe_addr->comm,
-            &flag, &status1);
-        if (mpi_ret != MPI_SUCCESS) {
-            NA_LOG_ERROR("MPI_Iprobe() failed");
-            ret = NA_PROTOCOL_ERROR;
-            goto done;
+        /* First look for user unexpected message, only match it when an
+         * unexpected recv has been posted so that it otherwise remains
+         * queued in MPI */
+        hg_thread_mutex_lock(
+                &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue_mutex);
+        if (!HG_QUEUE_IS_EMPTY(
+                &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue)) {
+            mpi_ret = MPI_Improbe(MPI_ANY_SOURCE, MPI_ANY_TAG,
+                probe_addr->comm, &flag, &message, &status);
+            if (mpi_ret != MPI_SUCCESS) {
+                hg_thread_mutex_unlock(
+                    &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue_mutex);
+                NA_LOG_ERROR("MPI_Improbe() failed");
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+            }
+            if (flag) {
+                na_mpi_op_id = HG_QUEUE_FIRST(
+                    &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue);
+                HG_QUEUE_POP_HEAD(
+                    &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue, entry);
+            }
         }
+        hg_thread_mutex_unlock(
+                &NA_MPI_PRIVATE_DATA(na_class)->unexpected_op_queue_mutex);
 
-        if (flag) {
+        if (na_mpi_op_id) {
             ret = na_mpi_progress_unexpected_msg(na_class, context,
-                probe_addr, &status1);
+                probe_addr, na_mpi_op_id, &message, &status);
             if (ret != NA_SUCCESS) {
-                if (ret != NA_TIMEOUT) {
-                    NA_LOG_ERROR("Could not make unexpected MSG progress");
-                    goto done;
-                }
+                NA_LOG_ERROR("Could not make unexpected MSG progress");
+                goto done;
             } else
                 break; /* Progressed */
         }
 
         /* Look for internal unexpected RMA requests */
-        mpi_ret = MPI_Iprobe(probe_addr->rank, NA_MPI_RMA_REQUEST_TAG,
-            probe_addr->rma_comm, &flag, &status2);
+        mpi_ret = MPI_Improbe(probe_addr->rank, NA_MPI_RMA_REQUEST_TAG,
+            probe_addr->rma_comm, &flag, &message, &status);
         if (mpi_ret != MPI_SUCCESS) {
-            NA_LOG_ERROR("MPI_Iprobe() failed");
+            NA_LOG_ERROR("MPI_Improbe() failed");
             ret = NA_PROTOCOL_ERROR;
             goto done;
         }
 
         if (flag) {
             ret = na_mpi_progress_unexpected_rma(na_class, context,
-                probe_addr, &status2);
+                probe_addr, &message, &status);
             if (ret != NA_SUCCESS) {
                 NA_LOG_ERROR("Could not make unexpected RMA progress");
                 goto done;
@@ -2129,43 +2499,39 @@ na_mpi_progress_unexpected(na_class_t *na_class, na_context_t *context,
         }
     }
 
+done:
     hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->remote_list_mutex);
 
-done:
     return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_mpi_progress_unexpected_msg(na_class_t *na_class, na_context_t NA_UNUSED *context,
-        struct na_mpi_addr *na_mpi_addr, const MPI_Status *status)
+na_mpi_progress_unexpected_msg(na_class_t *na_class,
+        na_context_t NA_UNUSED *context, struct na_mpi_addr *na_mpi_addr,
+        struct na_mpi_op_id *na_mpi_op_id, MPI_Message *message,
+        const MPI_Status *status)
 {
-    struct na_mpi_op_id *na_mpi_op_id = NULL;
     int unexpected_buf_size = 0;
-    na_return_t ret = NA_TIMEOUT;
+    na_return_t ret = NA_SUCCESS;
     int mpi_ret;
 
     MPI_Get_count(status, MPI_BYTE, &unexpected_buf_size);
     if (unexpected_buf_size > (int)
             na_mpi_msg_get_max_unexpected_size(na_class)) {
         NA_LOG_ERROR("Exceeding unexpected MSG size");
+        /* Give back op id, message cannot be received */
+        na_mpi_msg_unexpected_op_push(na_class, na_mpi_op_id);
         ret = NA_SIZE_ERROR;
         goto done;
     }
 
-    /* Try to pop an unexpected recv op id */
-    na_mpi_op_id = na_mpi_msg_unexpected_op_pop(na_class);
-    if (!na_mpi_op_id) {
-        /* Can't process it since nobody has posted an unexpected recv yet */
-        goto done;
-    }
-
-    mpi_ret = MPI_Recv(na_mpi_op_id->info.recv_unexpected.buf,
-            na_mpi_op_id->info.recv_unexpected.buf_size, MPI_BYTE,
-            status->MPI_SOURCE, status->MPI_TAG, na_mpi_addr->comm,
+    /* Message is already matched, receive it */
+    mpi_ret = MPI_Mrecv(na_mpi_op_id->info.recv_unexpected.buf,
+            na_mpi_op_id->info.recv_unexpected.buf_size, MPI_BYTE, message,
             MPI_STATUS_IGNORE);
     if (mpi_ret != MPI_SUCCESS) {
-        NA_LOG_ERROR("MPI_Recv() failed");
+        NA_LOG_ERROR("MPI_Mrecv() failed");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
@@ -2186,7 +2552,8 @@ done:
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_mpi_progress_unexpected_rma(na_class_t *na_class, na_context_t *context,
-        struct na_mpi_addr *na_mpi_addr, const MPI_Status *status)
+        struct na_mpi_addr *na_mpi_addr, MPI_Message *message,
+        const MPI_Status *status)
 {
     struct na_mpi_rma_info *na_mpi_rma_info = NULL;
     struct na_mpi_op_id *na_mpi_op_id = NULL;
@@ -2210,18 +2577,18 @@ na_mpi_progress_unexpected_rma(na_class_t *na_class, na_context_t *context,
         goto done;
     }
 
-    /* Recv message (already arrived) */
-    mpi_ret = MPI_Recv(na_mpi_rma_info, sizeof(struct na_mpi_rma_info),
-            MPI_BYTE, status->MPI_SOURCE, status->MPI_TAG,
-            na_mpi_addr->rma_comm, MPI_STATUS_IGNORE);
+    /* Recv message (already matched) */
+    mpi_ret = MPI_Mrecv(na_mpi_rma_info, sizeof(struct na_mpi_rma_info),
+            MPI_BYTE, message, MPI_STATUS_IGNORE);
     if (mpi_ret != MPI_SUCCESS) {
-        NA_LOG_ERROR("MPI_Recv() failed");
+        NA_LOG_ERROR("MPI_Mrecv() failed");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
 
     /* Allocate na_op_id */
-    na_mpi_op_id = (struct na_mpi_op_id *) malloc(sizeof(struct na_mpi_op_id));
+    na_mpi_op_id = (struct na_mpi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_mpi_op_id));
     if (!na_mpi_op_id) {
         NA_LOG_ERROR("Could not allocate NA MPI operation ID");
         ret = NA_NOMEM_ERROR;
@@ -2241,6 +2608,7 @@ na_mpi_progress_unexpected_rma(na_class_t *na_class, na_context_t *context,
             na_mpi_op_id->info.put.rma_request = MPI_REQUEST_NULL;
             na_mpi_op_id->info.put.data_request = MPI_REQUEST_NULL;
             na_mpi_op_id->info.put.internal_progress = NA_TRUE;
+            na_mpi_op_id->info.put.one_sided = NA_FALSE;
             na_mpi_op_id->info.put.rma_info = na_mpi_rma_info;
 
             mpi_ret = MPI_Irecv(
@@ -2261,6 +2629,7 @@ na_mpi_progress_unexpected_rma(na_class_t *na_class, na_context_t *context,
             na_mpi_op_id->info.get.rma_request = MPI_REQUEST_NULL;
             na_mpi_op_id->info.get.data_request = MPI_REQUEST_NULL;
             na_mpi_op_id->info.get.internal_progress = NA_TRUE;
+            na_mpi_op_id->info.get.one_sided = NA_FALSE;
             na_mpi_op_id->info.get.rma_info = na_mpi_rma_info;
 
             mpi_ret = MPI_Isend(
@@ -2280,15 +2649,16 @@ na_mpi_progress_unexpected_rma(na_class_t *na_class, na_context_t *context,
             break;
     }
 
-    /* Add op_id to list */
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
-    HG_LIST_INSERT_HEAD(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list,
-        na_mpi_op_id, entry);
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    /* Track requests of op_id until completion */
+    ret = na_mpi_request_add(na_class, na_mpi_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add requests");
+        goto done;
+    }
 
 done:
     if (ret != NA_SUCCESS) {
-        free(na_mpi_op_id);
+        na_op_id_free(na_mpi_op_id);
         free(na_mpi_rma_info);
     }
     return ret;
@@ -2299,19 +2669,34 @@ static na_return_t
 na_mpi_progress_expected(na_class_t *na_class, na_context_t NA_UNUSED *context,
         unsigned int NA_UNUSED timeout)
 {
-    struct na_mpi_op_id *na_mpi_op_id = NULL;
+    struct na_mpi_private_data *priv = NA_MPI_PRIVATE_DATA(na_class);
+    int i, j, completed_count = 0;
     na_return_t ret = NA_TIMEOUT;
+    int mpi_ret;
+
+    hg_thread_mutex_lock(&priv->request_mutex);
 
-    hg_thread_mutex_lock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    if (!priv->request_count)
+        goto done;
 
-    na_mpi_op_id = HG_LIST_FIRST(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list);
-    while (na_mpi_op_id) {
-        MPI_Request *request = NULL;
-        na_bool_t internal = NA_FALSE; /* Only used to complete internal ops */
-        struct na_mpi_rma_info **rma_info = NULL;
-        na_bool_t complete_op_id = NA_TRUE;
-        int flag = 0, mpi_ret = 0;
-        MPI_Status *status = MPI_STATUS_IGNORE;
+    /* Test all outstanding requests at once */
+    mpi_ret = MPI_Testsome(priv->request_count, priv->requests,
+            &completed_count, priv->request_indices, priv->request_statuses);
+    if (mpi_ret != MPI_SUCCESS) {
+        NA_LOG_ERROR("MPI_Testsome() failed");
+        completed_count = 0;
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    if (completed_count == MPI_UNDEFINED || !completed_count) {
+        completed_count = 0;
+        goto done;
+    }
+
+    for (i = 0; i < completed_count; i++) {
+        struct na_mpi_request_slot *slot =
+            &priv->request_slots[priv->request_indices[i]];
+        struct na_mpi_op_id *na_mpi_op_id = slot->op_id;
 
         /* If the op_id is marked as completed, something is wrong */
         if (na_mpi_op_id->completed) {
@@ -2320,107 +2705,63 @@ na_mpi_progress_expected(na_class_t *na_class, na_context_t NA_UNUSED *context,
             goto done;
         }
 
-        switch (na_mpi_op_id->type) {
-            case NA_CB_LOOKUP:
-                NA_LOG_ERROR("Should not complete lookup here");
-                break;
-            case NA_CB_RECV_UNEXPECTED:
-                NA_LOG_ERROR("Should not complete unexpected recv here");
-                break;
-            case NA_CB_SEND_UNEXPECTED:
-                request = &na_mpi_op_id->info.send_unexpected.data_request;
-                break;
-            case NA_CB_RECV_EXPECTED:
-                status = &na_mpi_op_id->info.recv_expected.status;
-                request = &na_mpi_op_id->info.recv_expected.data_request;
-                break;
-            case NA_CB_SEND_EXPECTED:
-                request = &na_mpi_op_id->info.send_expected.data_request;
-                break;
-            case NA_CB_PUT:
-                if (na_mpi_op_id->info.put.internal_progress) {
-                    request = &na_mpi_op_id->info.put.data_request;
-                    rma_info = &na_mpi_op_id->info.put.rma_info;
-                    internal = NA_TRUE;
-                } else {
-                    request = &na_mpi_op_id->info.put.rma_request;
-                    if (*request != MPI_REQUEST_NULL) {
-                        complete_op_id = NA_FALSE;
-                    } else {
-                        request = &na_mpi_op_id->info.put.data_request;
-                    }
-                }
-                break;
-            case NA_CB_GET:
-                if (na_mpi_op_id->info.get.internal_progress) {
-                    request = &na_mpi_op_id->info.get.data_request;
-                    rma_info = &na_mpi_op_id->info.get.rma_info;
-                    internal = NA_TRUE;
-                } else {
-                    request = &na_mpi_op_id->info.get.rma_request;
-                    if (*request != MPI_REQUEST_NULL) {
-                        complete_op_id = NA_FALSE;
-                    } else {
-                        request = &na_mpi_op_id->info.get.data_request;
-                    }
-                }
-                break;
-            default:
-                NA_LOG_ERROR("Unknown type of operation ID");
-                ret = NA_PROTOCOL_ERROR;
-                goto done;
-        }
-
-        /* If request is MPI_REQUEST_NULL, the operation should be completed */
-        if (!request || (request && (*request == MPI_REQUEST_NULL))) {
-            NA_LOG_ERROR("NULL request found");
-            ret = NA_PROTOCOL_ERROR;
-            goto done;
-        }
+        *slot->request = MPI_REQUEST_NULL;
+        if (na_mpi_op_id->type == NA_CB_RECV_EXPECTED)
+            memcpy(&na_mpi_op_id->info.recv_expected.status,
+                &priv->request_statuses[i], sizeof(MPI_Status));
 
-        mpi_ret = MPI_Test(request, &flag, status);
-        if (mpi_ret != MPI_SUCCESS) {
-            NA_LOG_ERROR("MPI_Test() failed");
-            ret = NA_PROTOCOL_ERROR;
-            goto done;
-        }
-        if (!flag) {
-            na_mpi_op_id = HG_LIST_NEXT(na_mpi_op_id, entry);
+        /* Operation completes with its last request */
+        if (--na_mpi_op_id->request_count)
             continue;
-        }
 
-        *request = MPI_REQUEST_NULL;
+        /* Request of one-sided put only guarantees local completion */
+        if (na_mpi_op_id->type == NA_CB_PUT
+                && na_mpi_op_id->info.put.one_sided) {
+            mpi_ret = MPI_Win_flush(na_mpi_op_id->info.put.win_rank,
+                    priv->win);
+            if (mpi_ret != MPI_SUCCESS) {
+                NA_LOG_ERROR("MPI_Win_flush() failed");
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+            }
+        }
 
         /* If internal operation call release directly otherwise add callback
          * to completion queue */
-        if (internal) {
+        if ((na_mpi_op_id->type == NA_CB_PUT
+                && na_mpi_op_id->info.put.internal_progress)
+            || (na_mpi_op_id->type == NA_CB_GET
+                && na_mpi_op_id->info.get.internal_progress)) {
             na_mpi_op_id->completed = NA_TRUE;
-            /* Remove entry from list */
-            HG_LIST_REMOVE(na_mpi_op_id, entry);
-
-            free(*rma_info);
-            *rma_info = NULL;
+            if (na_mpi_op_id->type == NA_CB_PUT)
+                free(na_mpi_op_id->info.put.rma_info);
+            else
+                free(na_mpi_op_id->info.get.rma_info);
             na_mpi_release(na_mpi_op_id);
         } else {
-            if (!complete_op_id) {
-                na_mpi_op_id = HG_LIST_NEXT(na_mpi_op_id, entry);
-                continue;
-            }
-            /* Remove entry from list */
-            HG_LIST_REMOVE(na_mpi_op_id, entry);
-
             ret = na_mpi_complete(na_mpi_op_id);
             if (ret != NA_SUCCESS) {
                 NA_LOG_ERROR("Could not complete operation");
                 goto done;
             }
         }
-        ret = NA_SUCCESS; /* progressed */
-        break;
     }
+    ret = NA_SUCCESS; /* progressed */
 
 done:
-    hg_thread_mutex_unlock(&NA_MPI_PRIVATE_DATA(na_class)->op_id_list_mutex);
+    /* Remove completed requests, MPI_Testsome() has set them to
+     * MPI_REQUEST_NULL */
+    if (completed_count) {
+        for (i = 0, j = 0; i < priv->request_count; i++) {
+            if (priv->requests[i] == MPI_REQUEST_NULL)
+                continue;
+            priv->requests[j] = priv->requests[i];
+            priv->request_slots[j] = priv->request_slots[i];
+            j++;
+        }
+        priv->request_count = j;
+    }
+    hg_thread_mutex_unlock(&priv->request_mutex);
     return ret;
 }
 
@@ -2484,6 +2825,7 @@ na_mpi_complete(struct na_mpi_op_id *na_mpi_op_id)
             na_mpi_addr->comm = na_mpi_remote_addr->comm;
             na_mpi_addr->rma_comm = na_mpi_remote_addr->rma_comm;
             na_mpi_addr->rank = status->MPI_SOURCE;
+            na_mpi_addr->win_rank = MPI_UNDEFINED;
             na_mpi_addr->unexpected = NA_TRUE;
             na_mpi_addr->self = NA_FALSE;
             na_mpi_addr->dynamic = NA_TRUE;
@@ -2559,7 +2901,7 @@ na_mpi_release(void *arg)
     if (na_mpi_op_id && !na_mpi_op_id->completed) {
         NA_LOG_ERROR("Releasing resources from an uncompleted operation");
     }
-    free(na_mpi_op_id);
+    na_op_id_free(na_mpi_op_id);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -558,6 +558,10 @@ na_ofi_initialize(na_class_t *na_class, const struct na_info *na_info,
 static na_return_t
 na_ofi_finalize(na_class_t *na_class);
 
+/* Allocate operation ID, from context pool if context is not NULL */
+static struct na_ofi_op_id *
+na_ofi_op_alloc(na_context_t *context);
+
 /* op_create */
 static na_op_id_t
 na_ofi_op_create(na_class_t *na_class);
@@ -744,6 +748,8 @@ const na_class_t na_ofi_class_g = {
     NULL,                                   /* msg_init_expected */
     na_ofi_msg_send_expected,               /* msg_send_expected */
     na_ofi_msg_recv_expected,               /* msg_recv_expected */
+    NULL,                                   /* mem_alloc */
+    NULL,                                   /* mem_free */
     na_ofi_mem_handle_create,               /* mem_handle_create */
     NULL,                                   /* mem_handle_create_segment */
     na_ofi_mem_handle_free,                 /* mem_handle_free */
@@ -1828,7 +1834,7 @@ na_ofi_op_id_decref(struct na_ofi_op_id *na_ofi_op_id)
     /* No more references, cleanup */
     na_ofi_op_id->noo_magic_1 = 0;
     na_ofi_op_id->noo_magic_2 = 0;
-    free(na_ofi_op_id);
+    na_op_id_free(na_ofi_op_id);
 
     return;
 }
@@ -1850,16 +1856,18 @@ na_ofi_op_id_valid(struct na_ofi_op_id *na_ofi_op_id)
 }
 
 /*---------------------------------------------------------------------------*/
-static na_op_id_t
-na_ofi_op_create(na_class_t NA_UNUSED *na_class)
+static struct na_ofi_op_id *
+na_ofi_op_alloc(na_context_t *context)
 {
     struct na_ofi_op_id *na_ofi_op_id = NULL;
 
-    na_ofi_op_id = (struct na_ofi_op_id *)calloc(1, sizeof(struct na_ofi_op_id));
+    na_ofi_op_id = (struct na_ofi_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_ofi_op_id));
     if (!na_ofi_op_id) {
         NA_LOG_ERROR("Could not allocate NA OFI operation ID");
         goto done;
     }
+    memset(na_ofi_op_id, 0, sizeof(struct na_ofi_op_id));
     hg_atomic_set32(&na_ofi_op_id->noo_refcount, 1);
     /* Completed by default */
     hg_atomic_set32(&na_ofi_op_id->noo_completed, 1);
@@ -1868,7 +1876,14 @@ na_ofi_op_create(na_class_t NA_UNUSED *na_class)
     na_ofi_op_id->noo_magic_2 = NA_OFI_OP_ID_MAGIC_2;
 
 done:
-    return (na_op_id_t) na_ofi_op_id;
+    return na_ofi_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_ofi_op_create(na_class_t NA_UNUSED *na_class)
+{
+    return (na_op_id_t) na_ofi_op_alloc(NULL);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2005,7 +2020,7 @@ na_ofi_addr_lookup(na_class_t *na_class, na_context_t *context,
         na_ofi_op_id = (struct na_ofi_op_id *) *op_id;
         na_ofi_op_id_addref(na_ofi_op_id);
     } else {
-        na_ofi_op_id = (struct na_ofi_op_id *)na_ofi_op_create(na_class);
+        na_ofi_op_id = na_ofi_op_alloc(context);
         if (!na_ofi_op_id) {
             NA_LOG_ERROR("Could not create NA OFI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -2067,7 +2082,7 @@ na_ofi_addr_lookup(na_class_t *na_class, na_context_t *context,
 out:
     if (ret != NA_SUCCESS) {
         free(na_ofi_addr);
-        free(na_ofi_op_id);
+        na_op_id_free(na_ofi_op_id);
     }
 
     return ret;
@@ -2414,7 +2429,7 @@ na_ofi_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
         na_ofi_op_id = (struct na_ofi_op_id *) *op_id;
         na_ofi_op_id_addref(na_ofi_op_id);
     } else {
-        na_ofi_op_id = (struct na_ofi_op_id *)na_ofi_op_create(na_class);
+        na_ofi_op_id = na_ofi_op_alloc(context);
         if (!na_ofi_op_id) {
             NA_LOG_ERROR("Could not create NA OFI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -2479,7 +2494,7 @@ na_ofi_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
         na_ofi_op_id = (struct na_ofi_op_id *) *op_id;
         na_ofi_op_id_addref(na_ofi_op_id);
     } else {
-        na_ofi_op_id = (struct na_ofi_op_id *)na_ofi_op_create(na_class);
+        na_ofi_op_id = na_ofi_op_alloc(context);
         if (!na_ofi_op_id) {
             NA_LOG_ERROR("Could not create NA OFI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -2549,7 +2564,7 @@ na_ofi_msg_send_expected(na_class_t *na_class, na_context_t *context,
         na_ofi_op_id = (struct na_ofi_op_id *) *op_id;
         na_ofi_op_id_addref(na_ofi_op_id);
     } else {
-        na_ofi_op_id = (struct na_ofi_op_id *)na_ofi_op_create(na_class);
+        na_ofi_op_id = na_ofi_op_alloc(context);
         if (!na_ofi_op_id) {
             NA_LOG_ERROR("Could not create NA OFI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -2618,7 +2633,7 @@ na_ofi_msg_recv_expected(na_class_t *na_class, na_context_t *context,
         na_ofi_op_id = (struct na_ofi_op_id *) *op_id;
         na_ofi_op_id_addref(na_ofi_op_id);
     } else {
-        na_ofi_op_id = (struct na_ofi_op_id *)na_ofi_op_create(na_class);
+        na_ofi_op_id = na_ofi_op_alloc(context);
         if (!na_ofi_op_id) {
             NA_LOG_ERROR("Could not create NA OFI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -2981,7 +2996,7 @@ na_ofi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         na_ofi_op_id = (struct na_ofi_op_id *) *op_id;
         na_ofi_op_id_addref(na_ofi_op_id);
     } else {
-        na_ofi_op_id = (struct na_ofi_op_id *) na_ofi_op_create(na_class);
+        na_ofi_op_id = na_ofi_op_alloc(context);
         if (!na_ofi_op_id) {
             NA_LOG_ERROR("Could not create NA OFI operation ID");
             ret = NA_NOMEM_ERROR;
@@ -23,6 +23,7 @@ struct na_info {
     char *class_name;    /* Class name (e.g., bmi) */
     char *protocol_name; /* Protocol (e.g., tcp, ib) */
     char *host_name;     /* Host (may be NULL in anonymous mode) */
+    struct na_init_info na_init_info; /* Init options */
 };
 
 /* Private callback type for NA plugins */
@@ -224,6 +225,18 @@ struct na_class {
             na_tag_t      tag,
             na_op_id_t   *op_id
             );
+    void *
+    (*mem_alloc)(
+            na_class_t *na_class,
+            na_size_t buf_size,
+            void **plugin_data
+            );
+    na_return_t
+    (*mem_free)(
+            na_class_t *na_class,
+            void *buf,
+            void *plugin_data
+            );
     na_return_t
     (*mem_handle_create)(
             na_class_t      *na_class,
@@ -373,6 +386,34 @@ na_cb_completion_add(
         struct na_cb_completion_data *na_cb_completion_data
         );
 
+/**
+ * Allocate an operation ID of op_size bytes. If context is not NULL, op IDs
+ * released with na_op_id_free() are kept in a pool attached to context and
+ * reused by later allocations of the same size. Op IDs may be released after
+ * context is destroyed, they are then freed instead. Memory is not zeroed.
+ *
+ * \param context [IN/OUT]              pointer to context of execution
+ *                                      or NULL
+ * \param op_size [IN]                  size of plugin operation ID
+ *
+ * \return Pointer to operation ID or NULL on failure
+ */
+NA_EXPORT void *
+na_op_id_alloc(
+        na_context_t *context,
+        na_size_t     op_size
+        );
+
+/**
+ * Release an operation ID allocated with na_op_id_alloc().
+ *
+ * \param op_id [IN/OUT]                pointer to operation ID
+ */
+NA_EXPORT void
+na_op_id_free(
+        void *op_id
+        );
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,6 +15,7 @@
 #include "na_error.h"
 
 #include "mercury_queue.h"
+#include "mercury_list.h"
 #include "mercury_thread_mutex.h"
 #include "mercury_thread_spin.h"
 #include "mercury_time.h"
@@ -28,12 +29,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #ifdef _WIN32
 #include <process.h>
 #else
 #include <ftw.h>
 #include <unistd.h>
+#include <signal.h>
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -59,10 +64,21 @@
 #define NA_SM_RING_BUF_SIZE \
     (sizeof(struct na_sm_ring_buf) + NA_SM_NUM_BUFS * HG_ATOMIC_QUEUE_ELT_SIZE)
 #define NA_SM_COPY_BUF_SIZE     4096
+#define NA_SM_MAX_PEERS         1024 /* Connections per listener */
 #define NA_SM_CLEANUP_NFDS      16
-
-#define NA_SM_LISTEN_BACKLOG    64
-#define NA_SM_ACCEPT_INTERVAL   100 /* 100 ms */
+#define NA_SM_IOV_STATIC_MAX    8 /* Translated iovecs kept on the stack */
+#define NA_SM_NT_COPY_THRESHOLD (1 << 20) /* Non-temporal stores above 1MB */
+#define NA_SM_UNEXPECTED_POOL_SIZE 256 /* Default unexpected info pool size */
+#define NA_SM_CONN_TIMEOUT      1000 /* Time to send connection info (ms) */
+
+/* Node-local registry of listening classes */
+#define NA_SM_REGISTRY_SIZE     1024 /* Must be a power of 2 */
+#define NA_SM_REGISTRY_PREFIX   NA_SM_SHM_PREFIX "-registry"
+#define NA_SM_REGISTRY_RETRY    1000 /* Attempts to attach to registry */
+#define NA_SM_REGISTRY_FREE     0 /* Never used, terminates probing */
+#define NA_SM_REGISTRY_BUSY     1 /* Being filled by listener */
+#define NA_SM_REGISTRY_READY    2 /* Published */
+#define NA_SM_REGISTRY_RELEASED 3 /* Removed, can be reused */
 
 /* Msg sizes */
 #define NA_SM_UNEXPECTED_SIZE   4096
@@ -100,10 +116,19 @@
 
 #define NA_SM_SEND_NAME "s" /* used for pair_name */
 #define NA_SM_RECV_NAME "r" /* used for pair_name */
-#define NA_SM_GEN_RING_NAME(filename, pair_name, na_sm_addr)            \
+#define NA_SM_GEN_REGISTRY_NAME(filename)                               \
+    do {                                                                \
+        sprintf(filename, "%s-%u", NA_SM_REGISTRY_PREFIX,               \
+            (unsigned int) getuid());                                   \
+    } while (0)
+
+#define NA_SM_REGISTRY_HASH(pid, id)                                    \
+    (((unsigned int) (pid) * 31 + (id)) & (NA_SM_REGISTRY_SIZE - 1))
+
+#define NA_SM_GEN_MEM_NAME(filename, na_sm_addr, seg_id)                \
     do {                                                                \
-        sprintf(filename, "%s-%d-%u-%u-" pair_name, NA_SM_SHM_PREFIX,   \
-            na_sm_addr->pid, na_sm_addr->id, na_sm_addr->conn_id);      \
+        sprintf(filename, "%s-%d-%u-m%u", NA_SM_SHM_PREFIX,             \
+            na_sm_addr->pid, na_sm_addr->id, seg_id);                   \
     } while (0)
 
 #ifndef HG_UTIL_HAS_SYSEVENTFD_H
@@ -144,9 +169,10 @@ typedef union {
 struct na_sm_ring_buf {
     na_sm_cacheline_atomic_int32_t notify_count;
     na_sm_cacheline_atomic_int32_t polling;
+    na_sm_cacheline_atomic_int32_t closed;  /* Closed by sender */
     struct hg_atomic_queue queue;
     char pad[NA_SM_COPY_BUF_SIZE - sizeof(struct hg_atomic_queue)
-             - 2 * NA_SM_CACHE_LINE_SIZE
+             - 3 * NA_SM_CACHE_LINE_SIZE
              - NA_SM_NUM_BUFS * HG_ATOMIC_QUEUE_ELT_SIZE];
 };
 
@@ -157,10 +183,55 @@ struct na_sm_copy_buf {
     char pad[NA_SM_COPY_BUF_SIZE - NA_SM_CACHE_LINE_SIZE];
 };
 
+/* Ring buffer pair of a connection (send / recv from listener side) */
+struct na_sm_conn_buf {
+    union {
+        struct na_sm_ring_buf ring_buf;
+        char pad[NA_SM_RING_BUF_SIZE];
+    } send, recv;
+};
+
+/* Shared region created by listener, connections get a slot in it so that
+ * the ring buffers of all peers are packed into the same (huge) pages */
+struct na_sm_region {
+    struct na_sm_copy_buf copy_buf;                 /* Shared copy buffer */
+    union {
+        na_sm_cacheline_atomic_int64_t mask[NA_SM_MAX_PEERS / 64];
+        char pad[NA_SM_COPY_BUF_SIZE];
+    } available;                                    /* Atomic bitmasks */
+    struct na_sm_conn_buf conn_bufs[NA_SM_MAX_PEERS]; /* Connection slots */
+};
+
+/* Registry entry (one per listening class on the node) */
+struct na_sm_registry_entry {
+    hg_atomic_int32_t state;    /* Free / busy / ready */
+    pid_t pid;                  /* PID of listener */
+    unsigned int id;            /* SM ID of listener */
+    char pad[NA_SM_CACHE_LINE_SIZE - sizeof(hg_atomic_int32_t)
+             - sizeof(pid_t) - sizeof(unsigned int)];
+};
+
+/* Shared registry, listeners publish themselves so that peers can attach
+ * directly without going through an accept handshake. There is one registry
+ * per user, it is unlinked by the last class that detaches from it. */
+struct na_sm_registry {
+    union {
+        hg_atomic_int32_t val;  /* Attached classes, -1 once unlinked */
+        char pad[NA_SM_COPY_BUF_SIZE];
+    } ref_count;
+    struct na_sm_registry_entry entries[NA_SM_REGISTRY_SIZE];
+};
+
+/* Connection info sent by peers to listener */
+struct na_sm_conn_info {
+    pid_t pid;              /* PID of peer */
+    unsigned int id;        /* SM ID of peer */
+    unsigned int conn_id;   /* Connection slot reserved in region */
+};
+
 /* Poll type */
 typedef enum na_sm_poll_type {
     NA_SM_ACCEPT = 1,
-    NA_SM_SOCK,
     NA_SM_NOTIFY
 } na_sm_poll_type_t;
 
@@ -171,12 +242,22 @@ struct na_sm_poll_data {
     struct na_sm_addr *addr; /* Address */
 };
 
-/* Sock progress type */
-typedef enum {
-    NA_SM_ADDR_INFO,
-    NA_SM_CONN_ID,
-    NA_SM_SOCK_DONE
-} na_sm_sock_progress_t;
+/* Shared memory segment allocated for RMA (exported to peers) */
+struct na_sm_mem_seg {
+    void *base;                             /* Base address */
+    size_t size;                            /* Size of segment */
+    unsigned int id;                        /* Segment ID */
+    HG_LIST_ENTRY(na_sm_mem_seg) entry;     /* Next list entry */
+};
+
+/* Cached mapping of remote shared memory segment */
+struct na_sm_mem_map {
+    void *remote_base;                      /* Base address in remote process */
+    void *base;                             /* Base address of local mapping */
+    size_t size;                            /* Size of segment */
+    unsigned int id;                        /* Segment ID */
+    HG_LIST_ENTRY(na_sm_mem_map) entry;     /* Next list entry */
+};
 
 /* Address */
 struct na_sm_addr {
@@ -186,17 +267,24 @@ struct na_sm_addr {
     struct na_sm_ring_buf *na_sm_send_ring_buf; /* Shared send ring buffer */
     struct na_sm_ring_buf *na_sm_recv_ring_buf; /* Shared recv ring buffer */
     struct na_sm_copy_buf *na_sm_copy_buf;  /* Shared copy buffer */
+    struct na_sm_region *na_sm_region;      /* Shared region (if mapped) */
+    struct na_sm_registry_entry *registry_entry; /* Published entry */
     na_bool_t accepted;                     /* Created on accept */
     na_bool_t self;                         /* Self address */
-    int sock;                               /* Sock fd */
-    na_sm_sock_progress_t sock_progress;    /* Current sock progress state */
+    int sock;                               /* Sock fd (self only) */
     struct na_sm_poll_data *sock_poll_data; /* Sock poll data */
     int local_notify;                       /* Local notify fd */
     struct na_sm_poll_data *local_notify_poll_data; /* Notify poll data */
     int remote_notify;                      /* Remote notify fd */
+    HG_LIST_HEAD(na_sm_mem_map) mem_map_list; /* Remote segments mapped */
+    HG_QUEUE_HEAD(na_sm_op_id) rma_get_queue; /* Pending get ops */
+    HG_QUEUE_HEAD(na_sm_op_id) rma_put_queue; /* Pending put ops */
+    na_bool_t rma_pending;                  /* Addr in RMA addr queue */
+    na_bool_t disconnected;                 /* Addr in disconnected queue */
     hg_atomic_int32_t ref_count;            /* Ref count */
     HG_QUEUE_ENTRY(na_sm_addr) entry;       /* Next queue entry */
     HG_QUEUE_ENTRY(na_sm_addr) poll_entry;  /* Next poll queue entry */
+    HG_QUEUE_ENTRY(na_sm_addr) rma_entry;   /* Next RMA addr queue entry */
 };
 
 /* Unexpected message info */
@@ -212,19 +300,25 @@ struct na_sm_mem_handle {
     unsigned long iovcnt;
     unsigned long flags; /* Flag of operation access */
     size_t len;
+    unsigned int shm_id; /* Segment ID if exported through shm (0 if not) */
+    void *shm_base;      /* Base address of segment */
+    size_t shm_size;     /* Size of segment */
 };
 
 /* Lookup info */
 struct na_sm_info_lookup {
     struct na_sm_addr *na_sm_addr;
+    hg_time_t start;        /* Time of first connection attempt */
+    na_return_t ret;        /* Return code of lookup */
 };
 
 /* Send unexpected and expected */
 struct na_sm_info_send {
-    void *buf;
+    const void *buf;
     size_t buf_size;
     struct na_sm_addr *na_sm_addr;
     na_tag_t tag;
+    na_return_t ret;        /* Return code of send */
 };
 
 /* Unexpected recv info */
@@ -242,6 +336,17 @@ struct na_sm_info_recv_expected {
     na_tag_t tag;
 };
 
+/* RMA info (put / get) */
+struct na_sm_info_rma {
+    struct na_sm_addr *na_sm_addr;
+    struct na_sm_mem_handle *local_mem_handle;
+    na_offset_t local_offset;
+    struct na_sm_mem_handle *remote_mem_handle;
+    na_offset_t remote_offset;
+    na_size_t length;
+    na_return_t ret;        /* Return code of transfer */
+};
+
 /* Operation ID */
 struct na_sm_op_id {
     na_class_t *na_class;
@@ -254,6 +359,7 @@ struct na_sm_op_id {
         struct na_sm_info_send send;
         struct na_sm_info_recv_unexpected recv_unexpected;
         struct na_sm_info_recv_expected recv_expected;
+        struct na_sm_info_rma rma;
     } info;
     hg_atomic_int32_t ref_count;    /* Ref count */
     HG_QUEUE_ENTRY(na_sm_op_id) entry;
@@ -262,21 +368,41 @@ struct na_sm_op_id {
 /* Private data */
 struct na_sm_private_data {
     struct na_sm_addr *self_addr;
+    struct na_sm_registry *registry;
+    char registry_name[NA_SM_MAX_FILENAME];
+    size_t region_size;
+    na_bool_t use_huge_pages;
     hg_poll_set_t *poll_set;
+    int conn_sock;
     HG_QUEUE_HEAD(na_sm_addr) accepted_addr_queue;
+    HG_QUEUE_HEAD(na_sm_addr) disconnected_addr_queue;
     HG_QUEUE_HEAD(na_sm_addr) poll_addr_queue;
     HG_QUEUE_HEAD(na_sm_unexpected_info) unexpected_msg_queue;
-    HG_QUEUE_HEAD(na_sm_op_id) lookup_op_queue;
+    struct na_sm_unexpected_info *unexpected_info_pool;
+    unsigned int unexpected_info_pool_size;
+    struct hg_atomic_queue *unexpected_info_free_queue;
     HG_QUEUE_HEAD(na_sm_op_id) unexpected_op_queue;
     HG_QUEUE_HEAD(na_sm_op_id) expected_op_queue;
+    HG_QUEUE_HEAD(na_sm_op_id) lookup_op_queue;
+    HG_QUEUE_HEAD(na_sm_op_id) send_op_queue;
+    HG_LIST_HEAD(na_sm_mem_seg) mem_seg_list;
+    HG_QUEUE_HEAD(na_sm_addr) rma_addr_queue;
+    struct iovec *rma_local_iov;
+    struct iovec *rma_remote_iov;
+    unsigned long rma_iov_max;
+    hg_atomic_int32_t rma_flushing;
     hg_thread_spin_t accepted_addr_queue_lock;
     hg_thread_spin_t poll_addr_queue_lock;
     hg_thread_spin_t unexpected_msg_queue_lock;
-    hg_thread_spin_t lookup_op_queue_lock;
     hg_thread_spin_t unexpected_op_queue_lock;
     hg_thread_spin_t expected_op_queue_lock;
+    hg_thread_spin_t lookup_op_queue_lock;
+    hg_thread_spin_t send_op_queue_lock;
     hg_thread_spin_t copy_buf_lock;
-    hg_time_t last_accept_time;
+    hg_thread_spin_t mem_seg_list_lock;
+    hg_thread_spin_t mem_map_lock;
+    hg_thread_spin_t rma_queue_lock;
+    hg_atomic_int32_t mem_seg_id;
     hg_atomic_int32_t polling;
     hg_atomic_int32_t notify_count;
 };
@@ -306,7 +432,7 @@ na_sm_close_shared_buf(
     );
 
 /**
- * Create UNIX domain socket.
+ * Create UNIX domain (datagram) socket.
  */
 static na_return_t
 na_sm_create_sock(
@@ -314,6 +440,15 @@ na_sm_create_sock(
     na_bool_t na_listen,
     int *sock);
 
+/**
+ * Fill UNIX domain socket address from pathname.
+ */
+static na_return_t
+na_sm_set_sock_addr(
+    const char *pathname,
+    struct sockaddr_un *addr
+    );
+
 /**
  * Close socket.
  */
@@ -404,44 +539,124 @@ na_sm_poll_deregister(
     );
 
 /**
- * Create copy buf and sock and register self address.
+ * Create / open shared region of listener.
  */
-static na_return_t na_sm_setup_shm(
+static struct na_sm_region *
+na_sm_region_open(
     na_class_t *na_class,
-    struct na_sm_addr *na_sm_addr
+    const char *name,
+    na_bool_t create
     );
 
 /**
- * Send addr info.
+ * Reserve connection slot in region.
  */
 static na_return_t
-na_sm_send_addr_info(
+na_sm_region_reserve_conn(
+    struct na_sm_region *na_sm_region,
+    unsigned int *conn_id
+    );
+
+/**
+ * Release connection slot in region.
+ */
+static void
+na_sm_region_release_conn(
+    struct na_sm_region *na_sm_region,
+    unsigned int conn_id
+    );
+
+/**
+ * Count connection slots still available in region.
+ */
+static unsigned int
+na_sm_region_count_conn(
+    struct na_sm_region *na_sm_region
+    );
+
+/**
+ * Create shared region and sock and register self address.
+ */
+static na_return_t na_sm_setup_shm(
     na_class_t *na_class,
     struct na_sm_addr *na_sm_addr
     );
 
 /**
- * Recv addr info.
+ * Map node-local registry.
  */
 static na_return_t
-na_sm_recv_addr_info(
-    struct na_sm_addr *na_sm_addr,
-    na_bool_t *received
+na_sm_registry_open(
+    na_class_t *na_class
+    );
+
+/**
+ * Unmap node-local registry.
+ */
+static na_return_t
+na_sm_registry_close(
+    na_class_t *na_class
     );
 
 /**
- * Send connection ID.
+ * Publish listening address to registry.
  */
 static na_return_t
-na_sm_send_conn_id(
+na_sm_registry_insert(
+    struct na_sm_registry *na_sm_registry,
     struct na_sm_addr *na_sm_addr
     );
 
 /**
- * Recv connection ID.
+ * Remove published address from registry.
+ */
+static void
+na_sm_registry_remove(
+    struct na_sm_registry_entry *na_sm_registry_entry
+    );
+
+/**
+ * Find published address in registry (lock-free).
+ */
+static struct na_sm_registry_entry *
+na_sm_registry_lookup(
+    struct na_sm_registry *na_sm_registry,
+    pid_t pid,
+    unsigned int id
+    );
+
+/**
+ * Initialize ring buffer pair and create notify events for new connection.
+ */
+static na_return_t
+na_sm_conn_create(
+    struct na_sm_addr *na_sm_addr
+    );
+
+/**
+ * Destroy notify events of connection that was not sent to remote.
+ */
+static void
+na_sm_conn_destroy(
+    struct na_sm_addr *na_sm_addr
+    );
+
+/**
+ * Send connection info.
+ */
+static na_return_t
+na_sm_send_conn_info(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr,
+    na_bool_t *sent
+    );
+
+/**
+ * Recv connection info.
  */
 static na_return_t
-na_sm_recv_conn_id(
+na_sm_recv_conn_info(
+    int sock,
     struct na_sm_addr *na_sm_addr,
     na_bool_t *received
     );
@@ -497,10 +712,79 @@ na_sm_copy_and_free_buf(
     );
 
 /**
- * Translate offset from mem_handle into usable iovec.
+ * Insert message into ring buffer of remote addr and complete operation.
  */
-static void
+static na_return_t
+na_sm_msg_insert(
+    na_class_t *na_class,
+    struct na_sm_op_id *na_sm_op_id,
+    na_cb_type_t cb_type,
+    struct na_sm_addr *na_sm_addr,
+    unsigned int idx_reserved,
+    na_size_t buf_size,
+    na_tag_t tag
+    );
+
+/**
+ * Send message or queue it until a copy buf becomes available.
+ */
+static na_return_t
+na_sm_msg_send(
+    na_class_t *na_class,
+    struct na_sm_op_id *na_sm_op_id
+    );
+
+/**
+ * Issue queued messages in order, stops at first one that cannot be sent.
+ */
+static na_return_t
+na_sm_msg_send_retry(
+    na_class_t *na_class,
+    na_bool_t *progressed
+    );
+
+/**
+ * Register looked up addr if connection info was sent, release it otherwise,
+ * and complete lookup operation.
+ */
+static na_return_t
+na_sm_lookup_finish(
+    na_class_t *na_class,
+    struct na_sm_op_id *na_sm_op_id,
+    na_bool_t sent,
+    na_return_t lookup_ret
+    );
+
+/**
+ * Retry sending connection info of pending lookups.
+ */
+static na_return_t
+na_sm_lookup_retry(
+    na_class_t *na_class,
+    na_bool_t *progressed
+    );
+
+/**
+ * Translate offset from mem_handle into usable iovec. iov_buf is used if it
+ * can hold the translated iovec, otherwise iovec is allocated and must be
+ * released with na_sm_iov_release().
+ */
+static na_return_t
 na_sm_offset_translate(
+    struct na_sm_mem_handle *mem_handle,
+    na_offset_t offset,
+    na_size_t length,
+    struct iovec *iov_buf,
+    struct iovec **iov,
+    unsigned long *iovcnt
+    );
+
+/**
+ * Translate offset from mem_handle into iov, iov must be able to hold
+ * mem_handle->iovcnt entries.
+ */
+static void
+na_sm_iov_translate(
     struct na_sm_mem_handle *mem_handle,
     na_offset_t offset,
     na_size_t length,
@@ -508,6 +792,91 @@ na_sm_offset_translate(
     unsigned long *iovcnt
     );
 
+/**
+ * Release iovec returned by na_sm_offset_translate().
+ */
+static NA_INLINE void
+na_sm_iov_release(
+    struct na_sm_mem_handle *mem_handle,
+    struct iovec *iov_buf,
+    struct iovec *iov
+    );
+
+/**
+ * Get local address of remote memory exported through shm. Segment is mapped
+ * on first access and the mapping is then cached on the remote addr.
+ */
+static na_return_t
+na_sm_mem_map_get(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr,
+    struct na_sm_mem_handle *na_sm_mem_handle,
+    na_offset_t offset,
+    na_size_t length,
+    char **ptr
+    );
+
+/**
+ * Unmap all remote segments cached on addr.
+ */
+static na_return_t
+na_sm_mem_map_release(
+    struct na_sm_addr *na_sm_addr
+    );
+
+/**
+ * Copy memory, use non-temporal stores for large sizes if supported.
+ */
+static NA_INLINE void
+na_sm_memcpy(
+    void *dest,
+    const void *src,
+    size_t n
+    );
+
+/**
+ * Copy between iovec and contiguous buffer.
+ */
+static void
+na_sm_iov_copy(
+    const struct iovec *iov,
+    unsigned long iovcnt,
+    char *ptr,
+    na_bool_t to_iov
+    );
+
+#ifdef NA_SM_HAS_CMA
+/**
+ * Queue RMA operation on remote addr, transfer is deferred to next progress
+ * so that it can be merged with other pending operations to the same peer.
+ */
+static void
+na_sm_rma_post(
+    na_class_t *na_class,
+    struct na_sm_op_id *na_sm_op_id
+    );
+
+/**
+ * Issue all pending RMA operations, merged per peer and direction.
+ */
+static na_return_t
+na_sm_rma_flush(
+    na_class_t *na_class,
+    na_bool_t *progressed
+    );
+
+/**
+ * Issue queued RMA operations of a given direction to a peer using as few
+ * process_vm_readv() / process_vm_writev() calls as possible.
+ */
+static na_return_t
+na_sm_rma_process(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr,
+    na_cb_type_t cb_type
+    );
+#endif
+
 /**
  * Progress callback
  */
@@ -529,25 +898,61 @@ na_sm_progress_accept(
     );
 
 /**
- * Progress on socket.
+ * Progress on notifications.
  */
 static na_return_t
-na_sm_progress_sock(
+na_sm_progress_notify(
     na_class_t *na_class,
     struct na_sm_addr *poll_addr,
     na_bool_t *progressed
     );
 
 /**
- * Progress on notifications.
+ * Move accepted addr to disconnected addr queue, the addr cannot be freed
+ * directly while the poll set is being walked.
+ */
+static na_bool_t
+na_sm_addr_disconnect(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr
+    );
+
+/**
+ * Move accepted addrs of dead peers to disconnected addr queue.
+ */
+static void
+na_sm_addr_disconnect_dead(
+    na_class_t *na_class
+    );
+
+/**
+ * Free disconnected addrs, which releases their connection slot once the
+ * last reference is dropped.
  */
 static na_return_t
-na_sm_progress_notify(
+na_sm_addr_release_disconnected(
     na_class_t *na_class,
-    struct na_sm_addr *poll_addr,
     na_bool_t *progressed
     );
 
+/**
+ * Get unexpected info from preallocated pool (lock-free). Falls back to
+ * malloc() when all descriptors of the pool are in use.
+ */
+static NA_INLINE struct na_sm_unexpected_info *
+na_sm_unexpected_info_get(
+    na_class_t *na_class
+    );
+
+/**
+ * Return unexpected info to pool, or free it if it was allocated.
+ */
+static NA_INLINE void
+na_sm_unexpected_info_release(
+    na_class_t *na_class,
+    struct na_sm_unexpected_info *na_sm_unexpected_info
+    );
+
 /**
  * Progress on unexpected messages.
  */
@@ -584,6 +989,15 @@ na_sm_release(
     void *arg
     );
 
+/**
+ * Allocate operation ID, from context pool if context is not NULL.
+ */
+static struct na_sm_op_id *
+na_sm_op_alloc(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
 /* check_protocol */
 static na_bool_t
 na_sm_check_protocol(
@@ -756,6 +1170,22 @@ na_sm_msg_recv_expected(
     na_op_id_t *op_id
     );
 
+/* mem_alloc */
+static void *
+na_sm_mem_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* mem_free */
+static na_return_t
+na_sm_mem_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
 /* mem_handle_create */
 static na_return_t
 na_sm_mem_handle_create(
@@ -907,6 +1337,8 @@ const na_class_t na_sm_class_g = {
     NULL,                                   /* msg_init_expected */
     na_sm_msg_send_expected,                /* msg_send_expected */
     na_sm_msg_recv_expected,                /* msg_recv_expected */
+    na_sm_mem_alloc,                        /* mem_alloc */
+    na_sm_mem_free,                         /* mem_free */
     na_sm_mem_handle_create,                /* mem_handle_create */
 #ifdef NA_SM_HAS_CMA
     na_sm_mem_handle_create_segments,       /* mem_handle_create_segments */
@@ -994,11 +1426,12 @@ na_sm_create_sock(const char *pathname, na_bool_t na_listen, int *sock)
     na_return_t ret = NA_SUCCESS;
     int fd;
 
-    /* Create a non-blocking socket so that we can poll for incoming connections */
+    /* Create a non-blocking datagram socket so that we can poll for incoming
+     * connection info without having to accept connections */
 #ifdef SOCK_NONBLOCK
-    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+    fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
 #else
-    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    fd = socket(AF_UNIX, SOCK_DGRAM, 0);
 #endif
     if (fd == -1) {
         NA_LOG_ERROR("socket() failed (%s)", strerror(errno));
@@ -1013,21 +1446,17 @@ na_sm_create_sock(const char *pathname, na_bool_t na_listen, int *sock)
     };
 #endif
 
-    memset(&addr, 0, sizeof(struct sockaddr_un));
-    addr.sun_family = AF_UNIX;
-    if (strlen(pathname) + strlen("/sock") > sizeof(addr.sun_path) - 1) {
-        NA_LOG_ERROR("Exceeds maximum AF UNIX socket path length");
-        ret = NA_SIZE_ERROR;
-        goto done;
-    }
-    strcpy(addr.sun_path, pathname);
-    strcat(addr.sun_path, "/sock");
-
     if (na_listen) {
-        char *dup_path = strdup(pathname);
+        char *dup_path = NULL;
         char stat_path[NA_SM_MAX_FILENAME];
-        char *path_ptr = dup_path;
+        char *path_ptr = NULL;
+
+        ret = na_sm_set_sock_addr(pathname, &addr);
+        if (ret != NA_SUCCESS)
+            goto done;
 
+        dup_path = strdup(pathname);
+        path_ptr = dup_path;
         memset(stat_path, '\0', NA_SM_MAX_FILENAME);
         if (dup_path[0] == '/') {
             path_ptr++;
@@ -1060,21 +1489,9 @@ na_sm_create_sock(const char *pathname, na_bool_t na_listen, int *sock)
             ret = NA_PROTOCOL_ERROR;
             goto done;
         }
-
-        /* Listen */
-        if (listen(fd, NA_SM_LISTEN_BACKLOG) == -1) {
-            NA_LOG_ERROR("listen() failed (%s)", strerror(errno));
-            ret = NA_PROTOCOL_ERROR;
-            goto done;
-        }
-    } else {
-        /* Connect */
-        if (connect(fd, (struct sockaddr *) &addr, sizeof(struct sockaddr_un)) == -1) {
-            NA_LOG_ERROR("connect() failed (%s)", strerror(errno));
-            ret = NA_PROTOCOL_ERROR;
-            goto done;
-        }
     }
+    /* Otherwise, socket is left unbound and only used to send connection
+     * info to listening peers */
 
     *sock = fd;
 
@@ -1084,12 +1501,32 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_close_sock(int sock, const char *pathname)
+na_sm_set_sock_addr(const char *pathname, struct sockaddr_un *addr)
 {
     na_return_t ret = NA_SUCCESS;
 
-    if (close(sock) == -1) {
-        NA_LOG_ERROR("close() failed (%s)", strerror(errno));
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    if (strlen(pathname) + strlen("/sock") > sizeof(addr->sun_path) - 1) {
+        NA_LOG_ERROR("Exceeds maximum AF UNIX socket path length");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+    strcpy(addr->sun_path, pathname);
+    strcat(addr->sun_path, "/sock");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_close_sock(int sock, const char *pathname)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    if (close(sock) == -1) {
+        NA_LOG_ERROR("close() failed (%s)", strerror(errno));
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
@@ -1136,9 +1573,12 @@ na_sm_cleanup_shm(const char *fpath, const struct stat NA_UNUSED *sb,
     int NA_UNUSED typeflag, struct FTW NA_UNUSED *ftwbuf)
 {
     const char *prefix = NA_SM_SHM_PATH "/" NA_SM_SHM_PREFIX;
+    const char *registry_prefix = NA_SM_SHM_PATH "/" NA_SM_REGISTRY_PREFIX;
     int ret = 0;
 
-    if (strncmp(fpath, prefix, strlen(prefix)) == 0) {
+    /* Registry is unlinked by its last user, live processes may use it */
+    if (strncmp(fpath, prefix, strlen(prefix)) == 0
+        && strncmp(fpath, registry_prefix, strlen(registry_prefix)) != 0) {
         const char *file = fpath + strlen(NA_SM_SHM_PATH "/");
         ret = hg_mem_shm_unmap(file, NULL, 0);
     }
@@ -1262,10 +1702,6 @@ na_sm_poll_register(na_class_t *na_class, na_sm_poll_type_t poll_type,
             fd = na_sm_addr->sock;
             na_sm_poll_data_ptr = &na_sm_addr->sock_poll_data;
             break;
-        case NA_SM_SOCK:
-            fd = na_sm_addr->sock;
-            na_sm_poll_data_ptr = &na_sm_addr->sock_poll_data;
-            break;
         case NA_SM_NOTIFY:
             fd = na_sm_addr->local_notify;
             na_sm_poll_data_ptr = &na_sm_addr->local_notify_poll_data;
@@ -1312,10 +1748,6 @@ na_sm_poll_deregister(na_class_t *na_class, na_sm_poll_type_t poll_type,
             na_sm_poll_data = na_sm_addr->sock_poll_data;
             fd = na_sm_addr->sock;
             break;
-        case NA_SM_SOCK:
-            na_sm_poll_data = na_sm_addr->sock_poll_data;
-            fd = na_sm_addr->sock;
-            break;
         case NA_SM_NOTIFY:
             na_sm_poll_data = na_sm_addr->local_notify_poll_data;
             fd = na_sm_addr->local_notify;
@@ -1338,27 +1770,129 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static struct na_sm_region *
+na_sm_region_open(na_class_t *na_class, const char *name, na_bool_t create)
+{
+    size_t region_size = NA_SM_PRIVATE_DATA(na_class)->region_size;
+    hg_mem_page_type_t page_type = HG_MEM_PAGE_DEFAULT;
+    struct na_sm_region *ret = NULL;
+
+    /* Peers always go through hg_mem_shm_map_huge() as they do not know
+     * which pages backed the region when it was created */
+    if (create && !NA_SM_PRIVATE_DATA(na_class)->use_huge_pages)
+        ret = (struct na_sm_region *) hg_mem_shm_map(name, region_size,
+            create);
+    else
+        ret = (struct na_sm_region *) hg_mem_shm_map_huge(name, region_size,
+            create, &page_type);
+    if (!ret)
+        goto done;
+
+    if (create && NA_SM_PRIVATE_DATA(na_class)->use_huge_pages) {
+        if (page_type == HG_MEM_PAGE_DEFAULT)
+            NA_LOG_WARNING("Could not use huge pages, using regular pages");
+        else
+            NA_LOG_DEBUG("Shared region %s backed by %s", name,
+                (page_type == HG_MEM_PAGE_HUGETLB) ? "hugetlbfs" :
+                "transparent huge pages");
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_region_reserve_conn(struct na_sm_region *na_sm_region,
+    unsigned int *conn_id)
+{
+    na_return_t ret = NA_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < NA_SM_MAX_PEERS / 64; i++) {
+        hg_atomic_int64_t *mask = &na_sm_region->available.mask[i].val;
+        hg_util_int64_t available;
+
+        while ((available = hg_atomic_get64(mask)) != 0) {
+            unsigned int j = 0;
+
+            /* Pick first available slot */
+            while (!(available & (1LL << j)))
+                j++;
+            if (hg_atomic_cas64(mask, available, available & ~(1LL << j))) {
+                *conn_id = i * 64 + j;
+                goto done;
+            }
+        }
+    }
+
+    NA_LOG_ERROR("No connection slot available (%d peers max)",
+        NA_SM_MAX_PEERS);
+    ret = NA_SIZE_ERROR;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_region_release_conn(struct na_sm_region *na_sm_region,
+    unsigned int conn_id)
+{
+    hg_atomic_int64_t *mask = &na_sm_region->available.mask[conn_id / 64].val;
+    hg_util_int64_t bits = 1LL << (conn_id % 64), available;
+
+    do {
+        available = hg_atomic_get64(mask);
+    } while (!hg_atomic_cas64(mask, available, available | bits));
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+na_sm_region_count_conn(struct na_sm_region *na_sm_region)
+{
+    unsigned int count = 0, i;
+
+    for (i = 0; i < NA_SM_MAX_PEERS / 64; i++) {
+        hg_util_int64_t available =
+            hg_atomic_get64(&na_sm_region->available.mask[i].val);
+
+        while (available) {
+            available &= available - 1;
+            count++;
+        }
+    }
+
+    return count;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_setup_shm(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
 {
     char filename[NA_SM_MAX_FILENAME], pathname[NA_SM_MAX_FILENAME];
-    struct na_sm_copy_buf *na_sm_copy_buf = NULL;
+    struct na_sm_region *na_sm_region = NULL;
     int listen_sock;
+    unsigned int i;
     na_return_t ret = NA_SUCCESS;
 
-    /* Create SHM buffer */
+    /* Create SHM region */
     NA_SM_GEN_SHM_NAME(filename, na_sm_addr);
-    na_sm_copy_buf = (struct na_sm_copy_buf *) na_sm_open_shared_buf(
-        filename, sizeof(struct na_sm_copy_buf), NA_TRUE);
-    if (!na_sm_copy_buf) {
-        NA_LOG_ERROR("Could not create copy buffer");
+    na_sm_region = na_sm_region_open(na_class, filename, NA_TRUE);
+    if (!na_sm_region) {
+        NA_LOG_ERROR("Could not create shared region");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
-    /* Initialize copy buf, store 1111111111...1111 */
-    hg_atomic_init64(&na_sm_copy_buf->available.val, ~((hg_util_int64_t)0));
-    na_sm_addr->na_sm_copy_buf = na_sm_copy_buf;
+    /* Initialize copy buf and connection slots, store 1111111111...1111 */
+    hg_atomic_init64(&na_sm_region->copy_buf.available.val,
+        ~((hg_util_int64_t)0));
+    for (i = 0; i < NA_SM_MAX_PEERS / 64; i++)
+        hg_atomic_init64(&na_sm_region->available.mask[i].val,
+            ~((hg_util_int64_t)0));
+    na_sm_addr->na_sm_region = na_sm_region;
+    na_sm_addr->na_sm_copy_buf = &na_sm_region->copy_buf;
 
     /* Create SHM sock */
     NA_SM_GEN_SOCK_PATH(pathname, na_sm_addr);
@@ -1376,76 +1910,264 @@ na_sm_setup_shm(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
         goto done;
     }
 
+    /* Publish self addr so that peers can attach to it */
+    ret = na_sm_registry_insert(NA_SM_PRIVATE_DATA(na_class)->registry,
+        na_sm_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not publish addr to registry");
+        goto done;
+    }
+
 done:
     return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_send_addr_info(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
+na_sm_registry_open(na_class_t *na_class)
 {
-    struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
-    ssize_t nsend;
-    struct iovec iovec[2];
+    char *registry_name = NA_SM_PRIVATE_DATA(na_class)->registry_name;
+    struct na_sm_registry *na_sm_registry = NULL;
+    unsigned int i;
     na_return_t ret = NA_SUCCESS;
 
-    /* Send local PID / ID */
-    iovec[0].iov_base = &NA_SM_PRIVATE_DATA(na_class)->self_addr->pid;
-    iovec[0].iov_len = sizeof(pid_t);
-    iovec[1].iov_base = &NA_SM_PRIVATE_DATA(na_class)->self_addr->id;
-    iovec[1].iov_len = sizeof(unsigned int);
-    msg.msg_iov = iovec;
-    msg.msg_iovlen = 2;
+    NA_SM_GEN_REGISTRY_NAME(registry_name);
 
-    nsend = sendmsg(na_sm_addr->sock, &msg, 0);
-    if (nsend == -1) {
-        NA_LOG_ERROR("sendmsg() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
+    for (i = 0; i < NA_SM_REGISTRY_RETRY; i++) {
+        hg_util_int32_t ref_count;
+
+        /* Registry is shared by all classes of the user on the node, create
+         * it if it does not exist yet (new segments are zero-filled, i.e.,
+         * all entries are free) */
+        na_sm_registry = (struct na_sm_registry *) na_sm_open_shared_buf(
+            registry_name, sizeof(struct na_sm_registry), NA_TRUE);
+        if (!na_sm_registry) {
+            NA_LOG_ERROR("Could not open registry %s", registry_name);
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        /* Attach unless the last user is about to unlink it */
+        ref_count = hg_atomic_get32(&na_sm_registry->ref_count.val);
+        while (ref_count >= 0 && !hg_atomic_cas32(
+            &na_sm_registry->ref_count.val, ref_count, ref_count + 1))
+            ref_count = hg_atomic_get32(&na_sm_registry->ref_count.val);
+        if (ref_count >= 0) {
+            NA_SM_PRIVATE_DATA(na_class)->registry = na_sm_registry;
+            goto done;
+        }
+
+        /* Retry once unlinked */
+        na_sm_close_shared_buf(NULL, na_sm_registry,
+            sizeof(struct na_sm_registry));
+        hg_thread_yield();
+    }
+
+    NA_LOG_ERROR("Could not attach to registry %s", registry_name);
+    ret = NA_PROTOCOL_ERROR;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_registry_close(na_class_t *na_class)
+{
+    struct na_sm_registry *na_sm_registry =
+        NA_SM_PRIVATE_DATA(na_class)->registry;
+    hg_util_int32_t ref_count;
+    const char *filename = NULL;
+
+    if (!na_sm_registry)
+        return NA_SUCCESS;
+
+    /* Last user marks registry as unlinked so that no one attaches to it */
+    do {
+        ref_count = hg_atomic_get32(&na_sm_registry->ref_count.val);
+    } while (!hg_atomic_cas32(&na_sm_registry->ref_count.val, ref_count,
+        (ref_count == 1) ? -1 : ref_count - 1));
+    if (ref_count == 1)
+        filename = NA_SM_PRIVATE_DATA(na_class)->registry_name;
+    NA_SM_PRIVATE_DATA(na_class)->registry = NULL;
+
+    return na_sm_close_shared_buf(filename, na_sm_registry,
+        sizeof(struct na_sm_registry));
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_registry_insert(struct na_sm_registry *na_sm_registry,
+    struct na_sm_addr *na_sm_addr)
+{
+    unsigned int hash = NA_SM_REGISTRY_HASH(na_sm_addr->pid, na_sm_addr->id);
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_SM_REGISTRY_SIZE; i++) {
+        struct na_sm_registry_entry *na_sm_registry_entry =
+            &na_sm_registry->entries[(hash + i) & (NA_SM_REGISTRY_SIZE - 1)];
+
+        /* Reclaim entries left behind by processes that did not finalize */
+        if (hg_atomic_get32(&na_sm_registry_entry->state)
+            == NA_SM_REGISTRY_READY && kill(na_sm_registry_entry->pid, 0) == -1
+            && errno == ESRCH)
+            hg_atomic_cas32(&na_sm_registry_entry->state, NA_SM_REGISTRY_READY,
+                NA_SM_REGISTRY_RELEASED);
+
+        if (!hg_atomic_cas32(&na_sm_registry_entry->state,
+            NA_SM_REGISTRY_FREE, NA_SM_REGISTRY_BUSY)
+            && !hg_atomic_cas32(&na_sm_registry_entry->state,
+                NA_SM_REGISTRY_RELEASED, NA_SM_REGISTRY_BUSY))
+            continue;
+
+        na_sm_registry_entry->pid = na_sm_addr->pid;
+        na_sm_registry_entry->id = na_sm_addr->id;
+
+        /* Entry becomes visible to peers once ready */
+        hg_atomic_set32(&na_sm_registry_entry->state, NA_SM_REGISTRY_READY);
+        na_sm_addr->registry_entry = na_sm_registry_entry;
         goto done;
     }
 
+    NA_LOG_ERROR("Registry is full (%d entries)", NA_SM_REGISTRY_SIZE);
+    ret = NA_SIZE_ERROR;
+
 done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_registry_remove(struct na_sm_registry_entry *na_sm_registry_entry)
+{
+    /* Keep entry as released so that probing of other entries continues */
+    hg_atomic_set32(&na_sm_registry_entry->state, NA_SM_REGISTRY_RELEASED);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_sm_registry_entry *
+na_sm_registry_lookup(struct na_sm_registry *na_sm_registry, pid_t pid,
+    unsigned int id)
+{
+    unsigned int hash = NA_SM_REGISTRY_HASH(pid, id);
+    unsigned int i;
+
+    for (i = 0; i < NA_SM_REGISTRY_SIZE; i++) {
+        struct na_sm_registry_entry *na_sm_registry_entry =
+            &na_sm_registry->entries[(hash + i) & (NA_SM_REGISTRY_SIZE - 1)];
+        hg_util_int32_t state = hg_atomic_get32(&na_sm_registry_entry->state);
+
+        if (state == NA_SM_REGISTRY_FREE)
+            break;
+        if (state == NA_SM_REGISTRY_READY && na_sm_registry_entry->pid == pid
+            && na_sm_registry_entry->id == id)
+            return na_sm_registry_entry;
+    }
+
+    return NULL;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_recv_addr_info(struct na_sm_addr *na_sm_addr, na_bool_t *received)
+na_sm_conn_create(struct na_sm_addr *na_sm_addr)
 {
-    struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
-    ssize_t nrecv;
-    struct iovec iovec[2];
+    struct na_sm_conn_buf *na_sm_conn_buf =
+        &na_sm_addr->na_sm_region->conn_bufs[na_sm_addr->conn_id];
+#ifndef HG_UTIL_HAS_SYSEVENTFD_H
+    char filename[NA_SM_MAX_FILENAME];
+#endif
+    int local_notify, remote_notify;
     na_return_t ret = NA_SUCCESS;
 
-    /* Receive remote PID / ID */
-    iovec[0].iov_base = &na_sm_addr->pid;
-    iovec[0].iov_len = sizeof(pid_t);
-    iovec[1].iov_base = &na_sm_addr->id;
-    iovec[1].iov_len = sizeof(unsigned int);
-    msg.msg_iov = iovec;
-    msg.msg_iovlen = 2;
+    /* Initialize ring buffer pair of reserved slot (send and recv correspond
+     * to remote ring buffer pair) */
+    na_sm_ring_buf_init(&na_sm_conn_buf->recv.ring_buf);
+    na_sm_addr->na_sm_send_ring_buf = &na_sm_conn_buf->recv.ring_buf;
+    na_sm_ring_buf_init(&na_sm_conn_buf->send.ring_buf);
+    na_sm_addr->na_sm_recv_ring_buf = &na_sm_conn_buf->send.ring_buf;
 
-    nrecv = recvmsg(na_sm_addr->sock, &msg, 0);
-    if (nrecv == -1) {
-        if (errno == EAGAIN) {
-            *received = NA_FALSE;
-            goto done;
-        }
-        NA_LOG_ERROR("recvmsg() failed (%s)", strerror(errno));
+    /* Create local signal event */
+#ifdef HG_UTIL_HAS_SYSEVENTFD_H
+    local_notify = hg_event_create();
+    if (local_notify == HG_UTIL_FAIL) {
+        NA_LOG_ERROR("hg_event_create() failed");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
-    *received = NA_TRUE;
+#else
+    /**
+     * If eventfd is not supported, we need to explicitly use named pipes in
+     * this case as kqueue file descriptors cannot be exchanged through
+     * ancillary data
+     */
+    NA_SM_GEN_FIFO_NAME(filename, NA_SM_SEND_NAME, na_sm_addr);
+    local_notify = na_sm_event_create(filename);
+    if (local_notify == -1) {
+        NA_LOG_ERROR("na_sm_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+#endif
+    na_sm_addr->local_notify = local_notify;
+
+    /* Create remote signal event */
+#ifdef HG_UTIL_HAS_SYSEVENTFD_H
+    remote_notify = hg_event_create();
+    if (remote_notify == HG_UTIL_FAIL) {
+        NA_LOG_ERROR("hg_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+#else
+    NA_SM_GEN_FIFO_NAME(filename, NA_SM_RECV_NAME, na_sm_addr);
+    remote_notify = na_sm_event_create(filename);
+    if (remote_notify == -1) {
+        NA_LOG_ERROR("na_sm_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+#endif
+    na_sm_addr->remote_notify = remote_notify;
 
 done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_conn_destroy(struct na_sm_addr *na_sm_addr)
+{
+#ifdef HG_UTIL_HAS_SYSEVENTFD_H
+    if (na_sm_addr->local_notify != -1)
+        hg_event_destroy(na_sm_addr->local_notify);
+    if (na_sm_addr->remote_notify != -1)
+        hg_event_destroy(na_sm_addr->remote_notify);
+#else
+    char filename[NA_SM_MAX_FILENAME];
+
+    if (na_sm_addr->local_notify != -1) {
+        NA_SM_GEN_FIFO_NAME(filename, NA_SM_SEND_NAME, na_sm_addr);
+        na_sm_event_destroy(filename, na_sm_addr->local_notify);
+    }
+    if (na_sm_addr->remote_notify != -1) {
+        NA_SM_GEN_FIFO_NAME(filename, NA_SM_RECV_NAME, na_sm_addr);
+        na_sm_event_destroy(filename, na_sm_addr->remote_notify);
+    }
+#endif
+    na_sm_addr->local_notify = -1;
+    na_sm_addr->remote_notify = -1;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_send_conn_id(struct na_sm_addr *na_sm_addr)
+na_sm_send_conn_info(na_class_t *na_class, struct na_sm_addr *na_sm_addr,
+    na_bool_t *sent)
 {
     struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
+    struct sockaddr_un addr;
+    char pathname[NA_SM_MAX_FILENAME];
+    struct na_sm_conn_info conn_info;
     struct cmsghdr *cmsg;
     /* Contains the file descriptors to pass */
     int fds[2] = {na_sm_addr->local_notify, na_sm_addr->remote_notify};
@@ -1460,9 +2182,20 @@ na_sm_send_conn_id(struct na_sm_addr *na_sm_addr)
     ssize_t nsend;
     na_return_t ret = NA_SUCCESS;
 
-    /* Send local PID / ID */
-    iovec[0].iov_base = &na_sm_addr->conn_id;
-    iovec[0].iov_len = sizeof(unsigned int);
+    /* Send to listening sock of remote addr */
+    NA_SM_GEN_SOCK_PATH(pathname, na_sm_addr);
+    ret = na_sm_set_sock_addr(pathname, &addr);
+    if (ret != NA_SUCCESS)
+        goto done;
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof(struct sockaddr_un);
+
+    /* Send local PID / ID and reserved connection ID */
+    conn_info.pid = NA_SM_PRIVATE_DATA(na_class)->self_addr->pid;
+    conn_info.id = NA_SM_PRIVATE_DATA(na_class)->self_addr->id;
+    conn_info.conn_id = na_sm_addr->conn_id;
+    iovec[0].iov_base = &conn_info;
+    iovec[0].iov_len = sizeof(struct na_sm_conn_info);
     msg.msg_iov = iovec;
     msg.msg_iovlen = 1;
 
@@ -1478,12 +2211,17 @@ na_sm_send_conn_id(struct na_sm_addr *na_sm_addr)
     fdptr = (int *) CMSG_DATA(cmsg);
     memcpy(fdptr, fds, sizeof(fds));
 
-    nsend = sendmsg(na_sm_addr->sock, &msg, 0);
+    nsend = sendmsg(NA_SM_PRIVATE_DATA(na_class)->conn_sock, &msg, 0);
     if (nsend == -1) {
+        if (errno == EAGAIN) {
+            *sent = NA_FALSE;
+            goto done;
+        }
         NA_LOG_ERROR("sendmsg() failed (%s)", strerror(errno));
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
+    *sent = NA_TRUE;
 
 done:
     return ret;
@@ -1491,9 +2229,11 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
+na_sm_recv_conn_info(int sock, struct na_sm_addr *na_sm_addr,
+    na_bool_t *received)
 {
     struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
+    struct na_sm_conn_info conn_info;
     struct cmsghdr *cmsg;
     int *fdptr;
     int fds[2];
@@ -1507,9 +2247,9 @@ na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
     struct iovec iovec[1];
     na_return_t ret = NA_SUCCESS;
 
-    /* Receive remote PID / ID */
-    iovec[0].iov_base = &na_sm_addr->conn_id;
-    iovec[0].iov_len = sizeof(unsigned int);
+    /* Receive remote PID / ID and connection ID */
+    iovec[0].iov_base = &conn_info;
+    iovec[0].iov_len = sizeof(struct na_sm_conn_info);
     msg.msg_iov = iovec;
     msg.msg_iovlen = 1;
 
@@ -1517,7 +2257,7 @@ na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
     msg.msg_control = u.buf;
     msg.msg_controllen = sizeof u.buf;
 
-    nrecv = recvmsg(na_sm_addr->sock, &msg, 0);
+    nrecv = recvmsg(sock, &msg, 0);
     if (nrecv == -1) {
         if (errno == EAGAIN) {
             *received = NA_FALSE;
@@ -1529,10 +2269,13 @@ na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
     }
     *received = NA_TRUE;
 
-    /* Retrieve ancillary data */
+    /* Retrieve ancillary data first so that received descriptors can be
+     * closed by the caller whatever the outcome */
     cmsg = CMSG_FIRSTHDR(&msg);
-    if (cmsg == NULL) {
-        NA_LOG_ERROR("NULL cmsg");
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET
+        || cmsg->cmsg_type != SCM_RIGHTS
+        || cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        NA_LOG_ERROR("Invalid cmsg");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
@@ -1542,6 +2285,15 @@ na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
     na_sm_addr->local_notify = fds[1];
     na_sm_addr->remote_notify = fds[0];
 
+    if (nrecv != sizeof(struct na_sm_conn_info)) {
+        NA_LOG_ERROR("Truncated connection info");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_sm_addr->pid = conn_info.pid;
+    na_sm_addr->id = conn_info.id;
+    na_sm_addr->conn_id = conn_info.conn_id;
+
 done:
     return ret;
 }
@@ -1560,6 +2312,7 @@ na_sm_ring_buf_init(struct na_sm_ring_buf *na_sm_ring_buf)
     hg_atomic_init32(&hg_atomic_queue->prod_tail, 0);
     hg_atomic_init32(&hg_atomic_queue->cons_tail, 0);
     hg_atomic_init32(&na_sm_ring_buf->polling.val, NA_FALSE);
+    hg_atomic_init32(&na_sm_ring_buf->closed.val, NA_FALSE);
     hg_atomic_init32(&na_sm_ring_buf->notify_count.val, 0);
 }
 
@@ -1729,413 +2482,867 @@ done:
 }
 
 /*---------------------------------------------------------------------------*/
-static void
-na_sm_offset_translate(struct na_sm_mem_handle *mem_handle, na_offset_t offset,
-    na_size_t length, struct iovec *iov, unsigned long *iovcnt)
+static na_return_t
+na_sm_msg_send(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id)
 {
-    unsigned long i, new_start_index = 0;
-    na_offset_t new_offset = offset, next_offset = 0;
-    na_size_t remaining_len = length;
+    struct na_sm_info_send *na_sm_info_send = &na_sm_op_id->info.send;
+    struct na_sm_addr *na_sm_addr = na_sm_info_send->na_sm_addr;
+    na_cb_type_t cb_type = (na_sm_op_id->completion_data.callback_info.type
+        == NA_CB_SEND_UNEXPECTED) ? NA_CB_RECV_UNEXPECTED : NA_CB_RECV_EXPECTED;
+    unsigned int idx_reserved;
+    na_bool_t reserved = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
 
-    /* Get start index and handle offset */
-    for (i = 0; i < mem_handle->iovcnt; i++) {
-        next_offset += mem_handle->iov[i].iov_len;
-        if (offset < next_offset) {
-            new_start_index = i;
-            break;
-        }
-        new_offset -= mem_handle->iov[i].iov_len;
+    /* Remote freed its addr and would never release copy bufs */
+    if (hg_atomic_get32(&na_sm_addr->na_sm_recv_ring_buf->closed.val)) {
+        NA_LOG_ERROR("Connection closed by remote");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
     }
 
-    iov[0].iov_base = (char *) mem_handle->iov[new_start_index].iov_base +
-        new_offset;
-    iov[0].iov_len = NA_SM_MIN(remaining_len,
-        mem_handle->iov[new_start_index].iov_len - new_offset);
-    remaining_len -= iov[0].iov_len;
-
-    for (i = 1; remaining_len && (i < mem_handle->iovcnt - new_start_index); i++) {
-        iov[i].iov_base = mem_handle->iov[i + new_start_index].iov_base;
-        /* Can only transfer smallest size */
-        iov[i].iov_len = NA_SM_MIN(remaining_len,
-            mem_handle->iov[i + new_start_index].iov_len);
+    /* Messages already queued must go out first to preserve ordering */
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+    if (HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue)
+        && na_sm_reserve_and_copy_buf(na_class, na_sm_addr->na_sm_copy_buf,
+            na_sm_info_send->buf, na_sm_info_send->buf_size, &idx_reserved)
+            == NA_SUCCESS)
+        reserved = NA_TRUE;
+    else {
+        /* No copy buf available, retry on progress and keep addr alive
+         * until then */
+        hg_atomic_incr32(&na_sm_addr->ref_count);
+        HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue,
+            na_sm_op_id, entry);
+    }
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
 
-        /* Decrease remaining len from the len of data */
-        remaining_len -= iov[i].iov_len;
+    if (reserved) {
+        /* Insert message into ring buffer (complete OP ID) */
+        ret = na_sm_msg_insert(na_class, na_sm_op_id, cb_type, na_sm_addr,
+            idx_reserved, na_sm_info_send->buf_size, na_sm_info_send->tag);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not insert message");
+            goto done;
+        }
     }
 
-    *iovcnt = i;
+done:
+    return ret;
 }
 
 /*---------------------------------------------------------------------------*/
-static int
-na_sm_progress_cb(void *arg, unsigned int NA_UNUSED timeout,
-    hg_util_bool_t *progressed)
+static na_return_t
+na_sm_msg_send_retry(na_class_t *na_class, na_bool_t *progressed)
 {
-    na_class_t *na_class;
-    struct na_sm_poll_data *na_sm_poll_data = (struct na_sm_poll_data *) arg;
-    na_return_t na_ret;
+    na_return_t ret = NA_SUCCESS;
 
-    if (!na_sm_poll_data) {
-        NA_LOG_ERROR("NULL SM poll data");
-        na_ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    na_class = na_sm_poll_data->na_class;
+    *progressed = NA_FALSE;
 
-    switch (na_sm_poll_data->type) {
-        case NA_SM_ACCEPT:
-            na_ret = na_sm_progress_accept(na_class, na_sm_poll_data->addr,
-                (hg_util_bool_t *) progressed);
-            if (na_ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not make progress on accept");
-                goto done;
-            }
+    for (;;) {
+        struct na_sm_op_id *na_sm_op_id;
+        struct na_sm_info_send *na_sm_info_send;
+        struct na_sm_addr *na_sm_addr;
+        na_cb_type_t cb_type;
+        unsigned int idx_reserved;
+
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+        na_sm_op_id = HG_QUEUE_FIRST(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue);
+        if (!na_sm_op_id) {
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
             break;
-        case NA_SM_SOCK:
-            na_ret = na_sm_progress_sock(na_class, na_sm_poll_data->addr,
-                (hg_util_bool_t *) progressed);
-            if (na_ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not make progress on sock");
-                goto done;
+        }
+        na_sm_info_send = &na_sm_op_id->info.send;
+        na_sm_addr = na_sm_info_send->na_sm_addr;
+        if (hg_atomic_get32(&na_sm_addr->na_sm_recv_ring_buf->closed.val)) {
+            /* Remote freed its addr, report error through callback */
+            HG_QUEUE_POP_HEAD(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue,
+                entry);
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+            *progressed = NA_TRUE;
+
+            NA_LOG_ERROR("Connection closed by remote");
+            na_sm_info_send->ret = NA_PROTOCOL_ERROR;
+            ret = na_sm_complete(na_sm_op_id);
+            na_sm_addr_free(na_class, (na_addr_t) na_sm_addr);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not complete operation");
+                break;
             }
+            continue;
+        }
+        if (na_sm_reserve_and_copy_buf(na_class, na_sm_addr->na_sm_copy_buf,
+            na_sm_info_send->buf, na_sm_info_send->buf_size, &idx_reserved)
+            != NA_SUCCESS) {
+            /* Still full, wait for remote to release copy bufs */
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
             break;
-        case NA_SM_NOTIFY:
-            na_ret = na_sm_progress_notify(na_class, na_sm_poll_data->addr,
-                (hg_util_bool_t *) progressed);
-            if (na_ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not make progress on notify");
-                goto done;
+        }
+        HG_QUEUE_POP_HEAD(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue, entry);
+        cb_type = (na_sm_op_id->completion_data.callback_info.type
+            == NA_CB_SEND_UNEXPECTED) ?
+            NA_CB_RECV_UNEXPECTED : NA_CB_RECV_EXPECTED;
+
+        /* Keep OP ID until we know whether it got completed and insert
+         * while locked so that messages enter the ring buffer in order */
+        hg_atomic_incr32(&na_sm_op_id->ref_count);
+        ret = na_sm_msg_insert(na_class, na_sm_op_id, cb_type, na_sm_addr,
+            idx_reserved, na_sm_info_send->buf_size, na_sm_info_send->tag);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+        *progressed = NA_TRUE;
+
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not insert message");
+            if (!hg_atomic_get32(&na_sm_op_id->completed)) {
+                /* Report error through callback */
+                na_sm_info_send->ret = ret;
+                na_sm_complete(na_sm_op_id);
             }
-            break;
-        default:
-            NA_LOG_ERROR("Unknown poll data type");
-            na_ret = NA_PROTOCOL_ERROR;
-            goto done;
+        }
+        na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
+
+        /* Release ref taken when operation was queued */
+        na_sm_addr_free(na_class, (na_addr_t) na_sm_addr);
+        if (ret != NA_SUCCESS)
             break;
     }
 
-done:
-    return (na_ret == NA_SUCCESS) ? HG_UTIL_SUCCESS : HG_UTIL_FAIL;
+    return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_progress_accept(na_class_t *na_class, struct na_sm_addr *poll_addr,
-    na_bool_t *progressed)
+na_sm_lookup_finish(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id,
+    na_bool_t sent, na_return_t lookup_ret)
 {
-    struct na_sm_addr *na_sm_addr = NULL;
-    struct na_sm_ring_buf *na_sm_ring_buf = NULL;
-    char filename[NA_SM_MAX_FILENAME];
-    int conn_sock, local_notify, remote_notify;
-    hg_time_t now;
-    double elapsed_ms;
+    struct na_sm_addr *na_sm_addr = na_sm_op_id->info.lookup.na_sm_addr;
     na_return_t ret = NA_SUCCESS;
 
-    if (poll_addr != NA_SM_PRIVATE_DATA(na_class)->self_addr) {
-        NA_LOG_ERROR("Unrecognized poll addr");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+    if (lookup_ret == NA_SUCCESS) {
+        /* Add local notify to poll set */
+        lookup_ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, na_sm_addr);
+        if (lookup_ret != NA_SUCCESS)
+            NA_LOG_ERROR("Could not add notify to poll set");
+        else {
+            /* Add addr to poll addr queue */
+            hg_thread_spin_lock(
+                &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
+            HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue,
+                na_sm_addr, poll_entry);
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
+        }
     }
 
-    /* Prevent from entering accept too often */
-    hg_time_get_current(&now);
-    elapsed_ms = hg_time_to_double(hg_time_subtract(now,
-        NA_SM_PRIVATE_DATA(na_class)->last_accept_time)) * 1000.0;
-    if (elapsed_ms < NA_SM_ACCEPT_INTERVAL) {
-        *progressed = NA_FALSE;
-        goto done;
+    if (lookup_ret != NA_SUCCESS) {
+        na_sm_conn_destroy(na_sm_addr);
+        /* Once sent, remote releases the slot when it frees its addr */
+        if (!sent)
+            na_sm_region_release_conn(na_sm_addr->na_sm_region,
+                na_sm_addr->conn_id);
+        na_sm_close_shared_buf(NULL, na_sm_addr->na_sm_region,
+            NA_SM_PRIVATE_DATA(na_class)->region_size);
+        free(na_sm_addr);
+        na_sm_op_id->info.lookup.na_sm_addr = NULL;
     }
-    NA_SM_PRIVATE_DATA(na_class)->last_accept_time = now;
+    na_sm_op_id->info.lookup.ret = lookup_ret;
 
-#ifdef SOCK_NONBLOCK
-    conn_sock = accept4(poll_addr->sock, NULL, NULL, SOCK_NONBLOCK);
-#else
-    conn_sock = accept(poll_addr->sock, NULL, NULL);
-#endif
-    if (conn_sock == -1) {
-        if (errno == EAGAIN) {
-            *progressed = NA_FALSE;
-            goto done;
-        }
-        NA_LOG_ERROR("accept() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
+    /* Add to completion queue, lookup errors are reported to callback */
+    ret = na_sm_complete(na_sm_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
         goto done;
     }
-#ifndef SOCK_NONBLOCK
-    if (fcntl(conn_sock, F_SETFL, O_NONBLOCK) == -1) {
-        NA_LOG_ERROR("fcntl() failed (%s)", strerror(errno));
+
+    /* Notify local completion */
+    hg_atomic_incr32(&NA_SM_PRIVATE_DATA(na_class)->notify_count);
+    if (hg_atomic_get32(&NA_SM_PRIVATE_DATA(na_class)->polling)
+        && (hg_event_set(NA_SM_PRIVATE_DATA(na_class)->self_addr->local_notify)
+        != HG_UTIL_SUCCESS)) {
+        NA_LOG_ERROR("Could not signal local completion");
         ret = NA_PROTOCOL_ERROR;
         goto done;
-    };
-#endif
+    }
 
-    /* Allocate new addr and pass it to poll set */
-    na_sm_addr = (struct na_sm_addr *) malloc(sizeof(struct na_sm_addr));
-    if (!na_sm_addr) {
-        NA_LOG_ERROR("Could not allocate NA SM addr");
-        ret = NA_NOMEM_ERROR;
-        goto done;
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_lookup_retry(na_class_t *na_class, na_bool_t *progressed)
+{
+    struct na_sm_op_id *na_sm_op_id;
+    unsigned int count = 0;
+    na_return_t ret = NA_SUCCESS;
+
+    *progressed = NA_FALSE;
+
+    /* Only go once through lookups that are pending now */
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+    HG_QUEUE_FOREACH(na_sm_op_id,
+        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue, entry)
+        count++;
+    hg_thread_spin_unlock(
+        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+
+    while (count--) {
+        struct na_sm_addr *na_sm_addr;
+        na_bool_t sent = NA_FALSE;
+        na_return_t lookup_ret;
+        hg_time_t now;
+
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+        na_sm_op_id = HG_QUEUE_FIRST(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue);
+        HG_QUEUE_POP_HEAD(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue,
+            entry);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+        if (!na_sm_op_id)
+            /* Canceled or retried by another thread */
+            break;
+        na_sm_addr = na_sm_op_id->info.lookup.na_sm_addr;
+
+        lookup_ret = na_sm_send_conn_info(na_class, na_sm_addr, &sent);
+        if (lookup_ret != NA_SUCCESS)
+            NA_LOG_ERROR("Could not send connection info");
+        else if (!sent) {
+            hg_time_get_current(&now);
+            if (kill(na_sm_addr->pid, 0) == -1 && errno == ESRCH) {
+                NA_LOG_ERROR("Remote process %d no longer exists",
+                    na_sm_addr->pid);
+                lookup_ret = NA_PROTOCOL_ERROR;
+            } else if (hg_time_to_double(hg_time_subtract(now,
+                na_sm_op_id->info.lookup.start)) * 1000.0
+                > NA_SM_CONN_TIMEOUT) {
+                NA_LOG_ERROR("Timed out sending connection info to %d/%u",
+                    na_sm_addr->pid, na_sm_addr->id);
+                lookup_ret = NA_TIMEOUT;
+            } else {
+                /* Remote sock queue is still full */
+                hg_thread_spin_lock(
+                    &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+                HG_QUEUE_PUSH_TAIL(
+                    &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue,
+                    na_sm_op_id, entry);
+                hg_thread_spin_unlock(
+                    &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+                continue;
+            }
+        }
+
+        *progressed = NA_TRUE;
+        ret = na_sm_lookup_finish(na_class, na_sm_op_id, sent, lookup_ret);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not finish lookup");
+            break;
+        }
     }
-    memset(na_sm_addr, 0, sizeof(struct na_sm_addr));
-    hg_atomic_init32(&na_sm_addr->ref_count, 1);
-    na_sm_addr->accepted = NA_TRUE;
-    na_sm_addr->na_sm_copy_buf = poll_addr->na_sm_copy_buf;
-    na_sm_addr->sock = conn_sock;
-    /* We need to receive addr info in sock progress */
-    na_sm_addr->sock_progress = NA_SM_ADDR_INFO;
-
-    /* Add conn_sock to poll set */
-    ret = na_sm_poll_register(na_class, NA_SM_SOCK, na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not add conn_sock to poll set");
-        goto done;
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_iov_translate(struct na_sm_mem_handle *mem_handle, na_offset_t offset,
+    na_size_t length, struct iovec *iov, unsigned long *iovcnt)
+{
+    unsigned long i, new_start_index = 0;
+    na_offset_t new_offset = offset, next_offset = 0;
+    na_size_t remaining_len = length;
+
+    /* Get start index and handle offset */
+    for (i = 0; i < mem_handle->iovcnt; i++) {
+        next_offset += mem_handle->iov[i].iov_len;
+        if (offset < next_offset) {
+            new_start_index = i;
+            break;
+        }
+        new_offset -= mem_handle->iov[i].iov_len;
     }
 
-    /* Set up ring buffer pair (send/recv) for connection IDs */
-    na_sm_addr->conn_id = NA_SM_PRIVATE_DATA(na_class)->self_addr->conn_id;
-    NA_SM_GEN_RING_NAME(filename, NA_SM_SEND_NAME,
-        NA_SM_PRIVATE_DATA(na_class)->self_addr);
-    na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(filename,
-        NA_SM_RING_BUF_SIZE, NA_TRUE);
-    if (!na_sm_ring_buf) {
-        NA_LOG_ERROR("Could not open ring buf");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+    iov[0].iov_base = (char *) mem_handle->iov[new_start_index].iov_base +
+        new_offset;
+    iov[0].iov_len = NA_SM_MIN(remaining_len,
+        mem_handle->iov[new_start_index].iov_len - new_offset);
+    remaining_len -= iov[0].iov_len;
+
+    for (i = 1; remaining_len && (i < mem_handle->iovcnt - new_start_index); i++) {
+        iov[i].iov_base = mem_handle->iov[i + new_start_index].iov_base;
+        /* Can only transfer smallest size */
+        iov[i].iov_len = NA_SM_MIN(remaining_len,
+            mem_handle->iov[i + new_start_index].iov_len);
+
+        /* Decrease remaining len from the len of data */
+        remaining_len -= iov[i].iov_len;
     }
-    /* Initialize ring buffer */
-    na_sm_ring_buf_init(na_sm_ring_buf);
-    na_sm_addr->na_sm_send_ring_buf = na_sm_ring_buf;
 
-    NA_SM_GEN_RING_NAME(filename, NA_SM_RECV_NAME,
-        NA_SM_PRIVATE_DATA(na_class)->self_addr);
-    na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(filename,
-        NA_SM_RING_BUF_SIZE, NA_TRUE);
-    if (!na_sm_ring_buf) {
-        NA_LOG_ERROR("Could not open ring buf");
-        ret = NA_PROTOCOL_ERROR;
+    *iovcnt = i;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_offset_translate(struct na_sm_mem_handle *mem_handle, na_offset_t offset,
+    na_size_t length, struct iovec *iov_buf, struct iovec **iov,
+    unsigned long *iovcnt)
+{
+    struct iovec *new_iov = iov_buf;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Skip this step if not necessary */
+    if (!offset && length == mem_handle->len) {
+        *iov = mem_handle->iov;
+        *iovcnt = mem_handle->iovcnt;
         goto done;
     }
-    /* Initialize ring buffer */
-    na_sm_ring_buf_init(na_sm_ring_buf);
-    na_sm_addr->na_sm_recv_ring_buf = na_sm_ring_buf;
 
-    /* Create local signal event */
-#ifdef HG_UTIL_HAS_SYSEVENTFD_H
-    local_notify = hg_event_create();
-    if (local_notify == HG_UTIL_FAIL) {
-        NA_LOG_ERROR("hg_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+    /* Only allocate if translated iovec may not fit in iov_buf */
+    if (mem_handle->iovcnt > NA_SM_IOV_STATIC_MAX) {
+        new_iov = (struct iovec *) malloc(
+            mem_handle->iovcnt * sizeof(struct iovec));
+        if (!new_iov) {
+            NA_LOG_ERROR("Could not allocate iovec");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
     }
-#else
-    /**
-     * If eventfd is not supported, we need to explicitly use named pipes in
-     * this case as kqueue file descriptors cannot be exchanged through
-     * ancillary data
-     */
-    NA_SM_GEN_FIFO_NAME(filename, NA_SM_RECV_NAME,
-        NA_SM_PRIVATE_DATA(na_class)->self_addr);
-    local_notify = na_sm_event_create(filename);
-    if (local_notify == -1) {
-        NA_LOG_ERROR("na_sm_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
+
+    na_sm_iov_translate(mem_handle, offset, length, new_iov, iovcnt);
+    *iov = new_iov;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_sm_iov_release(struct na_sm_mem_handle *mem_handle, struct iovec *iov_buf,
+    struct iovec *iov)
+{
+    if (iov && iov != iov_buf && iov != mem_handle->iov)
+        free(iov);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_mem_map_get(na_class_t *na_class, struct na_sm_addr *na_sm_addr,
+    struct na_sm_mem_handle *na_sm_mem_handle, na_offset_t offset,
+    na_size_t length, char **ptr)
+{
+    struct na_sm_mem_map *na_sm_mem_map = NULL, *new_mem_map = NULL;
+    size_t start;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Handle comes from the wire, check that it stays within its segment */
+    if ((char *) na_sm_mem_handle->iov[0].iov_base
+        < (char *) na_sm_mem_handle->shm_base) {
+        NA_LOG_ERROR("Remote buffer is not in exported segment");
+        ret = NA_INVALID_PARAM;
         goto done;
     }
-#endif
-    na_sm_addr->local_notify = local_notify;
+    start = (size_t) ((char *) na_sm_mem_handle->iov[0].iov_base
+        - (char *) na_sm_mem_handle->shm_base);
 
-    /* Create remote signal event */
-#ifdef HG_UTIL_HAS_SYSEVENTFD_H
-    remote_notify = hg_event_create();
-    if (remote_notify == HG_UTIL_FAIL) {
-        NA_LOG_ERROR("hg_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+    /* Look for existing mapping */
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->mem_map_lock);
+    HG_LIST_FOREACH(na_sm_mem_map, &na_sm_addr->mem_map_list, entry) {
+        if (na_sm_mem_map->id == na_sm_mem_handle->shm_id)
+            break;
     }
-#else
-    /**
-     * If eventfd is not supported, we need to explicitly use named pipes in
-     * this case as kqueue file descriptors cannot be exchanged through
-     * ancillary data
-     */
-    NA_SM_GEN_FIFO_NAME(filename, NA_SM_SEND_NAME,
-        NA_SM_PRIVATE_DATA(na_class)->self_addr);
-    remote_notify = na_sm_event_create(filename);
-    if (remote_notify == -1) {
-        NA_LOG_ERROR("na_sm_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->mem_map_lock);
+
+    if (!na_sm_mem_map) {
+        char filename[NA_SM_MAX_FILENAME];
+
+        new_mem_map = (struct na_sm_mem_map *) malloc(
+            sizeof(struct na_sm_mem_map));
+        if (!new_mem_map) {
+            NA_LOG_ERROR("Could not allocate NA SM mem map");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        new_mem_map->remote_base = na_sm_mem_handle->shm_base;
+        new_mem_map->size = na_sm_mem_handle->shm_size;
+        new_mem_map->id = na_sm_mem_handle->shm_id;
+
+        /* Map remote segment, fails if it is smaller than advertised */
+        NA_SM_GEN_MEM_NAME(filename, na_sm_addr, na_sm_mem_handle->shm_id);
+        new_mem_map->base = na_sm_open_shared_buf(filename,
+            na_sm_mem_handle->shm_size, NA_FALSE);
+        if (!new_mem_map->base) {
+            NA_LOG_ERROR("Could not map remote segment %s", filename);
+            free(new_mem_map);
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        /* Another thread may have mapped it in the meantime, keep one */
+        hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->mem_map_lock);
+        HG_LIST_FOREACH(na_sm_mem_map, &na_sm_addr->mem_map_list, entry) {
+            if (na_sm_mem_map->id == na_sm_mem_handle->shm_id)
+                break;
+        }
+        if (!na_sm_mem_map) {
+            HG_LIST_INSERT_HEAD(&na_sm_addr->mem_map_list, new_mem_map,
+                entry);
+            na_sm_mem_map = new_mem_map;
+            new_mem_map = NULL;
+        }
+        hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->mem_map_lock);
+
+        if (new_mem_map) {
+            na_sm_close_shared_buf(NULL, new_mem_map->base, new_mem_map->size);
+            free(new_mem_map);
+        }
     }
-#endif
-    na_sm_addr->remote_notify = remote_notify;
 
-    /* Add local notify to poll set */
-    ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not add notify to poll set");
+    /* Check against what is actually mapped */
+    if (na_sm_mem_handle->shm_base != na_sm_mem_map->remote_base
+        || start > na_sm_mem_map->size
+        || offset > na_sm_mem_map->size - start
+        || length > na_sm_mem_map->size - start - offset) {
+        NA_LOG_ERROR("Remote range exceeds exported segment");
+        ret = NA_INVALID_PARAM;
         goto done;
     }
 
-    /* Addr addr to poll addr queue */
-    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
-    HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue,
-        na_sm_addr, poll_entry);
-    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
+    *ptr = (char *) na_sm_mem_map->base + start;
 
-    /* Send connection ID / event IDs */
-    ret = na_sm_send_conn_id(na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not send connection ID");
-        goto done;
-    }
+done:
+    return ret;
+}
 
-    /* Increment connection ID */
-    NA_SM_PRIVATE_DATA(na_class)->self_addr->conn_id++;
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_mem_map_release(struct na_sm_addr *na_sm_addr)
+{
+    na_return_t ret = NA_SUCCESS;
 
-    /* Push the addr to accepted addr queue so that we can free it later */
-    hg_thread_spin_lock(
-        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
-    HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue,
-        na_sm_addr, entry);
-    hg_thread_spin_unlock(
-        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    while (!HG_LIST_IS_EMPTY(&na_sm_addr->mem_map_list)) {
+        struct na_sm_mem_map *na_sm_mem_map =
+            HG_LIST_FIRST(&na_sm_addr->mem_map_list);
 
-    *progressed = NA_TRUE;
+        HG_LIST_REMOVE(na_sm_mem_map, entry);
+
+        /* Owner is responsible for unlinking segment */
+        ret = na_sm_close_shared_buf(NULL, na_sm_mem_map->base,
+            na_sm_mem_map->size);
+        free(na_sm_mem_map);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not unmap remote segment");
+            goto done;
+        }
+    }
 
 done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_sm_memcpy(void *dest, const void *src, size_t n)
+{
+#ifdef __SSE2__
+    if (n >= NA_SM_NT_COPY_THRESHOLD) {
+        char *dest_ptr = (char *) dest;
+        const char *src_ptr = (const char *) src;
+        size_t head = (16 - ((size_t) dest_ptr & 15)) & 15;
+
+        /* Align destination first */
+        memcpy(dest_ptr, src_ptr, head);
+        dest_ptr += head;
+        src_ptr += head;
+        n -= head;
+
+        /* Bypass cache so that large copies do not evict the working set */
+        for (; n >= 64; n -= 64, dest_ptr += 64, src_ptr += 64) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *) src_ptr);
+            __m128i x1 = _mm_loadu_si128((const __m128i *) (src_ptr + 16));
+            __m128i x2 = _mm_loadu_si128((const __m128i *) (src_ptr + 32));
+            __m128i x3 = _mm_loadu_si128((const __m128i *) (src_ptr + 48));
+            _mm_stream_si128((__m128i *) dest_ptr, x0);
+            _mm_stream_si128((__m128i *) (dest_ptr + 16), x1);
+            _mm_stream_si128((__m128i *) (dest_ptr + 32), x2);
+            _mm_stream_si128((__m128i *) (dest_ptr + 48), x3);
+        }
+        _mm_sfence();
+
+        dest = dest_ptr;
+        src = src_ptr;
+    }
+#endif
+    memcpy(dest, src, n);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_iov_copy(const struct iovec *iov, unsigned long iovcnt, char *ptr,
+    na_bool_t to_iov)
+{
+    unsigned long i;
+
+    for (i = 0; i < iovcnt; i++) {
+        if (to_iov)
+            na_sm_memcpy(iov[i].iov_base, ptr, iov[i].iov_len);
+        else
+            na_sm_memcpy(ptr, iov[i].iov_base, iov[i].iov_len);
+        ptr += iov[i].iov_len;
+    }
+}
+
+#ifdef NA_SM_HAS_CMA
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_rma_post(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id)
+{
+    struct na_sm_addr *na_sm_addr = na_sm_op_id->info.rma.na_sm_addr;
+
+    /* Keep addr alive until the operation is issued */
+    hg_atomic_incr32(&na_sm_addr->ref_count);
+
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+    if (!na_sm_addr->rma_pending) {
+        /* Queues are always drained before addr leaves the RMA addr queue */
+        HG_QUEUE_INIT(&na_sm_addr->rma_get_queue);
+        HG_QUEUE_INIT(&na_sm_addr->rma_put_queue);
+        HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->rma_addr_queue,
+            na_sm_addr, rma_entry);
+        na_sm_addr->rma_pending = NA_TRUE;
+    }
+    if (na_sm_op_id->completion_data.callback_info.type == NA_CB_GET)
+        HG_QUEUE_PUSH_TAIL(&na_sm_addr->rma_get_queue, na_sm_op_id, entry);
+    else
+        HG_QUEUE_PUSH_TAIL(&na_sm_addr->rma_put_queue, na_sm_op_id, entry);
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_progress_sock(na_class_t *na_class, struct na_sm_addr *poll_addr,
-    na_bool_t *progressed)
+na_sm_rma_flush(na_class_t *na_class, na_bool_t *progressed)
 {
     na_return_t ret = NA_SUCCESS;
 
-    if (poll_addr == NA_SM_PRIVATE_DATA(na_class)->self_addr) {
-        *progressed = NA_FALSE;
+    *progressed = NA_FALSE;
+
+    /* Batch iovecs are shared, only one thread can flush at a time */
+    if (!hg_atomic_cas32(&NA_SM_PRIVATE_DATA(na_class)->rma_flushing,
+        NA_FALSE, NA_TRUE))
         goto done;
+
+    for (;;) {
+        struct na_sm_addr *na_sm_addr;
+        na_return_t rma_ret;
+
+        hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+        na_sm_addr = HG_QUEUE_FIRST(
+            &NA_SM_PRIVATE_DATA(na_class)->rma_addr_queue);
+        if (na_sm_addr)
+            hg_atomic_incr32(&na_sm_addr->ref_count);
+        hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+        if (!na_sm_addr)
+            break;
+
+        rma_ret = na_sm_rma_process(na_class, na_sm_addr, NA_CB_GET);
+        if (rma_ret != NA_SUCCESS)
+            ret = rma_ret;
+        rma_ret = na_sm_rma_process(na_class, na_sm_addr, NA_CB_PUT);
+        if (rma_ret != NA_SUCCESS)
+            ret = rma_ret;
+
+        /* Remove addr once both queues are drained, more operations may have
+         * been posted in the meantime */
+        hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+        if (HG_QUEUE_IS_EMPTY(&na_sm_addr->rma_get_queue)
+            && HG_QUEUE_IS_EMPTY(&na_sm_addr->rma_put_queue)) {
+            HG_QUEUE_POP_HEAD(&NA_SM_PRIVATE_DATA(na_class)->rma_addr_queue,
+                rma_entry);
+            na_sm_addr->rma_pending = NA_FALSE;
+        }
+        hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+        na_sm_addr_free(na_class, na_sm_addr);
+
+        *progressed = NA_TRUE;
     }
 
-    switch (poll_addr->sock_progress) {
-        case NA_SM_ADDR_INFO: {
-            na_bool_t received = NA_FALSE;
+    hg_atomic_set32(&NA_SM_PRIVATE_DATA(na_class)->rma_flushing, NA_FALSE);
 
-            /* Receive addr info (PID / ID) */
-            ret = na_sm_recv_addr_info(poll_addr, &received);
-            if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not recv addr info");
-                ret = NA_PROTOCOL_ERROR;
-                goto done;
-            }
-            if (!received) {
-                *progressed = NA_FALSE;
-                goto done;
-            }
+done:
+    return ret;
+}
 
-            poll_addr->sock_progress = NA_SM_SOCK_DONE;
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_rma_process(na_class_t *na_class, struct na_sm_addr *na_sm_addr,
+    na_cb_type_t cb_type)
+{
+    struct iovec *local_iov = NA_SM_PRIVATE_DATA(na_class)->rma_local_iov;
+    struct iovec *remote_iov = NA_SM_PRIVATE_DATA(na_class)->rma_remote_iov;
+    unsigned long iov_max = NA_SM_PRIVATE_DATA(na_class)->rma_iov_max;
+    na_return_t ret = NA_SUCCESS;
 
-            /* Progressed */
-            *progressed = NA_TRUE;
+    for (;;) {
+        HG_QUEUE_HEAD(na_sm_op_id) batch_queue =
+            HG_QUEUE_HEAD_INITIALIZER(batch_queue);
+        struct na_sm_op_id *na_sm_op_id;
+        unsigned long liovcnt = 0, riovcnt = 0;
+        ssize_t nbytes;
+
+        /* Take as many operations as the batch iovecs can hold, a single
+         * operation never exceeds IOV_MAX segments */
+        hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+        for (;;) {
+            if (cb_type == NA_CB_GET)
+                na_sm_op_id = HG_QUEUE_FIRST(&na_sm_addr->rma_get_queue);
+            else
+                na_sm_op_id = HG_QUEUE_FIRST(&na_sm_addr->rma_put_queue);
+            if (!na_sm_op_id
+                || liovcnt + na_sm_op_id->info.rma.local_mem_handle->iovcnt
+                    > iov_max
+                || riovcnt + na_sm_op_id->info.rma.remote_mem_handle->iovcnt
+                    > iov_max)
+                break;
+            if (cb_type == NA_CB_GET)
+                HG_QUEUE_POP_HEAD(&na_sm_addr->rma_get_queue, entry);
+            else
+                HG_QUEUE_POP_HEAD(&na_sm_addr->rma_put_queue, entry);
+            HG_QUEUE_PUSH_TAIL(&batch_queue, na_sm_op_id, entry);
+            liovcnt += na_sm_op_id->info.rma.local_mem_handle->iovcnt;
+            riovcnt += na_sm_op_id->info.rma.remote_mem_handle->iovcnt;
         }
-        break;
-        case NA_SM_CONN_ID: {
-            char filename[NA_SM_MAX_FILENAME];
-            struct na_sm_ring_buf *na_sm_ring_buf;
-            struct na_sm_op_id *na_sm_op_id = NULL;
-            na_bool_t received = NA_FALSE;
+        hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+        if (HG_QUEUE_IS_EMPTY(&batch_queue))
+            break;
 
-            /* Receive connection ID / event IDs */
-            ret = na_sm_recv_conn_id(poll_addr, &received);
-            if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not recv connection ID");
-                ret = NA_PROTOCOL_ERROR;
-                goto done;
+        /* A short transfer only fails the operation that contains the
+         * fault, operations that follow are issued again as a new batch */
+        while (!HG_QUEUE_IS_EMPTY(&batch_queue)) {
+            na_bool_t faulted = NA_FALSE, fatal = NA_FALSE;
+
+            /* Translate all operations into a single pair of iovecs */
+            liovcnt = 0;
+            riovcnt = 0;
+            HG_QUEUE_FOREACH(na_sm_op_id, &batch_queue, entry) {
+                struct na_sm_info_rma *na_sm_info_rma =
+                    &na_sm_op_id->info.rma;
+                unsigned long iovcnt;
+
+                na_sm_iov_translate(na_sm_info_rma->local_mem_handle,
+                    na_sm_info_rma->local_offset, na_sm_info_rma->length,
+                    &local_iov[liovcnt], &iovcnt);
+                liovcnt += iovcnt;
+                na_sm_iov_translate(na_sm_info_rma->remote_mem_handle,
+                    na_sm_info_rma->remote_offset, na_sm_info_rma->length,
+                    &remote_iov[riovcnt], &iovcnt);
+                riovcnt += iovcnt;
             }
-            if (!received) {
-                *progressed = NA_FALSE;
-                goto done;
+
+            if (cb_type == NA_CB_GET)
+                nbytes = process_vm_readv(na_sm_addr->pid, local_iov,
+                    liovcnt, remote_iov, riovcnt, /* unused */0);
+            else
+                nbytes = process_vm_writev(na_sm_addr->pid, local_iov,
+                    liovcnt, remote_iov, riovcnt, /* unused */0);
+            if (nbytes < 0) {
+                NA_LOG_ERROR("%s() failed (%s)", (cb_type == NA_CB_GET) ?
+                    "process_vm_readv" : "process_vm_writev",
+                    strerror(errno));
+                /* Only a fault is specific to the first segment, any other
+                 * error fails the entire batch */
+                fatal = (errno != EFAULT);
+                nbytes = 0;
             }
-            poll_addr->sock_progress = NA_SM_SOCK_DONE;
 
-            /* Find op ID that corresponds to addr */
-            hg_thread_spin_lock(
-                &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
-            HG_QUEUE_FOREACH(na_sm_op_id,
-                &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue, entry) {
-                if (na_sm_op_id->info.lookup.na_sm_addr == poll_addr) {
-                    HG_QUEUE_REMOVE(
-                        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue,
-                        na_sm_op_id, na_sm_op_id, entry);
+            /* Transfer stops at the first faulting segment, complete
+             * operations that were entirely covered */
+            while (!HG_QUEUE_IS_EMPTY(&batch_queue)) {
+                na_return_t complete_ret;
+
+                na_sm_op_id = HG_QUEUE_FIRST(&batch_queue);
+                if ((na_size_t) nbytes >= na_sm_op_id->info.rma.length) {
+                    nbytes -= (ssize_t) na_sm_op_id->info.rma.length;
+                    na_sm_op_id->info.rma.ret = NA_SUCCESS;
+                } else if (fatal)
+                    na_sm_op_id->info.rma.ret = NA_PROTOCOL_ERROR;
+                else if (!faulted) {
+                    NA_LOG_ERROR("Transferred %ld bytes, was expecting %lu "
+                        "bytes", nbytes, na_sm_op_id->info.rma.length);
+                    na_sm_op_id->info.rma.ret = NA_SIZE_ERROR;
+                    nbytes = 0;
+                    faulted = NA_TRUE;
+                } else
+                    /* Not attempted, issue again */
                     break;
+                HG_QUEUE_POP_HEAD(&batch_queue, entry);
+
+                complete_ret = na_sm_complete(na_sm_op_id);
+                if (complete_ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    ret = complete_ret;
                 }
-            }
-            hg_thread_spin_unlock(
-                &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
 
-            if (!na_sm_op_id) {
-                NA_LOG_ERROR("Could not find lookup op ID, conn ID=%u, PID=%u",
-                    poll_addr->conn_id, (unsigned int) poll_addr->pid);
-                ret = NA_PROTOCOL_ERROR;
-                goto done;
+                /* Release ref taken when operation was posted */
+                na_sm_addr_free(na_class, na_sm_addr);
             }
+        }
+    }
+
+    return ret;
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+static int
+na_sm_progress_cb(void *arg, unsigned int NA_UNUSED timeout,
+    hg_util_bool_t *progressed)
+{
+    na_class_t *na_class;
+    struct na_sm_poll_data *na_sm_poll_data = (struct na_sm_poll_data *) arg;
+    na_return_t na_ret;
 
-            /* Open remote ring buf pair (send and recv names correspond to
-             * remote ring buffer pair) */
-            NA_SM_GEN_RING_NAME(filename, NA_SM_RECV_NAME, poll_addr);
-            na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(
-                filename, NA_SM_RING_BUF_SIZE, NA_FALSE);
-            if (!na_sm_ring_buf) {
-                NA_LOG_ERROR("Could not open ring buf");
-                ret = NA_PROTOCOL_ERROR;
+    if (!na_sm_poll_data) {
+        NA_LOG_ERROR("NULL SM poll data");
+        na_ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_class = na_sm_poll_data->na_class;
+
+    switch (na_sm_poll_data->type) {
+        case NA_SM_ACCEPT:
+            na_ret = na_sm_progress_accept(na_class, na_sm_poll_data->addr,
+                (hg_util_bool_t *) progressed);
+            if (na_ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on accept");
                 goto done;
             }
-            poll_addr->na_sm_send_ring_buf = na_sm_ring_buf;
-
-            NA_SM_GEN_RING_NAME(filename, NA_SM_SEND_NAME, poll_addr);
-            na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(
-                filename, NA_SM_RING_BUF_SIZE, NA_FALSE);
-            if (!na_sm_ring_buf) {
-                NA_LOG_ERROR("Could not open ring buf");
-                ret = NA_PROTOCOL_ERROR;
+            break;
+        case NA_SM_NOTIFY:
+            na_ret = na_sm_progress_notify(na_class, na_sm_poll_data->addr,
+                (hg_util_bool_t *) progressed);
+            if (na_ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on notify");
                 goto done;
             }
-            poll_addr->na_sm_recv_ring_buf = na_sm_ring_buf;
+            break;
+        default:
+            NA_LOG_ERROR("Unknown poll data type");
+            na_ret = NA_PROTOCOL_ERROR;
+            goto done;
+            break;
+    }
 
-            /* Add received local notify to poll set */
-            ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, poll_addr);
-            if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not add notify to poll set");
-                goto done;
-            }
+done:
+    return (na_ret == NA_SUCCESS) ? HG_UTIL_SUCCESS : HG_UTIL_FAIL;
+}
 
-            /* Add addr to poll addr queue */
-            hg_thread_spin_lock(
-                &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
-            HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue,
-                poll_addr, poll_entry);
-            hg_thread_spin_unlock(
-                &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_progress_accept(na_class_t *na_class, struct na_sm_addr *poll_addr,
+    na_bool_t *progressed)
+{
+    struct na_sm_addr *na_sm_addr = NULL;
+    na_bool_t accepted = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
 
-            /* Completion */
-            ret = na_sm_complete(na_sm_op_id);
-            if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not complete operation");
-                goto done;
-            }
+    if (poll_addr != NA_SM_PRIVATE_DATA(na_class)->self_addr) {
+        NA_LOG_ERROR("Unrecognized poll addr");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
 
-            /* Progressed */
-            *progressed = NA_TRUE;
+    /* Reclaim slots of peers that exited without freeing their addr before
+     * the region runs out of slots */
+    if (na_sm_region_count_conn(poll_addr->na_sm_region)
+        < NA_SM_MAX_PEERS / 16)
+        na_sm_addr_disconnect_dead(na_class);
+
+    /* Drain all pending connection infos at once, peers have already set up
+     * the connection so there is no handshake to wait for */
+    for (;;) {
+        struct na_sm_conn_buf *na_sm_conn_buf = NULL;
+        na_bool_t received = NA_FALSE;
+
+        /* Allocate new addr and pass it to poll set */
+        na_sm_addr = (struct na_sm_addr *) malloc(sizeof(struct na_sm_addr));
+        if (!na_sm_addr) {
+            NA_LOG_ERROR("Could not allocate NA SM addr");
+            ret = NA_NOMEM_ERROR;
+            goto done;
         }
-        break;
-        default:
-            /* TODO Silently ignore, no progress */
-            *progressed = NA_FALSE;
+        memset(na_sm_addr, 0, sizeof(struct na_sm_addr));
+        hg_atomic_init32(&na_sm_addr->ref_count, 1);
+        na_sm_addr->accepted = NA_TRUE;
+        na_sm_addr->na_sm_copy_buf = poll_addr->na_sm_copy_buf;
+        na_sm_addr->sock = -1;
+        na_sm_addr->local_notify = -1;
+        na_sm_addr->remote_notify = -1;
+
+        /* Receive PID / ID, connection ID and event IDs */
+        ret = na_sm_recv_conn_info(poll_addr->sock, na_sm_addr, &received);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not recv connection info");
+            goto done;
+        }
+        if (!received) {
+            free(na_sm_addr);
+            na_sm_addr = NULL;
             break;
+        }
+
+        /* Ring buffer pair was initialized by peer in reserved slot */
+        if (na_sm_addr->conn_id >= NA_SM_MAX_PEERS) {
+            NA_LOG_ERROR("Invalid connection ID (%u)", na_sm_addr->conn_id);
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        na_sm_conn_buf =
+            &poll_addr->na_sm_region->conn_bufs[na_sm_addr->conn_id];
+        na_sm_addr->na_sm_send_ring_buf = &na_sm_conn_buf->send.ring_buf;
+        na_sm_addr->na_sm_recv_ring_buf = &na_sm_conn_buf->recv.ring_buf;
+
+        /* Add received local notify to poll set */
+        ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, na_sm_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not add notify to poll set");
+            goto done;
+        }
+
+        /* Addr addr to poll addr queue */
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue,
+            na_sm_addr, poll_entry);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
+
+        /* Push the addr to accepted addr queue so that we can free it later */
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue,
+            na_sm_addr, entry);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        na_sm_addr = NULL;
+
+        accepted = NA_TRUE;
     }
 
 done:
+    if (ret != NA_SUCCESS && na_sm_addr) {
+        /* Close received descriptors, peer keeps its own copy */
+        if (na_sm_addr->local_notify != -1)
+            close(na_sm_addr->local_notify);
+        if (na_sm_addr->remote_notify != -1)
+            close(na_sm_addr->remote_notify);
+        free(na_sm_addr);
+    }
+    *progressed = accepted;
     return ret;
 }
 
@@ -2145,7 +3352,7 @@ na_sm_progress_notify(na_class_t *na_class, struct na_sm_addr *poll_addr,
     na_bool_t *progressed)
 {
     na_sm_cacheline_hdr_t na_sm_hdr;
-    na_bool_t notified = NA_FALSE, notify_count = NA_FALSE;
+    na_bool_t notified = NA_FALSE, notify_count = NA_FALSE, closed;
     na_return_t ret = NA_SUCCESS;
 
     if (poll_addr == NA_SM_PRIVATE_DATA(na_class)->self_addr) {
@@ -2199,8 +3406,14 @@ na_sm_progress_notify(na_class_t *na_class, struct na_sm_addr *poll_addr,
         goto done;
     }
 
+    /* Read closed flag first so that messages pushed before the peer closed
+     * the connection are still popped */
+    closed = hg_atomic_get32(&poll_addr->na_sm_recv_ring_buf->closed.val);
+
     if (!na_sm_ring_buf_pop(poll_addr->na_sm_recv_ring_buf, &na_sm_hdr)) {
-        *progressed = NA_FALSE;
+        /* Peer freed its addr, tear down accepted connection */
+        *progressed = (closed && poll_addr->accepted) ?
+            na_sm_addr_disconnect(na_class, poll_addr) : NA_FALSE;
         goto done;
     }
 
@@ -2222,12 +3435,136 @@ na_sm_progress_notify(na_class_t *na_class, struct na_sm_addr *poll_addr,
             ret = NA_PROTOCOL_ERROR;
             break;
     }
-    *progressed = NA_TRUE;
+    *progressed = NA_TRUE;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_sm_addr_disconnect(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
+{
+    na_bool_t disconnected = NA_FALSE;
+
+    hg_thread_spin_lock(
+        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    if (!na_sm_addr->disconnected) {
+        HG_QUEUE_REMOVE(&NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue,
+            na_sm_addr, na_sm_addr, entry);
+        HG_QUEUE_PUSH_TAIL(
+            &NA_SM_PRIVATE_DATA(na_class)->disconnected_addr_queue,
+            na_sm_addr, entry);
+        na_sm_addr->disconnected = NA_TRUE;
+        disconnected = NA_TRUE;
+    }
+    hg_thread_spin_unlock(
+        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+
+    return disconnected;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_addr_disconnect_dead(na_class_t *na_class)
+{
+    struct na_sm_addr *na_sm_addr, *next;
+
+    hg_thread_spin_lock(
+        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    na_sm_addr = HG_QUEUE_FIRST(
+        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue);
+    while (na_sm_addr) {
+        next = HG_QUEUE_NEXT(na_sm_addr, entry);
+        /* Peer exited without freeing its addr */
+        if (kill(na_sm_addr->pid, 0) == -1 && errno == ESRCH) {
+            HG_QUEUE_REMOVE(
+                &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue,
+                na_sm_addr, na_sm_addr, entry);
+            HG_QUEUE_PUSH_TAIL(
+                &NA_SM_PRIVATE_DATA(na_class)->disconnected_addr_queue,
+                na_sm_addr, entry);
+            na_sm_addr->disconnected = NA_TRUE;
+        }
+        na_sm_addr = next;
+    }
+    hg_thread_spin_unlock(
+        &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_addr_release_disconnected(na_class_t *na_class, na_bool_t *progressed)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    *progressed = NA_FALSE;
+
+    for (;;) {
+        struct na_sm_addr *na_sm_addr;
+
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        na_sm_addr = HG_QUEUE_FIRST(
+            &NA_SM_PRIVATE_DATA(na_class)->disconnected_addr_queue);
+        if (na_sm_addr)
+            HG_QUEUE_POP_HEAD(
+                &NA_SM_PRIVATE_DATA(na_class)->disconnected_addr_queue, entry);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        if (!na_sm_addr)
+            break;
+
+        /* Drop accepted queue reference, addr may still be in use by the
+         * upper layer (e.g., unexpected source) */
+        ret = na_sm_addr_free(na_class, (na_addr_t) na_sm_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not free disconnected addr");
+            break;
+        }
+        *progressed = NA_TRUE;
+    }
 
-done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static NA_INLINE struct na_sm_unexpected_info *
+na_sm_unexpected_info_get(na_class_t *na_class)
+{
+    struct na_sm_unexpected_info *na_sm_unexpected_info;
+
+    na_sm_unexpected_info = (struct na_sm_unexpected_info *)
+        hg_atomic_queue_pop_mc(
+            NA_SM_PRIVATE_DATA(na_class)->unexpected_info_free_queue);
+    if (!na_sm_unexpected_info) {
+        /* Pool exhausted (more early arrivals than max_unexpected) */
+        NA_LOG_DEBUG("Unexpected info pool exhausted, allocating");
+        na_sm_unexpected_info = (struct na_sm_unexpected_info *) malloc(
+            sizeof(struct na_sm_unexpected_info));
+    }
+
+    return na_sm_unexpected_info;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_sm_unexpected_info_release(na_class_t *na_class,
+    struct na_sm_unexpected_info *na_sm_unexpected_info)
+{
+    struct na_sm_unexpected_info *pool =
+        NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool;
+
+    if (na_sm_unexpected_info >= pool && na_sm_unexpected_info
+        < pool + NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool_size)
+        /* Cannot fail, queue can hold all descriptors of the pool */
+        hg_atomic_queue_push(
+            NA_SM_PRIVATE_DATA(na_class)->unexpected_info_free_queue,
+            na_sm_unexpected_info);
+    else
+        free(na_sm_unexpected_info);
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_progress_unexpected(na_class_t *na_class, struct na_sm_addr *poll_addr,
@@ -2261,8 +3598,7 @@ na_sm_progress_unexpected(na_class_t *na_class, struct na_sm_addr *poll_addr,
     } else {
         /* If no error and message arrived, keep a copy of the struct in
          * the unexpected message queue (should rarely happen) */
-        na_sm_unexpected_info = (struct na_sm_unexpected_info *) malloc(
-            sizeof(struct na_sm_unexpected_info));
+        na_sm_unexpected_info = na_sm_unexpected_info_get(na_class);
         if (!na_sm_unexpected_info) {
             NA_LOG_ERROR("Could not allocate unexpected info");
             ret = NA_NOMEM_ERROR;
@@ -2342,10 +3678,14 @@ na_sm_complete(struct na_sm_op_id *na_sm_op_id)
 
     switch (callback_info->type) {
         case NA_CB_LOOKUP:
+            if (!canceled)
+                callback_info->ret = na_sm_op_id->info.lookup.ret;
             callback_info->info.lookup.addr =
                 (na_addr_t) na_sm_op_id->info.lookup.na_sm_addr;
             break;
         case NA_CB_SEND_UNEXPECTED:
+            if (!canceled)
+                callback_info->ret = na_sm_op_id->info.send.ret;
             break;
         case NA_CB_RECV_UNEXPECTED: {
             struct na_sm_unexpected_info *na_sm_unexpected_info =
@@ -2380,12 +3720,15 @@ na_sm_complete(struct na_sm_op_id *na_sm_op_id)
             break;
         }
         case NA_CB_SEND_EXPECTED:
+            if (!canceled)
+                callback_info->ret = na_sm_op_id->info.send.ret;
             break;
         case NA_CB_RECV_EXPECTED:
             break;
         case NA_CB_PUT:
-            break;
         case NA_CB_GET:
+            if (!canceled)
+                callback_info->ret = na_sm_op_id->info.rma.ret;
             break;
         default:
             NA_LOG_ERROR("Operation not supported");
@@ -2419,6 +3762,31 @@ na_sm_release(void *arg)
     na_sm_op_destroy(NULL, na_sm_op_id);
 }
 
+/*---------------------------------------------------------------------------*/
+static struct na_sm_op_id *
+na_sm_op_alloc(na_class_t *na_class, na_context_t *context)
+{
+    struct na_sm_op_id *na_sm_op_id = NULL;
+
+    na_sm_op_id = (struct na_sm_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_sm_op_id));
+    if (!na_sm_op_id) {
+        NA_LOG_ERROR("Could not allocate NA SM operation ID");
+        goto done;
+    }
+    memset(na_sm_op_id, 0, sizeof(struct na_sm_op_id));
+    na_sm_op_id->na_class = na_class;
+    hg_atomic_init32(&na_sm_op_id->ref_count, 1);
+    hg_atomic_init32(&na_sm_op_id->completed, NA_TRUE); /* Completed by default */
+
+    /* Set op ID release callbacks */
+    na_sm_op_id->completion_data.plugin_callback = na_sm_release;
+    na_sm_op_id->completion_data.plugin_callback_args = na_sm_op_id;
+
+done:
+    return na_sm_op_id;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_bool_t
 na_sm_check_protocol(const char *protocol_name)
@@ -2433,14 +3801,16 @@ na_sm_check_protocol(const char *protocol_name)
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
+na_sm_initialize(na_class_t *na_class, const struct na_info *na_info,
     na_bool_t listen)
 {
     static hg_atomic_int32_t id = HG_ATOMIC_VAR_INIT(0);
     struct na_sm_addr *na_sm_addr = NULL;
+    size_t region_align;
+    unsigned int pool_size, queue_size, i;
     pid_t pid;
     hg_poll_set_t *poll_set;
-    int local_notify;
+    int local_notify, conn_sock;
     na_return_t ret = NA_SUCCESS;
 
     /* TODO parse host name */
@@ -2461,6 +3831,79 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
     memset(na_class->private_data, 0, sizeof(struct na_sm_private_data));
     hg_atomic_init32(&NA_SM_PRIVATE_DATA(na_class)->polling, NA_FALSE);
     hg_atomic_init32(&NA_SM_PRIVATE_DATA(na_class)->notify_count, 0);
+    hg_atomic_init32(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_id, 0);
+    hg_atomic_init32(&NA_SM_PRIVATE_DATA(na_class)->rma_flushing, NA_FALSE);
+    NA_SM_PRIVATE_DATA(na_class)->conn_sock = -1;
+    NA_SM_PRIVATE_DATA(na_class)->use_huge_pages =
+        na_info->na_init_info.use_huge_pages;
+
+    /* Round region size to huge page size (if any) so that listeners and
+     * peers agree on it whatever pages back the region */
+    region_align = (size_t) hg_mem_get_page_size();
+    if (hg_mem_get_huge_page_size() > (long) region_align)
+        region_align = (size_t) hg_mem_get_huge_page_size();
+    NA_SM_PRIVATE_DATA(na_class)->region_size =
+        (sizeof(struct na_sm_region) + region_align - 1) / region_align
+        * region_align;
+
+    /* Preallocate unexpected infos so that progress does not need to
+     * allocate them when messages arrive before recvs are posted */
+    pool_size = (na_info->na_init_info.max_unexpected) ?
+        na_info->na_init_info.max_unexpected : NA_SM_UNEXPECTED_POOL_SIZE;
+    NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool =
+        (struct na_sm_unexpected_info *) malloc(
+            pool_size * sizeof(struct na_sm_unexpected_info));
+    if (!NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool) {
+        NA_LOG_ERROR("Could not allocate unexpected info pool");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool_size = pool_size;
+
+    /* Atomic queue must be a power of 2 and holds one less entry */
+    for (queue_size = 2; queue_size <= pool_size; queue_size <<= 1);
+    NA_SM_PRIVATE_DATA(na_class)->unexpected_info_free_queue =
+        hg_atomic_queue_alloc(queue_size);
+    if (!NA_SM_PRIVATE_DATA(na_class)->unexpected_info_free_queue) {
+        NA_LOG_ERROR("Could not allocate unexpected info queue");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    for (i = 0; i < pool_size; i++)
+        hg_atomic_queue_push(
+            NA_SM_PRIVATE_DATA(na_class)->unexpected_info_free_queue,
+            &NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool[i]);
+
+#ifdef NA_SM_HAS_CMA
+    /* Allocate iovecs used to merge pending RMA operations */
+    NA_SM_PRIVATE_DATA(na_class)->rma_iov_max =
+        (unsigned long) sysconf(_SC_IOV_MAX);
+    NA_SM_PRIVATE_DATA(na_class)->rma_local_iov = (struct iovec *) malloc(
+        NA_SM_PRIVATE_DATA(na_class)->rma_iov_max * sizeof(struct iovec));
+    NA_SM_PRIVATE_DATA(na_class)->rma_remote_iov = (struct iovec *) malloc(
+        NA_SM_PRIVATE_DATA(na_class)->rma_iov_max * sizeof(struct iovec));
+    if (!NA_SM_PRIVATE_DATA(na_class)->rma_local_iov
+        || !NA_SM_PRIVATE_DATA(na_class)->rma_remote_iov) {
+        NA_LOG_ERROR("Could not allocate RMA iovecs");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+#endif
+
+    /* Map node-local registry */
+    ret = na_sm_registry_open(na_class);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not open registry");
+        goto done;
+    }
+
+    /* Create sock used to send connection info to remote addrs */
+    ret = na_sm_create_sock(NULL, NA_FALSE, &conn_sock);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not create sock");
+        goto done;
+    }
+    NA_SM_PRIVATE_DATA(na_class)->conn_sock = conn_sock;
 
     /* Create poll set to wait for events */
     poll_set = hg_poll_create();
@@ -2482,6 +3925,7 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
     na_sm_addr->pid = pid;
     na_sm_addr->id = (unsigned int) hg_atomic_incr32(&id) - 1;
     na_sm_addr->self = NA_TRUE;
+    na_sm_addr->sock = -1;
     hg_atomic_init32(&na_sm_addr->ref_count, 1);
     /* If we're listening, create a new shm region */
     if (listen) {
@@ -2510,11 +3954,15 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
 
     /* Initialize queues */
     HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue);
+    HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->disconnected_addr_queue);
     HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue);
     HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->unexpected_msg_queue);
-    HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue);
     HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->unexpected_op_queue);
     HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->expected_op_queue);
+    HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue);
+    HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue);
+    HG_LIST_INIT(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list);
+    HG_QUEUE_INIT(&NA_SM_PRIVATE_DATA(na_class)->rma_addr_queue);
 
     /* Initialize mutexes */
     hg_thread_spin_init(
@@ -2523,16 +3971,27 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
             &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
     hg_thread_spin_init(
             &NA_SM_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
-    hg_thread_spin_init(
-            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
     hg_thread_spin_init(
             &NA_SM_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
     hg_thread_spin_init(
             &NA_SM_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    hg_thread_spin_init(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+    hg_thread_spin_init(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
     hg_thread_spin_init(
              &NA_SM_PRIVATE_DATA(na_class)->copy_buf_lock);
+    hg_thread_spin_init(
+             &NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
+    hg_thread_spin_init(
+             &NA_SM_PRIVATE_DATA(na_class)->mem_map_lock);
+    hg_thread_spin_init(
+             &NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
 
 done:
+    /* Do not keep registry attached, it would never be unlinked */
+    if (ret != NA_SUCCESS && na_class->private_data)
+        na_sm_registry_close(na_class);
     return ret;
 }
 
@@ -2540,19 +3999,13 @@ done:
 static na_return_t
 na_sm_finalize(na_class_t *na_class)
 {
+    na_bool_t released;
     na_return_t ret = NA_SUCCESS;
 
     if (!na_class->private_data) {
         goto done;
     }
 
-    /* Check that lookup op queue is empty */
-    if (!HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue)) {
-        NA_LOG_ERROR("Lookup op queue should be empty");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-
     /* Check that unexpected op queue is empty */
     if (!HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->unexpected_op_queue)) {
         NA_LOG_ERROR("Unexpected op queue should be empty");
@@ -2574,6 +4027,41 @@ na_sm_finalize(na_class_t *na_class)
         goto done;
     }
 
+    /* Check that all lookups have been completed */
+    if (!HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue)) {
+        NA_LOG_ERROR("Lookup op queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that all sends have been issued */
+    if (!HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->send_op_queue)) {
+        NA_LOG_ERROR("Send op queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that all RMA operations have been issued */
+    if (!HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->rma_addr_queue)) {
+        NA_LOG_ERROR("RMA addr queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that all segments have been freed */
+    if (!HG_LIST_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list)) {
+        NA_LOG_ERROR("Memory segment list should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Free addrs of closed connections */
+    ret = na_sm_addr_release_disconnected(na_class, &released);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not release disconnected addrs");
+        goto done;
+    }
+
     /* Check that accepted addr queue is empty */
     while (!HG_QUEUE_IS_EMPTY(&NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue)) {
         struct na_sm_addr *na_sm_addr = HG_QUEUE_FIRST(
@@ -2600,6 +4088,20 @@ na_sm_finalize(na_class_t *na_class)
         goto done;
     }
 
+    /* Close connection sock */
+    ret = na_sm_close_sock(NA_SM_PRIVATE_DATA(na_class)->conn_sock, NULL);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not close sock");
+        goto done;
+    }
+
+    /* Unmap registry */
+    ret = na_sm_registry_close(na_class);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not close registry");
+        goto done;
+    }
+
     /* Destroy mutexes */
     hg_thread_spin_destroy(
             &NA_SM_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
@@ -2607,14 +4109,28 @@ na_sm_finalize(na_class_t *na_class)
             &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
     hg_thread_spin_destroy(
             &NA_SM_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
-    hg_thread_spin_destroy(
-            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
     hg_thread_spin_destroy(
             &NA_SM_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
     hg_thread_spin_destroy(
             &NA_SM_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    hg_thread_spin_destroy(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+    hg_thread_spin_destroy(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
     hg_thread_spin_destroy(
              &NA_SM_PRIVATE_DATA(na_class)->copy_buf_lock);
+    hg_thread_spin_destroy(
+             &NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
+    hg_thread_spin_destroy(
+             &NA_SM_PRIVATE_DATA(na_class)->mem_map_lock);
+    hg_thread_spin_destroy(
+             &NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+
+    free(NA_SM_PRIVATE_DATA(na_class)->rma_local_iov);
+    free(NA_SM_PRIVATE_DATA(na_class)->rma_remote_iov);
+    hg_atomic_queue_free(
+        NA_SM_PRIVATE_DATA(na_class)->unexpected_info_free_queue);
+    free(NA_SM_PRIVATE_DATA(na_class)->unexpected_info_pool);
 
     free(na_class->private_data);
 
@@ -2664,24 +4180,7 @@ na_sm_check_feature(na_class_t NA_UNUSED *na_class, na_uint8_t feature)
 static na_op_id_t
 na_sm_op_create(na_class_t *na_class)
 {
-    struct na_sm_op_id *na_sm_op_id = NULL;
-
-    na_sm_op_id = (struct na_sm_op_id *) malloc(sizeof(struct na_sm_op_id));
-    if (!na_sm_op_id) {
-        NA_LOG_ERROR("Could not allocate NA SM operation ID");
-        goto done;
-    }
-    memset(na_sm_op_id, 0, sizeof(struct na_sm_op_id));
-    na_sm_op_id->na_class = na_class;
-    hg_atomic_init32(&na_sm_op_id->ref_count, 1);
-    hg_atomic_init32(&na_sm_op_id->completed, NA_TRUE); /* Completed by default */
-
-    /* Set op ID release callbacks */
-    na_sm_op_id->completion_data.plugin_callback = na_sm_release;
-    na_sm_op_id->completion_data.plugin_callback_args = na_sm_op_id;
-
-done:
-    return (na_op_id_t) na_sm_op_id;
+    return (na_op_id_t) na_sm_op_alloc(na_class, NULL);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2695,7 +4194,7 @@ na_sm_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
         /* Cannot free yet */
         goto done;
     }
-    free(na_sm_op_id);
+    na_op_id_free(na_sm_op_id);
 
 done:
     return ret;
@@ -2708,10 +4207,10 @@ na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
     struct na_sm_addr *na_sm_addr = NULL;
-    struct na_sm_copy_buf *na_sm_copy_buf = NULL;
+    struct na_sm_region *na_sm_region = NULL;
+    struct na_sm_registry_entry *na_sm_registry_entry = NULL;
     char filename[NA_SM_MAX_FILENAME];
-    char pathname[NA_SM_MAX_FILENAME];
-    int conn_sock;
+    na_bool_t reserved = NA_FALSE, sent = NA_FALSE, completed = NA_FALSE;
     char *name_string = NULL, *short_name = NULL;
     na_return_t ret = NA_SUCCESS;
 
@@ -2720,7 +4219,7 @@ na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -2743,6 +4242,9 @@ na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
     }
     memset(na_sm_addr, 0, sizeof(struct na_sm_addr));
     hg_atomic_init32(&na_sm_addr->ref_count, 1);
+    na_sm_addr->sock = -1;
+    na_sm_addr->local_notify = -1;
+    na_sm_addr->remote_notify = -1;
     na_sm_op_id->info.lookup.na_sm_addr = na_sm_addr;
 
     /**
@@ -2764,57 +4266,86 @@ na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
     /* Get PID / ID from name */
     sscanf(short_name, "%d/%u", &na_sm_addr->pid, &na_sm_addr->id);
 
-    /* Open shared copy buf */
+    /* Find remote addr in registry */
+    na_sm_registry_entry = na_sm_registry_lookup(
+        NA_SM_PRIVATE_DATA(na_class)->registry, na_sm_addr->pid,
+        na_sm_addr->id);
+    if (!na_sm_registry_entry) {
+        NA_LOG_ERROR("Could not find %d/%u in registry", na_sm_addr->pid,
+            na_sm_addr->id);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Open shared region */
     NA_SM_GEN_SHM_NAME(filename, na_sm_addr);
-    na_sm_copy_buf = (struct na_sm_copy_buf *) na_sm_open_shared_buf(
-        filename, sizeof(struct na_sm_copy_buf), NA_FALSE);
-    if (!na_sm_copy_buf) {
-        NA_LOG_ERROR("Could not open copy buf");
+    na_sm_region = na_sm_region_open(na_class, filename, NA_FALSE);
+    if (!na_sm_region) {
+        NA_LOG_ERROR("Could not open shared region");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
-    na_sm_addr->na_sm_copy_buf = na_sm_copy_buf;
+    na_sm_addr->na_sm_region = na_sm_region;
+    na_sm_addr->na_sm_copy_buf = &na_sm_region->copy_buf;
 
-    /* Open SHM sock */
-    NA_SM_GEN_SOCK_PATH(pathname, na_sm_addr);
-    ret = na_sm_create_sock(pathname, NA_FALSE, &conn_sock);
+    /* Reserve connection slot and set up connection on our side, remote will
+     * only have to attach to it */
+    ret = na_sm_region_reserve_conn(na_sm_region, &na_sm_addr->conn_id);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not create sock");
+        NA_LOG_ERROR("Could not reserve connection slot");
+        goto done;
+    }
+    reserved = NA_TRUE;
+    ret = na_sm_conn_create(na_sm_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not create connection");
         goto done;
     }
-    na_sm_addr->sock = conn_sock;
-    /* We only need to receive conn ID in sock progress */
-    na_sm_addr->sock_progress = NA_SM_CONN_ID;
 
-    /* Push op ID to lookup op queue */
-    hg_thread_spin_lock(
-        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
-    HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue,
-        na_sm_op_id, entry);
-    hg_thread_spin_unlock(
-        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+    /* Send connection info (PID / ID, connection ID and event IDs) */
+    ret = na_sm_send_conn_info(na_class, na_sm_addr, &sent);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not send connection info");
+        goto done;
+    }
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
+    completed = NA_TRUE;
 
-    /* Add conn_sock to poll set */
-    ret = na_sm_poll_register(na_class, NA_SM_SOCK, na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not add conn_sock to poll set");
+    if (!sent) {
+        /* Remote sock queue is full, retry on progress for a bounded time */
+        hg_time_get_current(&na_sm_op_id->info.lookup.start);
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue,
+            na_sm_op_id, entry);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
         goto done;
     }
 
-    /* Send addr info (PID / ID) */
-    ret = na_sm_send_addr_info(na_class, na_sm_addr);
+    /* Register addr and complete */
+    ret = na_sm_lookup_finish(na_class, na_sm_op_id, NA_TRUE, NA_SUCCESS);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not send addr info");
+        NA_LOG_ERROR("Could not finish lookup");
         goto done;
     }
 
 done:
-    if (ret != NA_SUCCESS) {
-        free(na_sm_addr);
+    /* Once handed over, addr and op ID are released by the user callback */
+    if (ret != NA_SUCCESS && !completed) {
+        if (na_sm_addr) {
+            na_sm_conn_destroy(na_sm_addr);
+            /* Once sent, remote releases the slot when it frees its addr */
+            if (reserved && !sent)
+                na_sm_region_release_conn(na_sm_region, na_sm_addr->conn_id);
+            if (na_sm_region)
+                na_sm_close_shared_buf(NULL, na_sm_region,
+                    NA_SM_PRIVATE_DATA(na_class)->region_size);
+            free(na_sm_addr);
+        }
         na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
     }
     free(name_string);
@@ -2826,11 +4357,8 @@ static na_return_t
 na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
 {
     struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) addr;
-    const char *copy_buf_name = NULL, *send_ring_buf_name = NULL,
-        *recv_ring_buf_name = NULL, *pathname = NULL;
-    char na_sm_copy_buf_name[NA_SM_MAX_FILENAME],
-        na_sm_send_ring_buf_name[NA_SM_MAX_FILENAME],
-        na_sm_recv_ring_buf_name[NA_SM_MAX_FILENAME],
+    const char *region_name = NULL, *pathname = NULL;
+    char na_sm_region_name[NA_SM_MAX_FILENAME],
         na_sock_name[NA_SM_MAX_FILENAME];
     na_return_t ret = NA_SUCCESS;
 
@@ -2868,13 +4396,6 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
         const char *local_event_name = NULL, *remote_event_name = NULL;
 #endif
 
-        /* Deregister sock file descriptor */
-        ret = na_sm_poll_deregister(na_class, NA_SM_SOCK, na_sm_addr);
-        if (ret != NA_SUCCESS) {
-            NA_LOG_ERROR("Could not delete sock from poll set");
-            goto done;
-        }
-
         /* Remove addr from poll addr queue */
         hg_thread_spin_lock(
             &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
@@ -2883,20 +4404,23 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
         hg_thread_spin_unlock(
             &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
 
-        if (na_sm_addr->accepted) { /* Create by accept */
-            /* Get file names from ring bufs / events to delete files */
-            sprintf(na_sm_send_ring_buf_name, "%s-%d-%d-%d-%s",
-                NA_SM_SHM_PREFIX, NA_SM_PRIVATE_DATA(na_class)->self_addr->pid,
-                NA_SM_PRIVATE_DATA(na_class)->self_addr->id,
-                na_sm_addr->conn_id, NA_SM_SEND_NAME);
-            sprintf(na_sm_recv_ring_buf_name, "%s-%d-%d-%d-%s",
-                NA_SM_SHM_PREFIX, NA_SM_PRIVATE_DATA(na_class)->self_addr->pid,
-                NA_SM_PRIVATE_DATA(na_class)->self_addr->id,
-                na_sm_addr->conn_id, NA_SM_RECV_NAME);
-            send_ring_buf_name = na_sm_send_ring_buf_name;
-            recv_ring_buf_name = na_sm_recv_ring_buf_name;
+        /* Tell remote that the connection is closed, listener releases the
+         * connection slot once it has seen it */
+        hg_atomic_set32(&na_sm_addr->na_sm_send_ring_buf->closed.val, NA_TRUE);
+        hg_atomic_incr32(&na_sm_addr->na_sm_send_ring_buf->notify_count.val);
+        if (hg_atomic_get32(&na_sm_addr->na_sm_send_ring_buf->polling.val)) {
+#ifdef HG_UTIL_HAS_SYSEVENTFD_H
+            if (hg_event_set(na_sm_addr->remote_notify) != HG_UTIL_SUCCESS)
+                NA_LOG_ERROR("Could not send close notification");
+#else
+            if (na_sm_event_set(na_sm_addr->remote_notify) != NA_SUCCESS)
+                NA_LOG_ERROR("Could not send close notification");
+#endif
+        }
 
+        if (na_sm_addr->accepted) { /* Create by accept */
 #ifndef HG_UTIL_HAS_SYSEVENTFD_H
+            /* Get file names from events to delete files */
             sprintf(na_sm_local_event_name, "%s/%s/%d/%u/fifo-%u-%s",
                 NA_SM_TMP_DIRECTORY, NA_SM_SHM_PREFIX,
                 NA_SM_PRIVATE_DATA(na_class)->self_addr->pid,
@@ -2944,47 +4468,50 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
         }
 #endif
         if (na_sm_addr->na_sm_copy_buf) { /* Self addr and listen */
+            /* Unpublish first so that peers stop attaching */
+            if (na_sm_addr->registry_entry)
+                na_sm_registry_remove(na_sm_addr->registry_entry);
+
             ret = na_sm_poll_deregister(na_class, NA_SM_ACCEPT, na_sm_addr);
             if (ret != NA_SUCCESS) {
                 NA_LOG_ERROR("Could not delete listen from poll set");
                 goto done;
             }
 
-            NA_SM_GEN_SHM_NAME(na_sm_copy_buf_name, na_sm_addr);
-            copy_buf_name = na_sm_copy_buf_name;
+            NA_SM_GEN_SHM_NAME(na_sm_region_name, na_sm_addr);
+            region_name = na_sm_region_name;
             NA_SM_GEN_SOCK_PATH(na_sock_name, na_sm_addr);
             pathname = na_sock_name;
         }
     }
 
     /* Close sock (delete also tmp dir if pathname is set) */
-    ret = na_sm_close_sock(na_sm_addr->sock, pathname);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not close sock");
-        goto done;
+    if (na_sm_addr->sock != -1) {
+        ret = na_sm_close_sock(na_sm_addr->sock, pathname);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not close sock");
+            goto done;
+        }
     }
 
-    /* Close ring buf (send) */
-    ret = na_sm_close_shared_buf(send_ring_buf_name,
-        na_sm_addr->na_sm_send_ring_buf, sizeof(struct na_sm_ring_buf));
+    /* Unmap remote segments */
+    ret = na_sm_mem_map_release(na_sm_addr);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not close send ring buffer");
+        NA_LOG_ERROR("Could not release remote segments");
         goto done;
     }
 
-    /* Close ring buf (recv) */
-    ret = na_sm_close_shared_buf(recv_ring_buf_name,
-        na_sm_addr->na_sm_recv_ring_buf, sizeof(struct na_sm_ring_buf));
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not close recv ring buffer");
-        goto done;
-    }
+    /* Slot can be reused by other peers once events are destroyed */
+    if (na_sm_addr->accepted)
+        na_sm_region_release_conn(
+            NA_SM_PRIVATE_DATA(na_class)->self_addr->na_sm_region,
+            na_sm_addr->conn_id);
 
-    /* Close copy buf */
-    ret = na_sm_close_shared_buf(copy_buf_name, na_sm_addr->na_sm_copy_buf,
-        sizeof(struct na_sm_copy_buf));
+    /* Close shared region (accepted addrs share the one of self addr) */
+    ret = na_sm_close_shared_buf(region_name, na_sm_addr->na_sm_region,
+        NA_SM_PRIVATE_DATA(na_class)->region_size);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not close copy buffer");
+        NA_LOG_ERROR("Could not close shared region");
         goto done;
     }
 
@@ -3091,8 +4618,6 @@ na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
     na_op_id_t *op_id)
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
-    struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) dest;
-    unsigned int idx_reserved;
     na_return_t ret = NA_SUCCESS;
 
     if (buf_size > NA_SM_UNEXPECTED_SIZE) {
@@ -3106,7 +4631,7 @@ na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -3119,33 +4644,20 @@ na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
     na_sm_op_id->completion_data.callback_info.arg = arg;
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
+    na_sm_op_id->info.send.buf = buf;
+    na_sm_op_id->info.send.buf_size = buf_size;
+    na_sm_op_id->info.send.na_sm_addr = (struct na_sm_addr *) dest;
+    na_sm_op_id->info.send.tag = tag;
+    na_sm_op_id->info.send.ret = NA_SUCCESS;
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
 
-    /* Try to reserve buffer atomically */
-    do {
-        ret = na_sm_reserve_and_copy_buf(na_class, na_sm_addr->na_sm_copy_buf,
-            buf, buf_size, &idx_reserved);
-        if (ret != NA_SUCCESS) {
-            na_return_t progress_ret = na_sm_progress(na_class, context, 0);
-
-            if (progress_ret != NA_SUCCESS && progress_ret != NA_TIMEOUT) {
-                NA_LOG_ERROR("Could not make progress");
-                ret = progress_ret;
-                goto done;
-            }
-            continue;
-        }
-        break;
-    } while (1);
-
-    /* Insert message into ring buffer (complete OP ID) */
-    ret = na_sm_msg_insert(na_class, na_sm_op_id, NA_CB_RECV_UNEXPECTED,
-        na_sm_addr, idx_reserved, buf_size, tag);
+    /* Send now or once a copy buf is available (complete OP ID) */
+    ret = na_sm_msg_send(na_class, na_sm_op_id);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not insert message");
+        NA_LOG_ERROR("Could not send message");
         goto done;
     }
 
@@ -3177,7 +4689,7 @@ na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -3210,7 +4722,7 @@ na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
     if (na_sm_unexpected_info) {
         na_sm_op_id->info.recv_unexpected.unexpected_info =
             *na_sm_unexpected_info;
-        free(na_sm_unexpected_info);
+        na_sm_unexpected_info_release(na_class, na_sm_unexpected_info);
 
         ret = na_sm_complete(na_sm_op_id);
         if (ret != NA_SUCCESS) {
@@ -3236,14 +4748,12 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_msg_send_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
+na_sm_msg_send_expected(na_class_t *na_class, na_context_t *context,
     na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
     void NA_UNUSED *plugin_data, na_addr_t dest, na_tag_t tag,
     na_op_id_t *op_id)
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
-    struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) dest;
-    unsigned int idx_reserved;
     na_return_t ret = NA_SUCCESS;
 
     if (buf_size > NA_SM_EXPECTED_SIZE) {
@@ -3257,7 +4767,7 @@ na_sm_msg_send_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -3270,33 +4780,20 @@ na_sm_msg_send_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
     na_sm_op_id->completion_data.callback_info.arg = arg;
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
+    na_sm_op_id->info.send.buf = buf;
+    na_sm_op_id->info.send.buf_size = buf_size;
+    na_sm_op_id->info.send.na_sm_addr = (struct na_sm_addr *) dest;
+    na_sm_op_id->info.send.tag = tag;
+    na_sm_op_id->info.send.ret = NA_SUCCESS;
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
 
-    /* Try to reserve buffer atomically */
-    do {
-        ret = na_sm_reserve_and_copy_buf(na_class, na_sm_addr->na_sm_copy_buf,
-            buf, buf_size, &idx_reserved);
-        if (ret != NA_SUCCESS) {
-            na_return_t progress_ret = na_sm_progress(na_class, context, 0);
-
-            if (progress_ret != NA_SUCCESS && progress_ret != NA_TIMEOUT) {
-                NA_LOG_ERROR("Could not make progress");
-                ret = progress_ret;
-                goto done;
-            }
-            continue;
-        }
-        break;
-    } while (1);
-
-    /* Insert message into ring buffer (complete OP ID) */
-    ret = na_sm_msg_insert(na_class, na_sm_op_id, NA_CB_RECV_EXPECTED,
-        na_sm_addr, idx_reserved, buf_size, tag);
+    /* Send now or once a copy buf is available (complete OP ID) */
+    ret = na_sm_msg_send(na_class, na_sm_op_id);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not insert message");
+        NA_LOG_ERROR("Could not send message");
         goto done;
     }
 
@@ -3328,7 +4825,7 @@ na_sm_msg_recv_expected(na_class_t *na_class, na_context_t *context,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -3350,29 +4847,107 @@ na_sm_msg_recv_expected(na_class_t *na_class, na_context_t *context,
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
 
-    /* Expected messages must always be pre-posted, therefore a message should
-     * never arrive before that call returns (not completes), simply add
-     * op_id to queue */
-    hg_thread_spin_lock(
-        &NA_SM_PRIVATE_DATA(na_class)->expected_op_queue_lock);
-    HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->expected_op_queue,
-        na_sm_op_id, entry);
-    hg_thread_spin_unlock(
-        &NA_SM_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    /* Expected messages must always be pre-posted, therefore a message should
+     * never arrive before that call returns (not completes), simply add
+     * op_id to queue */
+    hg_thread_spin_lock(
+        &NA_SM_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    HG_QUEUE_PUSH_TAIL(&NA_SM_PRIVATE_DATA(na_class)->expected_op_queue,
+        na_sm_op_id, entry);
+    hg_thread_spin_unlock(
+        &NA_SM_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+done:
+    if (ret != NA_SUCCESS) {
+        na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_sm_mem_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
+{
+    na_size_t page_size = (na_size_t) hg_mem_get_page_size();
+    struct na_sm_mem_seg *na_sm_mem_seg = NULL;
+    char filename[NA_SM_MAX_FILENAME];
+    void *ret = NULL;
+
+    na_sm_mem_seg = (struct na_sm_mem_seg *) malloc(
+        sizeof(struct na_sm_mem_seg));
+    if (!na_sm_mem_seg) {
+        NA_LOG_ERROR("Could not allocate NA SM mem segment");
+        goto done;
+    }
+    /* Segment IDs are never reused so that remote mappings stay unambiguous */
+    na_sm_mem_seg->id = (unsigned int) hg_atomic_incr32(
+        &NA_SM_PRIVATE_DATA(na_class)->mem_seg_id);
+    na_sm_mem_seg->size = (buf_size + page_size - 1) / page_size * page_size;
+
+    /* Create segment that peers can map directly */
+    NA_SM_GEN_MEM_NAME(filename, NA_SM_PRIVATE_DATA(na_class)->self_addr,
+        na_sm_mem_seg->id);
+    na_sm_mem_seg->base = na_sm_open_shared_buf(filename, na_sm_mem_seg->size,
+        NA_TRUE);
+    if (!na_sm_mem_seg->base) {
+        NA_LOG_ERROR("Could not create segment %s", filename);
+        free(na_sm_mem_seg);
+        goto done;
+    }
+
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
+    HG_LIST_INSERT_HEAD(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list,
+        na_sm_mem_seg, entry);
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
+
+    *plugin_data = na_sm_mem_seg;
+    ret = na_sm_mem_seg->base;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_mem_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    struct na_sm_mem_seg *na_sm_mem_seg = (struct na_sm_mem_seg *) plugin_data;
+    char filename[NA_SM_MAX_FILENAME];
+    na_return_t ret = NA_SUCCESS;
+
+    if (na_sm_mem_seg->base != buf) {
+        NA_LOG_ERROR("Invalid plugin data value");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
+    HG_LIST_REMOVE(na_sm_mem_seg, entry);
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
 
-done:
+    /* Unlink segment, peers that still have it mapped keep their mapping
+     * until they release the corresponding addr */
+    NA_SM_GEN_MEM_NAME(filename, NA_SM_PRIVATE_DATA(na_class)->self_addr,
+        na_sm_mem_seg->id);
+    ret = na_sm_close_shared_buf(filename, na_sm_mem_seg->base,
+        na_sm_mem_seg->size);
     if (ret != NA_SUCCESS) {
-        na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
+        NA_LOG_ERROR("Could not close segment %s", filename);
+        goto done;
     }
+    free(na_sm_mem_seg);
+
+done:
     return ret;
 }
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
+na_sm_mem_handle_create(na_class_t *na_class, void *buf,
     na_size_t buf_size, unsigned long flags, na_mem_handle_t *mem_handle)
 {
     struct na_sm_mem_handle *na_sm_mem_handle = NULL;
+    struct na_sm_mem_seg *na_sm_mem_seg = NULL;
     na_return_t ret = NA_SUCCESS;
 
     na_sm_mem_handle = (struct na_sm_mem_handle *) malloc(
@@ -3394,6 +4969,24 @@ na_sm_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
     na_sm_mem_handle->iovcnt = 1;
     na_sm_mem_handle->flags = flags;
     na_sm_mem_handle->len = buf_size;
+    na_sm_mem_handle->shm_id = 0;
+    na_sm_mem_handle->shm_base = NULL;
+    na_sm_mem_handle->shm_size = 0;
+
+    /* Export through shm if buffer was allocated by na_sm_mem_alloc() */
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
+    HG_LIST_FOREACH(na_sm_mem_seg,
+        &NA_SM_PRIVATE_DATA(na_class)->mem_seg_list, entry) {
+        if ((char *) buf >= (char *) na_sm_mem_seg->base
+            && (char *) buf + buf_size
+            <= (char *) na_sm_mem_seg->base + na_sm_mem_seg->size) {
+            na_sm_mem_handle->shm_id = na_sm_mem_seg->id;
+            na_sm_mem_handle->shm_base = na_sm_mem_seg->base;
+            na_sm_mem_handle->shm_size = na_sm_mem_seg->size;
+            break;
+        }
+    }
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->mem_seg_list_lock);
 
     *mem_handle = (na_mem_handle_t) na_sm_mem_handle;
 
@@ -3442,6 +5035,9 @@ na_sm_mem_handle_create_segments(na_class_t NA_UNUSED *na_class,
     }
     na_sm_mem_handle->iovcnt = segment_count;
     na_sm_mem_handle->flags = flags;
+    na_sm_mem_handle->shm_id = 0;
+    na_sm_mem_handle->shm_base = NULL;
+    na_sm_mem_handle->shm_size = 0;
 
     *mem_handle = (na_mem_handle_t) na_sm_mem_handle;
 
@@ -3473,7 +5069,8 @@ na_sm_mem_handle_get_serialize_size(na_class_t NA_UNUSED *na_class,
     struct na_sm_mem_handle *na_sm_mem_handle =
         (struct na_sm_mem_handle *) mem_handle;
     unsigned long i;
-    na_size_t ret = 2 * sizeof(unsigned long) + sizeof(size_t);
+    na_size_t ret = 2 * sizeof(unsigned long) + sizeof(size_t)
+        + sizeof(unsigned int) + sizeof(void *) + sizeof(size_t);
 
     for (i = 0; i < na_sm_mem_handle->iovcnt; i++) {
         ret += sizeof(void *) + sizeof(size_t);
@@ -3505,6 +5102,14 @@ na_sm_mem_handle_serialize(na_class_t NA_UNUSED *na_class, void *buf,
     memcpy(buf_ptr, &na_sm_mem_handle->len, sizeof(size_t));
     buf_ptr += sizeof(size_t);
 
+    /* Shm segment */
+    memcpy(buf_ptr, &na_sm_mem_handle->shm_id, sizeof(unsigned int));
+    buf_ptr += sizeof(unsigned int);
+    memcpy(buf_ptr, &na_sm_mem_handle->shm_base, sizeof(void *));
+    buf_ptr += sizeof(void *);
+    memcpy(buf_ptr, &na_sm_mem_handle->shm_size, sizeof(size_t));
+    buf_ptr += sizeof(size_t);
+
     /* Segments */
     for (i = 0; i < na_sm_mem_handle->iovcnt; i++) {
         memcpy(buf_ptr, &na_sm_mem_handle->iov[i].iov_base, sizeof(void *));
@@ -3552,6 +5157,14 @@ na_sm_mem_handle_deserialize(na_class_t NA_UNUSED *na_class,
     memcpy(&na_sm_mem_handle->len, buf_ptr, sizeof(size_t));
     buf_ptr += sizeof(size_t);
 
+    /* Shm segment */
+    memcpy(&na_sm_mem_handle->shm_id, buf_ptr, sizeof(unsigned int));
+    buf_ptr += sizeof(unsigned int);
+    memcpy(&na_sm_mem_handle->shm_base, buf_ptr, sizeof(void *));
+    buf_ptr += sizeof(void *);
+    memcpy(&na_sm_mem_handle->shm_size, buf_ptr, sizeof(size_t));
+    buf_ptr += sizeof(size_t);
+
     /* Segments */
     na_sm_mem_handle->iov = (struct iovec *) malloc(na_sm_mem_handle->iovcnt *
         sizeof(struct iovec));
@@ -3587,23 +5200,18 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     struct na_sm_mem_handle *na_sm_mem_handle_remote =
         (struct na_sm_mem_handle *) remote_mem_handle;
     struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) remote_addr;
-    struct iovec *local_iov, *remote_iov;
-    unsigned long liovcnt, riovcnt;
+    struct iovec local_iov_buf[NA_SM_IOV_STATIC_MAX],
+        remote_iov_buf[NA_SM_IOV_STATIC_MAX];
+    struct iovec *local_iov = NULL, *remote_iov = NULL;
+    unsigned long liovcnt;
+    na_bool_t deferred = NA_FALSE;
     na_return_t ret = NA_SUCCESS;
-#if defined(NA_SM_HAS_CMA)
-    ssize_t nwrite;
-#elif defined(__APPLE__)
+#if defined(__APPLE__) && !defined(NA_SM_HAS_CMA)
+    unsigned long riovcnt;
     kern_return_t kret;
     mach_port_name_t remote_task;
 #endif
 
-#if !defined(NA_SM_HAS_CMA) && !defined(__APPLE__)
-    (void) na_sm_addr;
-    NA_LOG_ERROR("Not implemented for this platform");
-    ret = NA_PROTOCOL_ERROR;
-    goto done;
-#endif
-
     switch (na_sm_mem_handle_remote->flags) {
         case NA_MEM_READ_ONLY:
             NA_LOG_ERROR("Registered memory requires write permission");
@@ -3623,7 +5231,7 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -3637,75 +5245,101 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
 
-    /* Assign op_id */
-    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
-        *op_id = na_sm_op_id;
-
-    /* Translate local offset, skip this step if not necessary */
-    if (local_offset || length != na_sm_mem_handle_local->len) {
-        /* TODO fix allocation */
-        local_iov = (struct iovec *) alloca(
-            na_sm_mem_handle_local->iovcnt * sizeof(struct iovec));
-        na_sm_offset_translate(na_sm_mem_handle_local, local_offset, length,
-            local_iov, &liovcnt);
-    } else {
-        local_iov = na_sm_mem_handle_local->iov;
-        liovcnt = na_sm_mem_handle_local->iovcnt;
-    }
+    /* Keep track of transfer parameters */
+    na_sm_op_id->info.rma.na_sm_addr = na_sm_addr;
+    na_sm_op_id->info.rma.local_mem_handle = na_sm_mem_handle_local;
+    na_sm_op_id->info.rma.local_offset = local_offset;
+    na_sm_op_id->info.rma.remote_mem_handle = na_sm_mem_handle_remote;
+    na_sm_op_id->info.rma.remote_offset = remote_offset;
+    na_sm_op_id->info.rma.length = length;
+    na_sm_op_id->info.rma.ret = NA_SUCCESS;
+
+    if (na_sm_mem_handle_remote->shm_id) {
+        char *remote_ptr = NULL;
+
+        /* Translate local offset */
+        ret = na_sm_offset_translate(na_sm_mem_handle_local, local_offset,
+            length, local_iov_buf, &local_iov, &liovcnt);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not translate local offset");
+            goto done;
+        }
 
-    /* Translate remote offset, skip this step if not necessary */
-    if (remote_offset || length != na_sm_mem_handle_remote->len) {
-        /* TODO fix allocation */
-        remote_iov = (struct iovec *) alloca(
-            na_sm_mem_handle_remote->iovcnt * sizeof(struct iovec));
-        na_sm_offset_translate(na_sm_mem_handle_remote, remote_offset, length,
-            remote_iov, &riovcnt);
+        /* Remote memory is exported through shm, copy directly */
+        ret = na_sm_mem_map_get(na_class, na_sm_addr, na_sm_mem_handle_remote,
+            remote_offset, length, &remote_ptr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not map remote memory");
+            goto done;
+        }
+        na_sm_iov_copy(local_iov, liovcnt, remote_ptr + remote_offset,
+            NA_FALSE);
     } else {
-        remote_iov = na_sm_mem_handle_remote->iov;
-        riovcnt = na_sm_mem_handle_remote->iovcnt;
-    }
-
 #if defined(NA_SM_HAS_CMA)
-    nwrite = process_vm_writev(na_sm_addr->pid, local_iov, liovcnt, remote_iov,
-        riovcnt, /* unused */0);
-    if (nwrite < 0) {
-        NA_LOG_ERROR("process_vm_writev() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    if ((na_size_t)nwrite != length) {
-        NA_LOG_ERROR("Wrote %ld bytes, was expecting %lu bytes", nwrite, length);
-        ret = NA_SIZE_ERROR;
-        goto done;
-    }
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+            *op_id = na_sm_op_id;
+
+        /* Defer transfer to progress so that it can be merged with other
+         * pending transfers to the same peer */
+        na_sm_rma_post(na_class, na_sm_op_id);
+        deferred = NA_TRUE;
 #elif defined(__APPLE__)
-    kret = task_for_pid(mach_task_self(), na_sm_addr->pid, &remote_task);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("task_for_pid() failed (%s)\n"
-                     "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+        /* Translate local offset */
+        ret = na_sm_offset_translate(na_sm_mem_handle_local, local_offset,
+            length, local_iov_buf, &local_iov, &liovcnt);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not translate local offset");
+            goto done;
+        }
 
-    if (liovcnt > 1 || riovcnt > 1) {
-        NA_LOG_ERROR("Non-contiguous transfers are not supported");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+        /* Translate remote offset */
+        ret = na_sm_offset_translate(na_sm_mem_handle_remote, remote_offset,
+            length, remote_iov_buf, &remote_iov, &riovcnt);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not translate remote offset");
+            goto done;
+        }
+
+        kret = task_for_pid(mach_task_self(), na_sm_addr->pid, &remote_task);
+        if (kret != KERN_SUCCESS) {
+            NA_LOG_ERROR("task_for_pid() failed (%s)\n"
+                         "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        if (liovcnt > 1 || riovcnt > 1) {
+            NA_LOG_ERROR("Non-contiguous transfers are not supported");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
 
-    kret = mach_vm_write(remote_task, remote_iov->iov_base, local_iov->iov_base, length);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("mach_vm_write() failed (%s)", mach_error_string(kret));
+        kret = mach_vm_write(remote_task, remote_iov->iov_base,
+            local_iov->iov_base, length);
+        if (kret != KERN_SUCCESS) {
+            NA_LOG_ERROR("mach_vm_write() failed (%s)", mach_error_string(kret));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+#else
+        NA_LOG_ERROR("Not implemented for this platform");
         ret = NA_PROTOCOL_ERROR;
         goto done;
-    }
 #endif
+    }
 
-    /* Immediate completion */
-    ret = na_sm_complete(na_sm_op_id);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not complete operation");
-        goto done;
+    /* Immediate completion, op_id is only assigned once the transfer is
+     * done so that it never refers to a destroyed operation */
+    if (!deferred) {
+        if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+            *op_id = na_sm_op_id;
+
+        ret = na_sm_complete(na_sm_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
     }
 
     /* Notify local completion */
@@ -3719,7 +5353,9 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     }
 
 done:
-    if (ret != NA_SUCCESS) {
+    na_sm_iov_release(na_sm_mem_handle_local, local_iov_buf, local_iov);
+    na_sm_iov_release(na_sm_mem_handle_remote, remote_iov_buf, remote_iov);
+    if (ret != NA_SUCCESS && !deferred) {
         na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
     }
     return ret;
@@ -3738,24 +5374,19 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     struct na_sm_mem_handle *na_sm_mem_handle_remote =
         (struct na_sm_mem_handle *) remote_mem_handle;
     struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) remote_addr;
-    struct iovec *local_iov, *remote_iov;
-    unsigned long liovcnt, riovcnt;
+    struct iovec local_iov_buf[NA_SM_IOV_STATIC_MAX],
+        remote_iov_buf[NA_SM_IOV_STATIC_MAX];
+    struct iovec *local_iov = NULL, *remote_iov = NULL;
+    unsigned long liovcnt;
+    na_bool_t deferred = NA_FALSE;
     na_return_t ret = NA_SUCCESS;
-#if defined(NA_SM_HAS_CMA)
-    ssize_t nread;
-#elif defined(__APPLE__)
+#if defined(__APPLE__) && !defined(NA_SM_HAS_CMA)
+    unsigned long riovcnt;
     mach_vm_size_t nread;
     kern_return_t kret;
     mach_port_name_t remote_task;
 #endif
 
-#if !defined(NA_SM_HAS_CMA) && !defined(__APPLE__)
-    (void) na_sm_addr;
-    NA_LOG_ERROR("Not implemented for this platform");
-    ret = NA_PROTOCOL_ERROR;
-    goto done;
-#endif
-
     switch (na_sm_mem_handle_remote->flags) {
         case NA_MEM_WRITE_ONLY:
             NA_LOG_ERROR("Registered memory requires read permission");
@@ -3775,7 +5406,7 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
         hg_atomic_incr32(&na_sm_op_id->ref_count);
     } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        na_sm_op_id = na_sm_op_alloc(na_class, context);
         if (!na_sm_op_id) {
             NA_LOG_ERROR("Could not allocate NA SM operation ID");
             ret = NA_NOMEM_ERROR;
@@ -3789,78 +5420,109 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
 
-    /* Assign op_id */
-    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
-        *op_id = na_sm_op_id;
-
-    /* Translate local offset, skip this step if not necessary */
-    if (local_offset || length != na_sm_mem_handle_local->len) {
-        /* TODO fix allocation */
-        local_iov = (struct iovec *) alloca(
-            na_sm_mem_handle_local->iovcnt * sizeof(struct iovec));
-        na_sm_offset_translate(na_sm_mem_handle_local, local_offset, length,
-            local_iov, &liovcnt);
-    } else {
-        local_iov = na_sm_mem_handle_local->iov;
-        liovcnt = na_sm_mem_handle_local->iovcnt;
-    }
+    /* Keep track of transfer parameters */
+    na_sm_op_id->info.rma.na_sm_addr = na_sm_addr;
+    na_sm_op_id->info.rma.local_mem_handle = na_sm_mem_handle_local;
+    na_sm_op_id->info.rma.local_offset = local_offset;
+    na_sm_op_id->info.rma.remote_mem_handle = na_sm_mem_handle_remote;
+    na_sm_op_id->info.rma.remote_offset = remote_offset;
+    na_sm_op_id->info.rma.length = length;
+    na_sm_op_id->info.rma.ret = NA_SUCCESS;
+
+    if (na_sm_mem_handle_remote->shm_id) {
+        char *remote_ptr = NULL;
+
+        /* Translate local offset */
+        ret = na_sm_offset_translate(na_sm_mem_handle_local, local_offset,
+            length, local_iov_buf, &local_iov, &liovcnt);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not translate local offset");
+            goto done;
+        }
 
-    /* Translate remote offset, skip this step if not necessary */
-    if (remote_offset || length != na_sm_mem_handle_remote->len) {
-        /* TODO fix allocation */
-        remote_iov = (struct iovec *) alloca(
-            na_sm_mem_handle_remote->iovcnt * sizeof(struct iovec));
-        na_sm_offset_translate(na_sm_mem_handle_remote, remote_offset, length,
-            remote_iov, &riovcnt);
+        /* Remote memory is exported through shm, copy directly */
+        ret = na_sm_mem_map_get(na_class, na_sm_addr, na_sm_mem_handle_remote,
+            remote_offset, length, &remote_ptr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not map remote memory");
+            goto done;
+        }
+        na_sm_iov_copy(local_iov, liovcnt, remote_ptr + remote_offset,
+            NA_TRUE);
     } else {
-        remote_iov = na_sm_mem_handle_remote->iov;
-        riovcnt = na_sm_mem_handle_remote->iovcnt;
-    }
-
 #if defined(NA_SM_HAS_CMA)
-    nread = process_vm_readv(na_sm_addr->pid, local_iov, liovcnt, remote_iov,
-        riovcnt, /* unused */0);
-    if (nread < 0) {
-        NA_LOG_ERROR("process_vm_readv() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+            *op_id = na_sm_op_id;
+
+        /* Defer transfer to progress so that it can be merged with other
+         * pending transfers to the same peer */
+        na_sm_rma_post(na_class, na_sm_op_id);
+        deferred = NA_TRUE;
 #elif defined(__APPLE__)
-    kret = task_for_pid(mach_task_self(), na_sm_addr->pid, &remote_task);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("task_for_pid() failed (%s)\n"
-                     "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+        /* Translate local offset */
+        ret = na_sm_offset_translate(na_sm_mem_handle_local, local_offset,
+            length, local_iov_buf, &local_iov, &liovcnt);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not translate local offset");
+            goto done;
+        }
 
-    if (liovcnt > 1 || riovcnt > 1) {
-        NA_LOG_ERROR("Non-contiguous transfers are not supported");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+        /* Translate remote offset */
+        ret = na_sm_offset_translate(na_sm_mem_handle_remote, remote_offset,
+            length, remote_iov_buf, &remote_iov, &riovcnt);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not translate remote offset");
+            goto done;
+        }
+
+        kret = task_for_pid(mach_task_self(), na_sm_addr->pid, &remote_task);
+        if (kret != KERN_SUCCESS) {
+            NA_LOG_ERROR("task_for_pid() failed (%s)\n"
+                         "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        if (liovcnt > 1 || riovcnt > 1) {
+            NA_LOG_ERROR("Non-contiguous transfers are not supported");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
 
-    kret = mach_vm_read_overwrite(remote_task, remote_iov->iov_base, length,
-        local_iov->iov_base, &nread);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("mach_vm_read_overwrite() failed (%s)", mach_error_string(kret));
+        kret = mach_vm_read_overwrite(remote_task, remote_iov->iov_base, length,
+            local_iov->iov_base, &nread);
+        if (kret != KERN_SUCCESS) {
+            NA_LOG_ERROR("mach_vm_read_overwrite() failed (%s)", mach_error_string(kret));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+#else
+        NA_LOG_ERROR("Not implemented for this platform");
         ret = NA_PROTOCOL_ERROR;
         goto done;
-    }
 #endif
-#if defined(NA_SM_HAS_CMA) || defined(__APPLE__)
-    if ((na_size_t)nread != length) {
-        NA_LOG_ERROR("Read %ld bytes, was expecting %lu bytes", nread, length);
-        ret = NA_SIZE_ERROR;
-        goto done;
-    }
+#if defined(__APPLE__) && !defined(NA_SM_HAS_CMA)
+        if ((na_size_t)nread != length) {
+            NA_LOG_ERROR("Read %ld bytes, was expecting %lu bytes", nread,
+                length);
+            ret = NA_SIZE_ERROR;
+            goto done;
+        }
 #endif
+    }
 
-    /* Immediate completion */
-    ret = na_sm_complete(na_sm_op_id);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not complete operation");
-        goto done;
+    /* Immediate completion, op_id is only assigned once the transfer is
+     * done so that it never refers to a destroyed operation */
+    if (!deferred) {
+        if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+            *op_id = na_sm_op_id;
+
+        ret = na_sm_complete(na_sm_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
     }
 
     /* Notify local completion */
@@ -3874,7 +5536,9 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     }
 
 done:
-    if (ret != NA_SUCCESS) {
+    na_sm_iov_release(na_sm_mem_handle_local, local_iov_buf, local_iov);
+    na_sm_iov_release(na_sm_mem_handle_remote, remote_iov_buf, remote_iov);
+    if (ret != NA_SUCCESS && !deferred) {
         na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
     }
     return ret;
@@ -3899,6 +5563,7 @@ static na_bool_t
 na_sm_poll_try_wait(na_class_t *na_class, na_context_t NA_UNUSED *context)
 {
     struct na_sm_addr *na_sm_addr;
+    na_bool_t pending;
     na_bool_t ret = NA_TRUE;
 
     /* We're going to poll so we must receive notifications (we must enable
@@ -3918,6 +5583,33 @@ na_sm_poll_try_wait(na_class_t *na_class, na_context_t NA_UNUSED *context)
         ret = NA_FALSE;
         goto done;
     }
+    /* Pending lookups and sends are only retried on progress */
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+    pending = !HG_QUEUE_IS_EMPTY(
+        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue);
+    hg_thread_spin_unlock(
+        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+    if (!pending) {
+        hg_thread_spin_lock(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+        pending = !HG_QUEUE_IS_EMPTY(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue);
+        hg_thread_spin_unlock(
+            &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+    }
+    if (pending) {
+        ret = NA_FALSE;
+        goto done;
+    }
+    /* Pending RMA operations are only issued on progress */
+    hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+    pending = !HG_QUEUE_IS_EMPTY(
+        &NA_SM_PRIVATE_DATA(na_class)->rma_addr_queue);
+    hg_thread_spin_unlock(&NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+    if (pending) {
+        ret = NA_FALSE;
+        goto done;
+    }
     hg_thread_spin_lock(&NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue_lock);
     HG_QUEUE_FOREACH(na_sm_addr, &NA_SM_PRIVATE_DATA(na_class)->poll_addr_queue,
         poll_entry) {
@@ -3946,10 +5638,54 @@ na_sm_progress(na_class_t *na_class, na_context_t NA_UNUSED *context,
     do {
         hg_time_t t1, t2;
         hg_util_bool_t progressed;
+        na_bool_t lookup_progressed, send_progressed, released;
+#ifdef NA_SM_HAS_CMA
+        na_bool_t rma_progressed;
+#endif
 
         if (timeout)
             hg_time_get_current(&t1);
 
+        /* Tear down connections closed by peers (outside of poll walk) */
+        ret = na_sm_addr_release_disconnected(na_class, &released);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not release disconnected addrs");
+            goto done;
+        }
+
+        /* Retry lookups and sends that could not be issued when posted, do
+         * not block if some got completed */
+        ret = na_sm_lookup_retry(na_class, &lookup_progressed);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not retry lookups");
+            goto done;
+        }
+        ret = na_sm_msg_send_retry(na_class, &send_progressed);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not retry sends");
+            goto done;
+        }
+        if (lookup_progressed || send_progressed) {
+            ret = NA_SUCCESS;
+            break;
+        }
+        ret = NA_TIMEOUT;
+
+#ifdef NA_SM_HAS_CMA
+        /* Issue pending RMA operations first, do not block if some got
+         * completed */
+        ret = na_sm_rma_flush(na_class, &rma_progressed);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not flush RMA operations");
+            goto done;
+        }
+        if (rma_progressed) {
+            ret = NA_SUCCESS;
+            break;
+        }
+        ret = NA_TIMEOUT;
+#endif
+
         if (hg_poll_wait(NA_SM_PRIVATE_DATA(na_class)->poll_set,
             (unsigned int) (remaining * 1000.0), &progressed) != HG_UTIL_SUCCESS) {
             NA_LOG_ERROR("hg_poll_wait() failed");
@@ -4002,11 +5738,68 @@ na_sm_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
         goto done;
 
     switch (na_sm_op_id->completion_data.callback_info.type) {
-        case NA_CB_LOOKUP:
-            /* Nothing */
+        case NA_CB_LOOKUP: {
+            struct na_sm_op_id *na_sm_var_op_id = NULL;
+
+            /* Must remove op_id from lookup op queue if not connected yet */
+            hg_thread_spin_lock(
+                &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+            HG_QUEUE_FOREACH(na_sm_var_op_id,
+                &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue, entry) {
+                if (na_sm_var_op_id == na_sm_op_id) {
+                    HG_QUEUE_REMOVE(
+                        &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue,
+                        na_sm_var_op_id, na_sm_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->lookup_op_queue_lock);
+
+            /* Cancel op id, connection info was never sent */
+            if (na_sm_var_op_id == na_sm_op_id) {
+                hg_atomic_set32(&na_sm_op_id->canceled, NA_TRUE);
+                ret = na_sm_lookup_finish(na_class, na_sm_op_id, NA_FALSE,
+                    NA_CANCELED);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+        }
             break;
         case NA_CB_SEND_UNEXPECTED:
-            /* Nothing */
+        case NA_CB_SEND_EXPECTED: {
+            struct na_sm_addr *na_sm_addr = na_sm_op_id->info.send.na_sm_addr;
+            struct na_sm_op_id *na_sm_var_op_id = NULL;
+
+            /* Must remove op_id from send op queue if not issued yet */
+            hg_thread_spin_lock(
+                &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+            HG_QUEUE_FOREACH(na_sm_var_op_id,
+                &NA_SM_PRIVATE_DATA(na_class)->send_op_queue, entry) {
+                if (na_sm_var_op_id == na_sm_op_id) {
+                    HG_QUEUE_REMOVE(
+                        &NA_SM_PRIVATE_DATA(na_class)->send_op_queue,
+                        na_sm_var_op_id, na_sm_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->send_op_queue_lock);
+
+            /* Cancel op id */
+            if (na_sm_var_op_id == na_sm_op_id) {
+                hg_atomic_set32(&na_sm_op_id->canceled, NA_TRUE);
+                ret = na_sm_complete(na_sm_op_id);
+                /* Release ref taken when operation was queued */
+                na_sm_addr_free(na_class, na_sm_addr);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+        }
             break;
         case NA_CB_RECV_UNEXPECTED: {
             struct na_sm_op_id *na_sm_var_op_id = NULL;
@@ -4036,9 +5829,6 @@ na_sm_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
             }
         }
             break;
-        case NA_CB_SEND_EXPECTED:
-            /* Nothing */
-            break;
         case NA_CB_RECV_EXPECTED: {
             struct na_sm_op_id *na_sm_var_op_id = NULL;
 
@@ -4068,10 +5858,52 @@ na_sm_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
         }
             break;
         case NA_CB_PUT:
-            /* Nothing */
-            break;
-        case NA_CB_GET:
-            /* Nothing */
+        case NA_CB_GET: {
+#ifdef NA_SM_HAS_CMA
+            struct na_sm_addr *na_sm_addr = na_sm_op_id->info.rma.na_sm_addr;
+            struct na_sm_op_id *na_sm_var_op_id = NULL;
+
+            /* Must remove op_id from pending RMA queue if not issued yet */
+            hg_thread_spin_lock(
+                &NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+            if (na_sm_addr->rma_pending) {
+                if (na_sm_op_id->completion_data.callback_info.type
+                    == NA_CB_GET) {
+                    HG_QUEUE_FOREACH(na_sm_var_op_id,
+                        &na_sm_addr->rma_get_queue, entry) {
+                        if (na_sm_var_op_id == na_sm_op_id) {
+                            HG_QUEUE_REMOVE(&na_sm_addr->rma_get_queue,
+                                na_sm_var_op_id, na_sm_op_id, entry);
+                            break;
+                        }
+                    }
+                } else {
+                    HG_QUEUE_FOREACH(na_sm_var_op_id,
+                        &na_sm_addr->rma_put_queue, entry) {
+                        if (na_sm_var_op_id == na_sm_op_id) {
+                            HG_QUEUE_REMOVE(&na_sm_addr->rma_put_queue,
+                                na_sm_var_op_id, na_sm_op_id, entry);
+                            break;
+                        }
+                    }
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_SM_PRIVATE_DATA(na_class)->rma_queue_lock);
+
+            /* Cancel op id */
+            if (na_sm_var_op_id == na_sm_op_id) {
+                hg_atomic_set32(&na_sm_op_id->canceled, NA_TRUE);
+                ret = na_sm_complete(na_sm_op_id);
+                /* Release ref taken when operation was posted */
+                na_sm_addr_free(na_class, na_sm_addr);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+#endif
+        }
             break;
         default:
             NA_LOG_ERROR("Operation not supported");
@@ -0,0 +1,4615 @@
+/*
+ * Copyright (C) 2013-2017 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#include "na_private.h"
+#include "na_error.h"
+
+#include "mercury_queue.h"
+#include "mercury_list.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_spin.h"
+#include "mercury_time.h"
+#include "mercury_atomic.h"
+#include "mercury_poll.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#ifdef NA_TCP_HAS_IO_URING
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+#endif
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Plugin constants */
+#define NA_TCP_MAX_ADDR_NAME    256
+#define NA_TCP_RECV_BUF_SIZE    (64 * 1024) /* Staging buffer per connection */
+#define NA_TCP_IOV_MAX          64  /* Max iovecs gathered per sendmsg() */
+#define NA_TCP_RECV_MAX         16  /* Max reads per connection and event */
+
+/* Emulated RMA */
+#define NA_TCP_RMA_CHUNK_SIZE   (1 << 20)
+#define NA_TCP_RMA_WINDOW       4
+
+/* Msg sizes */
+#define NA_TCP_UNEXPECTED_SIZE  4096
+#define NA_TCP_EXPECTED_SIZE    NA_TCP_UNEXPECTED_SIZE
+
+/* Max tag */
+#define NA_TCP_MAX_TAG          NA_TAG_UB
+
+/* Private data access */
+#define NA_TCP_PRIVATE_DATA(na_class) \
+    ((struct na_tcp_private_data *)(na_class->private_data))
+
+/* Min macro */
+#define NA_TCP_MIN(a, b) \
+    (((a) < (b)) ? (a) : (b))
+
+/* Peers closing connections must not raise SIGPIPE */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 /* SO_NOSIGPIPE is set on sockets instead */
+#endif
+
+#ifdef NA_TCP_HAS_IO_URING
+/* io_uring */
+#define NA_TCP_URING_ENTRIES    256 /* Submission queue entries */
+#define NA_TCP_URING_BUF_COUNT  256 /* Provided recv buffers (power of 2) */
+#define NA_TCP_URING_BUF_SIZE   (2 * NA_TCP_UNEXPECTED_SIZE) /* Fits a
+                                                                message */
+#define NA_TCP_URING_BGID       0   /* Provided buffer group ID */
+
+/* Request type is encoded in the low bits of user_data */
+#define NA_TCP_URING_RECV       1UL
+#define NA_TCP_URING_SEND       2UL
+#define NA_TCP_URING_TYPE_MASK  3UL
+#endif
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Frame type */
+typedef enum na_tcp_frame_type {
+    NA_TCP_UNEXPECTED = 1,  /* Unexpected message */
+    NA_TCP_EXPECTED,        /* Expected message */
+    NA_TCP_PUT,             /* RMA put chunk (followed by data) */
+    NA_TCP_PUT_ACK,         /* RMA put chunk written */
+    NA_TCP_GET,             /* RMA get chunk request */
+    NA_TCP_GET_DATA         /* RMA get chunk (followed by data) */
+} na_tcp_frame_type_t;
+
+/* Frame header (peers are assumed to share the same byte order) */
+struct na_tcp_hdr {
+    na_uint32_t type;       /* Frame type */
+    na_uint32_t tag;        /* Message tag or RMA operation ID */
+    na_uint64_t size;       /* Size of payload following header */
+    na_ptr_t addr;          /* Remote address of RMA chunk */
+    na_uint64_t len;        /* Length of RMA chunk */
+};
+
+/* Frame queued on a connection */
+struct na_tcp_frame {
+    struct na_tcp_hdr hdr;              /* Header */
+    const void *payload;                /* Payload (not copied) */
+    na_size_t sent;                     /* Bytes of header + payload sent */
+    struct na_tcp_op_id *na_tcp_op_id;  /* Completed once sent (or NULL) */
+    HG_QUEUE_ENTRY(na_tcp_frame) entry;
+};
+
+/* Poll type */
+typedef enum na_tcp_poll_type {
+    NA_TCP_ACCEPT = 1,
+    NA_TCP_RECV,
+    NA_TCP_SEND,
+    NA_TCP_URING
+} na_tcp_poll_type_t;
+
+/* Poll data */
+struct na_tcp_poll_data {
+    na_class_t *na_class;
+    na_tcp_poll_type_t type;    /* Type of operation */
+    struct na_tcp_addr *addr;   /* Address */
+};
+
+/* Address */
+struct na_tcp_addr {
+    char name[NA_TCP_MAX_ADDR_NAME];            /* host:port */
+    int sock;                                   /* Sock fd */
+    int send_sock;                              /* Dup of sock polled for
+                                                   writes */
+    struct na_tcp_poll_data *recv_poll_data;    /* Recv / accept poll data */
+    struct na_tcp_poll_data *send_poll_data;    /* Send poll data */
+    HG_QUEUE_HEAD(na_tcp_frame) send_queue;     /* Frames not entirely sent */
+    HG_QUEUE_HEAD(na_tcp_op_id) rma_op_queue;   /* RMA ops in flight */
+    hg_thread_mutex_t send_lock;                /* Send queue / RMA ops lock */
+    na_bool_t send_pending;                     /* Addr in send addr queue */
+    char *rx_buf;                               /* Staging recv buffer */
+    na_size_t rx_start;                         /* Start of unprocessed data */
+    na_size_t rx_end;                           /* End of received data */
+    struct na_tcp_hdr rx_hdr;                   /* Header of current frame */
+    na_bool_t rx_payload;                       /* Receiving rx_hdr payload */
+    char *rx_dest;                              /* Where payload is kept */
+    na_size_t rx_dest_len;                      /* Bytes of payload kept */
+    na_size_t rx_recvd;                         /* Bytes of payload received */
+    struct na_tcp_op_id *rx_op_id;              /* Op matching current frame */
+    struct na_tcp_unexpected_info *rx_unexpected_info; /* Or unexpected info */
+    na_bool_t accepted;                         /* Created on accept */
+    na_bool_t accepted_queued;                  /* In accepted addr queue */
+    na_bool_t register_queued;                  /* In register addr queue */
+    na_bool_t self;                             /* Self address */
+    na_bool_t cached;                           /* In connection list */
+    na_bool_t closing;                          /* In close addr queue */
+    na_bool_t released;                         /* No more references */
+    hg_atomic_int32_t failed;                   /* Connection closed */
+    hg_atomic_int32_t ref_count;                /* Ref count */
+#ifdef NA_TCP_HAS_IO_URING
+    struct msghdr tx_msg;                       /* Sendmsg in flight */
+    struct iovec tx_iov[NA_TCP_IOV_MAX];        /* Iovecs of tx_msg */
+    na_bool_t tx_busy;                          /* Sendmsg in flight */
+    hg_atomic_int32_t uring_refs;               /* Ring requests in flight */
+#endif
+    HG_LIST_ENTRY(na_tcp_addr) conn_entry;      /* Connection list entry */
+    HG_QUEUE_ENTRY(na_tcp_addr) entry;          /* Accepted queue entry */
+    HG_QUEUE_ENTRY(na_tcp_addr) register_entry; /* Register queue entry */
+    HG_QUEUE_ENTRY(na_tcp_addr) send_entry;     /* Send queue entry */
+    HG_QUEUE_ENTRY(na_tcp_addr) close_entry;    /* Close queue entry */
+};
+
+/* Unexpected message info */
+struct na_tcp_unexpected_info {
+    struct na_tcp_addr *na_tcp_addr;
+    void *buf;
+    na_size_t buf_size;
+    na_tag_t tag;
+    HG_QUEUE_ENTRY(na_tcp_unexpected_info) entry;
+};
+
+/* Memory handle */
+struct na_tcp_mem_handle {
+    na_ptr_t base;          /* Base address of region */
+    na_size_t size;         /* Size of region */
+    unsigned long flags;    /* Flag of operation access */
+    na_bool_t registered;   /* Accessible by remote peers */
+    HG_LIST_ENTRY(na_tcp_mem_handle) entry; /* Registered handle entry */
+};
+
+/* Lookup info */
+struct na_tcp_info_lookup {
+    struct na_tcp_addr *na_tcp_addr;
+};
+
+/* Send unexpected and expected */
+struct na_tcp_info_send {
+    struct na_tcp_frame frame;
+};
+
+/* Unexpected recv info */
+struct na_tcp_info_recv_unexpected {
+    void *buf;
+    na_size_t buf_size;
+    na_size_t actual_buf_size;
+    struct na_tcp_addr *na_tcp_addr;
+    na_tag_t tag;
+};
+
+/* Expected recv info */
+struct na_tcp_info_recv_expected {
+    void *buf;
+    na_size_t buf_size;
+    struct na_tcp_addr *na_tcp_addr;
+    na_tag_t tag;
+};
+
+/* RMA info (put / get) */
+struct na_tcp_info_rma {
+    struct na_tcp_addr *na_tcp_addr;
+    char *local_buf;        /* Local buffer (offset applied) */
+    na_ptr_t remote_addr;   /* Remote address (offset applied) */
+    na_size_t length;       /* Length of transfer */
+    na_size_t posted;       /* Bytes of chunks posted */
+    na_size_t recvd;        /* Bytes of chunks received (get) */
+    na_size_t completed;    /* Bytes of chunks completed */
+    na_uint32_t in_flight;  /* Chunks in flight */
+    na_uint32_t id;         /* Operation ID sent with chunks */
+};
+
+/* Operation ID */
+struct na_tcp_op_id {
+    na_class_t *na_class;
+    na_context_t *context;
+    struct na_cb_completion_data completion_data;
+    hg_atomic_int32_t completed;    /* Operation completed */
+    hg_atomic_int32_t canceled;     /* Operation canceled */
+    na_return_t ret;                /* Return code of operation */
+    union {
+        struct na_tcp_info_lookup lookup;
+        struct na_tcp_info_send send;
+        struct na_tcp_info_recv_unexpected recv_unexpected;
+        struct na_tcp_info_recv_expected recv_expected;
+        struct na_tcp_info_rma rma;
+    } info;
+    hg_atomic_int32_t ref_count;    /* Ref count */
+    HG_QUEUE_ENTRY(na_tcp_op_id) entry;
+};
+
+/* Queue of operation IDs */
+HG_QUEUE_HEAD_DECL(na_tcp_op_queue, na_tcp_op_id);
+
+#ifdef NA_TCP_HAS_IO_URING
+/* io_uring instance (rings are mapped from the kernel) */
+struct na_tcp_uring {
+    int fd;                             /* Ring fd */
+    void *sq_ring;                      /* Submission queue ring */
+    size_t sq_ring_size;
+    void *cq_ring;                      /* Completion queue ring */
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;          /* Submission queue entries */
+    size_t sqes_size;
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_flags;
+    unsigned int *sq_array;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int cq_mask;
+    struct io_uring_cqe *cqes;
+    struct io_uring_buf_ring *buf_ring; /* Provided recv buffer ring */
+    char *bufs;                         /* Provided recv buffers */
+    unsigned short buf_tail;            /* Local tail of buffer ring */
+    unsigned int to_submit;             /* SQEs not submitted yet */
+    unsigned int pending;               /* Requests not completed yet */
+    na_bool_t reaping;                  /* Submissions deferred */
+    na_bool_t multishot;                /* Multishot recv supported */
+    hg_thread_mutex_t sq_lock;          /* Submission queue lock */
+    struct na_tcp_poll_data *poll_data; /* Ring fd poll data */
+};
+#endif
+
+/* Private data */
+struct na_tcp_private_data {
+    struct na_tcp_addr *self_addr;
+    hg_poll_set_t *poll_set;
+#ifdef NA_TCP_HAS_IO_URING
+    struct na_tcp_uring *uring;         /* NULL if not used */
+#endif
+    na_size_t rma_chunk_size;
+    na_uint32_t rma_window;
+    hg_atomic_int32_t rma_id;
+    HG_LIST_HEAD(na_tcp_addr) conn_addr_list;
+    HG_QUEUE_HEAD(na_tcp_addr) accepted_addr_queue;
+    HG_QUEUE_HEAD(na_tcp_addr) register_addr_queue;
+    HG_QUEUE_HEAD(na_tcp_addr) send_addr_queue;
+    HG_QUEUE_HEAD(na_tcp_addr) close_addr_queue;
+    HG_QUEUE_HEAD(na_tcp_unexpected_info) unexpected_msg_queue;
+    HG_QUEUE_HEAD(na_tcp_op_id) unexpected_op_queue;
+    HG_QUEUE_HEAD(na_tcp_op_id) expected_op_queue;
+    HG_LIST_HEAD(na_tcp_mem_handle) mem_handle_list;
+    hg_thread_spin_t conn_addr_list_lock;
+    hg_thread_spin_t accepted_addr_queue_lock;
+    hg_thread_spin_t register_addr_queue_lock;
+    hg_thread_spin_t send_addr_queue_lock;
+    hg_thread_spin_t close_addr_queue_lock;
+    hg_thread_spin_t unexpected_msg_queue_lock;
+    hg_thread_spin_t unexpected_op_queue_lock;
+    hg_thread_spin_t expected_op_queue_lock;
+    hg_thread_spin_t mem_handle_list_lock;
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Split "host:port" string (host may be empty).
+ */
+static na_return_t
+na_tcp_parse_name(
+    const char *name,
+    char *host,
+    char *port
+    );
+
+/**
+ * Set sock non-blocking and disable Nagle's algorithm.
+ */
+static na_return_t
+na_tcp_sock_setup(
+    int sock
+    );
+
+/**
+ * Create listening sock.
+ */
+static na_return_t
+na_tcp_listen(
+    const char *host,
+    const char *port,
+    int *sock
+    );
+
+/**
+ * Connect to remote listening sock.
+ */
+static na_return_t
+na_tcp_connect(
+    const char *host,
+    const char *port,
+    int *sock
+    );
+
+/**
+ * Create addr from connected sock.
+ */
+static na_return_t
+na_tcp_addr_create(
+    int sock,
+    struct na_tcp_addr **addr
+    );
+
+/**
+ * Destroy addr.
+ */
+static void
+na_tcp_addr_destroy(
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Mark connection as failed, it gets closed on progress.
+ */
+static void
+na_tcp_addr_fail(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Remove connection from poll set, close it and fail pending operations.
+ */
+static na_return_t
+na_tcp_addr_close(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Register addr to poll set.
+ */
+static na_return_t
+na_tcp_poll_register(
+    na_class_t *na_class,
+    na_tcp_poll_type_t poll_type,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Deregister addr from poll set.
+ */
+static na_return_t
+na_tcp_poll_deregister(
+    na_class_t *na_class,
+    na_tcp_poll_type_t poll_type,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Update poll set (register new connections, poll blocked sends for write
+ * and close failed or released connections). Must not be called while
+ * waiting on poll set.
+ */
+static na_return_t
+na_tcp_poll_update(
+    na_class_t *na_class,
+    na_bool_t *progressed
+    );
+
+/**
+ * Gather queued frames into iovecs (send lock must be held).
+ */
+static int
+na_tcp_send_iov(
+    struct na_tcp_addr *na_tcp_addr,
+    struct iovec *iov,
+    size_t *iov_len
+    );
+
+/**
+ * Advance send queue by nsent bytes (send lock must be held).
+ */
+static void
+na_tcp_send_consume(
+    struct na_tcp_addr *na_tcp_addr,
+    na_size_t nsent,
+    na_bool_t *progressed
+    );
+
+/**
+ * Move ops of queued frames and RMA ops to failed queue (send lock must be
+ * held).
+ */
+static void
+na_tcp_send_fail(
+    struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_op_queue *failed_op_queue
+    );
+
+/**
+ * Complete ops of failed queue.
+ */
+static na_return_t
+na_tcp_fail_complete(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_op_queue *failed_op_queue
+    );
+
+/**
+ * Write as many queued frames as possible (send lock must be held).
+ */
+static void
+na_tcp_send_flush(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    na_bool_t *progressed
+    );
+
+/**
+ * Queue frame and try to send it.
+ */
+static na_return_t
+na_tcp_send_frame(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_frame *na_tcp_frame
+    );
+
+/**
+ * Post RMA chunks up to window (send lock must be held).
+ */
+static na_return_t
+na_tcp_rma_post(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_op_id *na_tcp_op_id
+    );
+
+/**
+ * Account for completed RMA chunk and post next ones.
+ */
+static na_return_t
+na_tcp_rma_chunk_complete(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    na_uint32_t id,
+    na_size_t len
+    );
+
+/**
+ * Start RMA operation.
+ */
+static na_return_t
+na_tcp_rma(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    struct na_tcp_mem_handle *local_mem_handle,
+    na_offset_t local_offset,
+    struct na_tcp_mem_handle *remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    struct na_tcp_addr *na_tcp_addr,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Progress callback.
+ */
+static int
+na_tcp_progress_cb(
+    void *arg,
+    unsigned int timeout,
+    hg_util_bool_t *progressed
+    );
+
+/**
+ * Progress on listening sock.
+ */
+static na_return_t
+na_tcp_progress_accept(
+    na_class_t *na_class,
+    struct na_tcp_addr *poll_addr,
+    na_bool_t *progressed
+    );
+
+/**
+ * Progress on connection (incoming frames).
+ */
+static na_return_t
+na_tcp_progress_recv(
+    na_class_t *na_class,
+    struct na_tcp_addr *poll_addr,
+    na_bool_t *progressed
+    );
+
+/**
+ * Progress on connection (blocked sends).
+ */
+static na_return_t
+na_tcp_progress_send(
+    na_class_t *na_class,
+    struct na_tcp_addr *poll_addr,
+    na_bool_t *progressed
+    );
+
+#ifdef NA_TCP_HAS_IO_URING
+/**
+ * Set up io_uring and register recv buffers.
+ */
+static na_return_t
+na_tcp_uring_init(
+    na_class_t *na_class
+    );
+
+/**
+ * Tear down io_uring.
+ */
+static na_return_t
+na_tcp_uring_finalize(
+    na_class_t *na_class
+    );
+
+/**
+ * Give recv buffer back to the kernel.
+ */
+static void
+na_tcp_uring_buf_recycle(
+    struct na_tcp_uring *na_tcp_uring,
+    unsigned short bid
+    );
+
+/**
+ * Submit queued requests (sq lock must be held).
+ */
+static na_return_t
+na_tcp_uring_submit(
+    struct na_tcp_uring *na_tcp_uring
+    );
+
+/**
+ * Get free submission entry (sq lock must be held).
+ */
+static struct io_uring_sqe *
+na_tcp_uring_get_sqe(
+    struct na_tcp_uring *na_tcp_uring
+    );
+
+/**
+ * Queue submission entry (sq lock must be held).
+ */
+static na_return_t
+na_tcp_uring_push_sqe(
+    struct na_tcp_uring *na_tcp_uring
+    );
+
+/**
+ * Post recv on connection.
+ */
+static na_return_t
+na_tcp_uring_recv_post(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Post sendmsg of queued frames (send lock must be held).
+ */
+static na_return_t
+na_tcp_uring_send_post(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Release ring request reference on connection.
+ */
+static void
+na_tcp_uring_release(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Complete recv request.
+ */
+static na_return_t
+na_tcp_uring_recv_complete(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    const struct io_uring_cqe *cqe
+    );
+
+/**
+ * Complete sendmsg request.
+ */
+static na_return_t
+na_tcp_uring_send_complete(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    const struct io_uring_cqe *cqe,
+    na_bool_t *progressed
+    );
+
+/**
+ * Reap completion queue.
+ */
+static na_return_t
+na_tcp_uring_progress(
+    na_class_t *na_class,
+    na_bool_t *progressed
+    );
+
+/**
+ * Process data received in ring buffer.
+ */
+static na_return_t
+na_tcp_recv_data(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr,
+    const char *data,
+    na_size_t len
+    );
+#endif
+
+/**
+ * Process frames received in staging buffer.
+ */
+static na_return_t
+na_tcp_recv_process(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Check that [addr, addr + len) lies within a registered memory handle that
+ * grants access flags.
+ */
+static na_bool_t
+na_tcp_mem_check(
+    na_class_t *na_class,
+    na_ptr_t addr,
+    na_uint64_t len,
+    unsigned long flags
+    );
+
+/**
+ * Match received header and set payload destination.
+ */
+static na_return_t
+na_tcp_recv_hdr(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Complete received frame.
+ */
+static na_return_t
+na_tcp_recv_done(
+    na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr
+    );
+
+/**
+ * Send message.
+ */
+static na_return_t
+na_tcp_msg_send(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    struct na_tcp_addr *na_tcp_addr,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/**
+ * Complete operation.
+ */
+static na_return_t
+na_tcp_complete(
+    struct na_tcp_op_id *na_tcp_op_id
+    );
+
+/**
+ * Release memory.
+ */
+static void
+na_tcp_release(
+    void *arg
+    );
+
+/**
+ * Allocate operation ID, from context pool if context is not NULL.
+ */
+static struct na_tcp_op_id *
+na_tcp_op_alloc(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* check_protocol */
+static na_bool_t
+na_tcp_check_protocol(
+    const char *protocol_name
+    );
+
+/* initialize */
+static na_return_t
+na_tcp_initialize(
+    na_class_t *na_class,
+    const struct na_info *na_info,
+    na_bool_t listen
+    );
+
+/* finalize */
+static na_return_t
+na_tcp_finalize(
+    na_class_t *na_class
+    );
+
+/* check_feature */
+static na_bool_t
+na_tcp_check_feature(
+    na_class_t *na_class,
+    na_uint8_t feature
+    );
+
+/* op_create */
+static na_op_id_t
+na_tcp_op_create(
+    na_class_t *na_class
+    );
+
+/* op_destroy */
+static na_return_t
+na_tcp_op_destroy(
+    na_class_t *na_class,
+    na_op_id_t op_id
+    );
+
+/* addr_lookup */
+static na_return_t
+na_tcp_addr_lookup(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const char *name,
+    na_op_id_t *op_id
+    );
+
+/* addr_free */
+static na_return_t
+na_tcp_addr_free(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_self */
+static na_return_t
+na_tcp_addr_self(
+    na_class_t *na_class,
+    na_addr_t *addr
+    );
+
+/* addr_dup */
+static na_return_t
+na_tcp_addr_dup(
+    na_class_t *na_class,
+    na_addr_t addr,
+    na_addr_t *new_addr
+    );
+
+/* addr_is_self */
+static na_bool_t
+na_tcp_addr_is_self(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_to_string */
+static na_return_t
+na_tcp_addr_to_string(
+    na_class_t *na_class,
+    char *buf,
+    na_size_t *buf_size,
+    na_addr_t addr
+    );
+
+/* msg_get_max_unexpected_size */
+static na_size_t
+na_tcp_msg_get_max_unexpected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_expected_size */
+static na_size_t
+na_tcp_msg_get_max_expected_size(
+    const na_class_t *na_class
+    );
+
+/* msg_get_max_tag */
+static na_tag_t
+na_tcp_msg_get_max_tag(
+    const na_class_t *na_class
+    );
+
+/* msg_send_unexpected */
+static na_return_t
+na_tcp_msg_send_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_unexpected */
+static na_return_t
+na_tcp_msg_recv_unexpected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_tag_t mask,
+    na_op_id_t *op_id
+    );
+
+/* msg_send_expected */
+static na_return_t
+na_tcp_msg_send_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t dest,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* msg_recv_expected */
+static na_return_t
+na_tcp_msg_recv_expected(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    void *buf,
+    na_size_t buf_size,
+    void *plugin_data,
+    na_addr_t source,
+    na_tag_t tag,
+    na_op_id_t *op_id
+    );
+
+/* mem_handle */
+static na_return_t
+na_tcp_mem_handle_create(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    unsigned long flags,
+    na_mem_handle_t *mem_handle
+    );
+
+static na_return_t
+na_tcp_mem_handle_free(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_tcp_mem_register(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_tcp_mem_deregister(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+/* mem_handle serialization */
+static na_size_t
+na_tcp_mem_handle_get_serialize_size(
+    na_class_t *na_class,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_tcp_mem_handle_serialize(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    na_mem_handle_t mem_handle
+    );
+
+static na_return_t
+na_tcp_mem_handle_deserialize(
+    na_class_t *na_class,
+    na_mem_handle_t *mem_handle,
+    const void *buf,
+    na_size_t buf_size
+    );
+
+/* put */
+static na_return_t
+na_tcp_put(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* get */
+static na_return_t
+na_tcp_get(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id
+    );
+
+/* poll_get_fd */
+static int
+na_tcp_poll_get_fd(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* poll_try_wait */
+static na_bool_t
+na_tcp_poll_try_wait(
+    na_class_t *na_class,
+    na_context_t *context
+    );
+
+/* progress */
+static na_return_t
+na_tcp_progress(
+    na_class_t *na_class,
+    na_context_t *context,
+    unsigned int timeout
+    );
+
+/* cancel */
+static na_return_t
+na_tcp_cancel(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_op_id_t op_id
+    );
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+const na_class_t na_tcp_class_g = {
+    NULL,                                   /* private_data */
+    "tcp",                                  /* name */
+    na_tcp_check_protocol,                  /* check_protocol */
+    na_tcp_initialize,                      /* initialize */
+    na_tcp_finalize,                        /* finalize */
+    NULL,                                   /* cleanup */
+    na_tcp_check_feature,                   /* check_feature */
+    NULL,                                   /* context_create */
+    NULL,                                   /* context_destroy */
+    na_tcp_op_create,                       /* op_create */
+    na_tcp_op_destroy,                      /* op_destroy */
+    na_tcp_addr_lookup,                     /* addr_lookup */
+    na_tcp_addr_free,                       /* addr_free */
+    na_tcp_addr_self,                       /* addr_self */
+    na_tcp_addr_dup,                        /* addr_dup */
+    na_tcp_addr_is_self,                    /* addr_is_self */
+    na_tcp_addr_to_string,                  /* addr_to_string */
+    na_tcp_msg_get_max_unexpected_size,     /* msg_get_max_unexpected_size */
+    na_tcp_msg_get_max_expected_size,       /* msg_get_max_expected_size */
+    NULL,                                   /* msg_get_unexpected_header_size */
+    NULL,                                   /* msg_get_expected_header_size */
+    na_tcp_msg_get_max_tag,                 /* msg_get_max_tag */
+    NULL,                                   /* msg_buf_alloc */
+    NULL,                                   /* msg_buf_free */
+    NULL,                                   /* msg_init_unexpected */
+    na_tcp_msg_send_unexpected,             /* msg_send_unexpected */
+    na_tcp_msg_recv_unexpected,             /* msg_recv_unexpected */
+    NULL,                                   /* msg_init_expected */
+    na_tcp_msg_send_expected,               /* msg_send_expected */
+    na_tcp_msg_recv_expected,               /* msg_recv_expected */
+    NULL,                                   /* mem_alloc */
+    NULL,                                   /* mem_free */
+    na_tcp_mem_handle_create,               /* mem_handle_create */
+    NULL,                                   /* mem_handle_create_segments */
+    na_tcp_mem_handle_free,                 /* mem_handle_free */
+    na_tcp_mem_register,                    /* mem_register */
+    na_tcp_mem_deregister,                  /* mem_deregister */
+    NULL,                                   /* mem_publish */
+    NULL,                                   /* mem_unpublish */
+    na_tcp_mem_handle_get_serialize_size,   /* mem_handle_get_serialize_size */
+    na_tcp_mem_handle_serialize,            /* mem_handle_serialize */
+    na_tcp_mem_handle_deserialize,          /* mem_handle_deserialize */
+    na_tcp_put,                             /* put */
+    na_tcp_get,                             /* get */
+    na_tcp_poll_get_fd,                     /* poll_get_fd */
+    na_tcp_poll_try_wait,                   /* poll_try_wait */
+    na_tcp_progress,                        /* progress */
+    na_tcp_cancel                           /* cancel */
+};
+
+/********************/
+/* Plugin callbacks */
+/********************/
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_parse_name(const char *name, char *host, char *port)
+{
+    const char *sep;
+    na_size_t host_len;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Skip protocol if any: <protocol>://<host>:<port> */
+    if ((sep = strstr(name, "://")) != NULL)
+        name = sep + 3;
+
+    sep = strrchr(name, ':');
+    host_len = (sep) ? (na_size_t) (sep - name) : strlen(name);
+    if (host_len >= NA_TCP_MAX_ADDR_NAME
+        || (sep && strlen(sep + 1) >= NA_TCP_MAX_ADDR_NAME)) {
+        NA_LOG_ERROR("Exceeding max addr name");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+    memcpy(host, name, host_len);
+    host[host_len] = '\0';
+    strcpy(port, (sep) ? sep + 1 : "");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_sock_setup(int sock)
+{
+    int flags, nodelay = 1;
+    na_return_t ret = NA_SUCCESS;
+
+    flags = fcntl(sock, F_GETFL, 0);
+    if (flags == -1 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) == -1) {
+        NA_LOG_ERROR("fcntl() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Messages are small and latency bound, do not coalesce them */
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay,
+        sizeof(nodelay)) == -1) {
+        NA_LOG_ERROR("setsockopt() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+#ifdef SO_NOSIGPIPE
+    if (setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &nodelay,
+        sizeof(nodelay)) == -1) {
+        NA_LOG_ERROR("setsockopt() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+#endif
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_listen(const char *host, const char *port, int *sock)
+{
+    struct addrinfo hints, *res = NULL, *rp;
+    int fd = -1, reuse = 1, rc, err = 0;
+    na_return_t ret = NA_SUCCESS;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    rc = getaddrinfo((host && *host) ? host : NULL, (port && *port) ? port : "0",
+        &hints, &res);
+    if (rc != 0) {
+        NA_LOG_ERROR("getaddrinfo() failed (%s)", gai_strerror(rc));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    for (rp = res; rp; rp = rp->ai_next) {
+#ifdef SOCK_NONBLOCK
+        fd = socket(rp->ai_family, rp->ai_socktype | SOCK_NONBLOCK,
+            rp->ai_protocol);
+#else
+        fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+#endif
+        if (fd == -1) {
+            err = errno;
+            continue;
+        }
+#ifndef SOCK_NONBLOCK
+        if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
+            err = errno;
+            close(fd);
+            fd = -1;
+            continue;
+        }
+#endif
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse,
+            sizeof(reuse)) == 0
+            && bind(fd, rp->ai_addr, rp->ai_addrlen) == 0
+            && listen(fd, SOMAXCONN) == 0)
+            break;
+
+        err = errno;
+        close(fd);
+        fd = -1;
+    }
+    if (fd == -1) {
+        NA_LOG_ERROR("Could not listen on %s:%s (%s)", (host) ? host : "",
+            (port) ? port : "", strerror(err));
+        ret = (err == EADDRINUSE) ? NA_ADDRINUSE_ERROR : NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    *sock = fd;
+
+done:
+    if (res)
+        freeaddrinfo(res);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_connect(const char *host, const char *port, int *sock)
+{
+    struct addrinfo hints, *res = NULL, *rp;
+    int fd = -1, rc, err = 0;
+    na_return_t ret = NA_SUCCESS;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    rc = getaddrinfo(host, port, &hints, &res);
+    if (rc != 0) {
+        NA_LOG_ERROR("getaddrinfo() failed (%s)", gai_strerror(rc));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Connect is blocking, sock is only set non-blocking once connected */
+    for (rp = res; rp; rp = rp->ai_next) {
+        fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+        if (fd == -1) {
+            err = errno;
+            continue;
+        }
+        do {
+            rc = connect(fd, rp->ai_addr, rp->ai_addrlen);
+        } while (rc == -1 && errno == EINTR);
+        if (rc == 0)
+            break;
+
+        err = errno;
+        close(fd);
+        fd = -1;
+    }
+    if (fd == -1) {
+        NA_LOG_ERROR("Could not connect to %s:%s (%s)", host, port,
+            strerror(err));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    ret = na_tcp_sock_setup(fd);
+    if (ret != NA_SUCCESS) {
+        close(fd);
+        goto done;
+    }
+
+    *sock = fd;
+
+done:
+    if (res)
+        freeaddrinfo(res);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_create(int sock, struct na_tcp_addr **addr)
+{
+    struct na_tcp_addr *na_tcp_addr = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_addr = (struct na_tcp_addr *) malloc(sizeof(struct na_tcp_addr));
+    if (!na_tcp_addr) {
+        NA_LOG_ERROR("Could not allocate NA TCP addr");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_tcp_addr, 0, sizeof(struct na_tcp_addr));
+    na_tcp_addr->sock = sock;
+    hg_atomic_init32(&na_tcp_addr->failed, NA_FALSE);
+    hg_atomic_init32(&na_tcp_addr->ref_count, 1);
+    HG_QUEUE_INIT(&na_tcp_addr->send_queue);
+    HG_QUEUE_INIT(&na_tcp_addr->rma_op_queue);
+
+    /* Writes are polled on a separate descriptor so that both directions
+     * can be registered to the poll set independently */
+    na_tcp_addr->send_sock = dup(sock);
+    if (na_tcp_addr->send_sock == -1) {
+        NA_LOG_ERROR("dup() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        free(na_tcp_addr);
+        goto done;
+    }
+
+    na_tcp_addr->rx_buf = (char *) malloc(NA_TCP_RECV_BUF_SIZE);
+    if (!na_tcp_addr->rx_buf) {
+        NA_LOG_ERROR("Could not allocate recv buffer");
+        ret = NA_NOMEM_ERROR;
+        close(na_tcp_addr->send_sock);
+        free(na_tcp_addr);
+        goto done;
+    }
+    hg_thread_mutex_init(&na_tcp_addr->send_lock);
+
+    *addr = na_tcp_addr;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_addr_destroy(struct na_tcp_addr *na_tcp_addr)
+{
+    hg_thread_mutex_destroy(&na_tcp_addr->send_lock);
+    free(na_tcp_addr->rx_buf);
+    free(na_tcp_addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_addr_fail(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    if (!hg_atomic_cas32(&na_tcp_addr->failed, NA_FALSE, NA_TRUE))
+        return;
+
+    /* Sockets cannot be removed from the poll set while waiting on it */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+    if (!na_tcp_addr->closing) {
+        na_tcp_addr->closing = NA_TRUE;
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue,
+            na_tcp_addr, close_entry);
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_close(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_op_queue failed_op_queue;
+    struct na_tcp_op_id *na_tcp_op_id, *next_op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_atomic_set32(&na_tcp_addr->failed, NA_TRUE);
+    HG_QUEUE_INIT(&failed_op_queue);
+
+    /* Connection may be closed before it was ever registered */
+    hg_thread_spin_lock(
+        &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+    if (na_tcp_addr->register_queued) {
+        HG_QUEUE_REMOVE(&NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue,
+            na_tcp_addr, na_tcp_addr, register_entry);
+        na_tcp_addr->register_queued = NA_FALSE;
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+
+    /* Remove sockets from poll set */
+    if (na_tcp_addr->recv_poll_data) {
+        ret = na_tcp_poll_deregister(na_class, NA_TCP_RECV, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not remove sock from poll set");
+            goto done;
+        }
+    }
+    if (na_tcp_addr->send_poll_data) {
+        ret = na_tcp_poll_deregister(na_class, NA_TCP_SEND, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not remove sock from poll set");
+            goto done;
+        }
+    }
+
+    /* Fail frames not sent and RMA operations in flight */
+    hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+#ifdef NA_TCP_HAS_IO_URING
+    /* Ring may still be reading from queued frames, they are failed once
+     * the sendmsg in flight completes */
+    if (!na_tcp_addr->tx_busy)
+#endif
+        na_tcp_send_fail(na_tcp_addr, &failed_op_queue);
+    if (na_tcp_addr->send_pending) {
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+        HG_QUEUE_REMOVE(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue,
+            na_tcp_addr, na_tcp_addr, send_entry);
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+        na_tcp_addr->send_pending = NA_FALSE;
+    }
+#ifdef NA_TCP_HAS_IO_URING
+    /* Terminate ring requests still referencing the sock */
+    if (NA_TCP_PRIVATE_DATA(na_class)->uring)
+        shutdown(na_tcp_addr->sock, SHUT_RDWR);
+#endif
+    close(na_tcp_addr->sock);
+    close(na_tcp_addr->send_sock);
+    na_tcp_addr->sock = -1;
+    na_tcp_addr->send_sock = -1;
+    hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+
+    /* Fail message being received (RMA ops were already failed above) */
+    if (na_tcp_addr->rx_payload) {
+        if (na_tcp_addr->rx_hdr.type == NA_TCP_UNEXPECTED
+            || na_tcp_addr->rx_hdr.type == NA_TCP_EXPECTED) {
+            if (na_tcp_addr->rx_op_id) {
+                na_tcp_addr->rx_op_id->ret = NA_PROTOCOL_ERROR;
+                HG_QUEUE_PUSH_TAIL(&failed_op_queue, na_tcp_addr->rx_op_id,
+                    entry);
+            } else
+                free(na_tcp_addr->rx_unexpected_info);
+        }
+        na_tcp_addr->rx_payload = NA_FALSE;
+        na_tcp_addr->rx_op_id = NULL;
+        na_tcp_addr->rx_unexpected_info = NULL;
+    }
+    na_tcp_addr->rx_start = na_tcp_addr->rx_end = 0;
+
+    /* Expected messages from that peer will never arrive */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    na_tcp_op_id = HG_QUEUE_FIRST(
+        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue);
+    while (na_tcp_op_id) {
+        next_op_id = HG_QUEUE_NEXT(na_tcp_op_id, entry);
+        if (na_tcp_op_id->info.recv_expected.na_tcp_addr == na_tcp_addr) {
+            HG_QUEUE_REMOVE(&NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue,
+                na_tcp_op_id, na_tcp_op_id, entry);
+            na_tcp_op_id->ret = NA_PROTOCOL_ERROR;
+            HG_QUEUE_PUSH_TAIL(&failed_op_queue, na_tcp_op_id, entry);
+        }
+        na_tcp_op_id = next_op_id;
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+    /* Next lookups must reconnect */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+    if (na_tcp_addr->cached) {
+        HG_LIST_REMOVE(na_tcp_addr, conn_entry);
+        na_tcp_addr->cached = NA_FALSE;
+    }
+    hg_thread_spin_unlock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+
+    ret = na_tcp_fail_complete(na_class, na_tcp_addr, &failed_op_queue);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete failed operations");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_poll_register(na_class_t *na_class, na_tcp_poll_type_t poll_type,
+    struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_poll_data *na_tcp_poll_data = NULL;
+    struct na_tcp_poll_data **na_tcp_poll_data_ptr = NULL;
+    unsigned int flags = HG_POLLIN;
+    int fd;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (poll_type) {
+        case NA_TCP_ACCEPT:
+        case NA_TCP_RECV:
+            fd = na_tcp_addr->sock;
+            na_tcp_poll_data_ptr = &na_tcp_addr->recv_poll_data;
+            break;
+        case NA_TCP_SEND:
+            fd = na_tcp_addr->send_sock;
+            na_tcp_poll_data_ptr = &na_tcp_addr->send_poll_data;
+            flags = HG_POLLOUT;
+            break;
+        default:
+            NA_LOG_ERROR("Invalid poll type");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    na_tcp_poll_data = (struct na_tcp_poll_data *) malloc(
+        sizeof(struct na_tcp_poll_data));
+    if (!na_tcp_poll_data) {
+        NA_LOG_ERROR("Could not allocate NA TCP poll data");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    na_tcp_poll_data->na_class = na_class;
+    na_tcp_poll_data->type = poll_type;
+    na_tcp_poll_data->addr = na_tcp_addr;
+
+    if (hg_poll_add(NA_TCP_PRIVATE_DATA(na_class)->poll_set, fd, flags,
+        na_tcp_progress_cb, na_tcp_poll_data) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("hg_poll_add failed");
+        free(na_tcp_poll_data);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    *na_tcp_poll_data_ptr = na_tcp_poll_data;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_poll_deregister(na_class_t *na_class, na_tcp_poll_type_t poll_type,
+    struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_poll_data **na_tcp_poll_data_ptr = NULL;
+    int fd;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (poll_type) {
+        case NA_TCP_ACCEPT:
+        case NA_TCP_RECV:
+            fd = na_tcp_addr->sock;
+            na_tcp_poll_data_ptr = &na_tcp_addr->recv_poll_data;
+            break;
+        case NA_TCP_SEND:
+            fd = na_tcp_addr->send_sock;
+            na_tcp_poll_data_ptr = &na_tcp_addr->send_poll_data;
+            break;
+        default:
+            NA_LOG_ERROR("Invalid poll type");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    if (hg_poll_remove(NA_TCP_PRIVATE_DATA(na_class)->poll_set,
+        fd) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("hg_poll_remove failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    free(*na_tcp_poll_data_ptr);
+    *na_tcp_poll_data_ptr = NULL;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_poll_update(na_class_t *na_class, na_bool_t *progressed)
+{
+    HG_QUEUE_HEAD(na_tcp_addr) send_addr_queue;
+    struct na_tcp_addr *na_tcp_addr;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Register new connections */
+    for (;;) {
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+        na_tcp_addr = HG_QUEUE_FIRST(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue);
+        HG_QUEUE_POP_HEAD(&NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue,
+            register_entry);
+        if (na_tcp_addr)
+            na_tcp_addr->register_queued = NA_FALSE;
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+        if (!na_tcp_addr)
+            break;
+        if (hg_atomic_get32(&na_tcp_addr->failed))
+            continue;
+
+#ifdef NA_TCP_HAS_IO_URING
+        /* Incoming data is received from the ring */
+        if (NA_TCP_PRIVATE_DATA(na_class)->uring) {
+            ret = na_tcp_uring_recv_post(na_class, na_tcp_addr);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not post recv");
+                goto done;
+            }
+            *progressed = NA_TRUE;
+            continue;
+        }
+#endif
+        ret = na_tcp_poll_register(na_class, NA_TCP_RECV, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not add sock to poll set");
+            goto done;
+        }
+        *progressed = NA_TRUE;
+    }
+
+    /* Poll blocked sends for write until their queue drains */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+    send_addr_queue.head = NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue.head;
+    send_addr_queue.tail = (send_addr_queue.head) ?
+        NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue.tail
+        : &send_addr_queue.head;
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue);
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+
+    while ((na_tcp_addr = HG_QUEUE_FIRST(&send_addr_queue)) != NULL) {
+        na_bool_t drained;
+
+        HG_QUEUE_POP_HEAD(&send_addr_queue, send_entry);
+
+        hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+        drained = HG_QUEUE_IS_EMPTY(&na_tcp_addr->send_queue)
+            || hg_atomic_get32(&na_tcp_addr->failed);
+        if (drained)
+            na_tcp_addr->send_pending = NA_FALSE;
+        hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+
+        if (drained) {
+            if (na_tcp_addr->send_poll_data) {
+                ret = na_tcp_poll_deregister(na_class, NA_TCP_SEND,
+                    na_tcp_addr);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not remove sock from poll set");
+                    goto done;
+                }
+            }
+            continue;
+        }
+        if (!na_tcp_addr->send_poll_data) {
+            ret = na_tcp_poll_register(na_class, NA_TCP_SEND, na_tcp_addr);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not add sock to poll set");
+                goto done;
+            }
+            *progressed = NA_TRUE;
+        }
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue,
+            na_tcp_addr, send_entry);
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+    }
+
+    /* Close failed connections and destroy released addrs */
+    for (;;) {
+        na_bool_t release = NA_FALSE, destroy;
+
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+        na_tcp_addr = HG_QUEUE_FIRST(
+            &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue);
+        HG_QUEUE_POP_HEAD(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue,
+            close_entry);
+        if (na_tcp_addr)
+            na_tcp_addr->closing = NA_FALSE;
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+        if (!na_tcp_addr)
+            break;
+        *progressed = NA_TRUE;
+
+        if (na_tcp_addr->sock != -1) {
+            ret = na_tcp_addr_close(na_class, na_tcp_addr);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not close connection");
+                goto done;
+            }
+        }
+
+        /* Drop reference held by accepted addr queue */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        if (na_tcp_addr->accepted_queued) {
+            HG_QUEUE_REMOVE(&NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue,
+                na_tcp_addr, na_tcp_addr, entry);
+            na_tcp_addr->accepted_queued = NA_FALSE;
+            release = NA_TRUE;
+        }
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        if (release)
+            na_tcp_addr_free(na_class, na_tcp_addr);
+
+        /* If released again above, addr is destroyed when popped next */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+        destroy = na_tcp_addr->released && !na_tcp_addr->closing;
+#ifdef NA_TCP_HAS_IO_URING
+        /* Otherwise pushed back once last ring request completes */
+        destroy = destroy && !hg_atomic_get32(&na_tcp_addr->uring_refs);
+#endif
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+        if (destroy)
+            na_tcp_addr_destroy(na_tcp_addr);
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_tcp_send_iov(struct na_tcp_addr *na_tcp_addr, struct iovec *iov,
+    size_t *iov_len)
+{
+    struct na_tcp_frame *na_tcp_frame;
+    int iovcnt = 0;
+
+    *iov_len = 0;
+    HG_QUEUE_FOREACH(na_tcp_frame, &na_tcp_addr->send_queue, entry) {
+        na_size_t hdr_size = sizeof(struct na_tcp_hdr);
+
+        if (iovcnt + 2 > NA_TCP_IOV_MAX)
+            break;
+        if (na_tcp_frame->sent < hdr_size) {
+            iov[iovcnt].iov_base =
+                (char *) &na_tcp_frame->hdr + na_tcp_frame->sent;
+            iov[iovcnt].iov_len = hdr_size - na_tcp_frame->sent;
+            *iov_len += iov[iovcnt].iov_len;
+            iovcnt++;
+        }
+        if (na_tcp_frame->hdr.size) {
+            na_size_t offset = (na_tcp_frame->sent > hdr_size) ?
+                na_tcp_frame->sent - hdr_size : 0;
+
+            iov[iovcnt].iov_base = (char *) na_tcp_frame->payload + offset;
+            iov[iovcnt].iov_len = na_tcp_frame->hdr.size - offset;
+            *iov_len += iov[iovcnt].iov_len;
+            iovcnt++;
+        }
+    }
+
+    return iovcnt;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_send_consume(struct na_tcp_addr *na_tcp_addr, na_size_t nsent,
+    na_bool_t *progressed)
+{
+    while (nsent > 0) {
+        struct na_tcp_frame *na_tcp_frame =
+            HG_QUEUE_FIRST(&na_tcp_addr->send_queue);
+        na_size_t left = sizeof(struct na_tcp_hdr) + na_tcp_frame->hdr.size
+            - na_tcp_frame->sent;
+
+        if (nsent < left) {
+            na_tcp_frame->sent += nsent;
+            break;
+        }
+        nsent -= left;
+        HG_QUEUE_POP_HEAD(&na_tcp_addr->send_queue, entry);
+        if (na_tcp_frame->na_tcp_op_id) {
+            if (na_tcp_complete(na_tcp_frame->na_tcp_op_id) != NA_SUCCESS)
+                NA_LOG_ERROR("Could not complete operation");
+        } else
+            free(na_tcp_frame);
+        if (progressed)
+            *progressed = NA_TRUE;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_send_fail(struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_op_queue *failed_op_queue)
+{
+    struct na_tcp_frame *na_tcp_frame;
+    struct na_tcp_op_id *na_tcp_op_id;
+
+    while ((na_tcp_frame = HG_QUEUE_FIRST(&na_tcp_addr->send_queue)) != NULL) {
+        HG_QUEUE_POP_HEAD(&na_tcp_addr->send_queue, entry);
+        if (na_tcp_frame->na_tcp_op_id) {
+            na_tcp_frame->na_tcp_op_id->ret = NA_PROTOCOL_ERROR;
+            HG_QUEUE_PUSH_TAIL(failed_op_queue, na_tcp_frame->na_tcp_op_id,
+                entry);
+        } else
+            free(na_tcp_frame);
+    }
+    while ((na_tcp_op_id = HG_QUEUE_FIRST(&na_tcp_addr->rma_op_queue))
+        != NULL) {
+        HG_QUEUE_POP_HEAD(&na_tcp_addr->rma_op_queue, entry);
+        na_tcp_op_id->ret = NA_PROTOCOL_ERROR;
+        HG_QUEUE_PUSH_TAIL(failed_op_queue, na_tcp_op_id, entry);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_fail_complete(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_op_queue *failed_op_queue)
+{
+    struct na_tcp_op_id *na_tcp_op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    while ((na_tcp_op_id = HG_QUEUE_FIRST(failed_op_queue)) != NULL) {
+        na_cb_type_t cb_type = na_tcp_op_id->completion_data.callback_info.type;
+
+        HG_QUEUE_POP_HEAD(failed_op_queue, entry);
+        ret = na_tcp_complete(na_tcp_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+        /* Release ref taken when RMA operation was posted */
+        if (cb_type == NA_CB_PUT || cb_type == NA_CB_GET)
+            na_tcp_addr_free(na_class, na_tcp_addr);
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_send_flush(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr,
+    na_bool_t *progressed)
+{
+    struct iovec iov[NA_TCP_IOV_MAX];
+
+#ifdef NA_TCP_HAS_IO_URING
+    /* Queue is owned by the sendmsg in flight until it completes */
+    if (na_tcp_addr->tx_busy)
+        return;
+#endif
+
+    while (!HG_QUEUE_IS_EMPTY(&na_tcp_addr->send_queue)
+        && !hg_atomic_get32(&na_tcp_addr->failed)) {
+        struct msghdr msg;
+        size_t iov_len;
+        ssize_t nsent;
+
+        /* Gather queued frames into a single call */
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = na_tcp_send_iov(na_tcp_addr, iov, &iov_len);
+        nsent = sendmsg(na_tcp_addr->sock, &msg, MSG_NOSIGNAL);
+        if (nsent == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                NA_LOG_ERROR("sendmsg() failed (%s)", strerror(errno));
+                na_tcp_addr_fail(na_class, na_tcp_addr);
+            }
+            break;
+        }
+
+        /* Complete frames entirely sent */
+        na_tcp_send_consume(na_tcp_addr, (na_size_t) nsent, progressed);
+
+        /* Short write, sock buffer is full */
+        if ((size_t) nsent < iov_len)
+            break;
+    }
+
+#ifdef NA_TCP_HAS_IO_URING
+    /* Rest is sent from the ring, which completes once sock drains */
+    if (NA_TCP_PRIVATE_DATA(na_class)->uring) {
+        if (!HG_QUEUE_IS_EMPTY(&na_tcp_addr->send_queue)
+            && !hg_atomic_get32(&na_tcp_addr->failed)
+            && na_tcp_uring_send_post(na_class, na_tcp_addr) != NA_SUCCESS)
+            na_tcp_addr_fail(na_class, na_tcp_addr);
+        return;
+    }
+#endif
+
+    /* Let progress poll the sock for write until queue drains */
+    if (!HG_QUEUE_IS_EMPTY(&na_tcp_addr->send_queue)
+        && !na_tcp_addr->send_pending
+        && !hg_atomic_get32(&na_tcp_addr->failed)) {
+        na_tcp_addr->send_pending = NA_TRUE;
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue,
+            na_tcp_addr, send_entry);
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_send_frame(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_frame *na_tcp_frame)
+{
+    na_bool_t blocked;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_frame->sent = 0;
+
+    hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+    if (hg_atomic_get32(&na_tcp_addr->failed)) {
+        hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+        NA_LOG_ERROR("Connection to %s is closed", na_tcp_addr->name);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Frames already queued are waiting for the sock to become writable */
+    blocked = !HG_QUEUE_IS_EMPTY(&na_tcp_addr->send_queue);
+    HG_QUEUE_PUSH_TAIL(&na_tcp_addr->send_queue, na_tcp_frame, entry);
+    if (!blocked)
+        na_tcp_send_flush(na_class, na_tcp_addr, NULL);
+    hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_rma_post(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr,
+    struct na_tcp_op_id *na_tcp_op_id)
+{
+    struct na_tcp_info_rma *na_tcp_info_rma = &na_tcp_op_id->info.rma;
+    na_bool_t put =
+        (na_tcp_op_id->completion_data.callback_info.type == NA_CB_PUT);
+    na_bool_t blocked = !HG_QUEUE_IS_EMPTY(&na_tcp_addr->send_queue);
+    na_return_t ret = NA_SUCCESS;
+
+    /* Keep window of chunks in flight, other frames can be interleaved
+     * between chunks so that large transfers do not hold up messages */
+    while (na_tcp_info_rma->posted < na_tcp_info_rma->length
+        && na_tcp_info_rma->in_flight
+        < NA_TCP_PRIVATE_DATA(na_class)->rma_window) {
+        struct na_tcp_frame *na_tcp_frame;
+        na_size_t len = NA_TCP_MIN(NA_TCP_PRIVATE_DATA(na_class)->rma_chunk_size,
+            na_tcp_info_rma->length - na_tcp_info_rma->posted);
+
+        na_tcp_frame = (struct na_tcp_frame *) malloc(
+            sizeof(struct na_tcp_frame));
+        if (!na_tcp_frame) {
+            NA_LOG_ERROR("Could not allocate NA TCP frame");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+        na_tcp_frame->hdr.type = (put) ? NA_TCP_PUT : NA_TCP_GET;
+        na_tcp_frame->hdr.tag = na_tcp_info_rma->id;
+        na_tcp_frame->hdr.size = (put) ? len : 0;
+        na_tcp_frame->hdr.addr = na_tcp_info_rma->remote_addr
+            + na_tcp_info_rma->posted;
+        na_tcp_frame->hdr.len = len;
+        na_tcp_frame->payload = (put) ?
+            na_tcp_info_rma->local_buf + na_tcp_info_rma->posted : NULL;
+        na_tcp_frame->sent = 0;
+        na_tcp_frame->na_tcp_op_id = NULL;
+        HG_QUEUE_PUSH_TAIL(&na_tcp_addr->send_queue, na_tcp_frame, entry);
+
+        na_tcp_info_rma->posted += len;
+        na_tcp_info_rma->in_flight++;
+    }
+
+done:
+    if (!blocked)
+        na_tcp_send_flush(na_class, na_tcp_addr, NULL);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_rma_chunk_complete(na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr, na_uint32_t id, na_size_t len)
+{
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    na_bool_t completed = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+    HG_QUEUE_FOREACH(na_tcp_op_id, &na_tcp_addr->rma_op_queue, entry) {
+        if (na_tcp_op_id->info.rma.id == id)
+            break;
+    }
+    if (!na_tcp_op_id) {
+        hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+        NA_LOG_WARNING("Ignored RMA chunk of unknown operation");
+        goto done;
+    }
+    na_tcp_op_id->info.rma.completed += len;
+    na_tcp_op_id->info.rma.in_flight--;
+    if (na_tcp_op_id->info.rma.completed >= na_tcp_op_id->info.rma.length) {
+        HG_QUEUE_REMOVE(&na_tcp_addr->rma_op_queue, na_tcp_op_id, na_tcp_op_id,
+            entry);
+        completed = NA_TRUE;
+    } else {
+        ret = na_tcp_rma_post(na_class, na_tcp_addr, na_tcp_op_id);
+        if (ret != NA_SUCCESS)
+            NA_LOG_ERROR("Could not post RMA chunks");
+    }
+    hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+
+    if (completed) {
+        ret = na_tcp_complete(na_tcp_op_id);
+        /* Release ref taken when operation was posted */
+        na_tcp_addr_free(na_class, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_rma(na_class_t *na_class, na_context_t *context, na_cb_type_t cb_type,
+    na_cb_t callback, void *arg, struct na_tcp_mem_handle *local_mem_handle,
+    na_offset_t local_offset, struct na_tcp_mem_handle *remote_mem_handle,
+    na_offset_t remote_offset, na_size_t length,
+    struct na_tcp_addr *na_tcp_addr, na_op_id_t *op_id)
+{
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (local_offset + length > local_mem_handle->size
+        || remote_offset + length > remote_mem_handle->size) {
+        NA_LOG_ERROR("Exceeds size of registered memory");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+    if (na_tcp_addr->self) {
+        NA_LOG_ERROR("RMA to self is not supported");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_tcp_op_id = (struct na_tcp_op_id *) *op_id;
+        hg_atomic_incr32(&na_tcp_op_id->ref_count);
+    } else {
+        na_tcp_op_id = na_tcp_op_alloc(na_class, context);
+        if (!na_tcp_op_id) {
+            NA_LOG_ERROR("Could not allocate NA TCP operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_tcp_op_id->context = context;
+    na_tcp_op_id->completion_data.callback_info.type = cb_type;
+    na_tcp_op_id->completion_data.callback = callback;
+    na_tcp_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_tcp_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_tcp_op_id->canceled, NA_FALSE);
+    na_tcp_op_id->ret = NA_SUCCESS;
+    na_tcp_op_id->info.rma.na_tcp_addr = na_tcp_addr;
+    na_tcp_op_id->info.rma.local_buf =
+        (char *) local_mem_handle->base + local_offset;
+    na_tcp_op_id->info.rma.remote_addr = remote_mem_handle->base
+        + remote_offset;
+    na_tcp_op_id->info.rma.length = length;
+    na_tcp_op_id->info.rma.posted = 0;
+    na_tcp_op_id->info.rma.recvd = 0;
+    na_tcp_op_id->info.rma.completed = 0;
+    na_tcp_op_id->info.rma.in_flight = 0;
+    na_tcp_op_id->info.rma.id = (na_uint32_t) hg_atomic_incr32(
+        &NA_TCP_PRIVATE_DATA(na_class)->rma_id);
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_tcp_op_id;
+
+    if (!length) {
+        ret = na_tcp_complete(na_tcp_op_id);
+        if (ret != NA_SUCCESS)
+            NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+    /* Keep addr alive until operation completes */
+    hg_atomic_incr32(&na_tcp_addr->ref_count);
+
+    hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+    if (hg_atomic_get32(&na_tcp_addr->failed)) {
+        hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+        na_tcp_addr_free(na_class, na_tcp_addr);
+        NA_LOG_ERROR("Connection to %s is closed", na_tcp_addr->name);
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    HG_QUEUE_PUSH_TAIL(&na_tcp_addr->rma_op_queue, na_tcp_op_id, entry);
+    ret = na_tcp_rma_post(na_class, na_tcp_addr, na_tcp_op_id);
+    if (ret != NA_SUCCESS && !na_tcp_op_id->info.rma.in_flight) {
+        HG_QUEUE_REMOVE(&na_tcp_addr->rma_op_queue, na_tcp_op_id,
+            na_tcp_op_id, entry);
+        hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+        na_tcp_addr_free(na_class, na_tcp_addr);
+        NA_LOG_ERROR("Could not post RMA chunks");
+        goto done;
+    }
+    /* Chunks already posted complete the operation */
+    ret = NA_SUCCESS;
+    hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+
+done:
+    if (ret != NA_SUCCESS && na_tcp_op_id) {
+        na_tcp_op_destroy(na_class, (na_op_id_t) na_tcp_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_tcp_progress_cb(void *arg, unsigned int NA_UNUSED timeout,
+    hg_util_bool_t *progressed)
+{
+    na_class_t *na_class;
+    struct na_tcp_poll_data *na_tcp_poll_data = (struct na_tcp_poll_data *) arg;
+    na_return_t na_ret;
+
+    if (!na_tcp_poll_data) {
+        NA_LOG_ERROR("NULL TCP poll data");
+        na_ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_class = na_tcp_poll_data->na_class;
+
+    switch (na_tcp_poll_data->type) {
+        case NA_TCP_ACCEPT:
+            na_ret = na_tcp_progress_accept(na_class, na_tcp_poll_data->addr,
+                (na_bool_t *) progressed);
+            if (na_ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on accept");
+                goto done;
+            }
+            break;
+        case NA_TCP_RECV:
+            na_ret = na_tcp_progress_recv(na_class, na_tcp_poll_data->addr,
+                (na_bool_t *) progressed);
+            if (na_ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on recv");
+                goto done;
+            }
+            break;
+        case NA_TCP_SEND:
+            na_ret = na_tcp_progress_send(na_class, na_tcp_poll_data->addr,
+                (na_bool_t *) progressed);
+            if (na_ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on send");
+                goto done;
+            }
+            break;
+#ifdef NA_TCP_HAS_IO_URING
+        case NA_TCP_URING:
+            na_ret = na_tcp_uring_progress(na_class, (na_bool_t *) progressed);
+            if (na_ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on ring");
+                goto done;
+            }
+            break;
+#endif
+        default:
+            NA_LOG_ERROR("Unknown poll data type");
+            na_ret = NA_PROTOCOL_ERROR;
+            goto done;
+            break;
+    }
+
+done:
+    return (na_ret == NA_SUCCESS) ? HG_UTIL_SUCCESS : HG_UTIL_FAIL;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_progress_accept(na_class_t *na_class, struct na_tcp_addr *poll_addr,
+    na_bool_t *progressed)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    for (;;) {
+        struct na_tcp_addr *na_tcp_addr = NULL;
+        struct sockaddr_storage ss;
+        socklen_t ss_len = sizeof(ss);
+        /* Numeric host always fits, so that host:serv fits in addr name */
+        char host[INET6_ADDRSTRLEN], serv[NI_MAXSERV];
+        int fd;
+
+        fd = accept(poll_addr->sock, (struct sockaddr *) &ss, &ss_len);
+        if (fd == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK
+                || errno == ECONNABORTED)
+                break;
+            NA_LOG_ERROR("accept() failed (%s)", strerror(errno));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        ret = na_tcp_sock_setup(fd);
+        if (ret != NA_SUCCESS) {
+            close(fd);
+            goto done;
+        }
+        ret = na_tcp_addr_create(fd, &na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            close(fd);
+            goto done;
+        }
+        na_tcp_addr->accepted = NA_TRUE;
+        if (getnameinfo((struct sockaddr *) &ss, ss_len, host, sizeof(host),
+            serv, sizeof(serv), NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+            snprintf(na_tcp_addr->name, NA_TCP_MAX_ADDR_NAME, "%s:%s", host,
+                serv);
+
+        /* Keep a reference to accepted addr until connection is closed */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue,
+            na_tcp_addr, entry);
+        na_tcp_addr->accepted_queued = NA_TRUE;
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+
+        /* Poll set cannot be modified while waiting on it */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue,
+            na_tcp_addr, register_entry);
+        na_tcp_addr->register_queued = NA_TRUE;
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+
+        *progressed = NA_TRUE;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_progress_recv(na_class_t *na_class, struct na_tcp_addr *poll_addr,
+    na_bool_t *progressed)
+{
+    unsigned int i;
+    na_return_t ret = NA_SUCCESS;
+
+    for (i = 0; i < NA_TCP_RECV_MAX; i++) {
+        struct iovec iov[2];
+        na_size_t direct = 0;
+        ssize_t nrecv;
+        int iovcnt = 0;
+
+        /* Connection failed, wait until it gets removed from poll set */
+        if (hg_atomic_get32(&poll_addr->failed))
+            break;
+
+        /* Payloads are received in place, only headers and small payloads
+         * go through the staging buffer (which is always empty here when
+         * a payload is being received) */
+        if (poll_addr->rx_payload
+            && poll_addr->rx_recvd < poll_addr->rx_dest_len) {
+            direct = poll_addr->rx_dest_len - poll_addr->rx_recvd;
+            iov[iovcnt].iov_base = poll_addr->rx_dest + poll_addr->rx_recvd;
+            iov[iovcnt].iov_len = direct;
+            iovcnt++;
+        }
+        iov[iovcnt].iov_base = poll_addr->rx_buf + poll_addr->rx_end;
+        iov[iovcnt].iov_len = NA_TCP_RECV_BUF_SIZE - poll_addr->rx_end;
+        iovcnt++;
+
+        nrecv = readv(poll_addr->sock, iov, iovcnt);
+        if (nrecv == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                NA_LOG_ERROR("readv() failed (%s)", strerror(errno));
+                na_tcp_addr_fail(na_class, poll_addr);
+            }
+            break;
+        }
+        if (nrecv == 0) {
+            /* Peer closed connection */
+            na_tcp_addr_fail(na_class, poll_addr);
+            break;
+        }
+        *progressed = NA_TRUE;
+
+        if (direct) {
+            na_size_t len = NA_TCP_MIN((na_size_t) nrecv, direct);
+
+            poll_addr->rx_recvd += len;
+            nrecv -= (ssize_t) len;
+        }
+        poll_addr->rx_end += (na_size_t) nrecv;
+
+        ret = na_tcp_recv_process(na_class, poll_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not process received frames");
+            goto done;
+        }
+
+        /* Short read, sock is drained */
+        if (nrecv < (ssize_t) iov[iovcnt - 1].iov_len)
+            break;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_progress_send(na_class_t *na_class, struct na_tcp_addr *poll_addr,
+    na_bool_t *progressed)
+{
+    hg_thread_mutex_lock(&poll_addr->send_lock);
+    na_tcp_send_flush(na_class, poll_addr, progressed);
+    hg_thread_mutex_unlock(&poll_addr->send_lock);
+
+    return NA_SUCCESS;
+}
+
+#ifdef NA_TCP_HAS_IO_URING
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_init(na_class_t *na_class)
+{
+    struct na_tcp_uring *na_tcp_uring = NULL;
+    struct io_uring_params params;
+    struct io_uring_buf_reg buf_reg;
+    unsigned short i;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_uring = (struct na_tcp_uring *) malloc(sizeof(struct na_tcp_uring));
+    if (!na_tcp_uring) {
+        NA_LOG_ERROR("Could not allocate NA TCP ring");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_tcp_uring, 0, sizeof(struct na_tcp_uring));
+    na_tcp_uring->fd = -1;
+    na_tcp_uring->multishot = NA_TRUE;
+    hg_thread_mutex_init(&na_tcp_uring->sq_lock);
+    NA_TCP_PRIVATE_DATA(na_class)->uring = na_tcp_uring;
+
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+    na_tcp_uring->fd = (int) syscall(__NR_io_uring_setup, NA_TCP_URING_ENTRIES,
+        &params);
+    if (na_tcp_uring->fd == -1) {
+        NA_LOG_ERROR("io_uring_setup() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    if (!(params.features & IORING_FEAT_NODROP)) {
+        NA_LOG_ERROR("Kernel may drop completions");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Map rings */
+    na_tcp_uring->sq_ring_size = params.sq_off.array
+        + params.sq_entries * sizeof(unsigned int);
+    na_tcp_uring->sq_ring = mmap(NULL, na_tcp_uring->sq_ring_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, na_tcp_uring->fd,
+        IORING_OFF_SQ_RING);
+    if (na_tcp_uring->sq_ring == MAP_FAILED) {
+        na_tcp_uring->sq_ring = NULL;
+        NA_LOG_ERROR("mmap() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_tcp_uring->cq_ring_size = params.cq_off.cqes
+        + params.cq_entries * sizeof(struct io_uring_cqe);
+    na_tcp_uring->cq_ring = mmap(NULL, na_tcp_uring->cq_ring_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, na_tcp_uring->fd,
+        IORING_OFF_CQ_RING);
+    if (na_tcp_uring->cq_ring == MAP_FAILED) {
+        na_tcp_uring->cq_ring = NULL;
+        NA_LOG_ERROR("mmap() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_tcp_uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    na_tcp_uring->sqes = (struct io_uring_sqe *) mmap(NULL,
+        na_tcp_uring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, na_tcp_uring->fd, IORING_OFF_SQES);
+    if (na_tcp_uring->sqes == MAP_FAILED) {
+        na_tcp_uring->sqes = NULL;
+        NA_LOG_ERROR("mmap() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_tcp_uring->sq_head = (unsigned int *) ((char *) na_tcp_uring->sq_ring
+        + params.sq_off.head);
+    na_tcp_uring->sq_tail = (unsigned int *) ((char *) na_tcp_uring->sq_ring
+        + params.sq_off.tail);
+    na_tcp_uring->sq_flags = (unsigned int *) ((char *) na_tcp_uring->sq_ring
+        + params.sq_off.flags);
+    na_tcp_uring->sq_array = (unsigned int *) ((char *) na_tcp_uring->sq_ring
+        + params.sq_off.array);
+    na_tcp_uring->sq_mask = *(unsigned int *) ((char *) na_tcp_uring->sq_ring
+        + params.sq_off.ring_mask);
+    na_tcp_uring->sq_entries = params.sq_entries;
+    na_tcp_uring->cq_head = (unsigned int *) ((char *) na_tcp_uring->cq_ring
+        + params.cq_off.head);
+    na_tcp_uring->cq_tail = (unsigned int *) ((char *) na_tcp_uring->cq_ring
+        + params.cq_off.tail);
+    na_tcp_uring->cq_mask = *(unsigned int *) ((char *) na_tcp_uring->cq_ring
+        + params.cq_off.ring_mask);
+    na_tcp_uring->cqes = (struct io_uring_cqe *) ((char *) na_tcp_uring->cq_ring
+        + params.cq_off.cqes);
+
+    /* Register pool of recv buffers that the kernel picks from, buffers are
+     * sized so that a message and its header are received at once */
+    na_tcp_uring->buf_ring = (struct io_uring_buf_ring *) mmap(NULL,
+        NA_TCP_URING_BUF_COUNT * sizeof(struct io_uring_buf),
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (na_tcp_uring->buf_ring == MAP_FAILED) {
+        na_tcp_uring->buf_ring = NULL;
+        NA_LOG_ERROR("mmap() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    na_tcp_uring->bufs = (char *) malloc(
+        NA_TCP_URING_BUF_COUNT * NA_TCP_URING_BUF_SIZE);
+    if (!na_tcp_uring->bufs) {
+        NA_LOG_ERROR("Could not allocate recv buffers");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(&buf_reg, 0, sizeof(buf_reg));
+    buf_reg.ring_addr = (na_uint64_t) (na_ptr_t) na_tcp_uring->buf_ring;
+    buf_reg.ring_entries = NA_TCP_URING_BUF_COUNT;
+    buf_reg.bgid = NA_TCP_URING_BGID;
+    if (syscall(__NR_io_uring_register, na_tcp_uring->fd,
+        IORING_REGISTER_PBUF_RING, &buf_reg, 1) == -1) {
+        NA_LOG_ERROR("Could not register recv buffers (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    for (i = 0; i < NA_TCP_URING_BUF_COUNT; i++)
+        na_tcp_uring_buf_recycle(na_tcp_uring, i);
+
+    /* Completions are signaled on ring fd */
+    na_tcp_uring->poll_data = (struct na_tcp_poll_data *) malloc(
+        sizeof(struct na_tcp_poll_data));
+    if (!na_tcp_uring->poll_data) {
+        NA_LOG_ERROR("Could not allocate NA TCP poll data");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    na_tcp_uring->poll_data->na_class = na_class;
+    na_tcp_uring->poll_data->type = NA_TCP_URING;
+    na_tcp_uring->poll_data->addr = NULL;
+    if (hg_poll_add(NA_TCP_PRIVATE_DATA(na_class)->poll_set, na_tcp_uring->fd,
+        HG_POLLIN, na_tcp_progress_cb, na_tcp_uring->poll_data)
+        != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("hg_poll_add failed");
+        free(na_tcp_uring->poll_data);
+        na_tcp_uring->poll_data = NULL;
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_tcp_uring)
+        na_tcp_uring_finalize(na_class);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_finalize(na_class_t *na_class)
+{
+    struct na_tcp_uring *na_tcp_uring = NA_TCP_PRIVATE_DATA(na_class)->uring;
+    na_return_t ret = NA_SUCCESS;
+
+    if (na_tcp_uring->poll_data) {
+        if (hg_poll_remove(NA_TCP_PRIVATE_DATA(na_class)->poll_set,
+            na_tcp_uring->fd) != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_remove failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        free(na_tcp_uring->poll_data);
+    }
+
+    /* Buffer ring is unregistered when ring is closed */
+    if (na_tcp_uring->fd != -1)
+        close(na_tcp_uring->fd);
+    free(na_tcp_uring->bufs);
+    if (na_tcp_uring->buf_ring)
+        munmap(na_tcp_uring->buf_ring,
+            NA_TCP_URING_BUF_COUNT * sizeof(struct io_uring_buf));
+    if (na_tcp_uring->sqes)
+        munmap(na_tcp_uring->sqes, na_tcp_uring->sqes_size);
+    if (na_tcp_uring->cq_ring)
+        munmap(na_tcp_uring->cq_ring, na_tcp_uring->cq_ring_size);
+    if (na_tcp_uring->sq_ring)
+        munmap(na_tcp_uring->sq_ring, na_tcp_uring->sq_ring_size);
+    hg_thread_mutex_destroy(&na_tcp_uring->sq_lock);
+    free(na_tcp_uring);
+    NA_TCP_PRIVATE_DATA(na_class)->uring = NULL;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_uring_buf_recycle(struct na_tcp_uring *na_tcp_uring,
+    unsigned short bid)
+{
+    struct io_uring_buf *buf = &na_tcp_uring->buf_ring->bufs[
+        na_tcp_uring->buf_tail & (NA_TCP_URING_BUF_COUNT - 1)];
+
+    buf->addr = (na_uint64_t) (na_ptr_t) (na_tcp_uring->bufs
+        + (na_size_t) bid * NA_TCP_URING_BUF_SIZE);
+    buf->len = NA_TCP_URING_BUF_SIZE;
+    buf->bid = bid;
+    na_tcp_uring->buf_tail++;
+    __atomic_store_n(&na_tcp_uring->buf_ring->tail, na_tcp_uring->buf_tail,
+        __ATOMIC_RELEASE);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_submit(struct na_tcp_uring *na_tcp_uring)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    while (na_tcp_uring->to_submit) {
+        /* Also flush completions that overflowed the completion queue */
+        unsigned int flags = (__atomic_load_n(na_tcp_uring->sq_flags,
+            __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) ?
+                IORING_ENTER_GETEVENTS : 0;
+        int rc;
+
+        rc = (int) syscall(__NR_io_uring_enter, na_tcp_uring->fd,
+            na_tcp_uring->to_submit, 0, flags, NULL, 0);
+        if (rc == -1) {
+            if (errno == EINTR)
+                continue;
+            /* Completion queue is full, retry once it is reaped */
+            if (errno == EAGAIN || errno == EBUSY)
+                break;
+            NA_LOG_ERROR("io_uring_enter() failed (%s)", strerror(errno));
+            ret = NA_PROTOCOL_ERROR;
+            break;
+        }
+        if (!rc)
+            break;
+        na_tcp_uring->to_submit -= (unsigned int) rc;
+    }
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct io_uring_sqe *
+na_tcp_uring_get_sqe(struct na_tcp_uring *na_tcp_uring)
+{
+    unsigned int tail = *na_tcp_uring->sq_tail;
+    struct io_uring_sqe *sqe = NULL;
+
+    if (tail - __atomic_load_n(na_tcp_uring->sq_head, __ATOMIC_ACQUIRE)
+        >= na_tcp_uring->sq_entries) {
+        /* Submission queue is full, make room */
+        if (na_tcp_uring_submit(na_tcp_uring) != NA_SUCCESS
+            || tail - __atomic_load_n(na_tcp_uring->sq_head, __ATOMIC_ACQUIRE)
+            >= na_tcp_uring->sq_entries) {
+            NA_LOG_ERROR("Submission queue is full");
+            goto done;
+        }
+    }
+    sqe = &na_tcp_uring->sqes[tail & na_tcp_uring->sq_mask];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+
+done:
+    return sqe;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_push_sqe(struct na_tcp_uring *na_tcp_uring)
+{
+    unsigned int tail = *na_tcp_uring->sq_tail;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_uring->sq_array[tail & na_tcp_uring->sq_mask] =
+        tail & na_tcp_uring->sq_mask;
+    __atomic_store_n(na_tcp_uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    na_tcp_uring->to_submit++;
+    na_tcp_uring->pending++;
+
+    /* Requests issued while completions are processed are submitted at
+     * once when reaping ends */
+    if (!na_tcp_uring->reaping)
+        ret = na_tcp_uring_submit(na_tcp_uring);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_recv_post(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_uring *na_tcp_uring = NA_TCP_PRIVATE_DATA(na_class)->uring;
+    struct io_uring_sqe *sqe;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_mutex_lock(&na_tcp_uring->sq_lock);
+    sqe = na_tcp_uring_get_sqe(na_tcp_uring);
+    if (!sqe) {
+        ret = NA_PROTOCOL_ERROR;
+        goto unlock;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = na_tcp_addr->sock;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = NA_TCP_URING_BGID;
+    if (na_tcp_uring->multishot)
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+    else
+        sqe->len = NA_TCP_URING_BUF_SIZE;
+    sqe->user_data = (na_uint64_t) (na_ptr_t) na_tcp_addr | NA_TCP_URING_RECV;
+    hg_atomic_incr32(&na_tcp_addr->uring_refs);
+    ret = na_tcp_uring_push_sqe(na_tcp_uring);
+
+unlock:
+    hg_thread_mutex_unlock(&na_tcp_uring->sq_lock);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_send_post(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_uring *na_tcp_uring = NA_TCP_PRIVATE_DATA(na_class)->uring;
+    struct io_uring_sqe *sqe;
+    size_t iov_len;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Gather queued frames into a single request */
+    memset(&na_tcp_addr->tx_msg, 0, sizeof(struct msghdr));
+    na_tcp_addr->tx_msg.msg_iov = na_tcp_addr->tx_iov;
+    na_tcp_addr->tx_msg.msg_iovlen = na_tcp_send_iov(na_tcp_addr,
+        na_tcp_addr->tx_iov, &iov_len);
+
+    hg_thread_mutex_lock(&na_tcp_uring->sq_lock);
+    sqe = na_tcp_uring_get_sqe(na_tcp_uring);
+    if (!sqe) {
+        ret = NA_PROTOCOL_ERROR;
+        goto unlock;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = na_tcp_addr->sock;
+    sqe->addr = (na_uint64_t) (na_ptr_t) &na_tcp_addr->tx_msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (na_uint64_t) (na_ptr_t) na_tcp_addr | NA_TCP_URING_SEND;
+    na_tcp_addr->tx_busy = NA_TRUE;
+    hg_atomic_incr32(&na_tcp_addr->uring_refs);
+    ret = na_tcp_uring_push_sqe(na_tcp_uring);
+
+unlock:
+    hg_thread_mutex_unlock(&na_tcp_uring->sq_lock);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_uring_release(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    if (hg_atomic_decr32(&na_tcp_addr->uring_refs) || na_tcp_addr->sock != -1)
+        return;
+
+    /* Connection was closed with requests in flight, let progress destroy
+     * addr if it was released */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+    if (!na_tcp_addr->closing) {
+        na_tcp_addr->closing = NA_TRUE;
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue,
+            na_tcp_addr, close_entry);
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_recv_complete(na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr, const struct io_uring_cqe *cqe)
+{
+    struct na_tcp_uring *na_tcp_uring = NA_TCP_PRIVATE_DATA(na_class)->uring;
+    na_return_t ret = NA_SUCCESS;
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        unsigned short bid =
+            (unsigned short) (cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+        /* Data is copied out so that buffer can be reused right away */
+        if (cqe->res > 0 && !hg_atomic_get32(&na_tcp_addr->failed))
+            ret = na_tcp_recv_data(na_class, na_tcp_addr, na_tcp_uring->bufs
+                + (na_size_t) bid * NA_TCP_URING_BUF_SIZE,
+                (na_size_t) cqe->res);
+        na_tcp_uring_buf_recycle(na_tcp_uring, bid);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not process received data");
+            goto done;
+        }
+    }
+
+    /* Multishot recv stays armed */
+    if (cqe->flags & IORING_CQE_F_MORE)
+        goto done;
+
+    if (!hg_atomic_get32(&na_tcp_addr->failed)) {
+        if (cqe->res == -EINVAL && na_tcp_uring->multishot) {
+            /* Kernel does not support multishot recv */
+            NA_LOG_WARNING("Multishot recv not supported, using single recv");
+            na_tcp_uring->multishot = NA_FALSE;
+            ret = na_tcp_uring_recv_post(na_class, na_tcp_addr);
+        } else if (cqe->res > 0 || cqe->res == -ENOBUFS
+            || cqe->res == -EINTR || cqe->res == -EAGAIN)
+            ret = na_tcp_uring_recv_post(na_class, na_tcp_addr);
+        else {
+            /* Peer closed connection */
+            if (cqe->res < 0)
+                NA_LOG_ERROR("recv() failed (%s)", strerror(-cqe->res));
+            na_tcp_addr_fail(na_class, na_tcp_addr);
+        }
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not post recv");
+            na_tcp_addr_fail(na_class, na_tcp_addr);
+        }
+    }
+    na_tcp_uring_release(na_class, na_tcp_addr);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_send_complete(na_class_t *na_class,
+    struct na_tcp_addr *na_tcp_addr, const struct io_uring_cqe *cqe,
+    na_bool_t *progressed)
+{
+    struct na_tcp_op_queue failed_op_queue;
+    na_return_t ret = NA_SUCCESS;
+
+    HG_QUEUE_INIT(&failed_op_queue);
+
+    hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+    na_tcp_addr->tx_busy = NA_FALSE;
+    if (hg_atomic_get32(&na_tcp_addr->failed)) {
+        /* Frames were left queued if connection was closed meanwhile */
+        if (na_tcp_addr->sock == -1)
+            na_tcp_send_fail(na_tcp_addr, &failed_op_queue);
+    } else if (cqe->res < 0 && cqe->res != -EINTR && cqe->res != -EAGAIN) {
+        NA_LOG_ERROR("sendmsg() failed (%s)", strerror(-cqe->res));
+        na_tcp_addr_fail(na_class, na_tcp_addr);
+    } else {
+        if (cqe->res > 0)
+            na_tcp_send_consume(na_tcp_addr, (na_size_t) cqe->res, progressed);
+        /* Send what remains or was queued meanwhile */
+        na_tcp_send_flush(na_class, na_tcp_addr, progressed);
+    }
+    hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+
+    ret = na_tcp_fail_complete(na_class, na_tcp_addr, &failed_op_queue);
+    if (ret != NA_SUCCESS)
+        NA_LOG_ERROR("Could not complete failed operations");
+
+    na_tcp_uring_release(na_class, na_tcp_addr);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_uring_progress(na_class_t *na_class, na_bool_t *progressed)
+{
+    struct na_tcp_uring *na_tcp_uring = NA_TCP_PRIVATE_DATA(na_class)->uring;
+    unsigned int head, tail;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Requests issued while reaping are submitted together, only one thread
+     * reaps at a time */
+    hg_thread_mutex_lock(&na_tcp_uring->sq_lock);
+    if (na_tcp_uring->reaping) {
+        hg_thread_mutex_unlock(&na_tcp_uring->sq_lock);
+        goto done;
+    }
+    na_tcp_uring->reaping = NA_TRUE;
+    hg_thread_mutex_unlock(&na_tcp_uring->sq_lock);
+
+    head = *na_tcp_uring->cq_head;
+    tail = __atomic_load_n(na_tcp_uring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe cqe =
+            na_tcp_uring->cqes[head & na_tcp_uring->cq_mask];
+        struct na_tcp_addr *na_tcp_addr = (struct na_tcp_addr *) (na_ptr_t)
+            (cqe.user_data & ~NA_TCP_URING_TYPE_MASK);
+
+        /* Give entry back to the kernel */
+        __atomic_store_n(na_tcp_uring->cq_head, ++head, __ATOMIC_RELEASE);
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            hg_thread_mutex_lock(&na_tcp_uring->sq_lock);
+            na_tcp_uring->pending--;
+            hg_thread_mutex_unlock(&na_tcp_uring->sq_lock);
+        }
+
+        switch (cqe.user_data & NA_TCP_URING_TYPE_MASK) {
+            case NA_TCP_URING_RECV:
+                ret = na_tcp_uring_recv_complete(na_class, na_tcp_addr, &cqe);
+                break;
+            case NA_TCP_URING_SEND:
+                ret = na_tcp_uring_send_complete(na_class, na_tcp_addr, &cqe,
+                    progressed);
+                break;
+            default:
+                NA_LOG_ERROR("Unknown request type");
+                ret = NA_PROTOCOL_ERROR;
+                break;
+        }
+        if (ret != NA_SUCCESS)
+            break;
+        *progressed = NA_TRUE;
+    }
+
+    hg_thread_mutex_lock(&na_tcp_uring->sq_lock);
+    na_tcp_uring->reaping = NA_FALSE;
+    if (na_tcp_uring_submit(na_tcp_uring) != NA_SUCCESS && ret == NA_SUCCESS)
+        ret = NA_PROTOCOL_ERROR;
+    hg_thread_mutex_unlock(&na_tcp_uring->sq_lock);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_recv_data(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr,
+    const char *data, na_size_t len)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    while (len && !hg_atomic_get32(&na_tcp_addr->failed)) {
+        na_size_t n;
+
+        /* Copy payload in place (staging buffer is always empty then) */
+        if (na_tcp_addr->rx_payload
+            && na_tcp_addr->rx_recvd < na_tcp_addr->rx_dest_len) {
+            n = NA_TCP_MIN(len,
+                na_tcp_addr->rx_dest_len - na_tcp_addr->rx_recvd);
+            memcpy(na_tcp_addr->rx_dest + na_tcp_addr->rx_recvd, data, n);
+            na_tcp_addr->rx_recvd += n;
+        } else {
+            n = NA_TCP_MIN(len, NA_TCP_RECV_BUF_SIZE - na_tcp_addr->rx_end);
+            memcpy(na_tcp_addr->rx_buf + na_tcp_addr->rx_end, data, n);
+            na_tcp_addr->rx_end += n;
+        }
+        data += n;
+        len -= n;
+
+        ret = na_tcp_recv_process(na_class, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not process received frames");
+            goto done;
+        }
+    }
+
+done:
+    return ret;
+}
+#endif /* NA_TCP_HAS_IO_URING */
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_recv_process(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    for (;;) {
+        na_size_t avail = na_tcp_addr->rx_end - na_tcp_addr->rx_start;
+
+        if (na_tcp_addr->rx_payload) {
+            if (na_tcp_addr->rx_recvd < na_tcp_addr->rx_hdr.size) {
+                na_size_t len = NA_TCP_MIN(avail,
+                    na_tcp_addr->rx_hdr.size - na_tcp_addr->rx_recvd);
+
+                /* Copy what is kept, discard the rest */
+                if (na_tcp_addr->rx_recvd < na_tcp_addr->rx_dest_len)
+                    memcpy(na_tcp_addr->rx_dest + na_tcp_addr->rx_recvd,
+                        na_tcp_addr->rx_buf + na_tcp_addr->rx_start,
+                        NA_TCP_MIN(len,
+                            na_tcp_addr->rx_dest_len - na_tcp_addr->rx_recvd));
+                na_tcp_addr->rx_recvd += len;
+                na_tcp_addr->rx_start += len;
+                if (na_tcp_addr->rx_recvd < na_tcp_addr->rx_hdr.size)
+                    break;
+            }
+            na_tcp_addr->rx_payload = NA_FALSE;
+            ret = na_tcp_recv_done(na_class, na_tcp_addr);
+            if (ret != NA_SUCCESS)
+                goto done;
+        } else {
+            if (avail < sizeof(struct na_tcp_hdr))
+                break;
+            memcpy(&na_tcp_addr->rx_hdr,
+                na_tcp_addr->rx_buf + na_tcp_addr->rx_start,
+                sizeof(struct na_tcp_hdr));
+            na_tcp_addr->rx_start += sizeof(struct na_tcp_hdr);
+            ret = na_tcp_recv_hdr(na_class, na_tcp_addr);
+            if (ret != NA_SUCCESS)
+                goto done;
+            if (hg_atomic_get32(&na_tcp_addr->failed))
+                break;
+        }
+    }
+
+    /* Keep partial header at the beginning of staging buffer */
+    if (na_tcp_addr->rx_start == na_tcp_addr->rx_end)
+        na_tcp_addr->rx_start = na_tcp_addr->rx_end = 0;
+    else if (na_tcp_addr->rx_start) {
+        memmove(na_tcp_addr->rx_buf, na_tcp_addr->rx_buf
+            + na_tcp_addr->rx_start, na_tcp_addr->rx_end
+            - na_tcp_addr->rx_start);
+        na_tcp_addr->rx_end -= na_tcp_addr->rx_start;
+        na_tcp_addr->rx_start = 0;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_tcp_mem_check(na_class_t *na_class, na_ptr_t addr, na_uint64_t len,
+    unsigned long flags)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle;
+    na_bool_t ret = NA_FALSE;
+
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+    HG_LIST_FOREACH(na_tcp_mem_handle,
+        &NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list, entry) {
+        /* Written so that addr + len cannot overflow */
+        if ((na_tcp_mem_handle->flags & flags) == flags
+            && addr >= na_tcp_mem_handle->base
+            && len <= na_tcp_mem_handle->size
+            && addr - na_tcp_mem_handle->base
+                <= na_tcp_mem_handle->size - len) {
+            ret = NA_TRUE;
+            break;
+        }
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_recv_hdr(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_hdr *hdr = &na_tcp_addr->rx_hdr;
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_addr->rx_payload = NA_TRUE;
+    na_tcp_addr->rx_dest = NULL;
+    na_tcp_addr->rx_dest_len = 0;
+    na_tcp_addr->rx_recvd = 0;
+    na_tcp_addr->rx_op_id = NULL;
+    na_tcp_addr->rx_unexpected_info = NULL;
+
+    switch (hdr->type) {
+        case NA_TCP_UNEXPECTED:
+            if (hdr->size > NA_TCP_UNEXPECTED_SIZE)
+                goto error;
+
+            /* Pop op ID from queue */
+            hg_thread_spin_lock(
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+            na_tcp_op_id = HG_QUEUE_FIRST(
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue);
+            HG_QUEUE_POP_HEAD(
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue, entry);
+            hg_thread_spin_unlock(
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+
+            if (na_tcp_op_id) {
+                na_tcp_addr->rx_op_id = na_tcp_op_id;
+                na_tcp_addr->rx_dest =
+                    (char *) na_tcp_op_id->info.recv_unexpected.buf;
+                na_tcp_addr->rx_dest_len = NA_TCP_MIN(hdr->size,
+                    na_tcp_op_id->info.recv_unexpected.buf_size);
+            } else {
+                struct na_tcp_unexpected_info *na_tcp_unexpected_info;
+
+                /* Otherwise keep a copy of the message in the unexpected
+                 * message queue until a recv is posted */
+                na_tcp_unexpected_info = (struct na_tcp_unexpected_info *)
+                    malloc(sizeof(struct na_tcp_unexpected_info) + hdr->size);
+                if (!na_tcp_unexpected_info) {
+                    NA_LOG_ERROR("Could not allocate unexpected info");
+                    ret = NA_NOMEM_ERROR;
+                    goto done;
+                }
+                na_tcp_unexpected_info->buf = na_tcp_unexpected_info + 1;
+                na_tcp_unexpected_info->buf_size = hdr->size;
+                na_tcp_unexpected_info->tag = hdr->tag;
+                na_tcp_addr->rx_unexpected_info = na_tcp_unexpected_info;
+                na_tcp_addr->rx_dest = (char *) na_tcp_unexpected_info->buf;
+                na_tcp_addr->rx_dest_len = hdr->size;
+            }
+            break;
+        case NA_TCP_EXPECTED:
+            if (hdr->size > NA_TCP_EXPECTED_SIZE)
+                goto error;
+
+            hg_thread_spin_lock(
+                &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+            HG_QUEUE_FOREACH(na_tcp_op_id,
+                &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue, entry) {
+                if (na_tcp_op_id->info.recv_expected.na_tcp_addr == na_tcp_addr
+                    && na_tcp_op_id->info.recv_expected.tag == hdr->tag) {
+                    HG_QUEUE_REMOVE(
+                        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue,
+                        na_tcp_op_id, na_tcp_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+            if (!na_tcp_op_id) {
+                /* No match if either the message was not pre-posted or it
+                 * was canceled, payload is discarded */
+                NA_LOG_WARNING("Ignored expected message received (canceled?)");
+                break;
+            }
+            na_tcp_addr->rx_op_id = na_tcp_op_id;
+            na_tcp_addr->rx_dest = (char *) na_tcp_op_id->info.recv_expected.buf;
+            na_tcp_addr->rx_dest_len = NA_TCP_MIN(hdr->size,
+                na_tcp_op_id->info.recv_expected.buf_size);
+            break;
+        case NA_TCP_PUT:
+            /* Write chunk in place */
+            if (hdr->size != hdr->len
+                || !na_tcp_mem_check(na_class, hdr->addr, hdr->len,
+                    NA_MEM_WRITE_ONLY))
+                goto error;
+            na_tcp_addr->rx_dest = (char *) hdr->addr;
+            na_tcp_addr->rx_dest_len = hdr->size;
+            break;
+        case NA_TCP_GET_DATA:
+            hg_thread_mutex_lock(&na_tcp_addr->send_lock);
+            HG_QUEUE_FOREACH(na_tcp_op_id, &na_tcp_addr->rma_op_queue, entry) {
+                if (na_tcp_op_id->info.rma.id == hdr->tag)
+                    break;
+            }
+            if (na_tcp_op_id) {
+                struct na_tcp_info_rma *na_tcp_info_rma =
+                    &na_tcp_op_id->info.rma;
+
+                /* Chunks of an operation are returned in order */
+                na_tcp_addr->rx_op_id = na_tcp_op_id;
+                na_tcp_addr->rx_dest =
+                    na_tcp_info_rma->local_buf + na_tcp_info_rma->recvd;
+                na_tcp_addr->rx_dest_len = NA_TCP_MIN(hdr->size,
+                    na_tcp_info_rma->length - na_tcp_info_rma->recvd);
+                na_tcp_info_rma->recvd += na_tcp_addr->rx_dest_len;
+            }
+            hg_thread_mutex_unlock(&na_tcp_addr->send_lock);
+            break;
+        case NA_TCP_PUT_ACK:
+            if (hdr->size)
+                goto error;
+            break;
+        case NA_TCP_GET:
+            /* Chunk is returned from memory in place */
+            if (hdr->size
+                || !na_tcp_mem_check(na_class, hdr->addr, hdr->len,
+                    NA_MEM_READ_ONLY))
+                goto error;
+            break;
+        default:
+            goto error;
+    }
+
+done:
+    return ret;
+
+error:
+    /* Stream cannot be resynchronized */
+    NA_LOG_ERROR("Invalid frame received from %s", na_tcp_addr->name);
+    na_tcp_addr->rx_payload = NA_FALSE;
+    na_tcp_addr_fail(na_class, na_tcp_addr);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_recv_done(na_class_t *na_class, struct na_tcp_addr *na_tcp_addr)
+{
+    struct na_tcp_hdr *hdr = &na_tcp_addr->rx_hdr;
+    struct na_tcp_op_id *na_tcp_op_id = na_tcp_addr->rx_op_id;
+    struct na_tcp_frame *na_tcp_frame;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_addr->rx_op_id = NULL;
+
+    switch (hdr->type) {
+        case NA_TCP_UNEXPECTED:
+            /* Addr is referenced by the recv operation or the unexpected
+             * message until it gets freed */
+            hg_atomic_incr32(&na_tcp_addr->ref_count);
+
+            if (na_tcp_op_id) {
+                na_tcp_op_id->info.recv_unexpected.actual_buf_size =
+                    na_tcp_addr->rx_dest_len;
+                na_tcp_op_id->info.recv_unexpected.na_tcp_addr = na_tcp_addr;
+                na_tcp_op_id->info.recv_unexpected.tag = (na_tag_t) hdr->tag;
+
+                ret = na_tcp_complete(na_tcp_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            } else {
+                struct na_tcp_unexpected_info *na_tcp_unexpected_info =
+                    na_tcp_addr->rx_unexpected_info;
+
+                na_tcp_addr->rx_unexpected_info = NULL;
+                na_tcp_unexpected_info->na_tcp_addr = na_tcp_addr;
+
+                hg_thread_spin_lock(
+                    &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+                HG_QUEUE_PUSH_TAIL(
+                    &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue,
+                    na_tcp_unexpected_info, entry);
+                hg_thread_spin_unlock(
+                    &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+            }
+            break;
+        case NA_TCP_EXPECTED:
+            if (na_tcp_op_id) {
+                ret = na_tcp_complete(na_tcp_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+            break;
+        case NA_TCP_PUT:
+        case NA_TCP_GET:
+            /* Acknowledge put chunk or return get chunk */
+            na_tcp_frame = (struct na_tcp_frame *) malloc(
+                sizeof(struct na_tcp_frame));
+            if (!na_tcp_frame) {
+                NA_LOG_ERROR("Could not allocate NA TCP frame");
+                ret = NA_NOMEM_ERROR;
+                goto done;
+            }
+            na_tcp_frame->hdr.tag = hdr->tag;
+            na_tcp_frame->hdr.addr = hdr->addr;
+            na_tcp_frame->hdr.len = hdr->len;
+            if (hdr->type == NA_TCP_PUT) {
+                na_tcp_frame->hdr.type = NA_TCP_PUT_ACK;
+                na_tcp_frame->hdr.size = 0;
+                na_tcp_frame->payload = NULL;
+            } else {
+                na_tcp_frame->hdr.type = NA_TCP_GET_DATA;
+                na_tcp_frame->hdr.size = hdr->len;
+                na_tcp_frame->payload = (const void *) hdr->addr;
+            }
+            na_tcp_frame->na_tcp_op_id = NULL;
+
+            ret = na_tcp_send_frame(na_class, na_tcp_addr, na_tcp_frame);
+            if (ret != NA_SUCCESS) {
+                /* Connection closed, initiator fails the operation */
+                free(na_tcp_frame);
+                ret = NA_SUCCESS;
+            }
+            break;
+        case NA_TCP_PUT_ACK:
+        case NA_TCP_GET_DATA:
+            ret = na_tcp_rma_chunk_complete(na_class, na_tcp_addr, hdr->tag,
+                (hdr->type == NA_TCP_PUT_ACK) ? hdr->len : hdr->size);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not complete RMA chunk");
+                goto done;
+            }
+            break;
+        default:
+            NA_LOG_ERROR("Invalid frame type");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, struct na_tcp_addr *na_tcp_addr, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    struct na_tcp_frame *na_tcp_frame;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size > NA_TCP_UNEXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds message size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+    if (na_tcp_addr->self) {
+        NA_LOG_ERROR("Sending to self is not supported");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_tcp_op_id = (struct na_tcp_op_id *) *op_id;
+        hg_atomic_incr32(&na_tcp_op_id->ref_count);
+    } else {
+        na_tcp_op_id = na_tcp_op_alloc(na_class, context);
+        if (!na_tcp_op_id) {
+            NA_LOG_ERROR("Could not allocate NA TCP operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_tcp_op_id->context = context;
+    na_tcp_op_id->completion_data.callback_info.type = cb_type;
+    na_tcp_op_id->completion_data.callback = callback;
+    na_tcp_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_tcp_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_tcp_op_id->canceled, NA_FALSE);
+    na_tcp_op_id->ret = NA_SUCCESS;
+
+    /* Frame references user buffer, op completes once it is written */
+    na_tcp_frame = &na_tcp_op_id->info.send.frame;
+    na_tcp_frame->hdr.type = (cb_type == NA_CB_SEND_UNEXPECTED) ?
+        NA_TCP_UNEXPECTED : NA_TCP_EXPECTED;
+    na_tcp_frame->hdr.tag = (na_uint32_t) tag;
+    na_tcp_frame->hdr.size = buf_size;
+    na_tcp_frame->hdr.addr = 0;
+    na_tcp_frame->hdr.len = 0;
+    na_tcp_frame->payload = buf;
+    na_tcp_frame->na_tcp_op_id = na_tcp_op_id;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_tcp_op_id;
+
+    ret = na_tcp_send_frame(na_class, na_tcp_addr, na_tcp_frame);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not send frame");
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_tcp_op_id) {
+        na_tcp_op_destroy(na_class, (na_op_id_t) na_tcp_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_complete(struct na_tcp_op_id *na_tcp_op_id)
+{
+    struct na_cb_info *callback_info = NULL;
+    na_bool_t canceled = (na_bool_t) hg_atomic_get32(&na_tcp_op_id->canceled);
+    na_return_t ret = NA_SUCCESS;
+
+    /* Init callback info */
+    callback_info = &na_tcp_op_id->completion_data.callback_info;
+    callback_info->ret = (canceled) ? NA_CANCELED : na_tcp_op_id->ret;
+
+    switch (callback_info->type) {
+        case NA_CB_LOOKUP:
+            callback_info->info.lookup.addr =
+                (na_addr_t) na_tcp_op_id->info.lookup.na_tcp_addr;
+            break;
+        case NA_CB_SEND_UNEXPECTED:
+            break;
+        case NA_CB_RECV_UNEXPECTED:
+            if (callback_info->ret != NA_SUCCESS) {
+                /* In case of cancellation where no recv'd data */
+                callback_info->info.recv_unexpected.actual_buf_size = 0;
+                callback_info->info.recv_unexpected.source = NA_ADDR_NULL;
+                callback_info->info.recv_unexpected.tag = 0;
+                break;
+            }
+
+            /* Fill callback info */
+            callback_info->info.recv_unexpected.actual_buf_size =
+                na_tcp_op_id->info.recv_unexpected.actual_buf_size;
+            callback_info->info.recv_unexpected.source =
+                (na_addr_t) na_tcp_op_id->info.recv_unexpected.na_tcp_addr;
+            callback_info->info.recv_unexpected.tag =
+                na_tcp_op_id->info.recv_unexpected.tag;
+            break;
+        case NA_CB_SEND_EXPECTED:
+            break;
+        case NA_CB_RECV_EXPECTED:
+            break;
+        case NA_CB_PUT:
+        case NA_CB_GET:
+            break;
+        default:
+            NA_LOG_ERROR("Operation not supported");
+            ret = NA_INVALID_PARAM;
+            break;
+    }
+
+    /* Mark op id as completed */
+    hg_atomic_set32(&na_tcp_op_id->completed, NA_TRUE);
+
+    ret = na_cb_completion_add(na_tcp_op_id->context,
+        &na_tcp_op_id->completion_data);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add callback to completion queue");
+        goto done;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_tcp_release(void *arg)
+{
+    struct na_tcp_op_id *na_tcp_op_id = (struct na_tcp_op_id *) arg;
+
+    if (na_tcp_op_id && !hg_atomic_get32(&na_tcp_op_id->completed)) {
+        NA_LOG_WARNING("Releasing resources from an uncompleted operation");
+    }
+    na_tcp_op_destroy(NULL, na_tcp_op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_tcp_op_id *
+na_tcp_op_alloc(na_class_t *na_class, na_context_t *context)
+{
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+
+    na_tcp_op_id = (struct na_tcp_op_id *) na_op_id_alloc(context,
+        sizeof(struct na_tcp_op_id));
+    if (!na_tcp_op_id) {
+        NA_LOG_ERROR("Could not allocate NA TCP operation ID");
+        goto done;
+    }
+    memset(na_tcp_op_id, 0, sizeof(struct na_tcp_op_id));
+    na_tcp_op_id->na_class = na_class;
+    hg_atomic_init32(&na_tcp_op_id->ref_count, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_tcp_op_id->completed, NA_TRUE);
+
+    /* Set op ID release callbacks */
+    na_tcp_op_id->completion_data.plugin_callback = na_tcp_release;
+    na_tcp_op_id->completion_data.plugin_callback_args = na_tcp_op_id;
+
+done:
+    return na_tcp_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_tcp_check_protocol(const char *protocol_name)
+{
+    na_bool_t accept = NA_FALSE;
+
+    if (!strcmp("tcp", protocol_name))
+        accept = NA_TRUE;
+
+    return accept;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t listen)
+{
+    struct na_tcp_addr *na_tcp_addr = NULL;
+    char host[NA_TCP_MAX_ADDR_NAME], port[NA_TCP_MAX_ADDR_NAME];
+    hg_poll_set_t *poll_set;
+    int rc;
+    na_return_t ret = NA_SUCCESS;
+
+    host[0] = port[0] = '\0';
+    if (na_info->host_name) {
+        ret = na_tcp_parse_name(na_info->host_name, host, port);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not parse host name");
+            goto done;
+        }
+    }
+
+    /* Initialize private data */
+    na_class->private_data = malloc(sizeof(struct na_tcp_private_data));
+    if (!na_class->private_data) {
+        NA_LOG_ERROR("Could not allocate NA private data class");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_class->private_data, 0, sizeof(struct na_tcp_private_data));
+    hg_atomic_init32(&NA_TCP_PRIVATE_DATA(na_class)->rma_id, 0);
+
+    /* Emulated RMA is pipelined over the connection */
+    NA_TCP_PRIVATE_DATA(na_class)->rma_chunk_size =
+        (na_info->na_init_info.rma_chunk_size) ?
+        na_info->na_init_info.rma_chunk_size : NA_TCP_RMA_CHUNK_SIZE;
+    NA_TCP_PRIVATE_DATA(na_class)->rma_window =
+        (na_info->na_init_info.rma_window) ?
+        na_info->na_init_info.rma_window : NA_TCP_RMA_WINDOW;
+
+    /* Initialize queues */
+    HG_LIST_INIT(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue);
+    HG_QUEUE_INIT(&NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue);
+    HG_LIST_INIT(&NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list);
+
+    /* Initialize mutexes */
+    hg_thread_spin_init(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+    hg_thread_spin_init(
+        &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    hg_thread_spin_init(
+        &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+    hg_thread_spin_init(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+    hg_thread_spin_init(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+    hg_thread_spin_init(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    hg_thread_spin_init(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    hg_thread_spin_init(
+        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    hg_thread_spin_init(&NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+
+    /* Create poll set to wait for events */
+    poll_set = hg_poll_create();
+    if (!poll_set) {
+        NA_LOG_ERROR("Cannot create poll set");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    NA_TCP_PRIVATE_DATA(na_class)->poll_set = poll_set;
+
+#ifdef NA_TCP_HAS_IO_URING
+    /* Transfers go through io_uring if kernel supports it */
+    if (na_tcp_uring_init(na_class) != NA_SUCCESS)
+        NA_LOG_WARNING("Could not set up io_uring, using poll set");
+#endif
+
+    /* Create self addr */
+    na_tcp_addr = (struct na_tcp_addr *) malloc(sizeof(struct na_tcp_addr));
+    if (!na_tcp_addr) {
+        NA_LOG_ERROR("Could not allocate NA TCP addr");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_tcp_addr, 0, sizeof(struct na_tcp_addr));
+    na_tcp_addr->self = NA_TRUE;
+    na_tcp_addr->sock = -1;
+    na_tcp_addr->send_sock = -1;
+    hg_atomic_init32(&na_tcp_addr->ref_count, 1);
+    NA_TCP_PRIVATE_DATA(na_class)->self_addr = na_tcp_addr;
+
+    if (!host[0] && gethostname(host, NA_TCP_MAX_ADDR_NAME) == -1)
+        strcpy(host, "localhost");
+
+    if (listen) {
+        struct sockaddr_storage ss;
+        socklen_t ss_len = sizeof(ss);
+        char serv[NI_MAXSERV];
+
+        /* Bind to all interfaces if no host was given */
+        ret = na_tcp_listen((na_info->host_name) ? host : NULL, port,
+            &na_tcp_addr->sock);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not create listening sock");
+            goto done;
+        }
+
+        /* Get port actually bound */
+        if (getsockname(na_tcp_addr->sock, (struct sockaddr *) &ss, &ss_len)
+            == -1 || getnameinfo((struct sockaddr *) &ss, ss_len, NULL, 0,
+            serv, sizeof(serv), NI_NUMERICSERV) != 0) {
+            NA_LOG_ERROR("Could not get listening port (%s)", strerror(errno));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        rc = snprintf(na_tcp_addr->name, NA_TCP_MAX_ADDR_NAME, "%s:%s", host,
+            serv);
+        if (rc < 0 || rc >= NA_TCP_MAX_ADDR_NAME) {
+            NA_LOG_ERROR("Exceeding max addr name");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        }
+
+        ret = na_tcp_poll_register(na_class, NA_TCP_ACCEPT, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not add listening sock to poll set");
+            goto done;
+        }
+    } else
+        snprintf(na_tcp_addr->name, NA_TCP_MAX_ADDR_NAME, "%s", host);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_finalize(na_class_t *na_class)
+{
+    struct na_tcp_addr *na_tcp_addr;
+    na_bool_t progressed = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_class->private_data) {
+        goto done;
+    }
+
+    /* Check that unexpected op queue is empty */
+    if (!HG_QUEUE_IS_EMPTY(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue)) {
+        NA_LOG_ERROR("Unexpected op queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that unexpected message queue is empty */
+    if (!HG_QUEUE_IS_EMPTY(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue)) {
+        NA_LOG_ERROR("Unexpected msg queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Check that expected op queue is empty */
+    if (!HG_QUEUE_IS_EMPTY(&NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue)) {
+        NA_LOG_ERROR("Expected op queue should be empty");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Stop accepting connections */
+    na_tcp_addr = NA_TCP_PRIVATE_DATA(na_class)->self_addr;
+    if (na_tcp_addr->recv_poll_data) {
+        ret = na_tcp_poll_deregister(na_class, NA_TCP_ACCEPT, na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not remove listening sock from poll set");
+            goto done;
+        }
+    }
+    if (na_tcp_addr->sock != -1) {
+        close(na_tcp_addr->sock);
+        na_tcp_addr->sock = -1;
+    }
+
+    /* Close all remaining connections, addrs still referenced by the user
+     * are only closed */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    HG_QUEUE_FOREACH(na_tcp_addr,
+        &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue, entry)
+        na_tcp_addr_fail(na_class, na_tcp_addr);
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+    HG_LIST_FOREACH(na_tcp_addr,
+        &NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list, conn_entry)
+        na_tcp_addr_fail(na_class, na_tcp_addr);
+    hg_thread_spin_unlock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+
+    ret = na_tcp_poll_update(na_class, &progressed);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not close connections");
+        goto done;
+    }
+
+#ifdef NA_TCP_HAS_IO_URING
+    if (NA_TCP_PRIVATE_DATA(na_class)->uring) {
+        struct na_tcp_uring *na_tcp_uring =
+            NA_TCP_PRIVATE_DATA(na_class)->uring;
+
+        /* Wait for requests on closed connections to complete so that their
+         * addrs get destroyed */
+        while (na_tcp_uring->pending) {
+            if (syscall(__NR_io_uring_enter, na_tcp_uring->fd, 0, 1,
+                IORING_ENTER_GETEVENTS, NULL, 0) == -1 && errno != EINTR) {
+                NA_LOG_ERROR("io_uring_enter() failed (%s)", strerror(errno));
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+            }
+            ret = na_tcp_uring_progress(na_class, &progressed);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not make progress on ring");
+                goto done;
+            }
+            ret = na_tcp_poll_update(na_class, &progressed);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not close connections");
+                goto done;
+            }
+        }
+
+        ret = na_tcp_uring_finalize(na_class);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not finalize ring");
+            goto done;
+        }
+    }
+#endif
+
+    /* Free self addr */
+    ret = na_tcp_addr_free(na_class, NA_TCP_PRIVATE_DATA(na_class)->self_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not free self addr");
+        goto done;
+    }
+
+    /* Close poll set */
+    if (hg_poll_destroy(NA_TCP_PRIVATE_DATA(na_class)->poll_set)
+        != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("hg_poll_destroy() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    /* Destroy mutexes */
+    hg_thread_spin_destroy(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->accepted_addr_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    hg_thread_spin_destroy(
+        &NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+
+    free(na_class->private_data);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_tcp_check_feature(na_class_t NA_UNUSED *na_class, na_uint8_t feature)
+{
+    na_bool_t ret = NA_FALSE;
+
+    switch (feature) {
+        case NA_HAS_TAG_MASK:
+            ret = NA_FALSE;
+            break;
+        default:
+            break;
+    }
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_tcp_op_create(na_class_t *na_class)
+{
+    return (na_op_id_t) na_tcp_op_alloc(na_class, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
+{
+    struct na_tcp_op_id *na_tcp_op_id = (struct na_tcp_op_id *) op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_decr32(&na_tcp_op_id->ref_count)) {
+        /* Cannot free yet */
+        goto done;
+    }
+    na_op_id_free(na_tcp_op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    struct na_tcp_addr *na_tcp_addr = NULL;
+    char host[NA_TCP_MAX_ADDR_NAME], port[NA_TCP_MAX_ADDR_NAME];
+    char addr_name[NA_TCP_MAX_ADDR_NAME];
+    int sock, rc;
+    na_return_t ret = NA_SUCCESS;
+
+    /**
+     * Clean up name, strings can be of the format:
+     *   <protocol>://<host>:<port>
+     */
+    ret = na_tcp_parse_name(name, host, port);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not parse name");
+        goto done;
+    }
+    if (!host[0] || !port[0]) {
+        NA_LOG_ERROR("Host and port must be specified");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+    rc = snprintf(addr_name, NA_TCP_MAX_ADDR_NAME, "%s:%s", host, port);
+    if (rc < 0 || rc >= NA_TCP_MAX_ADDR_NAME) {
+        NA_LOG_ERROR("Exceeding max addr name");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_tcp_op_id = (struct na_tcp_op_id *) *op_id;
+        hg_atomic_incr32(&na_tcp_op_id->ref_count);
+    } else {
+        na_tcp_op_id = na_tcp_op_alloc(na_class, context);
+        if (!na_tcp_op_id) {
+            NA_LOG_ERROR("Could not allocate NA TCP operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_tcp_op_id->context = context;
+    na_tcp_op_id->completion_data.callback_info.type = NA_CB_LOOKUP;
+    na_tcp_op_id->completion_data.callback = callback;
+    na_tcp_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_tcp_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_tcp_op_id->canceled, NA_FALSE);
+    na_tcp_op_id->ret = NA_SUCCESS;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_tcp_op_id;
+
+    /* Reuse existing connection to that peer */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+    HG_LIST_FOREACH(na_tcp_addr,
+        &NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list, conn_entry) {
+        char *sep = strrchr(na_tcp_addr->name, ':');
+
+        if (sep && !strcmp(sep + 1, port)
+            && !strncmp(na_tcp_addr->name, host,
+                (size_t) (sep - na_tcp_addr->name))
+            && host[sep - na_tcp_addr->name] == '\0'
+            && !hg_atomic_get32(&na_tcp_addr->failed)) {
+            hg_atomic_incr32(&na_tcp_addr->ref_count);
+            break;
+        }
+    }
+    hg_thread_spin_unlock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+
+    if (!na_tcp_addr) {
+        ret = na_tcp_connect(host, port, &sock);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not connect to %s:%s", host, port);
+            goto done;
+        }
+        ret = na_tcp_addr_create(sock, &na_tcp_addr);
+        if (ret != NA_SUCCESS) {
+            close(sock);
+            goto done;
+        }
+        strcpy(na_tcp_addr->name, addr_name);
+
+        /* Connection is kept for subsequent lookups until released */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+        HG_LIST_INSERT_HEAD(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list,
+            na_tcp_addr, conn_entry);
+        na_tcp_addr->cached = NA_TRUE;
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+
+        /* Sock is added to poll set on next progress */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue,
+            na_tcp_addr, register_entry);
+        na_tcp_addr->register_queued = NA_TRUE;
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue_lock);
+    }
+    na_tcp_op_id->info.lookup.na_tcp_addr = na_tcp_addr;
+
+    ret = na_tcp_complete(na_tcp_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_tcp_op_id) {
+        na_tcp_op_destroy(na_class, (na_op_id_t) na_tcp_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_free(na_class_t *na_class, na_addr_t addr)
+{
+    struct na_tcp_addr *na_tcp_addr = (struct na_tcp_addr *) addr;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_tcp_addr) {
+        NA_LOG_ERROR("NULL TCP addr");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    /* Lookups must not be able to grab a released connection */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+    if (hg_atomic_decr32(&na_tcp_addr->ref_count)) {
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+        /* Cannot free yet */
+        goto done;
+    }
+    if (na_tcp_addr->cached) {
+        HG_LIST_REMOVE(na_tcp_addr, conn_entry);
+        na_tcp_addr->cached = NA_FALSE;
+    }
+    hg_thread_spin_unlock(&NA_TCP_PRIVATE_DATA(na_class)->conn_addr_list_lock);
+
+    if (na_tcp_addr->self) {
+        free(na_tcp_addr);
+        goto done;
+    }
+
+    /* Sock is removed from poll set and addr destroyed on progress */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+    na_tcp_addr->released = NA_TRUE;
+    if (!na_tcp_addr->closing) {
+        na_tcp_addr->closing = NA_TRUE;
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue,
+            na_tcp_addr, close_entry);
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue_lock);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_self(na_class_t *na_class, na_addr_t *addr)
+{
+    struct na_tcp_addr *na_tcp_addr = NA_TCP_PRIVATE_DATA(na_class)->self_addr;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Increment refcount */
+    hg_atomic_incr32(&na_tcp_addr->ref_count);
+
+    *addr = (na_addr_t) na_tcp_addr;
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_dup(na_class_t NA_UNUSED *na_class, na_addr_t addr,
+    na_addr_t *new_addr)
+{
+    struct na_tcp_addr *na_tcp_addr = (struct na_tcp_addr *) addr;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Increment refcount */
+    hg_atomic_incr32(&na_tcp_addr->ref_count);
+
+    *new_addr = (na_addr_t) na_tcp_addr;
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_tcp_addr_is_self(na_class_t NA_UNUSED *na_class, na_addr_t addr)
+{
+    struct na_tcp_addr *na_tcp_addr = (struct na_tcp_addr *) addr;
+
+    return na_tcp_addr->self;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_addr_to_string(na_class_t NA_UNUSED *na_class, char *buf,
+    na_size_t *buf_size, na_addr_t addr)
+{
+    struct na_tcp_addr *na_tcp_addr = (struct na_tcp_addr *) addr;
+    na_size_t string_len;
+    char addr_string[NA_TCP_MAX_ADDR_NAME + 8];
+    na_return_t ret = NA_SUCCESS;
+
+    sprintf(addr_string, "tcp://%s", na_tcp_addr->name);
+    string_len = strlen(addr_string);
+    if (buf) {
+        if (string_len >= *buf_size) {
+            NA_LOG_ERROR("Buffer size too small to copy addr");
+            ret = NA_SIZE_ERROR;
+            goto done;
+        } else {
+            strcpy(buf, addr_string);
+        }
+    }
+
+    *buf_size = string_len + 1;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_tcp_msg_get_max_unexpected_size(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_TCP_UNEXPECTED_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_tcp_msg_get_max_expected_size(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_TCP_EXPECTED_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_tag_t
+na_tcp_msg_get_max_tag(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_TCP_MAX_TAG;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    return na_tcp_msg_send(na_class, context, NA_CB_SEND_UNEXPECTED, callback,
+        arg, buf, buf_size, (struct na_tcp_addr *) dest, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_tag_t NA_UNUSED mask, na_op_id_t *op_id)
+{
+    struct na_tcp_unexpected_info *na_tcp_unexpected_info;
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size > NA_TCP_UNEXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds unexpected size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_tcp_op_id = (struct na_tcp_op_id *) *op_id;
+        hg_atomic_incr32(&na_tcp_op_id->ref_count);
+    } else {
+        na_tcp_op_id = na_tcp_op_alloc(na_class, context);
+        if (!na_tcp_op_id) {
+            NA_LOG_ERROR("Could not allocate NA TCP operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_tcp_op_id->context = context;
+    na_tcp_op_id->completion_data.callback_info.type = NA_CB_RECV_UNEXPECTED;
+    na_tcp_op_id->completion_data.callback = callback;
+    na_tcp_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_tcp_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_tcp_op_id->canceled, NA_FALSE);
+    na_tcp_op_id->ret = NA_SUCCESS;
+    na_tcp_op_id->info.recv_unexpected.buf = buf;
+    na_tcp_op_id->info.recv_unexpected.buf_size = buf_size;
+    na_tcp_op_id->info.recv_unexpected.na_tcp_addr = NULL;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_tcp_op_id;
+
+    /* Look for an unexpected message already received */
+    hg_thread_spin_lock(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    na_tcp_unexpected_info = HG_QUEUE_FIRST(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue);
+    HG_QUEUE_POP_HEAD(&NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue,
+        entry);
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_msg_queue_lock);
+    if (na_tcp_unexpected_info) {
+        /* Addr reference is transferred to the operation */
+        na_tcp_op_id->info.recv_unexpected.actual_buf_size = NA_TCP_MIN(
+            na_tcp_unexpected_info->buf_size, buf_size);
+        memcpy(buf, na_tcp_unexpected_info->buf,
+            na_tcp_op_id->info.recv_unexpected.actual_buf_size);
+        na_tcp_op_id->info.recv_unexpected.na_tcp_addr =
+            na_tcp_unexpected_info->na_tcp_addr;
+        na_tcp_op_id->info.recv_unexpected.tag = na_tcp_unexpected_info->tag;
+        free(na_tcp_unexpected_info);
+
+        ret = na_tcp_complete(na_tcp_op_id);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not complete operation");
+            goto done;
+        }
+    } else {
+        /* Nothing has been received yet so add op_id to progress queue */
+        hg_thread_spin_lock(
+            &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue,
+            na_tcp_op_id, entry);
+        hg_thread_spin_unlock(
+            &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+    }
+
+done:
+    if (ret != NA_SUCCESS && na_tcp_op_id) {
+        na_tcp_op_destroy(na_class, (na_op_id_t) na_tcp_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    return na_tcp_msg_send(na_class, context, NA_CB_SEND_EXPECTED, callback,
+        arg, buf, buf_size, (struct na_tcp_addr *) dest, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t source, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_tcp_op_id *na_tcp_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size > NA_TCP_EXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds expected size");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_tcp_op_id = (struct na_tcp_op_id *) *op_id;
+        hg_atomic_incr32(&na_tcp_op_id->ref_count);
+    } else {
+        na_tcp_op_id = na_tcp_op_alloc(na_class, context);
+        if (!na_tcp_op_id) {
+            NA_LOG_ERROR("Could not allocate NA TCP operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_tcp_op_id->context = context;
+    na_tcp_op_id->completion_data.callback_info.type = NA_CB_RECV_EXPECTED;
+    na_tcp_op_id->completion_data.callback = callback;
+    na_tcp_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_tcp_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_tcp_op_id->canceled, NA_FALSE);
+    na_tcp_op_id->ret = NA_SUCCESS;
+    na_tcp_op_id->info.recv_expected.buf = buf;
+    na_tcp_op_id->info.recv_expected.buf_size = buf_size;
+    na_tcp_op_id->info.recv_expected.na_tcp_addr =
+        (struct na_tcp_addr *) source;
+    na_tcp_op_id->info.recv_expected.tag = tag;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_tcp_op_id;
+
+    /* Expected messages must always be pre-posted, therefore a message should
+     * never arrive before that call returns (not completes), simply add
+     * op_id to queue */
+    hg_thread_spin_lock(
+        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+    HG_QUEUE_PUSH_TAIL(&NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue,
+        na_tcp_op_id, entry);
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+done:
+    if (ret != NA_SUCCESS && na_tcp_op_id) {
+        na_tcp_op_destroy(na_class, (na_op_id_t) na_tcp_op_id);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_tcp_mem_handle = (struct na_tcp_mem_handle *) malloc(
+        sizeof(struct na_tcp_mem_handle));
+    if (!na_tcp_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA TCP memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_tcp_mem_handle, 0, sizeof(struct na_tcp_mem_handle));
+    na_tcp_mem_handle->base = (na_ptr_t) buf;
+    na_tcp_mem_handle->size = buf_size;
+    na_tcp_mem_handle->flags = flags;
+
+    *mem_handle = (na_mem_handle_t) na_tcp_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_mem_handle_free(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle =
+        (struct na_tcp_mem_handle *) mem_handle;
+
+    /* Never leave a freed handle accessible */
+    if (na_tcp_mem_handle->registered)
+        na_tcp_mem_deregister(na_class, mem_handle);
+
+    free(na_tcp_mem_handle);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_mem_register(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle =
+        (struct na_tcp_mem_handle *) mem_handle;
+
+    /* Remote peers may only access registered regions */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+    if (!na_tcp_mem_handle->registered) {
+        HG_LIST_INSERT_HEAD(&NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list,
+            na_tcp_mem_handle, entry);
+        na_tcp_mem_handle->registered = NA_TRUE;
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_mem_deregister(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle =
+        (struct na_tcp_mem_handle *) mem_handle;
+
+    /* Deserialized handles are deregistered without being registered */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+    if (na_tcp_mem_handle->registered) {
+        HG_LIST_REMOVE(na_tcp_mem_handle, entry);
+        na_tcp_mem_handle->registered = NA_FALSE;
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->mem_handle_list_lock);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_tcp_mem_handle_get_serialize_size(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t NA_UNUSED mem_handle)
+{
+    return sizeof(na_ptr_t) + sizeof(na_size_t) + sizeof(unsigned long);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_mem_handle_serialize(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle =
+        (struct na_tcp_mem_handle *) mem_handle;
+    char *buf_ptr = (char *) buf;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size < sizeof(na_ptr_t) + sizeof(na_size_t)
+        + sizeof(unsigned long)) {
+        NA_LOG_ERROR("Buffer size too small for serializing handle");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* Base */
+    memcpy(buf_ptr, &na_tcp_mem_handle->base, sizeof(na_ptr_t));
+    buf_ptr += sizeof(na_ptr_t);
+
+    /* Size */
+    memcpy(buf_ptr, &na_tcp_mem_handle->size, sizeof(na_size_t));
+    buf_ptr += sizeof(na_size_t);
+
+    /* Flags */
+    memcpy(buf_ptr, &na_tcp_mem_handle->flags, sizeof(unsigned long));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_mem_handle_deserialize(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle = NULL;
+    const char *buf_ptr = (const char *) buf;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size < sizeof(na_ptr_t) + sizeof(na_size_t)
+        + sizeof(unsigned long)) {
+        NA_LOG_ERROR("Buffer size too small for deserializing handle");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    na_tcp_mem_handle = (struct na_tcp_mem_handle *) malloc(
+        sizeof(struct na_tcp_mem_handle));
+    if (!na_tcp_mem_handle) {
+        NA_LOG_ERROR("Could not allocate NA TCP memory handle");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    memset(na_tcp_mem_handle, 0, sizeof(struct na_tcp_mem_handle));
+
+    /* Base */
+    memcpy(&na_tcp_mem_handle->base, buf_ptr, sizeof(na_ptr_t));
+    buf_ptr += sizeof(na_ptr_t);
+
+    /* Size */
+    memcpy(&na_tcp_mem_handle->size, buf_ptr, sizeof(na_size_t));
+    buf_ptr += sizeof(na_size_t);
+
+    /* Flags */
+    memcpy(&na_tcp_mem_handle->flags, buf_ptr, sizeof(unsigned long));
+
+    *mem_handle = (na_mem_handle_t) na_tcp_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle_remote =
+        (struct na_tcp_mem_handle *) remote_mem_handle;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_tcp_mem_handle_remote->flags) {
+        case NA_MEM_READ_ONLY:
+            NA_LOG_ERROR("Registered memory requires write permission");
+            ret = NA_PERMISSION_ERROR;
+            goto done;
+        case NA_MEM_WRITE_ONLY:
+        case NA_MEM_READWRITE:
+            break;
+        default:
+            NA_LOG_ERROR("Invalid memory access flag");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    ret = na_tcp_rma(na_class, context, NA_CB_PUT, callback, arg,
+        (struct na_tcp_mem_handle *) local_mem_handle, local_offset,
+        na_tcp_mem_handle_remote, remote_offset, length,
+        (struct na_tcp_addr *) remote_addr, op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id)
+{
+    struct na_tcp_mem_handle *na_tcp_mem_handle_remote =
+        (struct na_tcp_mem_handle *) remote_mem_handle;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_tcp_mem_handle_remote->flags) {
+        case NA_MEM_WRITE_ONLY:
+            NA_LOG_ERROR("Registered memory requires read permission");
+            ret = NA_PERMISSION_ERROR;
+            goto done;
+        case NA_MEM_READ_ONLY:
+        case NA_MEM_READWRITE:
+            break;
+        default:
+            NA_LOG_ERROR("Invalid memory access flag");
+            ret = NA_INVALID_PARAM;
+            goto done;
+    }
+
+    ret = na_tcp_rma(na_class, context, NA_CB_GET, callback, arg,
+        (struct na_tcp_mem_handle *) local_mem_handle, local_offset,
+        na_tcp_mem_handle_remote, remote_offset, length,
+        (struct na_tcp_addr *) remote_addr, op_id);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_tcp_poll_get_fd(na_class_t *na_class, na_context_t NA_UNUSED *context)
+{
+    int fd;
+
+    fd = hg_poll_get_fd(NA_TCP_PRIVATE_DATA(na_class)->poll_set);
+    if (fd == HG_UTIL_FAIL) {
+        NA_LOG_ERROR("Could not get poll fd from poll set");
+    }
+
+    return fd;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_tcp_poll_try_wait(na_class_t *na_class, na_context_t NA_UNUSED *context)
+{
+    struct na_tcp_addr *na_tcp_addr;
+    na_bool_t ret = NA_TRUE;
+
+    /* Poll set must be updated by progress first */
+    if (!HG_QUEUE_IS_EMPTY(&NA_TCP_PRIVATE_DATA(na_class)->register_addr_queue)
+        || !HG_QUEUE_IS_EMPTY(
+            &NA_TCP_PRIVATE_DATA(na_class)->close_addr_queue)) {
+        ret = NA_FALSE;
+        goto done;
+    }
+
+#ifdef NA_TCP_HAS_IO_URING
+    /* Ring requests not submitted yet or completions not reaped yet */
+    if (NA_TCP_PRIVATE_DATA(na_class)->uring) {
+        struct na_tcp_uring *na_tcp_uring =
+            NA_TCP_PRIVATE_DATA(na_class)->uring;
+
+        if (na_tcp_uring->to_submit || *na_tcp_uring->cq_head
+            != __atomic_load_n(na_tcp_uring->cq_tail, __ATOMIC_ACQUIRE)) {
+            ret = NA_FALSE;
+            goto done;
+        }
+    }
+#endif
+
+    /* Blocked sends that are not polled for write yet */
+    hg_thread_spin_lock(&NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+    HG_QUEUE_FOREACH(na_tcp_addr,
+        &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue, send_entry) {
+        if (!na_tcp_addr->send_poll_data) {
+            ret = NA_FALSE;
+            break;
+        }
+    }
+    hg_thread_spin_unlock(
+        &NA_TCP_PRIVATE_DATA(na_class)->send_addr_queue_lock);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_progress(na_class_t *na_class, na_context_t NA_UNUSED *context,
+    unsigned int timeout)
+{
+    double remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
+    na_return_t ret = NA_TIMEOUT;
+
+    do {
+        hg_time_t t1, t2;
+        hg_util_bool_t progressed = HG_UTIL_FALSE;
+        na_bool_t updated = NA_FALSE;
+
+        if (timeout)
+            hg_time_get_current(&t1);
+
+        /* Register new connections and blocked sends before waiting, updates
+         * count as progress (see na_tcp_poll_try_wait()) */
+        ret = na_tcp_poll_update(na_class, &updated);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not update poll set");
+            goto done;
+        }
+
+#ifdef NA_TCP_HAS_IO_URING
+        /* Submit requests that could not be submitted yet */
+        if (NA_TCP_PRIVATE_DATA(na_class)->uring
+            && NA_TCP_PRIVATE_DATA(na_class)->uring->to_submit) {
+            hg_thread_mutex_lock(
+                &NA_TCP_PRIVATE_DATA(na_class)->uring->sq_lock);
+            ret = na_tcp_uring_submit(NA_TCP_PRIVATE_DATA(na_class)->uring);
+            hg_thread_mutex_unlock(
+                &NA_TCP_PRIVATE_DATA(na_class)->uring->sq_lock);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not submit ring requests");
+                goto done;
+            }
+        }
+#endif
+
+        if (hg_poll_wait(NA_TCP_PRIVATE_DATA(na_class)->poll_set,
+            (updated) ? 0 : (unsigned int) (remaining * 1000.0),
+            &progressed) != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_wait() failed");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+
+        /* Close connections that failed while waiting */
+        ret = na_tcp_poll_update(na_class, &updated);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not update poll set");
+            goto done;
+        }
+
+        /* We progressed, return success */
+        if (progressed || updated) {
+            ret = NA_SUCCESS;
+            break;
+        }
+        ret = NA_TIMEOUT;
+
+        if (timeout) {
+            hg_time_get_current(&t2);
+            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+        }
+    } while ((int)(remaining * 1000.0) > 0);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_tcp_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
+    na_op_id_t op_id)
+{
+    struct na_tcp_op_id *na_tcp_op_id = (struct na_tcp_op_id *) op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_tcp_op_id->completed))
+        goto done;
+
+    switch (na_tcp_op_id->completion_data.callback_info.type) {
+        case NA_CB_LOOKUP:
+            /* Nothing */
+            break;
+        case NA_CB_SEND_UNEXPECTED:
+            /* Nothing */
+            break;
+        case NA_CB_RECV_UNEXPECTED: {
+            struct na_tcp_op_id *na_tcp_var_op_id = NULL;
+
+            /* Must remove op_id from unexpected op_id queue */
+            hg_thread_spin_lock(
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+            HG_QUEUE_FOREACH(na_tcp_var_op_id,
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue, entry) {
+                if (na_tcp_var_op_id == na_tcp_op_id) {
+                    HG_QUEUE_REMOVE(
+                        &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue,
+                        na_tcp_var_op_id, na_tcp_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_TCP_PRIVATE_DATA(na_class)->unexpected_op_queue_lock);
+
+            /* Cancel op id */
+            if (na_tcp_var_op_id == na_tcp_op_id) {
+                hg_atomic_set32(&na_tcp_op_id->canceled, NA_TRUE);
+                ret = na_tcp_complete(na_tcp_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+        }
+            break;
+        case NA_CB_SEND_EXPECTED:
+            /* Nothing */
+            break;
+        case NA_CB_RECV_EXPECTED: {
+            struct na_tcp_op_id *na_tcp_var_op_id = NULL;
+
+            /* Must remove op_id from expected op_id queue */
+            hg_thread_spin_lock(
+                &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+            HG_QUEUE_FOREACH(na_tcp_var_op_id,
+                &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue, entry) {
+                if (na_tcp_var_op_id == na_tcp_op_id) {
+                    HG_QUEUE_REMOVE(
+                        &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue,
+                        na_tcp_var_op_id, na_tcp_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(
+                &NA_TCP_PRIVATE_DATA(na_class)->expected_op_queue_lock);
+
+            /* Cancel op id */
+            if (na_tcp_var_op_id == na_tcp_op_id) {
+                hg_atomic_set32(&na_tcp_op_id->canceled, NA_TRUE);
+                ret = na_tcp_complete(na_tcp_op_id);
+                if (ret != NA_SUCCESS) {
+                    NA_LOG_ERROR("Could not complete operation");
+                    goto done;
+                }
+            }
+        }
+            break;
+        case NA_CB_PUT:
+        case NA_CB_GET:
+            /* Nothing, chunks in flight complete the operation */
+            break;
+        default:
+            NA_LOG_ERROR("Operation not supported");
+            ret = NA_INVALID_PARAM;
+            break;
+    }
+
+done:
+    return ret;
+}
@@ -72,6 +72,10 @@ struct hg_atomic_queue {
 #define cpu_spinwait() asm volatile("pause\n": : :"memory");
 #endif
 
+/* Number of spins before yielding while waiting for a preceding thread, that
+ * thread may have been preempted when there are more threads than CPUs */
+#define HG_ATOMIC_QUEUE_SPIN_COUNT 128
+
 /*********************/
 /* Public Prototypes */
 /*********************/
@@ -154,14 +158,16 @@ static HG_UTIL_INLINE int
 hg_atomic_queue_push(struct hg_atomic_queue *hg_atomic_queue, void *entry)
 {
     hg_util_int32_t prod_head, prod_next, cons_tail;
+    unsigned int spin_count = 0;
     int ret = HG_UTIL_SUCCESS;
 
     do {
         prod_head = hg_atomic_get32(&hg_atomic_queue->prod_head);
-        prod_next = (prod_head + 1) & (int) hg_atomic_queue->prod_mask;
+        prod_next = (hg_util_int32_t) ((unsigned int) prod_head + 1);
         cons_tail = hg_atomic_get32(&hg_atomic_queue->cons_tail);
 
-        if (prod_next == cons_tail) {
+        if ((unsigned int) prod_head - (unsigned int) cons_tail
+            >= hg_atomic_queue->prod_mask) {
             hg_atomic_fence();
             if (prod_head == hg_atomic_get32(&hg_atomic_queue->prod_head) &&
                 cons_tail == hg_atomic_get32(&hg_atomic_queue->cons_tail)) {
@@ -175,7 +181,8 @@ hg_atomic_queue_push(struct hg_atomic_queue *hg_atomic_queue, void *entry)
     } while (!hg_atomic_cas32(&hg_atomic_queue->prod_head, prod_head,
         prod_next));
 
-    hg_atomic_set64((hg_atomic_int64_t *) &hg_atomic_queue->ring[prod_head],
+    hg_atomic_set64((hg_atomic_int64_t *) &hg_atomic_queue->ring[
+        (unsigned int) prod_head & hg_atomic_queue->prod_mask],
         (hg_util_int64_t) entry);
 
     /*
@@ -183,8 +190,12 @@ hg_atomic_queue_push(struct hg_atomic_queue *hg_atomic_queue, void *entry)
      * that preceded us, we need to wait for them
      * to complete
      */
-    while (hg_atomic_get32(&hg_atomic_queue->prod_tail) != prod_head)
-        cpu_spinwait();
+    while (hg_atomic_get32(&hg_atomic_queue->prod_tail) != prod_head) {
+        if (++spin_count < HG_ATOMIC_QUEUE_SPIN_COUNT) {
+            cpu_spinwait();
+        } else
+            hg_thread_yield();
+    }
 
     hg_atomic_set32(&hg_atomic_queue->prod_tail, prod_next);
 
@@ -197,11 +208,12 @@ static HG_UTIL_INLINE void *
 hg_atomic_queue_pop_mc(struct hg_atomic_queue *hg_atomic_queue)
 {
     hg_util_int32_t cons_head, cons_next;
+    unsigned int spin_count = 0;
     void *entry = NULL;
 
     do {
         cons_head = hg_atomic_get32(&hg_atomic_queue->cons_head);
-        cons_next = (cons_head + 1) & (int) hg_atomic_queue->cons_mask;
+        cons_next = (hg_util_int32_t) ((unsigned int) cons_head + 1);
 
         if (cons_head == hg_atomic_get32(&hg_atomic_queue->prod_tail))
             goto done;
@@ -209,15 +221,20 @@ hg_atomic_queue_pop_mc(struct hg_atomic_queue *hg_atomic_queue)
         cons_next));
 
     entry = (void *) hg_atomic_get64(
-        (hg_atomic_int64_t *) &hg_atomic_queue->ring[cons_head]);
+        (hg_atomic_int64_t *) &hg_atomic_queue->ring[
+        (unsigned int) cons_head & hg_atomic_queue->cons_mask]);
 
     /*
      * If there are other dequeues in progress
      * that preceded us, we need to wait for them
      * to complete
      */
-    while (hg_atomic_get32(&hg_atomic_queue->cons_tail) != cons_head)
-        cpu_spinwait();
+    while (hg_atomic_get32(&hg_atomic_queue->cons_tail) != cons_head) {
+        if (++spin_count < HG_ATOMIC_QUEUE_SPIN_COUNT) {
+            cpu_spinwait();
+        } else
+            hg_thread_yield();
+    }
 
     hg_atomic_set32(&hg_atomic_queue->cons_tail, cons_next);
 
@@ -235,7 +252,7 @@ hg_atomic_queue_pop_sc(struct hg_atomic_queue *hg_atomic_queue)
 
     cons_head = hg_atomic_get32(&hg_atomic_queue->cons_head);
     prod_tail = hg_atomic_get32(&hg_atomic_queue->prod_tail);
-    cons_next = (cons_head + 1) & (int) hg_atomic_queue->cons_mask;
+    cons_next = (hg_util_int32_t) ((unsigned int) cons_head + 1);
 
     if (cons_head == prod_tail)
         /* Empty */
@@ -244,7 +261,8 @@ hg_atomic_queue_pop_sc(struct hg_atomic_queue *hg_atomic_queue)
     hg_atomic_set32(&hg_atomic_queue->cons_head, cons_next);
 
     entry = (void *) hg_atomic_get64(
-        (hg_atomic_int64_t *) &hg_atomic_queue->ring[cons_head]);
+        (hg_atomic_int64_t *) &hg_atomic_queue->ring[
+        (unsigned int) cons_head & hg_atomic_queue->cons_mask]);
 
     hg_atomic_set32(&hg_atomic_queue->cons_tail, cons_next);
 
@@ -264,10 +282,8 @@ hg_atomic_queue_is_empty(struct hg_atomic_queue *hg_atomic_queue)
 static HG_UTIL_INLINE unsigned int
 hg_atomic_queue_count(struct hg_atomic_queue *hg_atomic_queue)
 {
-    return ((hg_atomic_queue->prod_size
-        + (unsigned int) hg_atomic_get32(&hg_atomic_queue->prod_tail)
-        - (unsigned int) hg_atomic_get32(&hg_atomic_queue->cons_tail))
-        & hg_atomic_queue->prod_mask);
+    return ((unsigned int) hg_atomic_get32(&hg_atomic_queue->prod_tail)
+        - (unsigned int) hg_atomic_get32(&hg_atomic_queue->cons_tail));
 }
 
 #ifdef __cplusplus
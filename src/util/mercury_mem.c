@@ -22,8 +22,104 @@
   #include <string.h>
   #include <errno.h>
 #endif
+#ifdef __linux__
+  #include <sys/vfs.h>
+  #include <mntent.h>
+  #include <limits.h>
+  #include <stdio.h>
+#endif
 #include <stdlib.h>
 
+/****************/
+/* Local Macros */
+/****************/
+
+#ifdef __linux__
+#define HG_MEM_HUGETLBFS_MAGIC  0x958458f6
+#define HG_MEM_MEMINFO_PATH     "/proc/meminfo"
+#define HG_MEM_THP_SHMEM_PATH \
+    "/sys/kernel/mm/transparent_hugepage/shmem_enabled"
+#endif
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+#ifdef __linux__
+/**
+ * Get path of file \name on first hugetlbfs mount and huge page size.
+ */
+static int
+hg_mem_hugetlbfs_path(const char *name, char *path, size_t path_len,
+    size_t *page_size);
+
+/**
+ * Check whether transparent huge pages can back shmem mappings.
+ */
+static hg_util_bool_t
+hg_mem_thp_shmem_enabled(void);
+#endif
+
+/*---------------------------------------------------------------------------*/
+#ifdef __linux__
+static int
+hg_mem_hugetlbfs_path(const char *name, char *path, size_t path_len,
+    size_t *page_size)
+{
+    struct mntent *mnt;
+    FILE *mnt_file;
+    int ret = HG_UTIL_FAIL;
+
+    mnt_file = setmntent("/proc/mounts", "r");
+    if (!mnt_file)
+        goto done;
+
+    while ((mnt = getmntent(mnt_file)) != NULL) {
+        struct statfs fs_stat;
+
+        if (strcmp(mnt->mnt_type, "hugetlbfs") != 0)
+            continue;
+        /* Must be writable by us */
+        if (access(mnt->mnt_dir, W_OK) != 0)
+            continue;
+        if (statfs(mnt->mnt_dir, &fs_stat) != 0
+            || fs_stat.f_type != HG_MEM_HUGETLBFS_MAGIC)
+            continue;
+        if ((size_t) snprintf(path, path_len, "%s/%s", mnt->mnt_dir,
+            (name[0] == '/') ? name + 1 : name) >= path_len)
+            continue;
+        *page_size = (size_t) fs_stat.f_bsize;
+        ret = HG_UTIL_SUCCESS;
+        break;
+    }
+    endmntent(mnt_file);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_util_bool_t
+hg_mem_thp_shmem_enabled(void)
+{
+    char buf[128];
+    FILE *file;
+    hg_util_bool_t ret = HG_UTIL_FALSE;
+
+    /* Current setting is the one between brackets */
+    file = fopen(HG_MEM_THP_SHMEM_PATH, "r");
+    if (!file)
+        goto done;
+    if (fgets(buf, sizeof(buf), file)
+        && !strstr(buf, "[never]") && !strstr(buf, "[deny]"))
+        ret = HG_UTIL_TRUE;
+    fclose(file);
+
+done:
+    return ret;
+}
+#endif
+
 /*---------------------------------------------------------------------------*/
 long
 hg_mem_get_page_size(void)
@@ -41,6 +137,42 @@ hg_mem_get_page_size(void)
     return page_size;
 }
 
+/*---------------------------------------------------------------------------*/
+long
+hg_mem_get_huge_page_size(void)
+{
+    long page_size = -1;
+#ifdef __linux__
+    char path[PATH_MAX];
+    size_t hugetlbfs_page_size;
+    char buf[128];
+    FILE *file;
+
+    if (hg_mem_hugetlbfs_path("", path, sizeof(path), &hugetlbfs_page_size)
+        == HG_UTIL_SUCCESS) {
+        page_size = (long) hugetlbfs_page_size;
+        goto done;
+    }
+
+    /* Default huge page size */
+    file = fopen(HG_MEM_MEMINFO_PATH, "r");
+    if (!file)
+        goto done;
+    while (fgets(buf, sizeof(buf), file)) {
+        long size_kb;
+
+        if (sscanf(buf, "Hugepagesize: %ld kB", &size_kb) == 1) {
+            page_size = size_kb * 1024;
+            break;
+        }
+    }
+    fclose(file);
+
+done:
+#endif
+    return page_size;
+}
+
 /*---------------------------------------------------------------------------*/
 void *
 hg_mem_aligned_alloc(size_t alignment, size_t size)
@@ -163,6 +295,64 @@ done:
     return mem_ptr;
 }
 
+/*---------------------------------------------------------------------------*/
+void *
+hg_mem_shm_map_huge(const char *name, size_t size, hg_util_bool_t create,
+    hg_mem_page_type_t *page_type)
+{
+    hg_mem_page_type_t mem_page_type = HG_MEM_PAGE_DEFAULT;
+    void *mem_ptr = NULL;
+#ifdef __linux__
+    char path[PATH_MAX];
+    size_t huge_page_size;
+
+    /* Try hugetlbfs first, mapping size must be a multiple of page size */
+    if (hg_mem_hugetlbfs_path(name, path, sizeof(path), &huge_page_size)
+        == HG_UTIL_SUCCESS && (size % huge_page_size) == 0) {
+        int flags = O_RDWR | (create ? O_CREAT : 0);
+        int fd;
+
+        fd = open(path, flags, S_IRUSR | S_IWUSR);
+        if (fd >= 0) {
+            struct stat file_stat;
+
+            if (fstat(fd, &file_stat) == 0 && (file_stat.st_size >= (off_t) size
+                || (file_stat.st_size == 0 && ftruncate(fd, (off_t) size) == 0))) {
+                /* Fails if not enough huge pages can be reserved */
+                mem_ptr = mmap(NULL, size, PROT_WRITE | PROT_READ, MAP_SHARED,
+                    fd, 0);
+                if (mem_ptr == MAP_FAILED)
+                    mem_ptr = NULL;
+            }
+            close(fd);
+            if (mem_ptr)
+                mem_page_type = HG_MEM_PAGE_HUGETLB;
+            else if (create)
+                unlink(path);
+        }
+        /* Peers fall back to shm if the creator could not use hugetlbfs */
+    }
+#endif
+
+    if (!mem_ptr) {
+        mem_ptr = hg_mem_shm_map(name, size, create);
+        if (!mem_ptr)
+            goto done;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        /* Only an advice, kernel decides whether huge pages are used */
+        if (hg_mem_thp_shmem_enabled()
+            && madvise(mem_ptr, size, MADV_HUGEPAGE) == 0)
+            mem_page_type = HG_MEM_PAGE_THP;
+#endif
+    }
+
+    if (page_type)
+        *page_type = mem_page_type;
+
+done:
+    return mem_ptr;
+}
+
 /*---------------------------------------------------------------------------*/
 int
 hg_mem_shm_unmap(const char *name, void *mem_ptr, size_t size)
@@ -182,6 +372,15 @@ hg_mem_shm_unmap(const char *name, void *mem_ptr, size_t size)
     }
 
     if (name && shm_unlink(name) == -1) {
+#ifdef __linux__
+        char path[PATH_MAX];
+        size_t huge_page_size;
+
+        /* File may have been created on hugetlbfs */
+        if (errno == ENOENT && hg_mem_hugetlbfs_path(name, path, sizeof(path),
+            &huge_page_size) == HG_UTIL_SUCCESS && unlink(path) == 0)
+            goto done;
+#endif
         HG_UTIL_LOG_ERROR("shm_unlink() failed (%s)", strerror(errno));
         ret = HG_UTIL_FAIL;
         goto done;
@@ -17,6 +17,13 @@
  * Purpose: memory related utility functions.
  */
 
+/* Type of pages backing a shared-memory mapping */
+typedef enum {
+    HG_MEM_PAGE_DEFAULT,    /*!< regular pages */
+    HG_MEM_PAGE_THP,        /*!< transparent huge pages (advised) */
+    HG_MEM_PAGE_HUGETLB     /*!< huge pages from hugetlbfs */
+} hg_mem_page_type_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,6 +36,15 @@ extern "C" {
 HG_UTIL_EXPORT long
 hg_mem_get_page_size(void);
 
+/**
+ * Get size of huge pages, either from the first hugetlbfs mount or from
+ * the system default.
+ *
+ * \return huge page size on success or negative on failure
+ */
+HG_UTIL_EXPORT long
+hg_mem_get_huge_page_size(void);
+
 /**
  * Allocate size bytes and return a pointer to the allocated memory.
  * The memory address will be a multiple of alignment, which must be a power of
@@ -62,6 +78,25 @@ hg_mem_aligned_free(void *mem_ptr);
 void *
 hg_mem_shm_map(const char *name, size_t size, hg_util_bool_t create);
 
+/**
+ * Create/open a shared-memory mapped file of size \size with name \name and
+ * try to back it with huge pages. The file is first created on the first
+ * hugetlbfs mount if there is one and if \size is a multiple of its page
+ * size, the mapping is otherwise created as in hg_mem_shm_map() and
+ * transparent huge pages are requested. Peers must open the file with this
+ * same routine.
+ *
+ * \param name [IN]             name of mapped file
+ * \param size [IN]             total requested size
+ * \param create [IN]           create file if not existing
+ * \param page_type [OUT]       type of pages obtained (may be NULL)
+ *
+ * \return a pointer to the mapped memory region, or NULL in case of failure
+ */
+void *
+hg_mem_shm_map_huge(const char *name, size_t size, hg_util_bool_t create,
+    hg_mem_page_type_t *page_type);
+
 /**
  * Unmap a previously mapped region and close the file.
  *